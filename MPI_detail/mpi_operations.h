@@ -46,6 +46,8 @@
 #include "boost/serialization/serialization.hpp"
 #include "boost/serialization/shared_ptr.hpp"
 #include "boost/serialization/map.hpp"
+#include "boost/serialization/vector.hpp"
+#include "boost/timer/timer.hpp"
 
 
 namespace MPI_detail
@@ -56,29 +58,43 @@ namespace MPI_detail
 
     // MESSAGE TAGS
 
+    // item and product tags must be distinct across all work types, because a pipelined task
+    // can interleave batches of several types
+
     constexpr unsigned int MESSAGE_NEW_TRANSFER_TASK          = 0;
     constexpr unsigned int MESSAGE_NEW_TRANSFER_INTEGRATION   = 1;
+    constexpr unsigned int MESSAGE_TRANSFER_INTEGRATION_READY = 2;
     
     constexpr unsigned int MESSAGE_NEW_FILTER_PK_TASK         = 10;
-    constexpr unsigned int MESSAGE_NEW_FILTER_PK              = 21;
+    constexpr unsigned int MESSAGE_NEW_FILTER_PK              = 11;
+    constexpr unsigned int MESSAGE_FILTER_PK_READY            = 12;
 
     constexpr unsigned int MESSAGE_NEW_LOOP_INTEGRAL_TASK     = 20;
     constexpr unsigned int MESSAGE_NEW_LOOP_INTEGRATION       = 21;
+    constexpr unsigned int MESSAGE_LOOP_INTEGRATION_READY     = 22;
     
     constexpr unsigned int MESSAGE_NEW_ONE_LOOP_PK_TASK       = 30;
     constexpr unsigned int MESSAGE_NEW_ONE_LOOP_PK            = 31;
+    constexpr unsigned int MESSAGE_ONE_LOOP_PK_READY          = 32;
     
     constexpr unsigned int MESSAGE_NEW_MATSUBARA_XY_TASK      = 40;
-    constexpr unsigned int MESSAGE_NEW_MATSUBARA_XY           = 51;
+    constexpr unsigned int MESSAGE_NEW_MATSUBARA_XY           = 41;
+    constexpr unsigned int MESSAGE_MATSUBARA_XY_READY         = 42;
     
     constexpr unsigned int MESSAGE_NEW_MULTIPOLE_PK_TASK      = 50;
     constexpr unsigned int MESSAGE_NEW_MULTIPOLE_PK           = 51;
+    constexpr unsigned int MESSAGE_MULTIPOLE_PK_READY         = 52;
 
     constexpr unsigned int MESSAGE_NEW_COUNTERTERM_TASK       = 60;
     constexpr unsigned int MESSAGE_NEW_COUNTERTERM            = 61;
+    constexpr unsigned int MESSAGE_COUNTERTERM_READY          = 62;
+
+    constexpr unsigned int MESSAGE_CACHE_INITIAL_FILTERED_PK  = 70;
+    constexpr unsigned int MESSAGE_CACHE_FINAL_FILTERED_PK    = 71;
+
+    constexpr unsigned int MESSAGE_NEW_PIPELINE_TASK          = 80;
 
     constexpr unsigned int MESSAGE_WORKER_READY               = 90;
-    constexpr unsigned int MESSAGE_WORK_PRODUCT_READY         = 91;
 
     constexpr unsigned int MESSAGE_END_OF_WORK                = 98;
     constexpr unsigned int MESSAGE_END_OF_WORK_ACK            = 99;
@@ -86,6 +102,77 @@ namespace MPI_detail
     constexpr unsigned int MESSAGE_TERMINATE                  = 999;
 
 
+    // BATCHED PAYLOADS
+
+
+    //! a batch of work items or work products; work is always dispatched to the workers in batches,
+    //! which may consist of a single item
+    template <typename Payload>
+    class payload_batch
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! empty constructor: used to receive or build a payload
+        payload_batch()
+          : items(),
+            compute_time(0)
+          {
+          }
+
+        //! destructor is default
+        ~payload_batch() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! add an item to the batch
+        void push_back(Payload p) { this->items.push_back(std::move(p)); }
+
+        //! get number of items in the batch
+        size_t size() const { return this->items.size(); }
+
+        //! get items
+        std::vector<Payload>& get_items() { return this->items; }
+
+        //! get items
+        const std::vector<Payload>& get_items() const { return this->items; }
+
+        //! get wall-clock time spent by the worker computing this batch (zero for outgoing batches)
+        boost::timer::nanosecond_type get_compute_time() const { return this->compute_time; }
+
+        //! set compute time
+        void set_compute_time(boost::timer::nanosecond_type t) { this->compute_time = t; }
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! payload items
+        std::vector<Payload> items;
+
+        //! time spent computing this batch
+        boost::timer::nanosecond_type compute_time;
+
+
+        // enable boost::serialization support, and hence automated packing for transmission over MPI
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, unsigned int version)
+          {
+            ar & items;
+            ar & compute_time;
+          }
+
+      };
+
+
     // TRANSFER INTEGRATION PAYLOADS
 
 
@@ -233,6 +320,7 @@ namespace MPI_detail
         //! empty constructor, used to receive a payload
         new_filter_Pk()
           : model("", 0, 0, 0, Mpc_units::energy(0), 0, 0, 0, 0, 0, 0, 0, Mpc_units::energy(0)),
+            model_tok(0),
             k(0),
             k_tok(0),
             Pk_tok(0),
@@ -243,9 +331,11 @@ namespace MPI_detail
           }
            
         //! value constructor, used to construct and send a payload
-        new_filter_Pk(const FRW_model& m, const Mpc_units::energy& _k, const k_token& kt, const linear_Pk_token& Pt,
-                      std::shared_ptr<filterable_Pk> _Pk, const filter_params_token& pt, const Pk_filter_params& p)
+        new_filter_Pk(const FRW_model& m, const FRW_model_token& mt, const Mpc_units::energy& _k, const k_token& kt,
+                      const linear_Pk_token& Pt, std::shared_ptr<filterable_Pk> _Pk, const filter_params_token& pt,
+                      const Pk_filter_params& p)
           : model(m),
+            model_tok(mt),
             k(_k),
             k_tok(kt),
             Pk_tok(Pt),
@@ -265,6 +355,9 @@ namespace MPI_detail
     
         //! get model
         const FRW_model& get_model() const { return(this->model); }
+        
+        //! get model token
+        const FRW_model_token& get_model_token() const { return(this->model_tok); }
     
         //! get wavenumber
         const Mpc_units::energy& get_k() const { return(this->k); }
@@ -291,6 +384,9 @@ namespace MPI_detail
     
         //! FRW model to use for this calculation
         FRW_model model;
+        
+        //! token for FRW model
+        FRW_model_token model_tok;
     
         //! wavenumber to integrate
         Mpc_units::energy k;
@@ -318,6 +414,7 @@ namespace MPI_detail
         void serialize(Archive& ar, unsigned int version)
           {
             ar & model;
+            ar & model_tok;
             ar & k;
             ar & k_tok;
             ar & Pk_tok;
@@ -379,6 +476,65 @@ namespace MPI_detail
       };
 
 
+    // WORKER-RESIDENT POWER SPECTRUM CACHE
+
+
+    template <typename FilteredPkType>
+    class cache_filtered_Pk
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! empty constructor: used to receive a payload
+        cache_filtered_Pk()
+          : Pk()
+          {
+          }
+
+        //! value constructor: used to construct and broadcast a payload
+        cache_filtered_Pk(std::shared_ptr<FilteredPkType> _Pk)
+          : Pk(std::move(_Pk))
+          {
+          }
+
+        //! destructor is default
+        ~cache_filtered_Pk() = default;
+
+
+        // ACCESS PAYLOAD
+
+      public:
+
+        //! get filtered power spectrum; ownership is shared with the worker-side cache
+        const std::shared_ptr<FilteredPkType>& get_Pk() const { return this->Pk; }
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! filtered power spectrum container
+        std::shared_ptr<FilteredPkType> Pk;
+
+
+        // enable boost::serialization support, and hence automated packing for transmission over MPI
+        friend class boost::serialization::access;
+
+        template <typename Archive>
+        void serialize(Archive& ar, unsigned int version)
+          {
+            ar & Pk;
+          }
+
+      };
+
+
+    typedef cache_filtered_Pk<initial_filtered_Pk> cache_initial_filtered_Pk;
+    typedef cache_filtered_Pk<final_filtered_Pk> cache_final_filtered_Pk;
+
+
     // LOOP INTEGRAL PAYLOADS
 
 
@@ -392,31 +548,33 @@ namespace MPI_detail
         //! empty constructor: used to receive a payload
         new_loop_momentum_integration()
           : model("", 0, 0, 0, Mpc_units::energy(0), 0, 0, 0, 0, 0, 0, 0, Mpc_units::energy(0)),
+            model_tok(0),
             k(0),
             UV_cutoff(0),
             IR_cutoff(0),
             k_tok(0),
             UV_tok(0),
             IR_tok(0),
-            Pk(),
+            Pk_tok(0),
             params_tok(0),
             params()
           {
           }
 
         //! value constructor: used to construct and send a payload
-        new_loop_momentum_integration(const FRW_model& m, const Mpc_units::energy& _k, const k_token& kt,
-                                      const Mpc_units::energy& UV, const UV_cutoff_token& UVt, const Mpc_units::energy& IR,
-                                      const IR_cutoff_token& IRt, std::shared_ptr<initial_filtered_Pk> _Pk,
+        new_loop_momentum_integration(const FRW_model& m, const FRW_model_token& mt, const Mpc_units::energy& _k,
+                                      const k_token& kt, const Mpc_units::energy& UV, const UV_cutoff_token& UVt,
+                                      const Mpc_units::energy& IR, const IR_cutoff_token& IRt, const linear_Pk_token& Pt,
                                       const loop_integral_params_token& pt, const loop_integral_params& p)
           : model(m),
+            model_tok(mt),
             k(_k),
             UV_cutoff(UV),
             IR_cutoff(IR),
             k_tok(kt),
             UV_tok(UVt),
             IR_tok(IRt),
-            Pk(std::move(_Pk)),
+            Pk_tok(Pt),
             params_tok(pt),
             params(p)
           {
@@ -432,6 +590,9 @@ namespace MPI_detail
 
         //! get model
         const FRW_model& get_model() const { return(this->model); }
+        
+        //! get model token
+        const FRW_model_token& get_model_token() const { return(this->model_tok); }
 
         //! get wavenumber
         const Mpc_units::energy& get_k() const { return(this->k); }
@@ -451,8 +612,8 @@ namespace MPI_detail
         //! get IR cutoff token
         const IR_cutoff_token& get_IR_token() const { return(this->IR_tok); }
 
-        //! get tree-level power spectrum
-        const initial_filtered_Pk& get_tree_power_spectrum() const { return *this->Pk; }
+        //! get token for tree-level power spectrum; the spectrum itself is resident on the worker
+        const linear_Pk_token& get_Pk_token() const { return this->Pk_tok; }
         
         //! get parameters token
         const loop_integral_params_token& get_params_token() const { return this->params_tok; }
@@ -467,6 +628,9 @@ namespace MPI_detail
 
         //! FRW model to use for the integration
         FRW_model model;
+        
+        //! token for FRW model
+        FRW_model_token model_tok;
 
         //! wavenumber to integrate
         Mpc_units::energy k;
@@ -486,8 +650,8 @@ namespace MPI_detail
         //! IR cutoff token
         IR_cutoff_token IR_tok;
 
-        //! tree-level power spectrum
-        std::shared_ptr<initial_filtered_Pk> Pk;
+        //! token for tree-level power spectrum
+        linear_Pk_token Pk_tok;
         
         //! parameters token
         loop_integral_params_token params_tok;
@@ -503,13 +667,16 @@ namespace MPI_detail
         void serialize(Archive& ar, unsigned int version)
           {
             ar & model;
+            ar & model_tok;
             ar & k;
             ar & k_tok;
             ar & UV_cutoff;
             ar & UV_tok;
             ar & IR_cutoff;
             ar & IR_tok;
-            ar & Pk;
+            ar & Pk_tok;
+            ar & params_tok;
+            ar & params;
           }
 
       };
@@ -578,7 +745,7 @@ namespace MPI_detail
         new_Matsubara_XY()
           : IR_resum(0.0),
             IR_resum_tok(0),
-            Pk(),
+            Pk_tok(0),
             params_tok(0),
             params()
           {
@@ -586,11 +753,11 @@ namespace MPI_detail
         
         //! value constructor: used to construct and send a payload
         new_Matsubara_XY(const Mpc_units::energy& _IR, const IR_resum_token& _IRt,
-                         std::shared_ptr<initial_filtered_Pk> _Pk, const MatsubaraXY_params_token& _pt,
+                         const linear_Pk_token& _Pt, const MatsubaraXY_params_token& _pt,
                          const MatsubaraXY_params& _pm)
           : IR_resum(_IR),
             IR_resum_tok(_IRt),
-            Pk(std::move(_Pk)),
+            Pk_tok(_Pt),
             params_tok(_pt),
             params(_pm)
           {
@@ -610,8 +777,8 @@ namespace MPI_detail
         //! get IR resummation token
         const IR_resum_token& get_IR_resum_token() const { return this->IR_resum_tok; }
     
-        //! get tree-level power spectrum
-        const initial_filtered_Pk& get_tree_power_spectrum() const { return *this->Pk; }
+        //! get token for tree-level power spectrum; the spectrum itself is resident on the worker
+        const linear_Pk_token& get_Pk_token() const { return this->Pk_tok; }
         
         //! get parameters token
         const MatsubaraXY_params_token& get_params_token() const { return this->params_tok; }
@@ -630,8 +797,8 @@ namespace MPI_detail
         //! IR resummation token
         IR_resum_token IR_resum_tok;
     
-        //! tree-level power spectrum
-        std::shared_ptr<initial_filtered_Pk> Pk;
+        //! token for tree-level power spectrum
+        linear_Pk_token Pk_tok;
         
         //! parameters token
         MatsubaraXY_params_token params_tok;
@@ -648,7 +815,7 @@ namespace MPI_detail
           {
             ar & IR_resum;
             ar & IR_resum_tok;
-            ar & Pk;
+            ar & Pk_tok;
             ar & params_tok;
             ar & params;
           }
@@ -722,21 +889,23 @@ namespace MPI_detail
           : k(0.0),
             gf_factors(),
             loop_data(),
-            Pk_init(),
-            Pk_final()
+            init_Pk_tok(0),
+            has_final_Pk(false),
+            final_Pk_tok(0)
           {
           }
         
         //! value constructor: used to construct and send a payload
         new_one_loop_Pk(const Mpc_units::energy& _k,
                         std::shared_ptr<oneloop_growth> gf, std::shared_ptr<loop_integral> k,
-                        std::shared_ptr<initial_filtered_Pk> _Pk_init,
-                        std::shared_ptr<final_filtered_Pk> _Pk_final)
+                        const linear_Pk_token& _init_tok,
+                        const boost::optional<linear_Pk_token>& _final_tok)
           : k(_k),
             gf_factors(std::move(gf)),
             loop_data(std::move(k)),
-            Pk_init(std::move(_Pk_init)),
-            Pk_final(std::move(_Pk_final))
+            init_Pk_tok(_init_tok),
+            has_final_Pk(static_cast<bool>(_final_tok)),
+            final_Pk_tok(_final_tok ? *_final_tok : linear_Pk_token(0))
           {
           }
         
@@ -757,13 +926,13 @@ namespace MPI_detail
         //! get one-loop kernel data
         const loop_integral& get_loop_data() const { return *this->loop_data; }
     
-        //! get initial linear power spectrum
-        const initial_filtered_Pk& get_init_linear_Pk() const { return *this->Pk_init; }
+        //! get token for initial linear power spectrum; the spectrum itself is resident on the worker
+        const linear_Pk_token& get_init_Pk_token() const { return this->init_Pk_tok; }
         
-        //! get final linear power spectrum, if provided
-        boost::optional<const final_filtered_Pk&> get_final_linear_Pk() const
+        //! get token for final linear power spectrum, if provided
+        boost::optional<linear_Pk_token> get_final_Pk_token() const
           {
-            if(this->Pk_final) return *this->Pk_final;
+            if(this->has_final_Pk) return this->final_Pk_tok;
             return boost::none;
           }
 
@@ -781,11 +950,14 @@ namespace MPI_detail
         //! loop kernel data
         std::shared_ptr<loop_integral> loop_data;
     
-        //! initial linear power spectrum
-        std::shared_ptr<initial_filtered_Pk> Pk_init;
+        //! token for initial linear power spectrum
+        linear_Pk_token init_Pk_tok;
         
-        //! final linear power spectrum, if provided
-        std::shared_ptr<final_filtered_Pk> Pk_final;
+        //! flag indicating whether a final linear power spectrum was provided
+        bool has_final_Pk;
+        
+        //! token for final linear power spectrum, if provided
+        linear_Pk_token final_Pk_tok;
     
     
         // enable boost::serialization support, and hence automated packing for transmission over MPI
@@ -797,8 +969,9 @@ namespace MPI_detail
             ar & k;
             ar & gf_factors;
             ar & loop_data;
-            ar & Pk_init;
-            ar & Pk_final;
+            ar & init_Pk_tok;
+            ar & has_final_Pk;
+            ar & final_Pk_tok;
           }
     
       };
@@ -867,21 +1040,23 @@ namespace MPI_detail
             XY(),
             data(),
             Df_data(),
-            Pk_init(),
-            Pk_final()
+            init_Pk_tok(0),
+            has_final_Pk(false),
+            final_Pk_tok(0)
           {
           }
         
         //! value constructor: used to construct and send a payload
         new_multipole_Pk(const Mpc_units::energy& _k, const Matsubara_XY& _XY, std::shared_ptr<oneloop_Pk_set> _data,
-                         const oneloop_growth_record& _Df_data, std::shared_ptr<initial_filtered_Pk> _Pk_init,
-                         std::shared_ptr<final_filtered_Pk> _Pk_final)
+                         const oneloop_growth_record& _Df_data, const linear_Pk_token& _init_tok,
+                         const boost::optional<linear_Pk_token>& _final_tok)
           : k(_k),
             XY(_XY),
             data(std::move(_data)),
             Df_data(_Df_data),
-            Pk_init(std::move(_Pk_init)),
-            Pk_final(std::move(_Pk_final))
+            init_Pk_tok(_init_tok),
+            has_final_Pk(static_cast<bool>(_final_tok)),
+            final_Pk_tok(_final_tok ? *_final_tok : linear_Pk_token(0))
           {
           }
         
@@ -905,13 +1080,13 @@ namespace MPI_detail
         //! get gf growth factors
         const oneloop_growth_record& get_Df_data() const { return this->Df_data; }
         
-        //! get initial linear power spectrum
-        const initial_filtered_Pk& get_init_linear_Pk() const { return *this->Pk_init; }
+        //! get token for initial linear power spectrum; the spectrum itself is resident on the worker
+        const linear_Pk_token& get_init_Pk_token() const { return this->init_Pk_tok; }
         
-        //! get final linear power spectrum, if provided
-        boost::optional<const final_filtered_Pk&> get_final_linear_Pk() const
+        //! get token for final linear power spectrum, if provided
+        boost::optional<linear_Pk_token> get_final_Pk_token() const
           {
-            if(this->Pk_final) return *this->Pk_final;
+            if(this->has_final_Pk) return this->final_Pk_tok;
             return boost::none;
           }
     
@@ -934,11 +1109,14 @@ namespace MPI_detail
         //! gf growth factors
         oneloop_growth_record Df_data;
     
-        //! initial linear power spectrum
-        std::shared_ptr<initial_filtered_Pk> Pk_init;
+        //! token for initial linear power spectrum
+        linear_Pk_token init_Pk_tok;
+        
+        //! flag indicating whether a final linear power spectrum was provided
+        bool has_final_Pk;
         
-        //! final linear power spectrum, if provided
-        std::shared_ptr<final_filtered_Pk> Pk_final;
+        //! token for final linear power spectrum, if provided
+        linear_Pk_token final_Pk_tok;
     
     
         // enable boost::serialization support, and hence automated packing for transmission over MPI
@@ -951,8 +1129,9 @@ namespace MPI_detail
             ar & XY;
             ar & data;
             ar & Df_data;
-            ar & Pk_init;
-            ar & Pk_final;
+            ar & init_Pk_tok;
+            ar & has_final_Pk;
+            ar & final_Pk_tok;
           }
         
       };
@@ -1024,8 +1203,9 @@ namespace MPI_detail
             z_tok(0),
             growth_tok(0),
             Df_data(),
-            Pk_init(),
-            Pk_final()
+            init_Pk_tok(0),
+            has_final_Pk(false),
+            final_Pk_tok(0)
           {
           }
 
@@ -1033,7 +1213,7 @@ namespace MPI_detail
         new_counterterm(const Mpc_units::energy& _k, const k_token& _ktok, const Matsubara_XY& _XY,
                         const IR_cutoff_token& _IRtok, const UV_cutoff_token& _UVtok, const z_token& _ztok,
                         const growth_params_token& _gtok, const oneloop_growth_record& _Df_data,
-                        std::shared_ptr<initial_filtered_Pk> _Pk_init, std::shared_ptr<final_filtered_Pk> _Pk_final)
+                        const linear_Pk_token& _init_tok, const boost::optional<linear_Pk_token>& _final_tok)
           : k(_k),
             k_tok(_ktok),
             XY(_XY),
@@ -1042,8 +1222,9 @@ namespace MPI_detail
             z_tok(_ztok),
             growth_tok(_gtok),
             Df_data(_Df_data),
-            Pk_init(std::move(_Pk_init)),
-            Pk_final(std::move(_Pk_final))
+            init_Pk_tok(_init_tok),
+            has_final_Pk(static_cast<bool>(_final_tok)),
+            final_Pk_tok(_final_tok ? *_final_tok : linear_Pk_token(0))
           {
           }
 
@@ -1079,13 +1260,13 @@ namespace MPI_detail
         //! get gf growth factors
         const oneloop_growth_record& get_Df_data() const { return this->Df_data; }
 
-        //! get initial linear power spectrum
-        const initial_filtered_Pk& get_init_linear_Pk() const { return *this->Pk_init; }
+        //! get token for initial linear power spectrum; the spectrum itself is resident on the worker
+        const linear_Pk_token& get_init_Pk_token() const { return this->init_Pk_tok; }
 
-        //! get final linear power spectrum, if provided
-        boost::optional<const final_filtered_Pk&> get_final_linear_Pk() const
+        //! get token for final linear power spectrum, if provided
+        boost::optional<linear_Pk_token> get_final_Pk_token() const
           {
-            if(this->Pk_final) return *this->Pk_final;
+            if(this->has_final_Pk) return this->final_Pk_tok;
             return boost::none;
           }
 
@@ -1120,11 +1301,14 @@ namespace MPI_detail
         //! gf growth factors
         oneloop_growth_record Df_data;
 
-        //! initial linear power spectrum
-        std::shared_ptr<initial_filtered_Pk> Pk_init;
+        //! token for initial linear power spectrum
+        linear_Pk_token init_Pk_tok;
+
+        //! flag indicating whether a final linear power spectrum was provided
+        bool has_final_Pk;
 
-        //! final linear power spectrum, if provided
-        std::shared_ptr<final_filtered_Pk> Pk_final;
+        //! token for final linear power spectrum, if provided
+        linear_Pk_token final_Pk_tok;
 
 
         // enable boost::serialization support, and hence automated packing for transmission over MPI
@@ -1141,8 +1325,9 @@ namespace MPI_detail
             ar & z_tok;
             ar & growth_tok;
             ar & Df_data;
-            ar & Pk_init;
-            ar & Pk_final;
+            ar & init_Pk_tok;
+            ar & has_final_Pk;
+            ar & final_Pk_tok;
           }
 
       };
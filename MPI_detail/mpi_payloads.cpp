@@ -30,6 +30,22 @@
 namespace MPI_detail
   {
 
+    namespace mpi_payloads_impl
+      {
+
+        //! extract token for an optional final power spectrum
+        boost::optional<linear_Pk_token> final_Pk_token(const std::shared_ptr<final_filtered_Pk>& Pk)
+          {
+            if(Pk) return Pk->get_token();
+            return boost::none;
+          }
+
+      }   // namespace mpi_payloads_impl
+
+
+    using mpi_payloads_impl::final_Pk_token;
+
+
     new_transfer_integration build_payload(const FRW_model& model, transfer_work_list::const_iterator& t)
       {
         return new_transfer_integration{model, *(*t), t->get_token(), t->get_z_db()};
@@ -38,34 +54,36 @@ namespace MPI_detail
 
     new_loop_momentum_integration build_payload(const FRW_model& model, loop_integral_work_list::const_iterator& t)
       {
-        return new_loop_momentum_integration{model, *(*t), t->get_k_token(), t->get_UV_cutoff(), t->get_UV_token(),
-                                             t->get_IR_cutoff(), t->get_IR_token(), t->get_tree_Pk_db(),
+        return new_loop_momentum_integration{model, t->get_model_token(), *(*t), t->get_k_token(), t->get_UV_cutoff(), t->get_UV_token(),
+                                             t->get_IR_cutoff(), t->get_IR_token(), t->get_tree_Pk_db()->get_token(),
                                              t->get_params_token(), t->get_params()};
       }
 
 
     new_filter_Pk build_payload(const FRW_model& model, filter_Pk_work_list::const_iterator& t)
       {
-        return new_filter_Pk{model, *(*t), t->get_k_token(), t->get_Pk_token(), t->get_linear_Pk(), t->get_params_token(), t->get_params()};
+        return new_filter_Pk{model, t->get_model_token(), *(*t), t->get_k_token(), t->get_Pk_token(), t->get_linear_Pk(),
+                             t->get_params_token(), t->get_params()};
       }
     
     
     new_Matsubara_XY build_payload(const FRW_model&, Matsubara_XY_work_list::const_iterator& t)
       {
-        return new_Matsubara_XY{t->get_IR_resum(), t->get_IR_resum_token(), t->get_linear_Pk(), t->get_params_token(), t->get_params()};
+        return new_Matsubara_XY{t->get_IR_resum(), t->get_IR_resum_token(), t->get_linear_Pk()->get_token(), t->get_params_token(), t->get_params()};
       }
     
     
     new_one_loop_Pk build_payload(const FRW_model&, one_loop_Pk_work_list::const_iterator& t)
       {
-        return new_one_loop_Pk{*(*t), t->get_gf_factors(), t->get_loop_data(), t->get_init_linear_Pk(), t->get_final_linear_Pk()};
+        return new_one_loop_Pk{*(*t), t->get_gf_factors(), t->get_loop_data(),
+                               t->get_init_linear_Pk()->get_token(), final_Pk_token(t->get_final_linear_Pk())};
       }
 
     
     new_multipole_Pk build_payload(const FRW_model&, multipole_Pk_work_list::const_iterator& t)
       {
         return new_multipole_Pk{*(*t), t->get_Matsubara_XY(), t->get_Pk_data(), t->get_Df_data(),
-                                t->get_init_linear_Pk(), t->get_final_linear_Pk()};
+                                t->get_init_linear_Pk()->get_token(), final_Pk_token(t->get_final_linear_Pk())};
       }
 
 
@@ -73,7 +91,62 @@ namespace MPI_detail
       {
         return new_counterterm{*(*t), t->get_k_token(), t->get_Matsubara_XY(), t->get_IR_cutoff_token(), t->get_UV_cutoff_token(),
                                t->get_z_token(), t->get_growth_params_token(), t->get_Df_data(),
-                               t->get_init_linear_Pk(), t->get_final_linear_Pk()};
+                               t->get_init_linear_Pk()->get_token(), final_Pk_token(t->get_final_linear_Pk())};
+      }
+
+
+    void filtered_Pk_set::add(const std::shared_ptr<initial_filtered_Pk>& Pk)
+      {
+        if(Pk) this->initial.insert(std::make_pair(Pk->get_token().get_id(), Pk));
+      }
+
+
+    void filtered_Pk_set::add(const std::shared_ptr<final_filtered_Pk>& Pk)
+      {
+        if(Pk) this->final.insert(std::make_pair(Pk->get_token().get_id(), Pk));
+      }
+
+
+    void collect_filtered_Pk(const transfer_work_record& rec, filtered_Pk_set& Pks)
+      {
+      }
+
+
+    void collect_filtered_Pk(const filter_Pk_work_record& rec, filtered_Pk_set& Pks)
+      {
+      }
+
+
+    void collect_filtered_Pk(const loop_integral_work_record& rec, filtered_Pk_set& Pks)
+      {
+        Pks.add(rec.get_tree_Pk_db());
+      }
+
+
+    void collect_filtered_Pk(const Matsubara_XY_work_record& rec, filtered_Pk_set& Pks)
+      {
+        Pks.add(rec.get_linear_Pk());
+      }
+
+
+    void collect_filtered_Pk(const one_loop_Pk_work_record& rec, filtered_Pk_set& Pks)
+      {
+        Pks.add(rec.get_init_linear_Pk());
+        Pks.add(rec.get_final_linear_Pk());
+      }
+
+
+    void collect_filtered_Pk(const multipole_Pk_work_record& rec, filtered_Pk_set& Pks)
+      {
+        Pks.add(rec.get_init_linear_Pk());
+        Pks.add(rec.get_final_linear_Pk());
+      }
+
+
+    void collect_filtered_Pk(const counterterm_work_record& rec, filtered_Pk_set& Pks)
+      {
+        Pks.add(rec.get_init_linear_Pk());
+        Pks.add(rec.get_final_linear_Pk());
       }
 
-  }
+  }   // namespace MPI_detail
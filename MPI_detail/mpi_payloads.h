@@ -28,6 +28,8 @@
 
 
 #include <list>
+#include <map>
+#include <memory>
 
 #include "cosmology/types.h"
 
@@ -59,6 +61,69 @@ namespace MPI_detail
     new_counterterm build_payload(const FRW_model&, counterterm_work_list::const_iterator& t);
     
     
+    //! set of filtered power spectra referenced by a work list, indexed by the id of their linear_Pk_token;
+    //! used by the master to decide which spectra should be made resident on the workers
+    class filtered_Pk_set
+      {
+        
+      public:
+        
+        typedef std::map< unsigned int, std::shared_ptr<initial_filtered_Pk> > initial_map_type;
+        typedef std::map< unsigned int, std::shared_ptr<final_filtered_Pk> > final_map_type;
+        
+        
+        // INTERFACE
+        
+      public:
+        
+        //! add an initial filtered power spectrum; empty pointers are ignored
+        void add(const std::shared_ptr<initial_filtered_Pk>& Pk);
+        
+        //! add a final filtered power spectrum; empty pointers are ignored
+        void add(const std::shared_ptr<final_filtered_Pk>& Pk);
+        
+        //! get initial power spectra
+        const initial_map_type& get_initial() const { return this->initial; }
+        
+        //! get final power spectra
+        const final_map_type& get_final() const { return this->final; }
+        
+        
+        // INTERNAL DATA
+        
+      private:
+        
+        //! initial filtered power spectra
+        initial_map_type initial;
+        
+        //! final filtered power spectra
+        final_map_type final;
+        
+      };
+    
+    
+    //! collect filtered power spectra referenced by a transfer-function work record (there are none)
+    void collect_filtered_Pk(const transfer_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a filtering work record (there are none)
+    void collect_filtered_Pk(const filter_Pk_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a loop integral work record
+    void collect_filtered_Pk(const loop_integral_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a Matsubara X & Y work record
+    void collect_filtered_Pk(const Matsubara_XY_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a one-loop P(k) work record
+    void collect_filtered_Pk(const one_loop_Pk_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a multipole P(k) work record
+    void collect_filtered_Pk(const multipole_Pk_work_record& rec, filtered_Pk_set& Pks);
+    
+    //! collect filtered power spectra referenced by a counterterm work record
+    void collect_filtered_Pk(const counterterm_work_record& rec, filtered_Pk_set& Pks);
+    
+    
   }   // namespace MPI_detail
 
 
@@ -46,8 +46,12 @@ namespace MPI_detail
         typedef new_transfer_integration   outgoing_payload_type;
         typedef transfer_integration_ready incoming_payload_type;
 
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
+
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_TRANSFER_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_TRANSFER_INTEGRATION); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_TRANSFER_INTEGRATION_READY); }
       };
     
     
@@ -58,9 +62,13 @@ namespace MPI_detail
     
         typedef new_filter_Pk   outgoing_payload_type;
         typedef filter_Pk_ready incoming_payload_type;
+
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
     
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_FILTER_PK_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_FILTER_PK); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_FILTER_PK_READY); }
       };
 
     
@@ -72,8 +80,12 @@ namespace MPI_detail
         typedef new_loop_momentum_integration   outgoing_payload_type;
         typedef loop_momentum_integration_ready incoming_payload_type;
 
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
+
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_LOOP_INTEGRAL_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_LOOP_INTEGRATION); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_LOOP_INTEGRATION_READY); }
       };
     
     
@@ -84,9 +96,13 @@ namespace MPI_detail
     
         typedef new_Matsubara_XY   outgoing_payload_type;
         typedef Matsubara_XY_ready incoming_payload_type;
+
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
         
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_MATSUBARA_XY_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_MATSUBARA_XY); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_MATSUBARA_XY_READY); }
       };
     
     
@@ -94,9 +110,13 @@ namespace MPI_detail
       {
         typedef new_one_loop_Pk   outgoing_payload_type;
         typedef one_loop_Pk_ready incoming_payload_type;
+
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
         
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_ONE_LOOP_PK_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_ONE_LOOP_PK); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_ONE_LOOP_PK_READY); }
       };
 
     
@@ -107,9 +127,13 @@ namespace MPI_detail
     
         typedef new_multipole_Pk   outgoing_payload_type;
         typedef multipole_Pk_ready incoming_payload_type;
+
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
         
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_MULTIPOLE_PK_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_MULTIPOLE_PK); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_MULTIPOLE_PK_READY); }
       };
 
 
@@ -121,8 +145,12 @@ namespace MPI_detail
         typedef new_counterterm   outgoing_payload_type;
         typedef counterterm_ready incoming_payload_type;
 
+        typedef payload_batch<outgoing_payload_type> outgoing_batch_type;
+        typedef payload_batch<incoming_payload_type> incoming_batch_type;
+
         static constexpr unsigned int new_task_message() { return(MESSAGE_NEW_COUNTERTERM_TASK); }
         static constexpr unsigned int new_item_message() { return(MESSAGE_NEW_COUNTERTERM); }
+        static constexpr unsigned int product_message()  { return(MESSAGE_COUNTERTERM_READY); }
       };
 
   }   // namespace MPI_detail
@@ -25,12 +25,18 @@
 
 #include "argument_cache.h"
 
+#include "defaults.h"
+
 
 argument_cache::argument_cache()
   : verbose(false),
     colour_output(true),
     EdS_mode(false),
-    network_mode(false)
+    k_tolerance(LSSEFT_DEFAULT_K_GRID_TOLERANCE),
+    network_mode(false),
+    prefetch_depth(LSSEFT_DEFAULT_PREFETCH_DEPTH),
+    worker_threads(LSSEFT_DEFAULT_WORKER_THREADS),
+    shared_memory(false)
   {
     // no default database
     database.clear();
@@ -35,6 +35,7 @@
 #include "boost/serialization/serialization.hpp"
 #include "boost/serialization/string.hpp"
 #include "boost/serialization/list.hpp"
+#include "boost/serialization/split_member.hpp"
 
 
 class argument_cache
@@ -120,6 +121,35 @@ class argument_cache
     
     //! set EdS mode
     void set_EdS_mode(bool m) { this->EdS_mode = m; }
+    
+    //! get relative tolerance on interpolation of loop integrals between sampled wavenumbers
+    double get_k_tolerance() const { return this->k_tolerance; }
+    
+    //! set tolerance on interpolation of loop integrals; zero disables refinement of the wavenumber grid
+    void set_k_tolerance(double t) { this->k_tolerance = (t > 0.0 ? t : 0.0); }
+    
+    
+    // INTERFACE -- SCHEDULING
+    
+  public:
+    
+    //! get number of batches which may be queued on each worker
+    unsigned int get_prefetch_depth() const { return this->prefetch_depth; }
+    
+    //! set prefetch depth; must be at least 1
+    void set_prefetch_depth(unsigned int d) { this->prefetch_depth = (d > 0 ? d : 1); }
+    
+    //! get number of threads per worker process
+    unsigned int get_worker_threads() const { return this->worker_threads; }
+    
+    //! set number of threads per worker process; must be at least 1
+    void set_worker_threads(unsigned int t) { this->worker_threads = (t > 0 ? t : 1); }
+    
+    //! query whether work should run in threads of the master process rather than on MPI workers
+    bool use_shared_memory() const { return this->shared_memory; }
+    
+    //! set shared-memory mode
+    void set_shared_memory(bool m) { this->shared_memory = m; }
 
 
     // INTERNAL DATA
@@ -135,8 +165,20 @@ class argument_cache
     //! use Einstein-de Sitter approximations to growth functions?
     bool EdS_mode;
     
+    //! relative tolerance on interpolation of loop integrals between sampled wavenumbers
+    double k_tolerance;
+    
     //! should we use network mode, ie. disable write-ahead log?
     bool network_mode;
+    
+    //! number of batches which may be queued on each worker
+    unsigned int prefetch_depth;
+    
+    //! number of threads per worker process
+    unsigned int worker_threads;
+    
+    //! run work in threads of the master process, without MPI workers?
+    bool shared_memory;
 
     //! database path
     boost::filesystem::path database;
@@ -152,16 +194,50 @@ class argument_cache
     friend class boost::serialization::access;
 
     template <typename Archive>
-    void serialize(Archive& ar, unsigned int version)
+    void save(Archive& ar, unsigned int version) const
       {
-        ar & verbose;
-        ar & colour_output;
-        ar & EdS_mode;
-        ar & network_mode;
-        ar & database;
-        ar & init_linear_Pk;
-        ar & final_linear_Pk;
+        ar << verbose;
+        ar << colour_output;
+        ar << EdS_mode;
+        ar << k_tolerance;
+        ar << network_mode;
+        ar << prefetch_depth;
+        ar << worker_threads;
+        ar << shared_memory;
+        
+        // boost::filesystem::path has no serialization support, so pack paths as strings
+        std::string db = database.string();
+        std::string init = init_linear_Pk.string();
+        std::string final_Pk = final_linear_Pk.string();
+        ar << db;
+        ar << init;
+        ar << final_Pk;
       }
+    
+    template <typename Archive>
+    void load(Archive& ar, unsigned int version)
+      {
+        ar >> verbose;
+        ar >> colour_output;
+        ar >> EdS_mode;
+        ar >> k_tolerance;
+        ar >> network_mode;
+        ar >> prefetch_depth;
+        ar >> worker_threads;
+        ar >> shared_memory;
+        
+        std::string db;
+        std::string init;
+        std::string final_Pk;
+        ar >> db;
+        ar >> init;
+        ar >> final_Pk;
+        database = db;
+        init_linear_Pk = init;
+        final_linear_Pk = final_Pk;
+      }
+    
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
 
   };
 
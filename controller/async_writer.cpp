@@ -0,0 +1,215 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <chrono>
+
+#include "async_writer.h"
+
+
+async_writer::async_writer(unsigned int c, idle_function i, boost::timer::nanosecond_type t)
+  : capacity(c > 0 ? c : 1),
+    idle(std::move(i)),
+    idle_interval(t),
+    busy(false),
+    dirty(false),
+    shutdown(false),
+    in_flight(0),
+    write_time(0),
+    stall_time(0)
+  {
+    // start writer thread only once all state is initialized
+    this->writer = std::thread(&async_writer::writer_loop, this);
+  }
+
+
+async_writer::~async_writer()
+  {
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->shutdown = true;
+    }
+    this->wake.notify_all();
+
+    this->writer.join();
+  }
+
+
+void async_writer::push(write_function w, completion_function c)
+  {
+    std::deque<completion_function> ready;
+
+    {
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->check_failure();
+
+      if(this->queue.size() >= this->capacity)
+        {
+          boost::timer::cpu_timer stall_timer;
+          this->done.wait(guard, [&]() -> bool { return this->queue.size() < this->capacity || this->failure; });
+          this->stall_time += stall_timer.elapsed().wall;
+          this->check_failure();
+        }
+
+      this->queue.push_back(std::move(w));
+      this->completions.push_back(std::move(c));
+      ++this->in_flight;
+
+      ready.swap(this->finished);
+    }
+    this->wake.notify_one();
+
+    this->run_completions(ready);
+  }
+
+
+void async_writer::poll()
+  {
+    std::deque<completion_function> ready;
+
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->check_failure();
+      ready.swap(this->finished);
+    }
+
+    this->run_completions(ready);
+  }
+
+
+void async_writer::flush()
+  {
+    std::deque<completion_function> ready;
+
+    {
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->done.wait(guard, [&]() -> bool { return (this->queue.empty() && !this->busy) || this->failure; });
+      this->check_failure();
+      ready.swap(this->finished);
+
+      // the caller may now use the database directly, so the idle function must not run concurrently
+      this->dirty = false;
+    }
+
+    this->run_completions(ready);
+  }
+
+
+boost::timer::nanosecond_type async_writer::get_write_time()
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    return this->write_time;
+  }
+
+
+void async_writer::run_completions(std::deque<completion_function>& ready)
+  {
+    for(completion_function& c : ready)
+      {
+        --this->in_flight;
+        if(c) c();
+      }
+  }
+
+
+void async_writer::check_failure()
+  {
+    if(this->failure) std::rethrow_exception(this->failure);
+  }
+
+
+void async_writer::writer_loop()
+  {
+    auto ready = [&]() -> bool { return this->shutdown || (!this->queue.empty() && !this->failure); };
+
+    while(true)
+      {
+        write_function w;
+        bool idling = false;
+
+        {
+          std::unique_lock<std::mutex> guard(this->lock);
+
+          if(this->idle && this->dirty && !this->failure)
+            {
+              // wait at most one interval for the next write; if none arrives, run the idle function,
+              // unless a flush has intervened in the meantime
+              if(!this->wake.wait_for(guard, std::chrono::nanoseconds(this->idle_interval), ready))
+                {
+                  if(!this->dirty) continue;
+                  idling = true;
+                }
+            }
+          else
+            {
+              this->wake.wait(guard, ready);
+            }
+
+          if(this->shutdown) return;
+
+          if(!idling)
+            {
+              w = std::move(this->queue.front());
+              this->queue.pop_front();
+            }
+
+          this->dirty = false;
+          this->busy = true;
+        }
+
+        // the queue has space again
+        if(!idling) this->done.notify_all();
+
+        boost::timer::cpu_timer timer;
+        std::exception_ptr e;
+
+        try
+          {
+            if(idling) this->idle();
+            else       w();
+          }
+        catch(...)
+          {
+            e = std::current_exception();
+          }
+
+        {
+          std::lock_guard<std::mutex> guard(this->lock);
+          this->write_time += timer.elapsed().wall;
+          this->busy = false;
+
+          if(e)
+            {
+              this->failure = e;
+            }
+          else if(!idling)
+            {
+              this->finished.push_back(std::move(this->completions.front()));
+              this->completions.pop_front();
+              this->dirty = true;
+            }
+        }
+
+        this->done.notify_all();
+      }
+  }
@@ -0,0 +1,169 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ASYNC_WRITER_H
+#define LSSEFT_ASYNC_WRITER_H
+
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+
+#include "boost/timer/timer.hpp"
+
+
+//! performs database writes on a dedicated thread, so the master's MPI loop can keep receiving results
+//! and dispatching work while SQLite is busy. Writes are queued in order; the queue is bounded, and push()
+//! blocks while it is full so that a slow database throttles the rate at which results are accepted.
+//! Each write may carry a completion function, which is run on the master thread by poll() or flush()
+//! once the write has finished; this is used to release dependent work only after its inputs are stored.
+//! An optional idle function is run on the writer thread when no write has arrived for a given interval
+//! since the last one; this is used to commit samples which would otherwise wait for the next write
+class async_writer
+  {
+
+    // TYPEDEFS
+
+  public:
+
+    typedef std::function<void()> write_function;
+
+    typedef std::function<void()> completion_function;
+
+    typedef std::function<void()> idle_function;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor; at most 'capacity' writes may be queued. If an idle function is supplied, it is run
+    //! once whenever the queue has been empty for 'interval' nanoseconds following a write
+    async_writer(unsigned int capacity, idle_function idle = nullptr, boost::timer::nanosecond_type interval = 0);
+
+    //! destructor abandons any queued writes and joins the writer thread;
+    //! call flush() first if they should be kept
+    ~async_writer();
+
+
+    // INTERFACE
+
+  public:
+
+    //! queue a write, blocking while the queue is full; rethrows any exception raised by an earlier write
+    void push(write_function w, completion_function c = nullptr);
+
+    //! run completion functions for writes which have finished; rethrows any exception raised by a write
+    void poll();
+
+    //! wait for all queued writes to finish, then run their completion functions; the idle function
+    //! is not run again until a further write has been performed
+    void flush();
+
+    //! get number of writes whose completion functions have not yet run
+    unsigned int pending() const { return this->in_flight; }
+
+    //! get wall time spent by the writer thread performing writes
+    boost::timer::nanosecond_type get_write_time();
+
+    //! get wall time spent by the caller blocked on a full queue
+    boost::timer::nanosecond_type get_stall_time() const { return this->stall_time; }
+
+
+    // INTERNAL API
+
+  private:
+
+    //! main loop for writer thread
+    void writer_loop();
+
+    //! run completion functions already collected; must be called without holding the lock
+    void run_completions(std::deque<completion_function>& ready);
+
+    //! rethrow any exception raised by a write; lock must be held
+    void check_failure();
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! maximum number of queued writes
+    const unsigned int capacity;
+
+    //! function run when the writer has been idle for the given interval, if any
+    const idle_function idle;
+
+    //! interval after the last write before the idle function is run
+    const boost::timer::nanosecond_type idle_interval;
+
+    //! writer thread
+    std::thread writer;
+
+    //! lock protecting queues and state
+    std::mutex lock;
+
+    //! signalled when a write is queued, or on shutdown
+    std::condition_variable wake;
+
+    //! signalled when a write has finished
+    std::condition_variable done;
+
+    //! writes waiting to be performed
+    std::deque<write_function> queue;
+
+    //! completion functions for queued writes, in the same order
+    std::deque<completion_function> completions;
+
+    //! completion functions for finished writes, waiting to be run on the caller's thread
+    std::deque<completion_function> finished;
+
+    //! true while the writer thread is performing a write, or running the idle function
+    bool busy;
+
+    //! set when a write has been performed since the idle function last ran, or since the last flush
+    bool dirty;
+
+    //! set when the writer is being destroyed
+    bool shutdown;
+
+    //! first exception raised by a write, if any; no further writes are performed after a failure
+    std::exception_ptr failure;
+
+    //! number of writes pushed whose completion functions have not yet run; only accessed by the caller's thread
+    unsigned int in_flight;
+
+    //! wall time spent performing writes
+    boost::timer::nanosecond_type write_time;
+
+    //! wall time spent blocked on a full queue
+    boost::timer::nanosecond_type stall_time;
+
+  };
+
+
+#endif //LSSEFT_ASYNC_WRITER_H
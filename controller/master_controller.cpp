@@ -26,10 +26,17 @@
 
 #include "core.h"
 
+#include <queue>
+#include <functional>
+#include <algorithm>
+
 #include "master_controller.h"
 
 #include "utilities/formatter.h"
 
+#include "defaults.h"
+#include "exceptions.h"
+
 #include "localizations/messages.h"
 
 #include "boost/program_options.hpp"
@@ -41,7 +48,8 @@ master_controller::master_controller(boost::mpi::environment& me, boost::mpi::co
     mpi_world(mw),
     arg_cache(ac),
     local_env(),
-    err_handler(arg_cache, local_env)
+    err_handler(arg_cache, local_env),
+    executor(err_handler)
   {
   }
 
@@ -61,7 +69,11 @@ void master_controller::process_arguments(int argc, char* argv[])
       (LSSEFT_SWITCH_DATABASE, boost::program_options::value<std::string>(), LSSEFT_HELP_DATABASE)
       (LSSEFT_SWITCH_INITIAL_POWERSPEC, boost::program_options::value<std::string>(), LSSEFT_HELP_INITIAL_POWERSPEC)
       (LSSEFT_SWITCH_FINAL_POWERSPEC, boost::program_options::value<std::string>(), LSSEFT_HELP_FINAL_POWERSPEC)
-      (LSSEFT_SWITCH_EDS_MODE, LSSEFT_HELP_EDS_MODE);
+      (LSSEFT_SWITCH_EDS_MODE, LSSEFT_HELP_EDS_MODE)
+      (LSSEFT_SWITCH_K_TOLERANCE, boost::program_options::value<double>(), LSSEFT_HELP_K_TOLERANCE)
+      (LSSEFT_SWITCH_PREFETCH, boost::program_options::value<unsigned int>(), LSSEFT_HELP_PREFETCH)
+      (LSSEFT_SWITCH_THREADS, boost::program_options::value<unsigned int>(), LSSEFT_HELP_THREADS)
+      (LSSEFT_SWITCH_SHARED_MEMORY, LSSEFT_HELP_SHARED_MEMORY);
 
     boost::program_options::options_description hidden("Hidden options");
     hidden.add_options()
@@ -111,6 +123,23 @@ void master_controller::process_arguments(int argc, char* argv[])
       }
     
     if(option_map.count(LSSEFT_SWITCH_EDS_MODE)) this->arg_cache.set_EdS_mode(true);
+    
+    if(option_map.count(LSSEFT_SWITCH_K_TOLERANCE))
+      {
+        this->arg_cache.set_k_tolerance(option_map[LSSEFT_SWITCH_K_TOLERANCE].as<double>());
+      }
+    
+    if(option_map.count(LSSEFT_SWITCH_PREFETCH))
+      {
+        this->arg_cache.set_prefetch_depth(option_map[LSSEFT_SWITCH_PREFETCH].as<unsigned int>());
+      }
+    
+    if(option_map.count(LSSEFT_SWITCH_THREADS_LONG))
+      {
+        this->arg_cache.set_worker_threads(option_map[LSSEFT_SWITCH_THREADS_LONG].as<unsigned int>());
+      }
+    
+    if(option_map.count(LSSEFT_SWITCH_SHARED_MEMORY)) this->arg_cache.set_shared_memory(true);
   }
 
 
@@ -141,7 +170,9 @@ std::unique_ptr<scheduler> master_controller::set_up_workers(unsigned int tag)
     boost::mpi::wait_all(requests.begin(), requests.end());
 
     // create scheduler object
-    std::unique_ptr<scheduler> sch = std::make_unique<scheduler>(this->mpi_world.size() - 1);
+    std::unique_ptr<scheduler> sch = std::make_unique<scheduler>(this->mpi_world.size() - 1,
+                                                                 this->arg_cache.get_prefetch_depth(),
+                                                                 this->arg_cache.get_worker_threads());
 
     // wait for messages from workers reporting that they are correctly set up
     while(!sch->is_ready())
@@ -177,6 +208,287 @@ void master_controller::close_down_workers()
   }
 
 
+thread_pool& master_controller::get_thread_pool()
+  {
+    unsigned int threads = this->arg_cache.get_worker_threads();
+    if(!this->pool || this->pool->size() != threads) this->pool = std::make_unique<thread_pool>(threads);
+    
+    return *this->pool;
+  }
+
+
+unsigned int master_controller::get_local_batch_size()
+  {
+    return this->get_thread_pool().size() * LSSEFT_DEFAULT_SHARED_MEMORY_ITEMS_PER_THREAD;
+  }
+
+
+unsigned int master_controller::distribute_filtered_Pk(const MPI_detail::filtered_Pk_set& Pks)
+  {
+    if(this->use_shared_memory())
+      {
+        this->executor.add_filtered_Pk(Pks);
+        return 0;
+      }
+    
+    unsigned int broadcasts = 0;
+    
+    for(const auto& t : Pks.get_initial())
+      {
+        if(this->broadcast_filtered_Pk(t.second, this->resident_initial_Pk, MPI_detail::MESSAGE_CACHE_INITIAL_FILTERED_PK))
+          ++broadcasts;
+      }
+    
+    for(const auto& t : Pks.get_final())
+      {
+        if(this->broadcast_filtered_Pk(t.second, this->resident_final_Pk, MPI_detail::MESSAGE_CACHE_FINAL_FILTERED_PK))
+          ++broadcasts;
+      }
+    
+    return broadcasts;
+  }
+
+
+void master_controller::scatter(pipeline& pipe, data_manager& dmgr)
+  {
+    boost::timer::cpu_timer timer;              // total CPU time
+    
+    if(this->use_shared_memory())
+      {
+        this->scatter_local(pipe, dmgr);
+        return;
+      }
+    
+    // nothing to do if no stage has any initial work; later stages can only be fed by earlier ones
+    if(pipe.ready() == 0) return;
+    
+    // ask data manager to prepare for new writes
+    boost::timer::cpu_timer pre_timer;          // time spent doing preparation
+    for(auto& stage : pipe.get_stages())
+      {
+        stage->setup_write(dmgr);
+      }
+    pre_timer.stop();
+    
+    // make sure all power spectra needed by the pipeline, including those needed by items
+    // released while it runs, are resident on the workers before they enter their task loop
+    boost::timer::cpu_timer bcast_timer;        // time spent broadcasting power spectra
+    MPI_detail::filtered_Pk_set Pks;
+    for(const auto& stage : pipe.get_stages())
+      {
+        stage->collect_filtered_Pk(Pks);
+      }
+    unsigned int broadcasts = this->distribute_filtered_Pk(Pks);
+    bcast_timer.stop();
+    
+    // instruct slave processes to await pipelined tasks
+    std::unique_ptr<scheduler> sch = this->set_up_workers(MPI_detail::MESSAGE_NEW_PIPELINE_TASK);
+    
+    // results are written on a separate thread, so this loop can continue to hand out work while SQLite is busy;
+    // if no results arrive for a while, the writer commits those it already holds
+    async_writer writer(LSSEFT_DEFAULT_WRITE_QUEUE_DEPTH, [&dmgr]() -> void { dmgr.commit_stores(); },
+                        LSSEFT_DEFAULT_GROUP_COMMIT_INTERVAL);
+    
+    bool sent_closedown = false;
+    unsigned int batches = 0;
+    
+    while(!sch->all_inactive())
+      {
+        // release downstream work for any products which have now been written
+        writer.poll();
+        
+        // work is exhausted only when nothing is ready and nothing is in flight which could release more,
+        // either on a worker or waiting to be written
+        if(!sent_closedown && pipe.ready() == 0 && pipe.outstanding() == 0 && writer.pending() == 0)
+          {
+            sent_closedown = true;
+            this->close_down_workers();
+          }
+        
+        // check whether any workers are waiting for assignments
+        if(pipe.ready() > 0 && sch->is_assignable())
+          {
+            std::vector<unsigned int> unassigned_list = sch->make_assignment();
+            std::vector<boost::mpi::request> requests;
+            
+            for(std::vector<unsigned int>::const_iterator t = unassigned_list.begin(); t != unassigned_list.end(); ++t)
+              {
+                pipeline_stage* stage = pipe.next_ready();
+                if(stage == nullptr) break;
+                
+                unsigned int N = sch->get_batch_size(pipe.ready());
+                unsigned int sent = stage->dispatch(this->mpi_world, this->worker_rank(*t), N, requests);
+                
+                sch->mark_assigned(*t, sent);
+                ++batches;
+              }
+            
+            // wait for all messages to be received
+            boost::mpi::wait_all(requests.begin(), requests.end());
+          }
+        
+        // check whether any messages are waiting in the queue
+        boost::optional<boost::mpi::status> stat = this->mpi_world.iprobe();
+        
+        while(stat) // consume messages until no more are available
+          {
+            if(stat->tag() == MPI_detail::MESSAGE_END_OF_WORK_ACK)
+              {
+                this->mpi_world.recv(stat->source(), MPI_detail::MESSAGE_END_OF_WORK_ACK);
+                sch->mark_inactive(this->worker_number(stat->source()));
+              }
+            else
+              {
+                pipeline_stage* stage = pipe.find_stage(stat->tag());
+                assert(stage != nullptr);
+                
+                boost::timer::nanosecond_type compute_time = stage->receive(this->mpi_world, stat->source(), writer, dmgr);
+                sch->mark_unassigned(this->worker_number(stat->source()), compute_time);
+              }
+            
+            stat = this->mpi_world.iprobe();
+          }
+      }
+    
+    // wait for outstanding writes before tidying up
+    boost::timer::cpu_timer flush_timer;    // time spent waiting for the writer to catch up
+    writer.flush();
+    flush_timer.stop();
+    
+    boost::timer::cpu_timer post_timer;     // time spent tidying up the database after a write
+    for(auto& stage : pipe.get_stages())
+      {
+        stage->finalize_write(dmgr);
+      }
+    post_timer.stop();
+    
+    timer.stop();
+    std::ostringstream msg;
+    msg << "completed pipeline in time " << format_time(timer.elapsed().wall) << " [";
+    bool first = true;
+    for(const auto& stage : pipe.get_stages())
+      {
+        if(!first) msg << ", ";
+        msg << stage->get_name() << " " << stage->size() << " items";
+        first = false;
+      }
+    msg << " in " << batches << " batches, final batch size " << sch->get_current_batch_size() << "]"
+        << " ["
+        << "database performance: prepare " << format_time(pre_timer.elapsed().wall) << ", "
+        << "writes " << format_time(writer.get_write_time()) << ", "
+        << "stalled " << format_time(writer.get_stall_time() + flush_timer.elapsed().wall) << ", "
+        << "cleanup " << format_time(post_timer.elapsed().wall)
+        << "]";
+    if(broadcasts > 0)
+      {
+        msg << " [broadcast " << broadcasts << " power spectra in time " << format_time(bcast_timer.elapsed().wall) << "]";
+      }
+    this->err_handler.info(msg.str());
+  }
+
+
+void master_controller::scatter_local(pipeline& pipe, data_manager& dmgr)
+  {
+    boost::timer::cpu_timer timer;              // total CPU time
+    boost::timer::cpu_timer write_timer;        // time spent writing to the database
+    write_timer.stop();
+    
+    if(pipe.ready() == 0) return;
+    
+    // ask data manager to prepare for new writes
+    boost::timer::cpu_timer pre_timer;          // time spent doing preparation
+    for(auto& stage : pipe.get_stages())
+      {
+        stage->setup_write(dmgr);
+      }
+    pre_timer.stop();
+    
+    // power spectra are shared with the executor directly
+    MPI_detail::filtered_Pk_set Pks;
+    for(const auto& stage : pipe.get_stages())
+      {
+        stage->collect_filtered_Pk(Pks);
+      }
+    this->distribute_filtered_Pk(Pks);
+    
+    thread_pool& pool = this->get_thread_pool();
+    unsigned int N = this->get_local_batch_size();
+    unsigned int batches = 0;
+    
+    // each batch is stored before the next is chosen, so items it releases are immediately eligible
+    while(pipe.ready() > 0)
+      {
+        pipeline_stage* stage = pipe.next_ready();
+        stage->execute(this->executor, pool, N, dmgr, write_timer);
+        ++batches;
+      }
+    this->executor.end_of_work();
+    
+    boost::timer::cpu_timer post_timer;     // time spent tidying up the database after a write
+    for(auto& stage : pipe.get_stages())
+      {
+        stage->finalize_write(dmgr);
+      }
+    post_timer.stop();
+    
+    timer.stop();
+    std::ostringstream msg;
+    msg << "completed pipeline in time " << format_time(timer.elapsed().wall) << " [";
+    bool first = true;
+    for(const auto& stage : pipe.get_stages())
+      {
+        if(!first) msg << ", ";
+        msg << stage->get_name() << " " << stage->size() << " items";
+        first = false;
+      }
+    msg << " in " << batches << " batches on " << pool.size() << " threads, shared-memory mode]"
+        << " ["
+        << "database performance: prepare " << format_time(pre_timer.elapsed().wall) << ", "
+        << "writes " << format_time(write_timer.elapsed().wall) << ", "
+        << "cleanup " << format_time(post_timer.elapsed().wall)
+        << "]";
+    this->err_handler.info(msg.str());
+  }
+
+
+void master_controller::report_predicted_makespan(const loop_integral_work_list& work)
+  {
+    // in shared-memory mode each thread of the pool acts as a worker
+    unsigned int N = this->use_shared_memory() ? this->get_thread_pool().size()
+                                               : static_cast<unsigned int>(this->mpi_world.size() - 1);
+    
+    // simulate longest-first assignment; the work list is already ordered by decreasing predicted time,
+    // so assign each item to whichever worker becomes free first
+    std::priority_queue< boost::timer::nanosecond_type, std::vector<boost::timer::nanosecond_type>,
+                         std::greater<boost::timer::nanosecond_type> > workers;
+    for(unsigned int i = 0; i < N; ++i)
+      {
+        workers.push(0);
+      }
+    
+    boost::timer::nanosecond_type total = 0;
+    boost::timer::nanosecond_type makespan = 0;
+    for(const auto& item : work)
+      {
+        // no prediction available for this work list
+        if(!item.get_predicted_time()) return;
+        
+        boost::timer::nanosecond_type t = *item.get_predicted_time();
+        boost::timer::nanosecond_type free = workers.top();
+        workers.pop();
+        workers.push(free + t);
+        
+        total += t;
+        makespan = std::max(makespan, free + t);
+      }
+    
+    std::ostringstream msg;
+    msg << "predicted makespan " << format_time(makespan) << " for " << format_time(total) << " of integration on "
+        << N << (this->use_shared_memory() ? " threads" : " workers");
+    this->err_handler.info(msg.str());
+  }
+
+
 void master_controller::integrate_loop_growth(const FRW_model& model, const FRW_model_token& token, z_database& z_db, data_manager& dmgr,
                                               const growth_params_token& params_tok, const growth_params& params)
   {
@@ -188,3 +500,40 @@ void master_controller::integrate_loop_growth(const FRW_model& model, const FRW_
     
     dmgr.finalize_growth_write();
   }
+
+
+void master_controller::refine_loop_k_db(const FRW_model& model, const FRW_model_token& token, data_manager& dmgr,
+                                         const growth_params_token& growth_tok, z_database& z_db,
+                                         std::unique_ptr<k_database>& k_db, IR_cutoff_database& IR_db,
+                                         UV_cutoff_database& UV_db, std::shared_ptr<initial_filtered_Pk>& Pk_init,
+                                         std::shared_ptr<final_filtered_Pk>& Pk_final,
+                                         const loop_integral_params_token& params_tok, const loop_integral_params& params)
+  {
+    double tol = this->arg_cache.get_k_tolerance();
+    if(tol <= 0.0) return;
+    
+    for(unsigned int pass = 0; pass < LSSEFT_DEFAULT_K_GRID_REFINEMENTS; ++pass)
+      {
+        // compute any loop integrals missing from the current grid
+        std::unique_ptr<loop_integral_work_list> work =
+          dmgr.build_loop_momentum_work_list(token, *k_db, IR_db, UV_db, Pk_init, params_tok, params);
+        if(work) this->scatter(model, token, *work, dmgr);
+        
+        // combine them into one-loop power spectra, which are what the tolerance applies to
+        std::unique_ptr<one_loop_Pk_work_list> Pk_work =
+          dmgr.build_one_loop_Pk_work_list(token, growth_tok, params_tok, z_db, *k_db, IR_db, UV_db,
+                                           Pk_init, Pk_final);
+        if(Pk_work) this->scatter(model, token, *Pk_work, dmgr);
+        
+        // insert wavenumbers wherever interpolation between the samples does not meet the tolerance
+        std::unique_ptr<k_database> refined =
+          dmgr.refine_loop_k_db(token, growth_tok, params_tok, z_db, *k_db, IR_db, UV_db, Pk_init, Pk_final, tol);
+        if(!refined) return;
+        
+        k_db = std::move(refined);
+      }
+    
+    std::ostringstream msg;
+    msg << ERROR_K_GRID_UNCONVERGED_A << " " << LSSEFT_DEFAULT_K_GRID_REFINEMENTS << " " << ERROR_K_GRID_UNCONVERGED_B;
+    throw runtime_exception(exception_type::runtime_error, msg.str());
+  }
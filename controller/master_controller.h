@@ -28,10 +28,15 @@
 
 
 #include <memory>
+#include <set>
 
 #include "argument_cache.h"
 #include "local_environment.h"
 #include "scheduler.h"
+#include "pipeline.h"
+#include "thread_pool.h"
+#include "work_executor.h"
+#include "async_writer.h"
 
 #include "database/data_manager.h"
 #include "database/tokens.h"
@@ -41,6 +46,7 @@
 #include "cosmology/oneloop_growth_integrator.h"
 #include "cosmology/Pk_filter.h"
 #include "cosmology/Matsubara_XY_calculator.h"
+#include "cosmology/loop_tolerance_planner.h"
 #include "cosmology/oneloop_growth_integrator.h"
 #include "cosmology/concepts/range.h"
 #include "cosmology/concepts/power_spectrum.h"
@@ -103,9 +109,33 @@ class master_controller
     template <typename WorkItemList>
     void scatter(const FRW_model& model, const FRW_model_token& token, WorkItemList& work, data_manager& dmgr);
 
-    //! store a payload returned by a worker
+    //! execute a job specified by a pipeline; work from all stages is interleaved, so downstream items
+    //! are processed as soon as their inputs have been stored rather than after the whole upstream stage
+    void scatter(pipeline& pipe, data_manager& dmgr);
+
+    //! execute a job specified by a work list using threads of this process, without MPI workers;
+    //! payloads are built and processed in place, so nothing is serialized
+    template <typename WorkItemList>
+    void scatter_local(const FRW_model& model, const FRW_model_token& token, WorkItemList& work, data_manager& dmgr);
+
+    //! execute a job specified by a pipeline using threads of this process, without MPI workers
+    void scatter_local(pipeline& pipe, data_manager& dmgr);
+
+    //! determine whether work should run in threads of this process; this is always the case
+    //! if there are no worker processes
+    bool use_shared_memory() const { return this->arg_cache.use_shared_memory() || this->mpi_world.size() == 1; }
+
+    //! get thread pool used in shared-memory mode, constructing it if necessary
+    thread_pool& get_thread_pool();
+
+    //! get number of items processed together in shared-memory mode
+    unsigned int get_local_batch_size();
+
+    //! receive a batch of payloads returned by a worker and queue it for storage; returns the compute time
+    //! reported by the worker
     template <typename WorkItem>
-    void store_payload(const FRW_model_token& token, unsigned int source, data_manager& dmgr);
+    boost::timer::nanosecond_type store_payload(const FRW_model_token& token, unsigned int source, async_writer& writer,
+                                                data_manager& dmgr);
 
     //! terminate worker processes
     void terminate_workers();
@@ -117,6 +147,39 @@ class master_controller
     void close_down_workers();
 
 
+    // WORKER-RESIDENT POWER SPECTRA
+
+  protected:
+
+    //! ensure all filtered power spectra referenced by a work list are resident on the workers,
+    //! so that work items need only carry a linear_Pk_token; returns number of spectra broadcast
+    template <typename WorkItemList>
+    unsigned int distribute_filtered_Pk(const WorkItemList& work);
+
+    //! ensure a set of filtered power spectra are resident on the workers; returns number of spectra broadcast.
+    //! In shared-memory mode the spectra are handed directly to the local executor and nothing is broadcast
+    unsigned int distribute_filtered_Pk(const MPI_detail::filtered_Pk_set& Pks);
+
+    //! broadcast a filtered power spectrum to all workers, unless it is already resident;
+    //! returns true if a broadcast was needed
+    template <typename FilteredPkType>
+    bool broadcast_filtered_Pk(const std::shared_ptr<FilteredPkType>& Pk, std::set<unsigned int>& resident,
+                               unsigned int tag);
+
+
+    // WORK PREDICTION
+
+  protected:
+
+    //! report predicted makespan for a work list; no prediction is available for most work types
+    template <typename WorkItemList>
+    void report_predicted_makespan(const WorkItemList& work) {}
+
+    //! report predicted makespan for loop integrals, simulating longest-first assignment of the
+    //! predicted times to the available workers
+    void report_predicted_makespan(const loop_integral_work_list& work);
+
+
     // COMPUTE ONE-LOOP KERNELS
 
   protected:
@@ -126,6 +189,21 @@ class master_controller
                                const growth_params_token& params_tok, const growth_params& params);
 
 
+    // REFINE WAVENUMBER GRIDS
+
+  protected:
+
+    //! compute loop integrals and one-loop power spectra on a wavenumber database, refining it until interpolation
+    //! of the one-loop power spectra between neighbouring samples meets the tolerance set on the command line;
+    //! on return, loop integrals are available for every wavenumber in k_db. Throws if the tolerance is not met
+    //! within the maximum number of refinement passes
+    void refine_loop_k_db(const FRW_model& model, const FRW_model_token& token, data_manager& dmgr,
+                          const growth_params_token& growth_tok, z_database& z_db,
+                          std::unique_ptr<k_database>& k_db, IR_cutoff_database& IR_db, UV_cutoff_database& UV_db,
+                          std::shared_ptr<initial_filtered_Pk>& Pk_init, std::shared_ptr<final_filtered_Pk>& Pk_final,
+                          const loop_integral_params_token& params_tok, const loop_integral_params& params);
+
+
     // INTERNAL DATA
 
   private:
@@ -147,12 +225,24 @@ class master_controller
     //! local environment properties (constructed locally)
     local_environment local_env;
 
+    //! ids of initial filtered power spectra already resident on the workers
+    std::set<unsigned int> resident_initial_Pk;
+
+    //! ids of final filtered power spectra already resident on the workers
+    std::set<unsigned int> resident_final_Pk;
+
 
     // Functional blocks
 
     //! error handler
     error_handler err_handler;
 
+    //! work executor used in shared-memory mode
+    work_executor executor;
+
+    //! thread pool used in shared-memory mode
+    std::unique_ptr<thread_pool> pool;
+
   };
 
 
@@ -162,21 +252,38 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
     using WorkItem = typename WorkItemList::value_type;
     
     boost::timer::cpu_timer timer;              // total CPU time
-    boost::timer::cpu_timer write_timer;        // time spent writing to the database
-    write_timer.stop();
     
-    if(this->mpi_world.size() == 1) throw runtime_exception(exception_type::runtime_error, ERROR_TOO_FEW_WORKERS);
+    if(this->use_shared_memory())
+      {
+        this->scatter_local(model, token, work, dmgr);
+        return;
+      }
     
     // ask data manager to prepare for new writes
     boost::timer::cpu_timer pre_timer;          // time spent doing preparation
     dmgr.setup_write(work);
     pre_timer.stop();
     
+    // make sure any power spectra needed by this work list are resident on the workers;
+    // this must happen before the workers enter their task loop
+    boost::timer::cpu_timer bcast_timer;        // time spent broadcasting power spectra
+    unsigned int broadcasts = this->distribute_filtered_Pk(work);
+    bcast_timer.stop();
+    
+    this->report_predicted_makespan(work);
+    
     // instruct slave processes to await transfer function tasks
     std::unique_ptr<scheduler> sch = this->set_up_workers(MPI_detail::work_item_traits<WorkItem>::new_task_message());
     
+    // results are written on a separate thread, so this loop can continue to hand out work while SQLite is busy;
+    // if no results arrive for a while, the writer commits those it already holds
+    async_writer writer(LSSEFT_DEFAULT_WRITE_QUEUE_DEPTH, [&dmgr]() -> void { dmgr.commit_stores(); },
+                        LSSEFT_DEFAULT_GROUP_COMMIT_INTERVAL);
+    
     bool sent_closedown = false;
     auto next_work_item = work.cbegin();
+    size_t remaining = work.size();
+    unsigned int batches = 0;
     
     while(!sch->all_inactive())
       {
@@ -196,13 +303,24 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
             for(std::vector<unsigned int>::const_iterator t = unassigned_list.begin();
                 next_work_item != work.cend() && t != unassigned_list.end(); ++t)
               {
-                // assign next work item to this worker
+                // assign a batch of work items to this worker; the batch size adapts to the measured
+                // ratio of compute time to communication time
+                unsigned int N = sch->get_batch_size(remaining);
+                typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type batch;
+                
+                for(unsigned int i = 0; i < N && next_work_item != work.cend(); ++i)
+                  {
+                    batch.push_back(MPI_detail::build_payload(model, next_work_item));
+                    ++next_work_item;
+                    --remaining;
+                  }
+                
                 requests.push_back(this->mpi_world.isend(this->worker_rank(*t),
                                                          MPI_detail::work_item_traits<WorkItem>::new_item_message(),
-                                                         MPI_detail::build_payload(model, next_work_item)));
+                                                         batch));
                 
-                sch->mark_assigned(*t);
-                ++next_work_item;
+                sch->mark_assigned(*t, static_cast<unsigned int>(batch.size()));
+                ++batches;
               }
             
             // wait for all messages to be received
@@ -216,12 +334,10 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
           {
             switch(stat->tag())
               {
-                case MPI_detail::MESSAGE_WORK_PRODUCT_READY:
+                case MPI_detail::work_item_traits<WorkItem>::product_message():
                   {
-                    write_timer.resume();
-                    this->store_payload<WorkItem>(token, stat->source(), dmgr);
-                    write_timer.stop();
-                    sch->mark_unassigned(this->worker_number(stat->source()));
+                    boost::timer::nanosecond_type compute_time = this->store_payload<WorkItem>(token, stat->source(), writer, dmgr);
+                    sch->mark_unassigned(this->worker_number(stat->source()), compute_time);
                     break;
                   }
                 
@@ -242,6 +358,11 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
           }
       }
     
+    // wait for outstanding writes before tidying up
+    boost::timer::cpu_timer flush_timer;    // time spent waiting for the writer to catch up
+    writer.flush();
+    flush_timer.stop();
+    
     boost::timer::cpu_timer post_timer;     // time spent tidying up the database after a write
     dmgr.finalize_write(work);
     post_timer.stop();
@@ -249,6 +370,80 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
     timer.stop();
     std::ostringstream msg;
     msg << "completed work in time " << format_time(timer.elapsed().wall)
+        << " [" << work.size() << " items in " << batches << " batches, final batch size " << sch->get_current_batch_size() << "]"
+        << " ["
+        << "database performance: prepare " << format_time(pre_timer.elapsed().wall) << ", "
+        << "writes " << format_time(writer.get_write_time()) << ", "
+        << "stalled " << format_time(writer.get_stall_time() + flush_timer.elapsed().wall) << ", "
+        << "cleanup " << format_time(post_timer.elapsed().wall)
+        << "]";
+    if(broadcasts > 0)
+      {
+        msg << " [broadcast " << broadcasts << " power spectra in time " << format_time(bcast_timer.elapsed().wall) << "]";
+      }
+    this->err_handler.info(msg.str());
+  }
+
+
+template <typename WorkItemList>
+void master_controller::scatter_local(const FRW_model& model, const FRW_model_token& token, WorkItemList& work, data_manager& dmgr)
+  {
+    using WorkItem = typename WorkItemList::value_type;
+    
+    boost::timer::cpu_timer timer;              // total CPU time
+    boost::timer::cpu_timer write_timer;        // time spent writing to the database
+    write_timer.stop();
+    
+    // ask data manager to prepare for new writes
+    boost::timer::cpu_timer pre_timer;          // time spent doing preparation
+    dmgr.setup_write(work);
+    pre_timer.stop();
+    
+    // power spectra are shared with the executor directly
+    this->distribute_filtered_Pk(work);
+    
+    this->report_predicted_makespan(work);
+    
+    thread_pool& pool = this->get_thread_pool();
+    unsigned int N = this->get_local_batch_size();
+    
+    auto next_work_item = work.cbegin();
+    unsigned int batches = 0;
+    
+    while(next_work_item != work.cend())
+      {
+        // payloads refer to the same model and power spectra as the work list; nothing is copied between processes
+        typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type batch;
+        
+        for(unsigned int i = 0; i < N && next_work_item != work.cend(); ++i)
+          {
+            batch.push_back(MPI_detail::build_payload(model, next_work_item));
+            ++next_work_item;
+          }
+        
+        auto results = this->executor.process_batch<WorkItem>(batch, pool);
+        ++batches;
+        
+        // database access is not thread-safe, so products are stored from this thread only;
+        // they are committed before the next batch is computed, so none wait for longer than one batch
+        write_timer.resume();
+        for(const auto& payload : results.get_items())
+          {
+            dmgr.store(token, payload.get_data());
+          }
+        dmgr.commit_stores();
+        write_timer.stop();
+      }
+    this->executor.end_of_work();
+    
+    boost::timer::cpu_timer post_timer;     // time spent tidying up the database after a write
+    dmgr.finalize_write(work);
+    post_timer.stop();
+    
+    timer.stop();
+    std::ostringstream msg;
+    msg << "completed work in time " << format_time(timer.elapsed().wall)
+        << " [" << work.size() << " items in " << batches << " batches on " << pool.size() << " threads, shared-memory mode]"
         << " ["
         << "database performance: prepare " << format_time(pre_timer.elapsed().wall) << ", "
         << "writes " << format_time(write_timer.elapsed().wall) << ", "
@@ -259,12 +454,62 @@ void master_controller::scatter(const FRW_model& model, const FRW_model_token& t
 
 
 template <typename WorkItem>
-void master_controller::store_payload(const FRW_model_token& token, unsigned int source, data_manager& dmgr)
+boost::timer::nanosecond_type master_controller::store_payload(const FRW_model_token& token, unsigned int source,
+                                                               async_writer& writer, data_manager& dmgr)
   {
-    typename MPI_detail::work_item_traits<WorkItem>::incoming_payload_type payload;
+    auto batch = std::make_shared<typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type>();
+    
+    this->mpi_world.recv(source, MPI_detail::work_item_traits<WorkItem>::product_message(), *batch);
+    
+    // blocks if the writer has fallen too far behind
+    writer.push([&token, &dmgr, batch]() -> void
+                  {
+                    for(const auto& payload : batch->get_items())
+                      {
+                        dmgr.store(token, payload.get_data());
+                      }
+                  });
+    
+    return batch->get_compute_time();
+  }
+
+
+template <typename WorkItemList>
+unsigned int master_controller::distribute_filtered_Pk(const WorkItemList& work)
+  {
+    MPI_detail::filtered_Pk_set Pks;
+    for(const auto& item : work)
+      {
+        MPI_detail::collect_filtered_Pk(item, Pks);
+      }
+    
+    return this->distribute_filtered_Pk(Pks);
+  }
+
+
+template <typename FilteredPkType>
+bool master_controller::broadcast_filtered_Pk(const std::shared_ptr<FilteredPkType>& Pk, std::set<unsigned int>& resident,
+                                              unsigned int tag)
+  {
+    unsigned int id = Pk->get_token().get_id();
+    if(resident.find(id) != resident.end()) return false;
+    
+    // alert workers that a broadcast is coming
+    std::vector<boost::mpi::request> requests(this->mpi_world.size() - 1);
+    for(unsigned int i = 0; i < this->mpi_world.size() - 1; ++i)
+      {
+        requests[i] = this->mpi_world.isend(this->worker_rank(i), tag);
+      }
+    
+    // wait for all messages to be received
+    boost::mpi::wait_all(requests.begin(), requests.end());
+    
+    // serialize the power spectrum once and broadcast it to all workers
+    MPI_detail::cache_filtered_Pk<FilteredPkType> payload(Pk);
+    boost::mpi::broadcast(this->mpi_world, payload, MPI_detail::RANK_MASTER);
     
-    this->mpi_world.recv(source, MPI_detail::MESSAGE_WORK_PRODUCT_READY, payload);
-    dmgr.store(token, payload.get_data());
+    resident.insert(id);
+    return true;
   }
 
 
@@ -0,0 +1,102 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <map>
+
+#include "pipeline.h"
+
+
+size_t pipeline::ready() const
+  {
+    size_t count = 0;
+
+    for(const auto& stage : this->stages)
+      {
+        count += stage->ready();
+      }
+
+    return count;
+  }
+
+
+unsigned int pipeline::outstanding() const
+  {
+    unsigned int count = 0;
+
+    for(const auto& stage : this->stages)
+      {
+        count += stage->get_outstanding();
+      }
+
+    return count;
+  }
+
+
+pipeline_stage* pipeline::next_ready()
+  {
+    for(const auto& stage : this->stages)
+      {
+        if(stage->ready() > 0) return stage.get();
+      }
+
+    return nullptr;
+  }
+
+
+pipeline_stage* pipeline::find_stage(unsigned int product_tag)
+  {
+    for(const auto& stage : this->stages)
+      {
+        if(stage->product_message() == product_tag) return stage.get();
+      }
+
+    return nullptr;
+  }
+
+
+void connect(work_stage<loop_integral_work_record>& loop_stage, work_stage<one_loop_Pk_work_record>& Pk_stage,
+             std::shared_ptr<oneloop_growth> Df_data, std::shared_ptr<initial_filtered_Pk> Pk_init,
+             std::shared_ptr<final_filtered_Pk> Pk_final)
+  {
+    // loop_integral products carry only a wavenumber token, so remember the corresponding wavenumbers
+    std::map<unsigned int, Mpc_units::energy> k_values;
+    for(const auto& item : loop_stage.get_pending())
+      {
+        k_values.emplace(item.get_k_token().get_id(), *item);
+      }
+
+    Pk_stage.add_filtered_Pk(Pk_init);
+    Pk_stage.add_filtered_Pk(Pk_final);
+
+    loop_stage.on_store(
+      [&Pk_stage, k_values, Df_data, Pk_init, Pk_final](const MPI_detail::loop_momentum_integration_ready& payload) -> void
+        {
+          const loop_integral& data = payload.get_data();
+          auto t = k_values.find(data.get_k_token().get_id());
+          if(t == k_values.end()) return;
+
+          Pk_stage.push_back(one_loop_Pk_work_record(t->second, Df_data, std::make_shared<loop_integral>(data),
+                                                     Pk_init, Pk_final));
+        });
+  }
@@ -0,0 +1,442 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_PIPELINE_H
+#define LSSEFT_PIPELINE_H
+
+
+#include <list>
+#include <memory>
+#include <string>
+#include <functional>
+
+#include "thread_pool.h"
+#include "work_executor.h"
+#include "async_writer.h"
+
+#include "database/data_manager.h"
+#include "database/tokens.h"
+
+#include "cosmology/types.h"
+#include "cosmology/FRW_model.h"
+
+#include "MPI_detail/mpi_traits.h"
+#include "MPI_detail/mpi_payloads.h"
+
+#include "boost/mpi.hpp"
+#include "boost/timer/timer.hpp"
+
+
+//! a single stage of a pipelined computation. Stages handling different work item types are scheduled
+//! together, so this interface is type-erased; a stage's work list may grow while the pipeline runs,
+//! as products of upstream stages are stored and release new items
+class pipeline_stage
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor
+    pipeline_stage(std::string n)
+      : name(std::move(n)),
+        outstanding(0)
+      {
+      }
+
+    //! destructor
+    virtual ~pipeline_stage() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! get name of stage
+    const std::string& get_name() const { return this->name; }
+
+    //! get number of batches dispatched but not yet returned
+    unsigned int get_outstanding() const { return this->outstanding; }
+
+    //! get number of items ready for dispatch
+    virtual size_t ready() const = 0;
+
+    //! get total number of items processed or awaiting dispatch
+    virtual size_t size() const = 0;
+
+    //! tag used by workers to return products of this stage
+    virtual unsigned int product_message() const = 0;
+
+    //! collect filtered power spectra needed by this stage, including any needed by items released later
+    virtual void collect_filtered_Pk(MPI_detail::filtered_Pk_set& Pks) const = 0;
+
+    //! prepare the database for writes from this stage
+    virtual void setup_write(data_manager& dmgr) = 0;
+
+    //! tidy up the database after writes from this stage
+    virtual void finalize_write(data_manager& dmgr) = 0;
+
+    //! build a batch of up to N ready items and post it to a worker; returns the number of items sent
+    virtual unsigned int dispatch(boost::mpi::communicator& world, unsigned int rank, unsigned int N,
+                                  std::vector<boost::mpi::request>& requests) = 0;
+
+    //! receive a batch of products and queue it for storage; downstream work is released once the write
+    //! has completed. Returns compute time reported by the worker
+    virtual boost::timer::nanosecond_type receive(boost::mpi::communicator& world, unsigned int source,
+                                                  async_writer& writer, data_manager& dmgr) = 0;
+
+    //! process a batch of up to N ready items in this process and store the products, without
+    //! involving MPI workers; time spent storing is accumulated in write_timer. Returns the number of items processed
+    virtual unsigned int execute(work_executor& executor, thread_pool& pool, unsigned int N, data_manager& dmgr,
+                                 boost::timer::cpu_timer& write_timer) = 0;
+
+
+    // INTERNAL DATA
+
+  protected:
+
+    //! name of stage, used for reporting
+    std::string name;
+
+    //! number of batches dispatched but not yet returned
+    unsigned int outstanding;
+
+  };
+
+
+//! pipeline stage for a specific work item type
+template <typename WorkItem>
+class work_stage: public pipeline_stage
+  {
+
+    // TYPEDEFS
+
+  public:
+
+    typedef std::list<WorkItem> work_list_type;
+
+    typedef typename MPI_detail::work_item_traits<WorkItem>::incoming_payload_type product_type;
+
+    //! function called for each stored product; used to release work into downstream stages
+    typedef std::function<void(const product_type&)> release_function;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor; initial work list may be empty
+    work_stage(std::string n, const FRW_model& m, const FRW_model_token& t, std::unique_ptr<work_list_type> work);
+
+    //! destructor is default
+    ~work_stage() = default;
+
+
+    // RELEASE OF NEW WORK
+
+  public:
+
+    //! add a work item which has become ready
+    void push_back(WorkItem item) { this->pending.push_back(std::move(item)); }
+
+    //! add a function to be called for each stored product
+    void on_store(release_function f) { this->releases.push_back(std::move(f)); }
+
+    //! add a filtered power spectrum which will be needed by items released later
+    template <typename FilteredPkType>
+    void add_filtered_Pk(const std::shared_ptr<FilteredPkType>& Pk) { this->future_Pks.add(Pk); }
+
+    //! get items not yet dispatched
+    const work_list_type& get_pending() const { return this->pending; }
+
+
+    // INTERFACE
+
+  public:
+
+    size_t ready() const override { return this->pending.size(); }
+
+    size_t size() const override { return this->pending.size() + this->dispatched.size(); }
+
+    unsigned int product_message() const override { return MPI_detail::work_item_traits<WorkItem>::product_message(); }
+
+    void collect_filtered_Pk(MPI_detail::filtered_Pk_set& Pks) const override;
+
+    void setup_write(data_manager& dmgr) override { dmgr.setup_write(this->pending); }
+
+    void finalize_write(data_manager& dmgr) override { dmgr.finalize_write(this->dispatched); }
+
+    unsigned int dispatch(boost::mpi::communicator& world, unsigned int rank, unsigned int N,
+                          std::vector<boost::mpi::request>& requests) override;
+
+    boost::timer::nanosecond_type receive(boost::mpi::communicator& world, unsigned int source,
+                                          async_writer& writer, data_manager& dmgr) override;
+
+    unsigned int execute(work_executor& executor, thread_pool& pool, unsigned int N, data_manager& dmgr,
+                         boost::timer::cpu_timer& write_timer) override;
+
+
+    // INTERNAL API
+
+  private:
+
+    //! move up to N ready items into a batch of payloads
+    void build_batch(unsigned int N, typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch);
+
+    //! store a batch of products
+    void store(const typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type& batch, data_manager& dmgr);
+
+    //! release downstream work for a batch of stored products
+    void release(const typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type& batch);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! cosmological model
+    const FRW_model& model;
+
+    //! token for cosmological model
+    const FRW_model_token& token;
+
+    //! items awaiting dispatch
+    work_list_type pending;
+
+    //! items already dispatched
+    work_list_type dispatched;
+
+    //! functions to be called for each stored product
+    std::list<release_function> releases;
+
+    //! filtered power spectra needed by items released later
+    MPI_detail::filtered_Pk_set future_Pks;
+
+  };
+
+
+template <typename WorkItem>
+work_stage<WorkItem>::work_stage(std::string n, const FRW_model& m, const FRW_model_token& t,
+                                 std::unique_ptr<work_list_type> work)
+  : pipeline_stage(std::move(n)),
+    model(m),
+    token(t)
+  {
+    if(work) this->pending.splice(this->pending.end(), *work);
+  }
+
+
+template <typename WorkItem>
+void work_stage<WorkItem>::collect_filtered_Pk(MPI_detail::filtered_Pk_set& Pks) const
+  {
+    for(const auto& item : this->pending)
+      {
+        MPI_detail::collect_filtered_Pk(item, Pks);
+      }
+
+    for(const auto& t : this->future_Pks.get_initial())
+      {
+        Pks.add(t.second);
+      }
+
+    for(const auto& t : this->future_Pks.get_final())
+      {
+        Pks.add(t.second);
+      }
+  }
+
+
+template <typename WorkItem>
+void work_stage<WorkItem>::build_batch(unsigned int N, typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch)
+  {
+    for(unsigned int i = 0; i < N && !this->pending.empty(); ++i)
+      {
+        typename work_list_type::const_iterator t = this->pending.cbegin();
+        batch.push_back(MPI_detail::build_payload(this->model, t));
+        this->dispatched.splice(this->dispatched.end(), this->pending, this->pending.begin());
+      }
+  }
+
+
+template <typename WorkItem>
+void work_stage<WorkItem>::store(const typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type& batch,
+                                 data_manager& dmgr)
+  {
+    for(const auto& payload : batch.get_items())
+      {
+        dmgr.store(this->token, payload.get_data());
+      }
+  }
+
+
+template <typename WorkItem>
+void work_stage<WorkItem>::release(const typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type& batch)
+  {
+    for(const auto& payload : batch.get_items())
+      {
+        for(const auto& f : this->releases)
+          {
+            f(payload);
+          }
+      }
+  }
+
+
+template <typename WorkItem>
+unsigned int work_stage<WorkItem>::dispatch(boost::mpi::communicator& world, unsigned int rank, unsigned int N,
+                                            std::vector<boost::mpi::request>& requests)
+  {
+    typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type batch;
+    this->build_batch(N, batch);
+
+    if(batch.size() == 0) return 0;
+
+    requests.push_back(world.isend(rank, MPI_detail::work_item_traits<WorkItem>::new_item_message(), batch));
+    ++this->outstanding;
+
+    return static_cast<unsigned int>(batch.size());
+  }
+
+
+template <typename WorkItem>
+boost::timer::nanosecond_type work_stage<WorkItem>::receive(boost::mpi::communicator& world, unsigned int source,
+                                                            async_writer& writer, data_manager& dmgr)
+  {
+    auto batch = std::make_shared<typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type>();
+
+    world.recv(source, MPI_detail::work_item_traits<WorkItem>::product_message(), *batch);
+    --this->outstanding;
+
+    // products are only released downstream once they are safely in the database; the release
+    // runs on this thread, because it modifies the pending lists of other stages
+    writer.push([this, batch, &dmgr]() -> void { this->store(*batch, dmgr); },
+                [this, batch]() -> void { this->release(*batch); });
+
+    return batch->get_compute_time();
+  }
+
+
+template <typename WorkItem>
+unsigned int work_stage<WorkItem>::execute(work_executor& executor, thread_pool& pool, unsigned int N, data_manager& dmgr,
+                                           boost::timer::cpu_timer& write_timer)
+  {
+    typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type batch;
+    this->build_batch(N, batch);
+
+    if(batch.size() == 0) return 0;
+
+    auto results = executor.process_batch<WorkItem>(batch, pool);
+
+    // commit before the next batch is computed, so no product waits for longer than one batch
+    write_timer.resume();
+    this->store(results, dmgr);
+    dmgr.commit_stores();
+    write_timer.stop();
+
+    this->release(results);
+
+    return static_cast<unsigned int>(batch.size());
+  }
+
+
+//! a collection of stages which are scheduled together; stages are given priority in the order they are added
+class pipeline
+  {
+
+    // TYPEDEFS
+
+  public:
+
+    typedef std::list< std::unique_ptr<pipeline_stage> > stage_list;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor
+    pipeline(const FRW_model& m, const FRW_model_token& t)
+      : model(m),
+        token(t)
+      {
+      }
+
+    //! destructor is default
+    ~pipeline() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! add a stage with a given initial work list, which may be empty
+    template <typename WorkItem>
+    work_stage<WorkItem>& add_stage(std::string name, std::unique_ptr< std::list<WorkItem> > work)
+      {
+        auto stage = std::make_unique< work_stage<WorkItem> >(std::move(name), this->model, this->token, std::move(work));
+        work_stage<WorkItem>& ref = *stage;
+        this->stages.push_back(std::move(stage));
+        return ref;
+      }
+
+    //! get stages
+    stage_list& get_stages() { return this->stages; }
+
+    //! get total number of items ready for dispatch
+    size_t ready() const;
+
+    //! get total number of batches outstanding
+    unsigned int outstanding() const;
+
+    //! get highest-priority stage with items ready for dispatch, or nullptr if none
+    pipeline_stage* next_ready();
+
+    //! get stage which returns products with a given tag, or nullptr if none
+    pipeline_stage* find_stage(unsigned int product_tag);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! cosmological model
+    const FRW_model& model;
+
+    //! token for cosmological model
+    const FRW_model_token& token;
+
+    //! stages, in priority order
+    stage_list stages;
+
+  };
+
+
+//! connect a loop-integral stage to a one-loop P(k) stage, so that each loop integral releases
+//! a one-loop P(k) work item as soon as it has been stored
+void connect(work_stage<loop_integral_work_record>& loop_stage, work_stage<one_loop_Pk_work_record>& Pk_stage,
+             std::shared_ptr<oneloop_growth> Df_data, std::shared_ptr<initial_filtered_Pk> Pk_init,
+             std::shared_ptr<final_filtered_Pk> Pk_final);
+
+
+#endif //LSSEFT_PIPELINE_H
@@ -25,6 +25,8 @@
 
 
 #include <assert.h>
+#include <algorithm>
+#include <cmath>
 
 #include "scheduler.h"
 
@@ -32,7 +34,7 @@
 scheduler_detail::worker_data::worker_data()
   : initialized(false),
     active(true),
-    assigned(false)
+    last_return(0)
   {
   }
 
@@ -44,11 +46,31 @@ void scheduler_detail::worker_data::initialize(unsigned int n)
   }
 
 
-scheduler::scheduler(unsigned int N)
+boost::timer::nanosecond_type scheduler_detail::worker_data::mark_unassigned(boost::timer::nanosecond_type now)
+  {
+    assert(!this->batches.empty());
+
+    boost::timer::nanosecond_type start = std::max(this->batches.front().second, this->last_return);
+    this->batches.pop_front();
+    this->last_return = now;
+
+    return(now - start);
+  }
+
+
+scheduler::scheduler(unsigned int N, unsigned int d, unsigned int t, double f, unsigned int m)
   : workers(N),
     waiting_for_initialization(N),
     active(0),
-    unassigned(N)
+    prefetch_depth(std::max(d, 1U)),
+    free_slots(N*std::max(d, 1U)),
+    comm_fraction(f),
+    min_batch_size(std::max(t, 1U)),
+    max_batch_size(std::max(m, std::max(t, 1U))),
+    batch_size(std::max(t, 1U)),
+    item_time(0.0),
+    overhead(0.0),
+    samples(0)
   {
     worker_list.clear();
     worker_list.resize(workers);
@@ -57,7 +79,7 @@ scheduler::scheduler(unsigned int N)
 
 bool scheduler::is_assignable() const
   {
-    return(this->unassigned > 0);
+    return(this->free_slots > 0);
   }
 
 
@@ -85,29 +107,84 @@ std::vector<unsigned int> scheduler::make_assignment()
 
     for(worker_list_type::const_iterator t = this->worker_list.begin(); t != this->worker_list.end(); ++t)
       {
-        if(!t->is_assigned()) list.push_back(t->get_worker_number());
+        if(t->get_outstanding() < this->prefetch_depth) list.push_back(t->get_worker_number());
       }
 
+    // top up idle workers before extending the queues of busy ones
+    std::stable_sort(list.begin(), list.end(),
+                     [&](unsigned int a, unsigned int b) -> bool
+                       { return this->worker_list[a].get_outstanding() < this->worker_list[b].get_outstanding(); });
+
     return(list);
   }
 
 
-void scheduler::mark_assigned(unsigned int n)
+void scheduler::mark_assigned(unsigned int n, unsigned int items)
   {
-    assert(!this->worker_list[n].is_assigned());
-    assert(this->unassigned > 0);
+    assert(this->worker_list[n].get_outstanding() < this->prefetch_depth);
+    assert(this->free_slots > 0);
 
-    this->worker_list[n].mark_assigned();
-    --this->unassigned;
+    this->worker_list[n].mark_assigned(items, this->clock.elapsed().wall);
+    --this->free_slots;
   }
 
 
-void scheduler::mark_unassigned(unsigned int n)
+void scheduler::mark_unassigned(unsigned int n, boost::timer::nanosecond_type compute_time)
   {
     assert(this->worker_list[n].is_assigned());
 
-    this->worker_list[n].mark_unassigned();
-    ++this->unassigned;
+    unsigned int items = this->worker_list[n].get_items();
+    boost::timer::nanosecond_type round_trip = this->worker_list[n].mark_unassigned(this->clock.elapsed().wall);
+
+    this->update_batch_size(items, round_trip, compute_time);
+    ++this->free_slots;
+  }
+
+
+unsigned int scheduler::get_batch_size(size_t remaining) const
+  {
+    // don't allow batches to grow so large that the remaining work can't be spread over all worker queues;
+    // otherwise the tail of the stage is dominated by a few large batches
+    size_t slots = std::max(this->workers * this->prefetch_depth, 1U);
+    size_t fair_share = (remaining + slots - 1) / slots;
+
+    return static_cast<unsigned int>(std::max(std::min(static_cast<size_t>(this->batch_size), fair_share), static_cast<size_t>(1)));
+  }
+
+
+void scheduler::update_batch_size(unsigned int items, boost::timer::nanosecond_type round_trip,
+                                  boost::timer::nanosecond_type compute_time)
+  {
+    // no timing information available
+    if(items == 0 || compute_time <= 0) return;
+
+    // per-batch overhead is everything in the round trip that wasn't spent computing:
+    // serialization, latency and time the worker spent waiting for the master.
+    // If prefetching successfully hides the latency this tends to zero, and batches shrink
+    double this_item_time = static_cast<double>(compute_time) / static_cast<double>(items);
+    double this_overhead = std::max(static_cast<double>(round_trip - compute_time), 0.0);
+
+    // exponentially-weighted running averages, so the estimate can track changes in cost across the stage
+    constexpr double weight = 0.25;
+
+    if(this->samples == 0)
+      {
+        this->item_time = this_item_time;
+        this->overhead = this_overhead;
+      }
+    else
+      {
+        this->item_time = (1.0-weight)*this->item_time + weight*this_item_time;
+        this->overhead = (1.0-weight)*this->overhead + weight*this_overhead;
+      }
+    ++this->samples;
+
+    // choose N so that overhead / (N * item_time) is approximately the target communication fraction
+    if(this->item_time <= 0.0) return;
+    double N = std::ceil(this->overhead / (this->comm_fraction * this->item_time));
+
+    this->batch_size = static_cast<unsigned int>(std::max(std::min(N, static_cast<double>(this->max_batch_size)),
+                                                          static_cast<double>(this->min_batch_size)));
   }
 
 
@@ -28,6 +28,12 @@
 
 
 #include <vector>
+#include <deque>
+#include <utility>
+
+#include "defaults.h"
+
+#include "boost/timer/timer.hpp"
 
 
 namespace scheduler_detail
@@ -58,11 +64,17 @@ namespace scheduler_detail
         bool is_active() const { return(this->active); }
 
         //! is this worker assigned
-        bool is_assigned() const { return(this->assigned); }
+        bool is_assigned() const { return(!this->batches.empty()); }
+
+        //! get number of batches assigned to this worker but not yet returned
+        unsigned int get_outstanding() const { return(static_cast<unsigned int>(this->batches.size())); }
 
         //! get worker number
         unsigned int get_worker_number() const { if(this->initialized) return(this->number); else return(0); }
 
+        //! get number of items in the oldest outstanding batch, which is the next to be returned
+        unsigned int get_items() const { return(this->batches.empty() ? 0 : this->batches.front().first); }
+
 
         // MANAGEMENT
 
@@ -74,11 +86,14 @@ namespace scheduler_detail
         //! set active status
         void mark_inactive() { this->active = false; }
 
-        //! set assigned status
-        void mark_assigned() { this->assigned = true; }
+        //! queue a new batch of n items, assigned at the given time
+        void mark_assigned(unsigned int n, boost::timer::nanosecond_type now) { this->batches.emplace_back(n, now); }
 
-        //! set unassigned status
-        void mark_unassigned() { this->assigned = false; }
+        //! retire the oldest outstanding batch, returned at the given time; returns the round-trip time
+        //! seen by this batch, ie. the time since it was assigned or since the worker returned its previous
+        //! result, whichever is later. When batches are queued ahead this excludes the time spent waiting
+        //! behind earlier batches
+        boost::timer::nanosecond_type mark_unassigned(boost::timer::nanosecond_type now);
 
 
         // INTERNAL DATA
@@ -94,8 +109,11 @@ namespace scheduler_detail
         //! is this worker active?
         bool active;
 
-        //! is this worker assigned
-        bool assigned;
+        //! outstanding batches, in order of assignment: number of items and time of assignment
+        std::deque< std::pair<unsigned int, boost::timer::nanosecond_type> > batches;
+
+        //! time at which this worker last returned a result
+        boost::timer::nanosecond_type last_return;
 
       };
 
@@ -108,8 +126,12 @@ class scheduler
 
   public:
 
-    //! construct new scheduler for N workers
-    scheduler(unsigned int N);
+    //! construct new scheduler for N workers, each of which may hold up to d outstanding batches and
+    //! processes them using t threads;
+    //! batches of work are sized so that roughly a fraction f of each worker's time is lost to communication,
+    //! subject to a maximum batch size m and a minimum of t, so that all threads on a worker have an item
+    scheduler(unsigned int N, unsigned int d=LSSEFT_DEFAULT_PREFETCH_DEPTH, unsigned int t=LSSEFT_DEFAULT_WORKER_THREADS,
+              double f=LSSEFT_DEFAULT_BATCH_COMMUNICATION_FRACTION, unsigned int m=LSSEFT_DEFAULT_MAX_BATCH_SIZE);
 
     //! destructor is default
     ~scheduler() = default;
@@ -136,11 +158,12 @@ class scheduler
     //! initialize a worker
     void initialize_worker(unsigned int n);
 
-    //! mark a worker assigned
-    void mark_assigned(unsigned int n);
+    //! mark a worker assigned with a batch of the given number of items
+    void mark_assigned(unsigned int n, unsigned int items=1);
 
-    //! mark a worker unassigned
-    void mark_unassigned(unsigned int n);
+    //! mark a worker unassigned; compute_time is the time the worker reported spending on its batch,
+    //! and is used to update the batch size
+    void mark_unassigned(unsigned int n, boost::timer::nanosecond_type compute_time=0);
 
     //! mark a worker inactive
     void mark_inactive(unsigned int n);
@@ -150,9 +173,24 @@ class scheduler
 
   public:
 
-    //! construct list workers requiring assignment
+    //! construct list of workers which can accept another batch, least-loaded first
     std::vector<unsigned int> make_assignment();
 
+    //! get number of items to include in the next batch, given the number of items still to be assigned
+    unsigned int get_batch_size(size_t remaining) const;
+
+    //! get current (unconstrained) batch size
+    unsigned int get_current_batch_size() const { return(this->batch_size); }
+
+
+    // BATCH SIZING
+
+  protected:
+
+    //! update batch size using timing information for a returned batch
+    void update_batch_size(unsigned int items, boost::timer::nanosecond_type round_trip,
+                           boost::timer::nanosecond_type compute_time);
+
 
     // INTERNAL DATA
 
@@ -170,8 +208,14 @@ class scheduler
     //! number of active workers
     unsigned int active;
 
-    //! number of unassigned workers
-    unsigned int unassigned;
+    //! number of batches which may be outstanding on each worker
+    const unsigned int prefetch_depth;
+
+    //! number of unused batch slots, summed over all workers
+    unsigned int free_slots;
+
+    //! clock used to time batch round trips
+    boost::timer::cpu_timer clock;
 
     // WORKER MANAGEMENT
 
@@ -181,6 +225,30 @@ class scheduler
     //! list of workers
     worker_list_type worker_list;
 
+
+    // BATCH SIZING
+
+    //! target fraction of worker time lost to communication
+    const double comm_fraction;
+
+    //! minimum batch size
+    const unsigned int min_batch_size;
+
+    //! maximum batch size
+    const unsigned int max_batch_size;
+
+    //! current batch size
+    unsigned int batch_size;
+
+    //! running estimate of compute time per item (in ns)
+    double item_time;
+
+    //! running estimate of communication overhead per batch (in ns)
+    double overhead;
+
+    //! number of batches contributing to running estimates
+    unsigned int samples;
+
   };
 
 
@@ -24,29 +24,29 @@
 //
 
 
+#include <deque>
+#include <list>
+#include <vector>
+
 #include "MPI_detail/mpi_traits.h"
 #include "MPI_detail/mpi_payloads.h"
 
 #include "slave_controller.h"
 
-#include "cosmology/transfer_integrator.h"
-#include "cosmology/oneloop_momentum_integrator.h"
-#include "cosmology/oneloop_Pk_calculator.h"
-#include "cosmology/multipole_Pk_calculator.h"
-#include "cosmology/Pk_filter.h"
-#include "cosmology/Matsubara_XY_calculator.h"
-
 #include "cosmology/types.h"
 
 #include "error/error_handler.h"
 
+#include "localizations/messages.h"
+
 
 slave_controller::slave_controller(boost::mpi::environment& me, boost::mpi::communicator& mw, argument_cache& ac)
   : mpi_env(me),
     mpi_world(mw),
     arg_cache(ac),
     local_env(),
-    err_handler(arg_cache, local_env)
+    err_handler(arg_cache, local_env),
+    executor(err_handler)
   {
   }
 
@@ -112,6 +112,30 @@ void slave_controller::execute()
                 break;
               }
 
+            case MPI_detail::MESSAGE_NEW_PIPELINE_TASK:
+              {
+                // a pipelined task may interleave batches of any work type
+                this->mpi_world.recv(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_NEW_PIPELINE_TASK);
+                this->process_task<transfer_work_record, filter_Pk_work_record, loop_integral_work_record,
+                                   Matsubara_XY_work_record, one_loop_Pk_work_record, multipole_Pk_work_record,
+                                   counterterm_work_record>();
+                break;
+              }
+
+            case MPI_detail::MESSAGE_CACHE_INITIAL_FILTERED_PK:
+              {
+                this->mpi_world.recv(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_CACHE_INITIAL_FILTERED_PK);
+                this->receive_filtered_Pk<initial_filtered_Pk>();
+                break;
+              }
+
+            case MPI_detail::MESSAGE_CACHE_FINAL_FILTERED_PK:
+              {
+                this->mpi_world.recv(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_CACHE_FINAL_FILTERED_PK);
+                this->receive_filtered_Pk<final_filtered_Pk>();
+                break;
+              }
+
             case MPI_detail::MESSAGE_TERMINATE:
               {
                 this->mpi_world.recv(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_TERMINATE);
@@ -128,205 +152,112 @@ void slave_controller::execute()
   }
 
 
-template <typename WorkItem>
+template <typename... WorkItems>
 void slave_controller::process_task()
   {
     // pass an acknowledgment to the master process
     this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORKER_READY);
 
-    bool finished = false;
-    
-    while(!finished)
+    // batches received from the master but not yet processed; the master keeps several batches outstanding
+    // on each worker, so the next batch is usually waiting here by the time the current one completes
+    batch_queue queue;
+
+    // results which have been posted to the master but not yet delivered
+    std::list<boost::mpi::request> sends;
+
+    bool end_of_work = false;
+
+    while(!end_of_work || !queue.empty())
       {
-        // wait for a message from the master node
-        boost::mpi::status stat = this->mpi_world.probe(MPI_detail::RANK_MASTER);
+        // collect any messages from the master node; block only if there is no queued work
+        boost::optional<boost::mpi::status> stat;
+        if(queue.empty()) stat = this->mpi_world.probe(MPI_detail::RANK_MASTER);
+        else              stat = this->mpi_world.iprobe(MPI_detail::RANK_MASTER);
 
-        switch(stat.tag())
+        while(stat)
           {
-            case MPI_detail::work_item_traits<WorkItem>::new_item_message():
-              {
-                typename MPI_detail::work_item_traits<WorkItem>::outgoing_payload_type payload;
-                this->mpi_world.recv(stat.source(), MPI_detail::work_item_traits<WorkItem>::new_item_message(), payload);
-                this->process_item(payload);
-                break;
-              }
-
-            case MPI_detail::MESSAGE_END_OF_WORK:
+            if(stat->tag() == MPI_detail::MESSAGE_END_OF_WORK)
               {
-                this->mpi_world.recv(stat.source(), MPI_detail::MESSAGE_END_OF_WORK);
-                finished = true;
-
-                // send acknowledgement to master
-                this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_END_OF_WORK_ACK);
-                break;
+                // no further batches will arrive, but any already queued must still be processed
+                this->mpi_world.recv(stat->source(), MPI_detail::MESSAGE_END_OF_WORK);
+                end_of_work = true;
               }
-
-            default:
+            else if(!this->receive_batch<WorkItems...>(*stat, queue))
               {
                 assert(false);
               }
+
+            stat = this->mpi_world.iprobe(MPI_detail::RANK_MASTER);
+          }
+
+        if(!queue.empty())
+          {
+            // process the oldest batch and return results asynchronously,
+            // so we can move straight on to the next queued batch
+            sends.push_back(queue.front()());
+            queue.pop_front();
           }
+
+        // release any sends which have completed
+        sends.remove_if([](boost::mpi::request& r) -> bool { return static_cast<bool>(r.test()); });
       }
+
+    // all results must be delivered before acknowledging end-of-work, because the master
+    // expects no further results from a worker once it has seen the acknowledgement
+    boost::mpi::wait_all(sends.begin(), sends.end());
+    this->executor.end_of_work();
+    this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_END_OF_WORK_ACK);
   }
 
 
-void slave_controller::process_item(MPI_detail::new_transfer_integration& payload)
+template <typename WorkItem, typename... WorkItems>
+bool slave_controller::receive_batch(const boost::mpi::status& stat, batch_queue& queue)
   {
-    const FRW_model& model = payload.get_model();
-    const Mpc_units::energy& k = payload.get_k();
-    const k_token& tok = payload.get_token();
-    const z_database& z_db = payload.get_z_db();
-
-    transfer_integrator integrator;
-    transfer_function sample = integrator.integrate(model, k, tok, z_db);
-
-    // inform master process that we have completed work on this integration
-    MPI_detail::transfer_integration_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
-  }
+    if(stat.tag() != MPI_detail::work_item_traits<WorkItem>::new_item_message())
+      return this->receive_batch<WorkItems...>(stat, queue);
 
+    auto batch = std::make_shared<typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type>();
+    this->mpi_world.recv(stat.source(), MPI_detail::work_item_traits<WorkItem>::new_item_message(), *batch);
 
-void slave_controller::process_item(MPI_detail::new_filter_Pk& payload)
-  {
-    const FRW_model& model = payload.get_model();
-    const Mpc_units::energy& k = payload.get_k();
-    const filterable_Pk& Pk_lin = payload.get_Pk_linear();
-    const Pk_filter_params& params = payload.get_params();
-    
-    const k_token& k_tok = payload.get_k_token();
-    const linear_Pk_token& Pk_tok = payload.get_Pk_token();
-    const filter_params_token& params_tok = payload.get_params_token();
-    
-    filtered_Pk_value sample;
-    try
-      {
-        Pk_filter filter(params);
-        auto out = filter(model, Pk_lin, k);
-        sample = filtered_Pk_value(k_tok, Pk_tok, params_tok, out.first, Pk_lin(k), out.second);
-      }
-    catch(runtime_exception& xe)
-      {
-        if(xe.get_exception_code() == exception_type::filter_failure)
-          {
-            this->err_handler.error(xe.what());
-            sample = filtered_Pk_value(k_tok, Pk_tok, params_tok, Pk_filter_result(), Pk_lin(k), 0.0);
-            sample.mark_failed();
-          }
-        else
-          {
-            throw;
-          }
-      }
-    
-    // inform master process we have finished work on this calculation
-    MPI_detail::filter_Pk_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
+    // defer processing until this batch reaches the front of the queue
+    queue.emplace_back([this, batch]() -> boost::mpi::request { return this->process_batch<WorkItem>(*batch); });
+    return true;
   }
 
 
-void slave_controller::process_item(MPI_detail::new_loop_momentum_integration& payload)
+template <typename... WorkItems>
+typename std::enable_if<sizeof...(WorkItems) == 0, bool>::type
+slave_controller::receive_batch(const boost::mpi::status& stat, batch_queue& queue)
   {
-    const FRW_model& model = payload.get_model();
-    const Mpc_units::energy& k = payload.get_k();
-    const Mpc_units::energy& UV_cutoff = payload.get_UV_cutoff();
-    const Mpc_units::energy& IR_cutoff = payload.get_IR_cutoff();
-    const loop_integral_params& params = payload.get_params();
-
-    const k_token& k_tok = payload.get_k_token();
-    const UV_cutoff_token& UV_tok = payload.get_UV_token();
-    const IR_cutoff_token& IR_tok = payload.get_IR_token();
-    const initial_filtered_Pk& Pk = payload.get_tree_power_spectrum();
-    const loop_integral_params_token& params_tok = payload.get_params_token();
-
-    oneloop_momentum_integrator integrator(params, this->err_handler);
-    loop_integral sample = integrator.integrate(model, params_tok, k, k_tok, UV_cutoff, UV_tok, IR_cutoff, IR_tok, Pk);
-
-    // inform master process that we have completed work on this integration
-    MPI_detail::loop_momentum_integration_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
+    // tag did not match any work type accepted by this task
+    return false;
   }
 
 
-void slave_controller::process_item(MPI_detail::new_Matsubara_XY& payload)
+template <typename WorkItem>
+boost::mpi::request
+slave_controller::process_batch(typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch)
   {
-    const Mpc_units::energy& IR_resum = payload.get_IR_resum();
-    const initial_filtered_Pk& Pk = payload.get_tree_power_spectrum();
-    const MatsubaraXY_params& params = payload.get_params();
-    
-    const IR_resum_token& IR_resum_tok = payload.get_IR_resum_token();
-    const MatsubaraXY_params_token params_tok = payload.get_params_token();
-    
-    Matsubara_XY_calculator calculator(params);
-    Matsubara_XY item = calculator.calculate_Matsubara_XY(IR_resum, IR_resum_tok, Pk, params_tok);
-    
-    // inform master process that the calculation is finished
-    MPI_detail::Matsubara_XY_ready return_payload(item);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
+    return this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::work_item_traits<WorkItem>::product_message(),
+                                 this->executor.process_batch<WorkItem>(batch, this->get_thread_pool()));
   }
 
 
-void slave_controller::process_item(MPI_detail::new_one_loop_Pk& payload)
+thread_pool& slave_controller::get_thread_pool()
   {
-    const Mpc_units::energy& k = payload.get_k();
-    const oneloop_growth& gf_factors = payload.get_gf_factors();
-    const loop_integral& loop_data = payload.get_loop_data();
-    const initial_filtered_Pk& Pk_init = payload.get_init_linear_Pk();
-    boost::optional<const final_filtered_Pk&> Pk_final = payload.get_final_linear_Pk();
-    
-    const k_token& k_tok = loop_data.get_k_token();
+    unsigned int threads = this->arg_cache.get_worker_threads();
+    if(!this->pool || this->pool->size() != threads) this->pool = std::make_unique<thread_pool>(threads);
 
-    oneloop_Pk_calculator calculator;
-    std::list<oneloop_Pk_set> sample = calculator.calculate_Pk(k, k_tok, gf_factors, loop_data, Pk_init, Pk_final);
-    
-    // inform master process that the calculation is finished
-    MPI_detail::one_loop_Pk_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
+    return *this->pool;
   }
 
 
-void slave_controller::process_item(MPI_detail::new_multipole_Pk& payload)
+template <typename FilteredPkType>
+void slave_controller::receive_filtered_Pk()
   {
-    const Mpc_units::energy& k = payload.get_k();
-    const Matsubara_XY& XY = payload.get_Matsubara_XY();
-    const oneloop_Pk_set& oneloop_data = payload.get_oneloop_Pk_data();
-    const oneloop_growth_record& Df_data = payload.get_Df_data();
-    const initial_filtered_Pk& Pk_init = payload.get_init_linear_Pk();
-    boost::optional<const final_filtered_Pk&> Pk_final = payload.get_final_linear_Pk();
-    
-    multipole_Pk_calculator calculator;
-    multipole_Pk_set sample = calculator.calculate_Legendre(k, XY, oneloop_data, Df_data, Pk_init, Pk_final);
-    
-    // inform master process that the calculation is finished
-    MPI_detail::multipole_Pk_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
-  }
+    // participate in broadcast initiated by the master
+    MPI_detail::cache_filtered_Pk<FilteredPkType> payload;
+    boost::mpi::broadcast(this->mpi_world, payload, MPI_detail::RANK_MASTER);
 
-
-void slave_controller::process_item(MPI_detail::new_counterterm& payload)
-  {
-    const Mpc_units::energy& k = payload.get_k();
-    const Matsubara_XY& XY = payload.get_Matsubara_XY();
-    const oneloop_growth_record& Df_data = payload.get_Df_data();
-    const initial_filtered_Pk& Pk_init = payload.get_init_linear_Pk();
-    boost::optional<const final_filtered_Pk&> Pk_final = payload.get_final_linear_Pk();
-
-    const k_token& k_token = payload.get_k_token();
-    const IR_cutoff_token& IR_tok = payload.get_IR_cutoff_token();
-    const UV_cutoff_token& UV_tok = payload.get_UV_cutoff_token();
-    const z_token& z_tok = payload.get_z_token();
-    const growth_params_token& growth_tok = payload.get_growth_params_token();
-
-    multipole_Pk_calculator calculator;
-    multipole_counterterm_set sample = calculator.calculate_counterterms(k, k_token, IR_tok, UV_tok, z_tok, growth_tok, XY, Df_data, Pk_init, Pk_final);
-
-    // inform master process that the calculation is finished
-    MPI_detail::counterterm_ready return_payload(sample);
-    boost::mpi::request ack = this->mpi_world.isend(MPI_detail::RANK_MASTER, MPI_detail::MESSAGE_WORK_PRODUCT_READY, return_payload);
-    ack.wait();
+    this->executor.add_filtered_Pk(payload.get_Pk());
   }
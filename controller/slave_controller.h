@@ -28,11 +28,19 @@
 
 
 #include <memory>
+#include <deque>
+#include <functional>
+#include <type_traits>
 
 #include "argument_cache.h"
 #include "local_environment.h"
+#include "thread_pool.h"
+#include "work_executor.h"
 
 #include "MPI_detail/mpi_operations.h"
+#include "MPI_detail/mpi_traits.h"
+
+#include "cosmology/concepts/power_spectrum.h"
 
 #include "error/error_handler.h"
 
@@ -82,50 +90,39 @@ class slave_controller
 
   protected:
 
-    //! process task corresponding to given work item type
-    template <typename WorkItem>
-    void process_task();
+    //! queue of received batches; each entry processes its batch and posts the results to the master
+    typedef std::deque< std::function<boost::mpi::request()> > batch_queue;
 
+    //! process task corresponding to given work item types; batches of any of these types
+    //! may be interleaved
+    template <typename... WorkItems>
+    void process_task();
 
-    // TRANSFER FUNCTION TASKS
+    //! receive a batch whose tag matches one of the given work item types and add it to the queue;
+    //! returns false if no type matches
+    template <typename WorkItem, typename... WorkItems>
+    bool receive_batch(const boost::mpi::status& stat, batch_queue& queue);
 
-  protected:
+    //! terminate recursion over work item types
+    template <typename... WorkItems>
+    typename std::enable_if<sizeof...(WorkItems) == 0, bool>::type
+    receive_batch(const boost::mpi::status& stat, batch_queue& queue);
 
-    //! integrate a given transfer function
-    void process_item(MPI_detail::new_transfer_integration& payload);
-    
-    
-    // LINEAR POWER SPECTRUM TASKS
-    
-  protected:
-    
-    //! filter a linear power spectrum into wiggle/no-wiggle components
-    void process_item(MPI_detail::new_filter_Pk& payload);
+    //! process a batch of work items and post the results to the master
+    template <typename WorkItem>
+    boost::mpi::request process_batch(typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch);
 
+    //! get thread pool used to process items within a batch, constructing it if necessary
+    thread_pool& get_thread_pool();
 
-    // LOOP MOMENTUM TASKS
 
-  protected:
+    // WORKER-RESIDENT POWER SPECTRA
 
-    //! integrate a given loop
-    void process_item(MPI_detail::new_loop_momentum_integration& payload);
-    
-    
-    // ONE-LOOP POWER SPECTRUM TASKS
-    
   protected:
-    
-    //! compute Matsubara's resummation X & Y coefficients
-    void process_item(MPI_detail::new_Matsubara_XY& payload);
-    
-    //! combine loop integral and growth-factor data to produce a 1-loop power spectrum
-    void process_item(MPI_detail::new_one_loop_Pk& payload);
-
-    //! combine 1-loop power spectrum data to produce multipole power spectra
-    void process_item(MPI_detail::new_multipole_Pk& payload);
 
-    //! compute counterterms
-    void process_item(MPI_detail::new_counterterm& payload);
+    //! receive a broadcast filtered power spectrum and make it resident in the executor
+    template <typename FilteredPkType>
+    void receive_filtered_Pk();
 
 
     // INTERNAL DATA
@@ -149,12 +146,18 @@ class slave_controller
     //! local environment properties (constructed locally)
     local_environment local_env;
 
+    //! thread pool; all threads share the power spectra resident in the executor
+    std::unique_ptr<thread_pool> pool;
+
 
     // Functional blocks
 
     //! error handler
     error_handler err_handler;
 
+    //! work executor; holds resident power spectra and performs the computation for each work item
+    work_executor executor;
+
   };
 
 
@@ -40,6 +40,9 @@ task_manager::task_manager(int argc, char* argv[])
       {
         master_ctrl.process_arguments(argc, argv);
       }
+    
+    // share configuration options with the workers
+    boost::mpi::broadcast(mpi_world, arg_cache, MPI_detail::RANK_MASTER);
   }
 
 
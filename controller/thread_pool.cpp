@@ -0,0 +1,127 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include "thread_pool.h"
+
+
+thread_pool::thread_pool(unsigned int N)
+  : job_size(0),
+    next(0),
+    busy(0),
+    generation(0),
+    shutdown(false)
+  {
+    for(unsigned int i = 1; i < N; ++i)
+      {
+        this->helpers.emplace_back(&thread_pool::helper_loop, this);
+      }
+  }
+
+
+thread_pool::~thread_pool()
+  {
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->shutdown = true;
+    }
+    this->wake.notify_all();
+
+    for(std::thread& t : this->helpers)
+      {
+        t.join();
+      }
+  }
+
+
+void thread_pool::run(size_t n, std::function<void(size_t)> f)
+  {
+    {
+      std::lock_guard<std::mutex> guard(this->lock);
+      this->job = std::move(f);
+      this->job_size = n;
+      this->next = 0;
+      this->failure = nullptr;
+      this->busy = static_cast<unsigned int>(this->helpers.size());
+      ++this->generation;
+    }
+    this->wake.notify_all();
+
+    // the calling thread participates too
+    this->work_on_job();
+
+    std::exception_ptr e;
+    {
+      std::unique_lock<std::mutex> guard(this->lock);
+      this->done.wait(guard, [&]() -> bool { return this->busy == 0; });
+      this->job = nullptr;
+      e = this->failure;
+    }
+
+    if(e) std::rethrow_exception(e);
+  }
+
+
+void thread_pool::work_on_job()
+  {
+    size_t i;
+    while((i = this->next.fetch_add(1)) < this->job_size)
+      {
+        try
+          {
+            this->job(i);
+          }
+        catch(...)
+          {
+            std::lock_guard<std::mutex> guard(this->lock);
+            if(!this->failure) this->failure = std::current_exception();
+
+            // abandon remaining items
+            this->next = this->job_size;
+          }
+      }
+  }
+
+
+void thread_pool::helper_loop()
+  {
+    unsigned long int seen = 0;
+
+    while(true)
+      {
+        {
+          std::unique_lock<std::mutex> guard(this->lock);
+          this->wake.wait(guard, [&]() -> bool { return this->shutdown || this->generation != seen; });
+          if(this->shutdown) return;
+          seen = this->generation;
+        }
+
+        this->work_on_job();
+
+        {
+          std::lock_guard<std::mutex> guard(this->lock);
+          --this->busy;
+          if(this->busy == 0) this->done.notify_all();
+        }
+      }
+  }
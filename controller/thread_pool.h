@@ -0,0 +1,140 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_THREAD_POOL_H
+#define LSSEFT_THREAD_POOL_H
+
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+
+//! fixed-size pool of threads used to process independent work items within a single process.
+//! Items are handed out dynamically, one index at a time, so threads which finish cheap items
+//! immediately pick up the next outstanding one and no thread idles while work remains.
+//! Everything referenced by the work function is shared, so read-only data (power spectra, splines)
+//! exist only once per process
+class thread_pool
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor; the pool has N threads in total, including the calling thread
+    thread_pool(unsigned int N);
+
+    //! destructor stops and joins all helper threads
+    ~thread_pool();
+
+
+    // INTERFACE
+
+  public:
+
+    //! get total number of threads, including the calling thread
+    unsigned int size() const { return(static_cast<unsigned int>(this->helpers.size()) + 1); }
+
+    //! apply f to each index in [0, n) and block until all have completed;
+    //! the first exception thrown by f is rethrown on the calling thread
+    template <typename Function>
+    void for_each(size_t n, Function f);
+
+
+    // INTERNAL API
+
+  private:
+
+    //! publish a new job to the helper threads, participate in it, and wait for completion
+    void run(size_t n, std::function<void(size_t)> f);
+
+    //! claim and process indices from the current job until none remain
+    void work_on_job();
+
+    //! main loop for helper threads
+    void helper_loop();
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! helper threads
+    std::vector<std::thread> helpers;
+
+    //! lock protecting job state
+    std::mutex lock;
+
+    //! signalled when a new job is available, or on shutdown
+    std::condition_variable wake;
+
+    //! signalled when all helpers have finished the current job
+    std::condition_variable done;
+
+    //! current job
+    std::function<void(size_t)> job;
+
+    //! number of indices in current job
+    size_t job_size;
+
+    //! next unclaimed index
+    std::atomic<size_t> next;
+
+    //! number of helpers still working on the current job
+    unsigned int busy;
+
+    //! job counter, used by helpers to detect new jobs
+    unsigned long int generation;
+
+    //! set when the pool is being destroyed
+    bool shutdown;
+
+    //! first exception raised by the current job, if any
+    std::exception_ptr failure;
+
+  };
+
+
+template <typename Function>
+void thread_pool::for_each(size_t n, Function f)
+  {
+    if(n == 0) return;
+
+    // no need to involve helper threads for a single item
+    if(n == 1 || this->helpers.empty())
+      {
+        for(size_t i = 0; i < n; ++i) f(i);
+        return;
+      }
+
+    this->run(n, std::function<void(size_t)>(f));
+  }
+
+
+#endif //LSSEFT_THREAD_POOL_H
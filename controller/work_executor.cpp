@@ -0,0 +1,387 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include "work_executor.h"
+
+#include "cosmology/transfer_integrator.h"
+#include "cosmology/oneloop_momentum_integrator.h"
+#include "cosmology/oneloop_P13_matrix.h"
+#include "cosmology/oneloop_fftlog.h"
+#include "cosmology/oneloop_cutoff_sweep.h"
+#include "cosmology/loop_tolerance_planner.h"
+#include "cosmology/oneloop_gauss_legendre_nodes.h"
+#include "cosmology/oneloop_Pk_calculator.h"
+#include "cosmology/multipole_Pk_calculator.h"
+#include "cosmology/Pk_filter.h"
+#include "cosmology/Matsubara_XY_calculator.h"
+
+#include "cosmology/types.h"
+
+#include "localizations/messages.h"
+
+
+work_executor::work_executor(error_handler& eh)
+  : err_handler(eh)
+  {
+  }
+
+
+void work_executor::add_filtered_Pk(const MPI_detail::filtered_Pk_set& Pks)
+  {
+    for(const auto& t : Pks.get_initial())
+      {
+        this->resident.add(t.second);
+      }
+
+    for(const auto& t : Pks.get_final())
+      {
+        this->resident.add(t.second);
+      }
+  }
+
+
+const initial_filtered_Pk& work_executor::find_initial_Pk(const linear_Pk_token& tok) const
+  {
+    auto t = this->resident.get_initial().find(tok.get_id());
+
+    if(t == this->resident.get_initial().end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_FILTERED_PK_NOT_RESIDENT << " " << tok.get_id();
+        throw runtime_exception(exception_type::runtime_error, msg.str());
+      }
+
+    return *t->second;
+  }
+
+
+boost::optional<const final_filtered_Pk&> work_executor::find_final_Pk(const boost::optional<linear_Pk_token>& tok) const
+  {
+    if(!tok) return boost::none;
+
+    auto t = this->resident.get_final().find(tok->get_id());
+
+    if(t == this->resident.get_final().end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_FILTERED_PK_NOT_RESIDENT << " " << tok->get_id();
+        throw runtime_exception(exception_type::runtime_error, msg.str());
+      }
+
+    return *t->second;
+  }
+
+
+MPI_detail::transfer_integration_ready work_executor::process_item(MPI_detail::new_transfer_integration& payload)
+  {
+    const FRW_model& model = payload.get_model();
+    const Mpc_units::energy& k = payload.get_k();
+    const k_token& tok = payload.get_token();
+    const z_database& z_db = payload.get_z_db();
+
+    transfer_integrator integrator;
+    transfer_function sample = integrator.integrate(model, k, tok, z_db);
+
+    // return work product to be batched for the master process
+    return MPI_detail::transfer_integration_ready(sample);
+  }
+
+
+MPI_detail::filter_Pk_ready work_executor::process_item(MPI_detail::new_filter_Pk& payload)
+  {
+    const FRW_model& model = payload.get_model();
+    const Mpc_units::energy& k = payload.get_k();
+    const filterable_Pk& Pk_lin = payload.get_Pk_linear();
+    const Pk_filter_params& params = payload.get_params();
+    
+    const k_token& k_tok = payload.get_k_token();
+    const linear_Pk_token& Pk_tok = payload.get_Pk_token();
+    const filter_params_token& params_tok = payload.get_params_token();
+    
+    filtered_Pk_value sample;
+    try
+      {
+        Pk_filter filter(params);
+        
+        auto t = this->reference_Pks.find(std::make_tuple(payload.get_model_token().get_id(), Pk_tok.get_id()));
+        if(t != this->reference_Pks.end()) filter.use_reference(t->second);
+        
+        auto out = filter(model, Pk_lin, k);
+        sample = filtered_Pk_value(k_tok, Pk_tok, params_tok, out.first, Pk_lin(k), out.second);
+      }
+    catch(runtime_exception& xe)
+      {
+        if(xe.get_exception_code() == exception_type::filter_failure)
+          {
+            this->err_handler.error(xe.what());
+            sample = filtered_Pk_value(k_tok, Pk_tok, params_tok, Pk_filter_result(), Pk_lin(k), 0.0);
+            sample.mark_failed();
+          }
+        else
+          {
+            throw;
+          }
+      }
+    
+    // return work product to be batched for the master process
+    return MPI_detail::filter_Pk_ready(sample);
+  }
+
+
+MPI_detail::loop_momentum_integration_ready work_executor::process_item(MPI_detail::new_loop_momentum_integration& payload)
+  {
+    const FRW_model& model = payload.get_model();
+    const Mpc_units::energy& k = payload.get_k();
+    const Mpc_units::energy& UV_cutoff = payload.get_UV_cutoff();
+    const Mpc_units::energy& IR_cutoff = payload.get_IR_cutoff();
+    const loop_integral_params& params = payload.get_params();
+
+    const k_token& k_tok = payload.get_k_token();
+    const UV_cutoff_token& UV_tok = payload.get_UV_token();
+    const IR_cutoff_token& IR_tok = payload.get_IR_token();
+    const initial_filtered_Pk& Pk = this->find_initial_Pk(payload.get_Pk_token());
+    const loop_integral_params_token& params_tok = payload.get_params_token();
+
+    oneloop_momentum_integrator integrator(params, this->err_handler);
+    
+    loop_group_key key = std::make_tuple(params_tok.get_id(), payload.get_Pk_token().get_id(), UV_tok.get_id(), IR_tok.get_id());
+    
+    auto t = this->P13_matrices.find(key);
+    if(t != this->P13_matrices.end()) integrator.use_P13_matrix(t->second);
+    
+    auto u = this->fftlog_engines.find(key);
+    if(u != this->fftlog_engines.end()) integrator.use_fftlog(u->second);
+    
+    auto g = this->gl_nodes.find(key);
+    if(g != this->gl_nodes.end()) integrator.use_gauss_legendre_nodes(g->second);
+    
+    auto v = this->cutoff_sweeps.find(std::make_tuple(params_tok.get_id(), payload.get_Pk_token().get_id(), k_tok.get_id()));
+    if(v != this->cutoff_sweeps.end()) integrator.use_cutoff_sweep(v->second);
+    
+    auto w = this->tolerance_planners.find(std::make_tuple(payload.get_model_token().get_id(), params_tok.get_id(),
+                                                           payload.get_Pk_token().get_id(), UV_tok.get_id(),
+                                                           IR_tok.get_id()));
+    if(w != this->tolerance_planners.end()) integrator.use_tolerance_planner(w->second);
+    
+    loop_integral sample = integrator.integrate(model, params_tok, k, k_tok, UV_cutoff, UV_tok, IR_cutoff, IR_tok, Pk);
+
+    // return work product to be batched for the master process
+    return MPI_detail::loop_momentum_integration_ready(sample);
+  }
+
+
+void work_executor::prepare_batch(MPI_detail::work_item_traits<filter_Pk_work_record>::outgoing_batch_type& batch)
+  {
+    std::set<reference_Pk_key> keys;
+    for(const auto& payload : batch.get_items())
+      {
+        keys.insert(std::make_tuple(payload.get_model_token().get_id(), payload.get_Pk_token().get_id()));
+      }
+    
+    // batches of a work list arrive grouped by linear power spectrum, so reference spectra not needed
+    // by this batch will not be needed again
+    for(auto t = this->reference_Pks.begin(); t != this->reference_Pks.end(); )
+      {
+        if(keys.count(t->first) == 0) t = this->reference_Pks.erase(t);
+        else                          ++t;
+      }
+    
+    for(const auto& payload : batch.get_items())
+      {
+        reference_Pk_key key = std::make_tuple(payload.get_model_token().get_id(), payload.get_Pk_token().get_id());
+        if(this->reference_Pks.count(key) == 0)
+          {
+            this->reference_Pks[key] = Pk_filter::eisenstein_hu(payload.get_model(), payload.get_Pk_linear());
+          }
+      }
+  }
+
+
+void work_executor::prepare_batch(MPI_detail::work_item_traits<loop_integral_work_record>::outgoing_batch_type& batch)
+  {
+    this->P13_matrices.clear();
+    this->fftlog_engines.clear();
+    this->cutoff_sweeps.clear();
+    this->gl_nodes.clear();
+    
+    // collect the wavenumbers belonging to each group of items which can share a P13 evaluation;
+    // only fixed-node rules can be written as matrix products
+    std::map< loop_group_key, std::vector<Mpc_units::energy> > grids;
+    std::map< loop_group_key, const MPI_detail::new_loop_momentum_integration* > representatives;
+    
+    // collect the cutoffs requested at each k, for items which are to be swept in a single pass
+    std::map< cutoff_sweep_key, std::pair< std::vector<Mpc_units::energy>, std::vector<Mpc_units::energy> > > sweeps;
+    std::map< cutoff_sweep_key, const MPI_detail::new_loop_momentum_integration* > sweep_representatives;
+    
+    for(const auto& payload : batch.get_items())
+      {
+        // planners are only needed when an error budget has been set
+        if(payload.get_params().get_target_err() > 0.0)
+          {
+            tolerance_planner_key key = std::make_tuple(payload.get_model_token().get_id(),
+                                                        payload.get_params_token().get_id(), payload.get_Pk_token().get_id(),
+                                                        payload.get_UV_token().get_id(), payload.get_IR_token().get_id());
+            if(this->tolerance_planners.count(key) == 0)
+              {
+                this->tolerance_planners[key] = std::make_shared<loop_tolerance_planner>(payload.get_params(), this->err_handler);
+              }
+          }
+        
+        if(payload.get_params().get_backend() == loop_integral_backend::cutoff_sweep)
+          {
+            cutoff_sweep_key key = std::make_tuple(payload.get_params_token().get_id(), payload.get_Pk_token().get_id(),
+                                                   payload.get_k_token().get_id());
+            sweeps[key].first.push_back(payload.get_UV_cutoff());
+            sweeps[key].second.push_back(payload.get_IR_cutoff());
+            sweep_representatives.emplace(key, &payload);
+            continue;
+          }
+        
+        loop_group_key key = std::make_tuple(payload.get_params_token().get_id(), payload.get_Pk_token().get_id(),
+                                             payload.get_UV_token().get_id(), payload.get_IR_token().get_id());
+        
+        // an FFTLog decomposition serves every k, so is worth building even for a single item
+        if(payload.get_params().get_backend() == loop_integral_backend::fftlog && this->fftlog_engines.count(key) == 0)
+          {
+            this->fftlog_engines[key] =
+              std::make_shared<oneloop_fftlog>(payload.get_model(), payload.get_UV_cutoff(), payload.get_IR_cutoff(),
+                                               this->find_initial_Pk(payload.get_Pk_token()));
+          }
+        
+        if(payload.get_params().get_backend() != loop_integral_backend::gauss_legendre) continue;
+        
+        // P(q) at the radial nodes is shared by every k; logarithmic nodes need a positive IR cutoff
+        if(payload.get_IR_cutoff() > Mpc_units::energy(0.0) && this->gl_nodes.count(key) == 0)
+          {
+            const initial_filtered_Pk& Pk = this->find_initial_Pk(payload.get_Pk_token());
+            wiggle_Pk_raw_adapter raw(Pk, payload.get_IR_cutoff(), payload.get_UV_cutoff());
+            wiggle_Pk_nowiggle_adapter nw(Pk, payload.get_IR_cutoff(), payload.get_UV_cutoff());
+            
+            this->gl_nodes[key] =
+              std::make_shared<oneloop_gauss_legendre_nodes>(payload.get_UV_cutoff(), payload.get_IR_cutoff(), raw, nw,
+                                                             payload.get_params().get_gl_points(),
+                                                             LSSEFT_DEFAULT_GAUSS_LEGENDRE_DOUBLINGS);
+          }
+        
+        grids[key].push_back(payload.get_k());
+        representatives.emplace(key, &payload);
+      }
+    
+    for(const auto& t : sweeps)
+      {
+        const MPI_detail::new_loop_momentum_integration& payload = *sweep_representatives[t.first];
+        
+        this->cutoff_sweeps[t.first] =
+          std::make_shared<oneloop_cutoff_sweep>(payload.get_model(), payload.get_k(), t.second.first, t.second.second,
+                                                 this->find_initial_Pk(payload.get_Pk_token()), payload.get_params());
+      }
+    
+    for(const auto& t : grids)
+      {
+        // a single wavenumber gains nothing from the matrix form
+        if(t.second.size() < 2) continue;
+        
+        const MPI_detail::new_loop_momentum_integration& payload = *representatives[t.first];
+        const loop_integral_params& params = payload.get_params();
+        
+        this->P13_matrices[t.first] =
+          std::make_shared<oneloop_P13_matrix>(payload.get_model(), t.second, payload.get_UV_cutoff(), payload.get_IR_cutoff(),
+                                               this->find_initial_Pk(payload.get_Pk_token()), params.get_gl_points(),
+                                               params.get_abserr_13(), params.get_relerr_13());
+      }
+  }
+
+
+MPI_detail::Matsubara_XY_ready work_executor::process_item(MPI_detail::new_Matsubara_XY& payload)
+  {
+    const Mpc_units::energy& IR_resum = payload.get_IR_resum();
+    const initial_filtered_Pk& Pk = this->find_initial_Pk(payload.get_Pk_token());
+    const MatsubaraXY_params& params = payload.get_params();
+    
+    const IR_resum_token& IR_resum_tok = payload.get_IR_resum_token();
+    const MatsubaraXY_params_token params_tok = payload.get_params_token();
+    
+    Matsubara_XY_calculator calculator(params);
+    Matsubara_XY item = calculator.calculate_Matsubara_XY(IR_resum, IR_resum_tok, Pk, params_tok);
+    
+    // return work product to be batched for the master process
+    return MPI_detail::Matsubara_XY_ready(item);
+  }
+
+
+MPI_detail::one_loop_Pk_ready work_executor::process_item(MPI_detail::new_one_loop_Pk& payload)
+  {
+    const Mpc_units::energy& k = payload.get_k();
+    const oneloop_growth& gf_factors = payload.get_gf_factors();
+    const loop_integral& loop_data = payload.get_loop_data();
+    const initial_filtered_Pk& Pk_init = this->find_initial_Pk(payload.get_init_Pk_token());
+    boost::optional<const final_filtered_Pk&> Pk_final = this->find_final_Pk(payload.get_final_Pk_token());
+    
+    const k_token& k_tok = loop_data.get_k_token();
+
+    oneloop_Pk_calculator calculator;
+    std::list<oneloop_Pk_set> sample = calculator.calculate_Pk(k, k_tok, gf_factors, loop_data, Pk_init, Pk_final);
+    
+    // return work product to be batched for the master process
+    return MPI_detail::one_loop_Pk_ready(sample);
+  }
+
+
+MPI_detail::multipole_Pk_ready work_executor::process_item(MPI_detail::new_multipole_Pk& payload)
+  {
+    const Mpc_units::energy& k = payload.get_k();
+    const Matsubara_XY& XY = payload.get_Matsubara_XY();
+    const oneloop_Pk_set& oneloop_data = payload.get_oneloop_Pk_data();
+    const oneloop_growth_record& Df_data = payload.get_Df_data();
+    const initial_filtered_Pk& Pk_init = this->find_initial_Pk(payload.get_init_Pk_token());
+    boost::optional<const final_filtered_Pk&> Pk_final = this->find_final_Pk(payload.get_final_Pk_token());
+    
+    multipole_Pk_calculator calculator;
+    multipole_Pk_set sample = calculator.calculate_Legendre(k, XY, oneloop_data, Df_data, Pk_init, Pk_final);
+    
+    // return work product to be batched for the master process
+    return MPI_detail::multipole_Pk_ready(sample);
+  }
+
+
+MPI_detail::counterterm_ready work_executor::process_item(MPI_detail::new_counterterm& payload)
+  {
+    const Mpc_units::energy& k = payload.get_k();
+    const Matsubara_XY& XY = payload.get_Matsubara_XY();
+    const oneloop_growth_record& Df_data = payload.get_Df_data();
+    const initial_filtered_Pk& Pk_init = this->find_initial_Pk(payload.get_init_Pk_token());
+    boost::optional<const final_filtered_Pk&> Pk_final = this->find_final_Pk(payload.get_final_Pk_token());
+
+    const k_token& k_token = payload.get_k_token();
+    const IR_cutoff_token& IR_tok = payload.get_IR_cutoff_token();
+    const UV_cutoff_token& UV_tok = payload.get_UV_cutoff_token();
+    const z_token& z_tok = payload.get_z_token();
+    const growth_params_token& growth_tok = payload.get_growth_params_token();
+
+    multipole_Pk_calculator calculator;
+    multipole_counterterm_set sample = calculator.calculate_counterterms(k, k_token, IR_tok, UV_tok, z_tok, growth_tok, XY, Df_data, Pk_init, Pk_final);
+
+    // return work product to be batched for the master process
+    return MPI_detail::counterterm_ready(sample);
+  }
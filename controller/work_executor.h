@@ -0,0 +1,272 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_WORK_EXECUTOR_H
+#define LSSEFT_WORK_EXECUTOR_H
+
+
+#include <memory>
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+
+#include "thread_pool.h"
+
+#include "MPI_detail/mpi_traits.h"
+#include "MPI_detail/mpi_payloads.h"
+
+#include "cosmology/concepts/power_spectrum.h"
+
+#include "error/error_handler.h"
+
+#include "boost/optional.hpp"
+#include "boost/timer/timer.hpp"
+
+
+// forward-declare batched P13 evaluator
+class oneloop_P13_matrix;
+
+// forward-declare FFTLog evaluator
+class oneloop_fftlog;
+
+// forward-declare single-pass cutoff sweep evaluator
+class oneloop_cutoff_sweep;
+
+// forward-declare per-kernel tolerance planner
+class loop_tolerance_planner;
+
+// forward-declare shared Gauss-Legendre node table
+class oneloop_gauss_legendre_nodes;
+
+
+//! performs the computation for each type of work item. Used by worker processes to handle batches received
+//! from the master, and by the master itself when running in shared-memory mode, where batches are built and
+//! processed in the same address space and never serialized
+class work_executor
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor
+    work_executor(error_handler& eh);
+
+    //! destructor is default
+    ~work_executor() = default;
+
+
+    // RESIDENT POWER SPECTRA
+
+  public:
+
+    //! add an initial filtered power spectrum to the resident set
+    void add_filtered_Pk(const std::shared_ptr<initial_filtered_Pk>& Pk) { this->resident.add(Pk); }
+
+    //! add a final filtered power spectrum to the resident set
+    void add_filtered_Pk(const std::shared_ptr<final_filtered_Pk>& Pk) { this->resident.add(Pk); }
+
+    //! add a set of filtered power spectra to the resident set
+    void add_filtered_Pk(const MPI_detail::filtered_Pk_set& Pks);
+
+  protected:
+
+    //! look up a resident initial filtered power spectrum
+    const initial_filtered_Pk& find_initial_Pk(const linear_Pk_token& tok) const;
+
+    //! look up a resident final filtered power spectrum, if one is required
+    boost::optional<const final_filtered_Pk&> find_final_Pk(const boost::optional<linear_Pk_token>& tok) const;
+
+
+    // BATCH PROCESSING
+
+  public:
+
+    //! process a batch of work items, spreading them over a thread pool; the returned batch
+    //! records the wall time spent computing
+    template <typename WorkItem>
+    typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type
+    process_batch(typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch, thread_pool& pool);
+    
+  protected:
+    
+    //! build state shared by all items in a batch; most work items need none
+    template <typename Batch>
+    void prepare_batch(Batch& batch) {}
+    
+    //! build the Eisenstein & Hu reference spectrum for each linear power spectrum in a batch of filtering tasks,
+    //! so that it is shared by every k rather than rebuilt for each; reference spectra persist between batches
+    //! of the same linear power spectrum, and are released when a batch moves on to another
+    void prepare_batch(MPI_detail::work_item_traits<filter_Pk_work_record>::outgoing_batch_type& batch);
+    
+    //! evaluate the P13 kernels for all loop integrals in a batch together, grouping items which share
+    //! a power spectrum, cutoffs and parameters; FFTLog decompositions and Gauss-Legendre node tables are shared
+    //! between the same groups,
+    //! and items differing only in their cutoffs share a single-pass cutoff sweep. Tolerance planners are
+    //! shared between the same groups within a model, and persist between batches of a work list
+    void prepare_batch(MPI_detail::work_item_traits<loop_integral_work_record>::outgoing_batch_type& batch);
+    
+  public:
+    
+    //! release state which persists between the batches of a single work list or pipeline
+    void end_of_work()
+      {
+        this->reference_Pks.clear();
+        this->tolerance_planners.clear();
+      }
+    
+  protected:
+    
+    //! release state shared by the items in a batch
+    void release_batch()
+      {
+        this->P13_matrices.clear();
+        this->fftlog_engines.clear();
+        this->cutoff_sweeps.clear();
+        this->gl_nodes.clear();
+      }
+
+
+    // TRANSFER FUNCTION TASKS
+
+  public:
+
+    //! integrate a given transfer function
+    MPI_detail::transfer_integration_ready process_item(MPI_detail::new_transfer_integration& payload);
+
+
+    // LINEAR POWER SPECTRUM TASKS
+
+  public:
+
+    //! filter a linear power spectrum into wiggle/no-wiggle components
+    MPI_detail::filter_Pk_ready process_item(MPI_detail::new_filter_Pk& payload);
+
+
+    // LOOP MOMENTUM TASKS
+
+  public:
+
+    //! integrate a given loop
+    MPI_detail::loop_momentum_integration_ready process_item(MPI_detail::new_loop_momentum_integration& payload);
+
+
+    // ONE-LOOP POWER SPECTRUM TASKS
+
+  public:
+
+    //! compute Matsubara's resummation X & Y coefficients
+    MPI_detail::Matsubara_XY_ready process_item(MPI_detail::new_Matsubara_XY& payload);
+
+    //! combine loop integral and growth-factor data to produce a 1-loop power spectrum
+    MPI_detail::one_loop_Pk_ready process_item(MPI_detail::new_one_loop_Pk& payload);
+
+    //! combine 1-loop power spectrum data to produce multipole power spectra
+    MPI_detail::multipole_Pk_ready process_item(MPI_detail::new_multipole_Pk& payload);
+
+    //! compute counterterms
+    MPI_detail::counterterm_ready process_item(MPI_detail::new_counterterm& payload);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! error handler, inherited from parent controller
+    error_handler& err_handler;
+
+    //! resident filtered power spectra; shared by all threads processing a batch
+    MPI_detail::filtered_Pk_set resident;
+    
+    //! key identifying loop integrals which can share precomputed state: parameters, power spectrum, UV and IR cutoff tokens
+    typedef std::tuple<unsigned int, unsigned int, unsigned int, unsigned int> loop_group_key;
+    
+    //! P13 evaluations for the batch currently being processed
+    std::map<loop_group_key, std::shared_ptr<oneloop_P13_matrix> > P13_matrices;
+    
+    //! FFTLog decompositions for the batch currently being processed
+    std::map<loop_group_key, std::shared_ptr<oneloop_fftlog> > fftlog_engines;
+    
+    //! Gauss-Legendre node tables for the batch currently being processed
+    std::map<loop_group_key, std::shared_ptr<oneloop_gauss_legendre_nodes> > gl_nodes;
+    
+    //! key identifying loop integrals which can share a cutoff sweep: parameters, power spectrum and k tokens
+    typedef std::tuple<unsigned int, unsigned int, unsigned int> cutoff_sweep_key;
+    
+    //! cutoff sweeps for the batch currently being processed
+    std::map<cutoff_sweep_key, std::shared_ptr<oneloop_cutoff_sweep> > cutoff_sweeps;
+    
+    //! key identifying loop integrals which can share a tolerance planner: model, parameters, power spectrum,
+    //! UV and IR cutoff tokens
+    typedef std::tuple<unsigned int, unsigned int, unsigned int, unsigned int, unsigned int> tolerance_planner_key;
+    
+    //! tolerance planners; these accumulate kernel magnitudes over every batch of a work list,
+    //! and are released when it ends
+    std::map<tolerance_planner_key, std::shared_ptr<loop_tolerance_planner> > tolerance_planners;
+    
+    //! key identifying filtering tasks which can share a reference power spectrum: model and power spectrum tokens
+    typedef std::tuple<unsigned int, unsigned int> reference_Pk_key;
+    
+    //! Eisenstein & Hu reference power spectra; these depend only on the model and linear power spectrum,
+    //! so are kept until the linear power spectrum changes or the work list ends
+    std::map<reference_Pk_key, std::shared_ptr<const approx_Pk> > reference_Pks;
+
+  };
+
+
+template <typename WorkItem>
+typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type
+work_executor::process_batch(typename MPI_detail::work_item_traits<WorkItem>::outgoing_batch_type& batch, thread_pool& pool)
+  {
+    using incoming_batch_type = typename MPI_detail::work_item_traits<WorkItem>::incoming_batch_type;
+    using incoming_payload_type = typename MPI_detail::work_item_traits<WorkItem>::incoming_payload_type;
+
+    // time the whole batch, so the master can estimate the compute-to-communication ratio
+    boost::timer::cpu_timer timer;
+    incoming_batch_type results;
+
+    auto& items = batch.get_items();
+    std::vector<incoming_payload_type> products(items.size());
+    
+    this->prepare_batch(batch);
+
+    // items are independent, so spread them over the thread pool
+    pool.for_each(items.size(), [&](size_t i) -> void { products[i] = this->process_item(items[i]); });
+    
+    this->release_batch();
+
+    for(auto& product : products)
+      {
+        results.push_back(std::move(product));
+      }
+
+    timer.stop();
+    results.set_compute_time(timer.elapsed().wall);
+
+    return results;
+  }
+
+
+#endif //LSSEFT_WORK_EXECUTOR_H
@@ -68,8 +68,9 @@ void master_controller::execute()
     // set up a list of IR cutoffs, measured in h/Mpc, to be used with the loop integrals
     stepping_range<Mpc_units::energy> IR_cutoffs(1E-4, 1E-4, 0, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
     
-    // set up a list of k at which to compute the loop integrals
-    stepping_range<Mpc_units::energy> loop_k_samples(0.005, 1.0, 500, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
+    // set up a coarse list of k at which to compute the loop integrals;
+    // it is refined below wherever interpolation between the samples does not meet the requested tolerance
+    stepping_range<Mpc_units::energy> loop_k_samples(0.005, 1.0, 100, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
     
     // set up a list of IR resummation scales, measured in h/Mpc
     stepping_range<Mpc_units::energy> IR_resummation(1.4, 1.4, 0, 1.0 / Mpc_units::Mpc, spacing_type::linear);
@@ -137,7 +138,7 @@ void master_controller::execute()
         
         // build a work list for filtering the linear power spectrum in wiggle/no-wiggle components
         std::shared_ptr<filterable_Pk> filterable_init_Pk_lin_db = make_filterable(*init_Pk_lin_db);
-        auto init_filter_work = dmgr.build_filter_Pk_work_list(*init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
+        auto init_filter_work = dmgr.build_filter_Pk_work_list(*model, *init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
         
         // distribute this work list among the worker processes
         if(init_filter_work) this->scatter(cosmology_model, *model, *init_filter_work, dmgr);
@@ -159,7 +160,7 @@ void master_controller::execute()
             
             // build a work list for filtering
             std::shared_ptr<filterable_Pk> filterable_final_Pk_lin_db = make_filterable(*final_Pk_lin_db);
-            auto final_filter_work = dmgr.build_filter_Pk_work_list(*final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
+            auto final_filter_work = dmgr.build_filter_Pk_work_list(*model, *final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
             
             // distribute this work list among the worker processes
             if(final_filter_work) this->scatter(cosmology_model, *model, *final_filter_work, dmgr);
@@ -184,6 +185,18 @@ void master_controller::execute()
         
         // STEP 3 - COMPUTE LOOP INTEGRALS
         
+        // when an error budget is set, weight each kernel's share of it by the growth factors multiplying it
+        if(loop_params.get_target_err() > 0.0)
+          {
+            auto weights = loop_tolerance_planner::growth_weights(*dmgr.find_growth_factors(*model, *growth_tok, *lo_z_db));
+            loop_params.set_growth_weights(weights.first, weights.second);
+          }
+        
+        // compute loop integrals on the coarse wavenumber grid, inserting wavenumbers wherever the BAO
+        // or the approach to the UV cutoff need them
+        this->refine_loop_k_db(cosmology_model, *model, dmgr, *growth_tok, *lo_z_db, loop_k_db, *IR_cutoff_db,
+                               *UV_cutoff_db, init_Pk_filt, final_Pk_filt, *loop_tok, loop_params);
+        
         // build a work list for the loop integrals
         std::unique_ptr<loop_integral_work_list> loop_momentum_work =
           dmgr.build_loop_momentum_work_list(*model, *loop_k_db, *IR_cutoff_db, *UV_cutoff_db, init_Pk_filt, *loop_tok, loop_params);
@@ -62,8 +62,9 @@ void master_controller::execute()
     // set up a list of IR cutoffs, measured in h/Mpc, to be used with the loop integrals
     stepping_range<Mpc_units::energy> IR_cutoffs(1E-4, 1E-4, 0, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
     
-    // set up a list of k at which to compute the loop integrals
-    stepping_range<Mpc_units::energy> loop_k_samples(0.005, 1.0, 500, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
+    // set up a coarse list of k at which to compute the loop integrals;
+    // it is refined below wherever interpolation between the samples does not meet the requested tolerance
+    stepping_range<Mpc_units::energy> loop_k_samples(0.005, 1.0, 100, 1.0 / Mpc_units::Mpc, spacing_type::logarithmic_bottom);
     
     // set up a list of IR resummation scales, measured in h/Mpc
     stepping_range<Mpc_units::energy> IR_resummation(1.4, 1.4, 0, 1.0 / Mpc_units::Mpc, spacing_type::linear);
@@ -131,7 +132,7 @@ void master_controller::execute()
         
         // build a work list for filtering the linear power spectrum in wiggle/no-wiggle components
         std::shared_ptr<filterable_Pk> filterable_init_Pk_lin_db = make_filterable(*init_Pk_lin_db);
-        auto init_filter_work = dmgr.build_filter_Pk_work_list(*init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
+        auto init_filter_work = dmgr.build_filter_Pk_work_list(*model, *init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
         
         // distribute this work list among the worker processes
         if(init_filter_work) this->scatter(cosmology_model, *model, *init_filter_work, dmgr);
@@ -153,7 +154,7 @@ void master_controller::execute()
             
             // build a work list for filtering
             std::shared_ptr<filterable_Pk> filterable_final_Pk_lin_db = make_filterable(*final_Pk_lin_db);
-            auto final_filter_work = dmgr.build_filter_Pk_work_list(*final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
+            auto final_filter_work = dmgr.build_filter_Pk_work_list(*model, *final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
             
             // distribute this work list among the worker processes
             if(final_filter_work) this->scatter(cosmology_model, *model, *final_filter_work, dmgr);
@@ -176,28 +177,55 @@ void master_controller::execute()
         if(Matsubara_work) this->scatter(cosmology_model, *model, *Matsubara_work, dmgr);
         
         
-        // STEP 3 - COMPUTE LOOP INTEGRALS
+        // STEP 3 - COMPUTE LOOP INTEGRALS, ONE-LOOP POWER SPECTRA AND COUNTERTERMS
+        
+        // these are computed as a single pipeline: a one-loop P(k) item depends only on the loop integral for
+        // its own (k, IR, UV) configuration, so it is released as soon as that integral has been stored.
+        // Counterterms depend only on the Matsubara X & Y coefficients, so they can be used to fill any gaps
+        
+        // when an error budget is set, weight each kernel's share of it by the growth factors multiplying it
+        if(loop_params.get_target_err() > 0.0)
+          {
+            auto weights = loop_tolerance_planner::growth_weights(*dmgr.find_growth_factors(*model, *growth_tok, *lo_z_db));
+            loop_params.set_growth_weights(weights.first, weights.second);
+          }
+        
+        // compute loop integrals on the coarse wavenumber grid, inserting wavenumbers wherever the BAO
+        // or the approach to the UV cutoff need them
+        this->refine_loop_k_db(cosmology_model, *model, dmgr, *growth_tok, *lo_z_db, loop_k_db, *IR_cutoff_db,
+                               *UV_cutoff_db, init_Pk_filt, final_Pk_filt, *loop_tok, loop_params);
         
         // build a work list for the loop integrals
         std::unique_ptr<loop_integral_work_list> loop_momentum_work =
           dmgr.build_loop_momentum_work_list(*model, *loop_k_db, *IR_cutoff_db, *UV_cutoff_db, init_Pk_filt, *loop_tok, loop_params);
+        if(loop_momentum_work) this->report_predicted_makespan(*loop_momentum_work);
         
-        // distribute this work list among the worker processes
-        if(loop_momentum_work) this->scatter(cosmology_model, *model, *loop_momentum_work, dmgr);
+        // build a work list for the individual power spectrum components whose loop integrals are already available
+        std::unique_ptr<one_loop_Pk_work_list> Pk_work =
+          dmgr.build_one_loop_Pk_work_list(*model, *growth_tok, *loop_tok, *lo_z_db, *loop_k_db,
+                                           *IR_cutoff_db, *UV_cutoff_db, init_Pk_filt, final_Pk_filt,
+                                           loop_momentum_work.get());
         
+        // build a work list for the counterterms
+        std::unique_ptr<counterterm_work_list> counterterm_work =
+          dmgr.build_counterterm_work_list(*model, *growth_tok, *XY_tok, *lo_z_db, *loop_k_db, *IR_cutoff_db, *UV_cutoff_db,
+                                           *IR_resum_db, init_Pk_filt, final_Pk_filt);
         
-        // STEP 4 - COMPUTE ONE-LOOP POWER SPECTRA IN REAL AND REDSHIFT SPACE
+        pipeline loop_pipeline(cosmology_model, *model);
+        auto& loop_stage = loop_pipeline.add_stage("loop integrals", std::move(loop_momentum_work));
+        auto& Pk_stage   = loop_pipeline.add_stage("one-loop P(k)", std::move(Pk_work));
+        loop_pipeline.add_stage("counterterms", std::move(counterterm_work));
         
-        // build a work list for the individual power spectrum components
-        std::unique_ptr<one_loop_Pk_work_list> Pk_work =
-          dmgr.build_one_loop_Pk_work_list(*model, *growth_tok, *loop_tok, *lo_z_db, *loop_k_db,
-                                           *IR_cutoff_db, *UV_cutoff_db, init_Pk_filt, final_Pk_filt);
+        if(loop_stage.ready() > 0)
+          {
+            connect(loop_stage, Pk_stage, dmgr.find_growth_factors(*model, *growth_tok, *lo_z_db), init_Pk_filt, final_Pk_filt);
+          }
         
-        // distribute this work list among the worker processes
-        if(Pk_work) this->scatter(cosmology_model, *model, *Pk_work, dmgr);
+        // distribute the pipeline among the worker processes
+        this->scatter(loop_pipeline, dmgr);
 
         
-        // STEP 5 - COMPUTE MULTIPOLE DECOMPOSIITON OF REDSHIFT-SPACE POWER SPECTRUM
+        // STEP 4 - COMPUTE MULTIPOLE DECOMPOSIITON OF REDSHIFT-SPACE POWER SPECTRUM
         
         // build a work list for the resummed multipole power spectra
         std::unique_ptr<multipole_Pk_work_list> multipole_Pk_work =
@@ -207,17 +235,6 @@ void master_controller::execute()
         
         // distribute this work list among the worker processes
         if(multipole_Pk_work) this->scatter(cosmology_model, *model, *multipole_Pk_work, dmgr);
-
-
-        // STEP 6 - COMPUTE MULTIPOLE COUNTERTERMS
-
-        // build a work list for the counterterms
-        std::unique_ptr<counterterm_work_list> counterterm_work =
-          dmgr.build_counterterm_work_list(*model, *growth_tok, *XY_tok, *lo_z_db, *loop_k_db, *IR_cutoff_db, *UV_cutoff_db,
-                                           *IR_resum_db, init_Pk_filt, final_Pk_filt);
-
-        // distribute this work list among the worker processes
-        if(counterterm_work) this->scatter(cosmology_model, *model, *counterterm_work, dmgr);
       }
     
     // instruct slave processes to terminate
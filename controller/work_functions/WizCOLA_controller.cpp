@@ -134,7 +134,7 @@ void master_controller::execute()
         
         // build a work list for filtering the linear power spectrum in wiggle/no-wiggle components
         std::shared_ptr<filterable_Pk> filterable_init_Pk_lin_db = make_filterable(*init_Pk_lin_db);
-        auto init_filter_work = dmgr.build_filter_Pk_work_list(*init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
+        auto init_filter_work = dmgr.build_filter_Pk_work_list(*model, *init_Pk_tok, filterable_init_Pk_lin_db, *filter_tok, filter_params);
         
         // distribute this work list among the worker processes
         if(init_filter_work) this->scatter(cosmology_model, *model, *init_filter_work, dmgr);
@@ -156,7 +156,7 @@ void master_controller::execute()
             
             // build a work list for filtering
             std::shared_ptr<filterable_Pk> filterable_final_Pk_lin_db = make_filterable(*final_Pk_lin_db);
-            auto final_filter_work = dmgr.build_filter_Pk_work_list(*final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
+            auto final_filter_work = dmgr.build_filter_Pk_work_list(*model, *final_Pk_tok, filterable_final_Pk_lin_db, *filter_tok, filter_params);
             
             // distribute this work list among the worker processes
             if(final_filter_work) this->scatter(cosmology_model, *model, *final_filter_work, dmgr);
@@ -181,6 +181,13 @@ void master_controller::execute()
         
         // STEP 3 - COMPUTE LOOP INTEGRALS
         
+        // when an error budget is set, weight each kernel's share of it by the growth factors multiplying it
+        if(loop_params.get_target_err() > 0.0)
+          {
+            auto weights = loop_tolerance_planner::growth_weights(*dmgr.find_growth_factors(*model, *growth_tok, *lo_z_db));
+            loop_params.set_growth_weights(weights.first, weights.second);
+          }
+        
         // build a work list for the loop integrals
         std::unique_ptr<loop_integral_work_list> loop_momentum_work =
           dmgr.build_loop_momentum_work_list(*model, *loop_k_db, *IR_cutoff_db, *UV_cutoff_db, init_Pk_filt, *loop_tok, loop_params);
@@ -23,6 +23,8 @@
 // --@@
 //
 
+#include <assert.h>
+
 #include "Matsubara_XY_calculator.h"
 
 #include "boost/math/special_functions/bessel.hpp"
@@ -33,7 +35,7 @@ namespace Matsubara_XY_calculator_impl
     
     constexpr unsigned int dimensions            = 2;       // k and q integrals
     constexpr unsigned int components            = 1;
-    constexpr unsigned int points_per_invocation = 1;
+    constexpr unsigned int points_per_invocation = 65;      // enough for a complete degree-13 rule in 2 dimensions, so each region is sampled in one call
     
     constexpr unsigned int verbosity_none        = 0;
     constexpr unsigned int verbosity_reasonable  = 1;
@@ -96,33 +98,66 @@ namespace Matsubara_XY_calculator_impl
       };
     
     
-    static int matsubara_X_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata)
+    //! map a batch of sample points to dimensionless s (in 1/Mpc) and q (in Mpc), and evaluate P(s) for the whole batch
+    inline void prepare_batch(const integrand_data& data, const int ndim, const int n, const cubareal* x,
+                              double* s, double* q, double* Pk)
+      {
+        const double s_lo = data.IR_cutoff * Mpc_units::Mpc;
+        const double s_range = data.s_range * Mpc_units::Mpc;
+        const double q_lo = data.qmin / Mpc_units::Mpc;
+        const double q_range = data.q_range / Mpc_units::Mpc;
+        
+        for(int i = 0; i < n; ++i)
+          {
+            s[i] = s_lo + x[i*ndim + 0] * s_range;
+            q[i] = q_lo + x[i*ndim + 1] * q_range;
+          }
+        
+        data.Pk.evaluate_batch(s, Pk, static_cast<unsigned int>(n));
+      }
+    
+    
+    // integrands accept batches of nvec points, laid out as x[i*ndim + d] and f[i*ncomp + c]
+    static int matsubara_X_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                     const int* nvec, const int* core)
       {
         Matsubara_XY_calculator_impl::integrand_data* data = static_cast<Matsubara_XY_calculator_impl::integrand_data*>(userdata);
         
-        Mpc_units::energy s = data->IR_cutoff + x[0] * data->s_range;
-        Mpc_units::inverse_energy q = data->qmin + x[1] * data->q_range;
+        const int n = *nvec;
+        assert(n <= static_cast<int>(points_per_invocation));
         
-        double qsq_dimless = q*q / Mpc_units::Mpc2;
-        double Pk_dimless = data->Pk(s) / Mpc_units::Mpc3;
+        double s[points_per_invocation];
+        double q[points_per_invocation];
+        double Pk[points_per_invocation];
+        prepare_batch(*data, *ndim, n, x, s, q, Pk);
         
-        f[0] = data->jacobian * qsq_dimless * Pk_dimless * (1.0/3.0 - (1.0/(q*s))*boost::math::sph_bessel(1, q*s));
+        for(int i = 0; i < n; ++i)
+          {
+            const double qs = q[i]*s[i];
+            f[i*(*ncomp)] = data->jacobian * q[i]*q[i] * Pk[i] * (1.0/3.0 - (1.0/qs)*boost::math::sph_bessel(1, qs));
+          }
         
         return(0);  // return value irrelevant unless = -999, which means stop integration
       }
     
     
-    static int matsubara_Y_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata)
+    static int matsubara_Y_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                     const int* nvec, const int* core)
       {
         Matsubara_XY_calculator_impl::integrand_data* data = static_cast<Matsubara_XY_calculator_impl::integrand_data*>(userdata);
         
-        Mpc_units::energy s = data->IR_cutoff + x[0] * data->s_range;
-        Mpc_units::inverse_energy q = data->qmin + x[1] * data->q_range;
-    
-        double qsq_dimless = q*q / Mpc_units::Mpc2;
-        double Pk_dimless = data->Pk(s) / Mpc_units::Mpc3;
-    
-        f[0] = data->jacobian * qsq_dimless * Pk_dimless * boost::math::sph_bessel(2, q*s);
+        const int n = *nvec;
+        assert(n <= static_cast<int>(points_per_invocation));
+        
+        double s[points_per_invocation];
+        double q[points_per_invocation];
+        double Pk[points_per_invocation];
+        prepare_batch(*data, *ndim, n, x, s, q, Pk);
+        
+        for(int i = 0; i < n; ++i)
+          {
+            f[i*(*ncomp)] = data->jacobian * q[i]*q[i] * Pk[i] * boost::math::sph_bessel(2, q[i]*s[i]);
+          }
         
         return(0);  // return value irrelevant unless = -999, which means stop integration
       }
@@ -149,8 +184,9 @@ Matsubara_XY_calculator::calculate_Matsubara_XY(const Mpc_units::energy& IR_resu
     // disable Cuba's built-in parallelization
     cubacores(0, Matsubara_XY_calculator_impl::pcores);
     
-    Mpc_units::inverse_energy2 X = this->compute_XY(IR_resum, k_min, nowiggle, Matsubara_XY_calculator_impl::matsubara_X_integrand);
-    Mpc_units::inverse_energy2 Y = this->compute_XY(IR_resum, k_min, nowiggle, Matsubara_XY_calculator_impl::matsubara_Y_integrand);
+    // batched integrands take extra nvec and core arguments, which Cuba supplies whatever the declared integrand type
+    Mpc_units::inverse_energy2 X = this->compute_XY(IR_resum, k_min, nowiggle, reinterpret_cast<integrand_t>(Matsubara_XY_calculator_impl::matsubara_X_integrand));
+    Mpc_units::inverse_energy2 Y = this->compute_XY(IR_resum, k_min, nowiggle, reinterpret_cast<integrand_t>(Matsubara_XY_calculator_impl::matsubara_Y_integrand));
     
     return Matsubara_XY(params_tok, Pk_lin.get_token(), IR_resum_tok, X, Y);
   }
@@ -24,6 +24,7 @@
 //
 
 #include <cmath>
+#include <assert.h>
 
 #include "Pk_filter.h"
 
@@ -35,7 +36,7 @@ namespace Pk_filter_impl
     
     constexpr unsigned int dimensions = 2;       // Cuhre only works in >= 2 dimensions, not 1
     constexpr unsigned int components = 1;
-    constexpr unsigned int points_per_invocation = 1;
+    constexpr unsigned int points_per_invocation = 65;     // enough for a complete degree-13 rule in 2 dimensions, so each region is sampled in one call
     
     constexpr unsigned int verbosity_none = 0;
     constexpr unsigned int verbosity_reasonable = 1;
@@ -94,26 +95,52 @@ namespace Pk_filter_impl
       };
     
     
-    static int filter_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata)
+    // integrands accept batches of nvec points, laid out as x[i*ndim + d] and f[i*ncomp + c]
+    static int filter_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                const int* nvec, const int* core)
       {
         auto* data = static_cast<Pk_filter_impl::integrand_data*>(userdata);
-    
-        double slog = data->slog_min + data->slog_range*x[0];
-        Mpc_units::energy s = std::pow(10.0, slog) / Mpc_units::Mpc;
-    
-        f[0] = data->jacobian * (data->Pk(s) / data->Pk_approx(s)) * std::exp(-(data->klog-slog)*(data->klog-slog) / (2.0*data->lambda*data->lambda));
-    
+        
+        const int n = *nvec;
+        assert(n <= static_cast<int>(points_per_invocation));
+        
+        double slog[points_per_invocation];
+        double s[points_per_invocation];
+        double Pk[points_per_invocation];
+        double Pk_approx[points_per_invocation];
+        
+        for(int i = 0; i < n; ++i)
+          {
+            slog[i] = data->slog_min + data->slog_range*x[i*(*ndim)];
+            s[i] = std::pow(10.0, slog[i]);
+          }
+        
+        // evaluate both spectra for the whole batch
+        data->Pk.evaluate_batch(s, Pk, static_cast<unsigned int>(n));
+        data->Pk_approx.evaluate_batch(s, Pk_approx, static_cast<unsigned int>(n));
+        
+        for(int i = 0; i < n; ++i)
+          {
+            const double dlog = data->klog - slog[i];
+            f[i*(*ncomp)] = data->jacobian * (Pk[i] / Pk_approx[i]) * std::exp(-dlog*dlog / (2.0*data->lambda*data->lambda));
+          }
+        
         return(0);  // return value irrelevant unless = -999, which means stop integration
       }
     
     
-    static int window_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata)
+    static int window_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                const int* nvec, const int* core)
       {
         auto* data = static_cast<Pk_filter_impl::integrand_data*>(userdata);
         
-        double slog = data->slog_min + data->slog_range*x[0];
-        
-        f[0] = data->jacobian * std::exp(-(data->klog-slog)*(data->klog-slog) / (2.0*data->lambda*data->lambda));
+        const int n = *nvec;
+        for(int i = 0; i < n; ++i)
+          {
+            const double slog = data->slog_min + data->slog_range*x[i*(*ndim)];
+            const double dlog = data->klog - slog;
+            f[i*(*ncomp)] = data->jacobian * std::exp(-dlog*dlog / (2.0*data->lambda*data->lambda));
+          }
         
         return(0);  // return value irrelevant unless = -999, which means stop integration
       }
@@ -124,8 +151,9 @@ namespace Pk_filter_impl
 std::pair< Pk_filter_result, Mpc_units::inverse_energy3 >
 Pk_filter::operator()(const FRW_model& model, const filterable_Pk& Pk_lin, const Mpc_units::energy& k)
   {
-    // build reference Eisenstein & Hu power spectrum
-    auto Papprox = this->eisenstein_hu(model, Pk_lin);
+    // build reference Eisenstein & Hu power spectrum, unless a precomputed one has been supplied
+    std::shared_ptr<const approx_Pk> Papprox = this->reference;
+    if(!Papprox) Papprox = Pk_filter::eisenstein_hu(model, Pk_lin);
     
     // get maximum available scale from linear power spectrum
     const Mpc_units::energy k_min = SPLINE_PK_DEFAULT_BOTTOM_CLEARANCE * Pk_lin.get_db().get_k_min();
@@ -145,8 +173,11 @@ Pk_filter::operator()(const FRW_model& model, const filterable_Pk& Pk_lin, const
     filter_result<double> filtered_Pk;
     filter_result<double> volume;
     
-    bool filter_fail = this->integrate(slog_min, slog_max, klog, lambda, Pk_lin, *Papprox, Pk_filter_impl::filter_integrand, filtered_Pk);
-    bool volume_fail = this->integrate(slog_min, slog_max, klog, lambda, Pk_lin, *Papprox, Pk_filter_impl::window_integrand, volume);
+    // batched integrands take extra nvec and core arguments, which Cuba supplies whatever the declared integrand type
+    bool filter_fail = this->integrate(slog_min, slog_max, klog, lambda, Pk_lin, *Papprox,
+                                       reinterpret_cast<integrand_t>(Pk_filter_impl::filter_integrand), filtered_Pk);
+    bool volume_fail = this->integrate(slog_min, slog_max, klog, lambda, Pk_lin, *Papprox,
+                                       reinterpret_cast<integrand_t>(Pk_filter_impl::window_integrand), volume);
 
     double raw_ratio = filtered_Pk.value / volume.value;
 
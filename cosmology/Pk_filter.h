@@ -203,6 +203,13 @@ class Pk_filter
     std::pair< Pk_filter_result, Mpc_units::inverse_energy3 >
     operator()(const FRW_model& model, const filterable_Pk& Pk_lin, const Mpc_units::energy& k);
     
+    //! use a precomputed reference power spectrum, rather than rebuilding it for each k; it must have been
+    //! built by eisenstein_hu() for the same model and linear power spectrum as are subsequently passed to operator()
+    void use_reference(std::shared_ptr<const approx_Pk> P) { this->reference = std::move(P); }
+
+    //! compute Eisenstein & Hu approximation to the power spectrum
+    static std::unique_ptr<approx_Pk> eisenstein_hu(const FRW_model& model, const filterable_Pk& Pk_lin);
+    
     
     // INTERNAL API
     
@@ -213,9 +220,6 @@ class Pk_filter
     bool integrate(const double slog_min, const double slog_max, const double klog, const double lambda,
                    const filterable_Pk& Pk_lin, const approx_Pk& Papprox, integrand_t integrand,
                    ResultType& result);
-
-    //! compute Eisenstein & Hu approximation to the power spectrum
-    std::unique_ptr<approx_Pk> eisenstein_hu(const FRW_model& model, const filterable_Pk& Pk_lin);
     
     
     // INTERNAL DATA
@@ -225,6 +229,9 @@ class Pk_filter
     //! filtering parameters
     const Pk_filter_params params;
     
+    //! precomputed reference power spectrum, if one has been supplied
+    std::shared_ptr<const approx_Pk> reference;
+    
   };
 
 
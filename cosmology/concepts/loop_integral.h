@@ -48,7 +48,10 @@ class loop_integral_result
         error(value_type(0.0)),
         regions(0),
         evaluations(0),
-        time(0)
+        time(0),
+        abs_tol(0.0),
+        rel_tol(0.0),
+        type(0)
       {
       }
     
@@ -66,6 +69,13 @@ class loop_integral_result
     unsigned int                  regions;
     unsigned int                  evaluations;
     boost::timer::nanosecond_type time;
+    
+    //! tolerances to which the value was accepted; zero if they were not recorded
+    double                        abs_tol;
+    double                        rel_tol;
+    
+    //! kernel type, 13 or 22, which selects the tolerances it is held to; zero if it was not recorded
+    unsigned int                  type;
   
   private:
     
@@ -80,6 +90,9 @@ class loop_integral_result
         ar & evaluations;
         ar & error;
         ar & time;
+        ar & abs_tol;
+        ar & rel_tol;
+        ar & type;
       }
 
   };
@@ -53,6 +53,18 @@ class generic_Pk
 
     //! evaluate spline
     virtual Dimension operator()(const Mpc_units::energy& k) const = 0;
+    
+    //! evaluate spline at a batch of n points, with k measured in 1/Mpc and P returned in the
+    //! corresponding power of Mpc; k and P may be the same array.
+    //! The default evaluates one point at a time, but implementations override this so that
+    //! a whole batch costs a single virtual call
+    virtual void evaluate_batch(const double* k, double* P, unsigned int n) const
+      {
+        for(unsigned int i = 0; i < n; ++i)
+          {
+            P[i] = static_cast<double>((*this)(k[i] / Mpc_units::Mpc));
+          }
+      }
 
   };
 
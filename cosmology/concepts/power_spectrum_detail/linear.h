@@ -113,6 +113,9 @@ class generic_linear_Pk
     //! evaluate spline
     Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const { return this->container(k); }
     
+    //! evaluate spline at a batch of points, with k in 1/Mpc and P in Mpc^3
+    void evaluate_batch(const double* k, double* P, unsigned int n) const { this->container.evaluate_batch(k, P, n); }
+    
     
     // METADATA
     
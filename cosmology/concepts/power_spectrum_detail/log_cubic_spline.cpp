@@ -0,0 +1,136 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <cmath>
+
+#include "log_cubic_spline.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+namespace log_cubic_spline_impl
+  {
+    
+    //! relative tolerance used to decide whether a grid is uniformly spaced in log k
+    constexpr double uniform_tolerance = 1E-8;
+    
+  }   // namespace log_cubic_spline_impl
+
+
+log_cubic_spline::log_cubic_spline()
+  : intervals(0),
+    uniform(false),
+    inv_h(0.0)
+  {
+  }
+
+
+log_cubic_spline::log_cubic_spline(const std::vector<double>& k, const std::vector<double>& f)
+  : log_cubic_spline()
+  {
+    this->fit(k, f);
+  }
+
+
+void log_cubic_spline::fit(const std::vector<double>& k, const std::vector<double>& f)
+  {
+    const size_t N = k.size();
+    if(N < 2 || f.size() != N) throw runtime_exception(exception_type::spline_error, ERROR_POWERSPECTRUM_SPLINE_TOO_FEW);
+    
+    this->x.resize(N);
+    for(size_t i = 0; i < N; ++i)
+      {
+        if(!(k[i] > 0.0)) throw runtime_exception(exception_type::spline_error, ERROR_POWERSPECTRUM_SPLINE_NOT_ORDERED);
+        this->x[i] = std::log(k[i]);
+        if(i > 0 && !(this->x[i] > this->x[i-1])) throw runtime_exception(exception_type::spline_error, ERROR_POWERSPECTRUM_SPLINE_NOT_ORDERED);
+      }
+    
+    this->intervals = N-1;
+    
+    std::vector<double> h(this->intervals);
+    for(size_t i = 0; i < this->intervals; ++i)
+      {
+        h[i] = this->x[i+1] - this->x[i];
+      }
+    
+    // natural spline: second derivatives vanish at the end points, and the interior values
+    // solve a symmetric tridiagonal system, which the Thomas algorithm handles in O(N)
+    std::vector<double> M(N, 0.0);
+    if(N > 2)
+      {
+        std::vector<double> diag(N, 0.0);
+        std::vector<double> rhs(N, 0.0);
+        
+        for(size_t i = 1; i < N-1; ++i)
+          {
+            diag[i] = 2.0*(h[i-1] + h[i]);
+            rhs[i] = 6.0*((f[i+1] - f[i])/h[i] - (f[i] - f[i-1])/h[i-1]);
+          }
+        
+        // forward elimination; the sub-diagonal entry in row i is h[i-1], the super-diagonal entry is h[i]
+        for(size_t i = 2; i < N-1; ++i)
+          {
+            const double w = h[i-1] / diag[i-1];
+            diag[i] -= w * h[i-1];
+            rhs[i] -= w * rhs[i-1];
+          }
+        
+        // back substitution
+        M[N-2] = rhs[N-2] / diag[N-2];
+        for(size_t i = N-2; i-- > 1; )
+          {
+            M[i] = (rhs[i] - h[i]*M[i+1]) / diag[i];
+          }
+      }
+    
+    this->coeffs.resize(4*this->intervals);
+    for(size_t i = 0; i < this->intervals; ++i)
+      {
+        double* c = this->coeffs.data() + 4*i;
+        c[0] = f[i];
+        c[1] = (f[i+1] - f[i])/h[i] - h[i]*(2.0*M[i] + M[i+1])/6.0;
+        c[2] = M[i]/2.0;
+        c[3] = (M[i+1] - M[i])/(6.0*h[i]);
+      }
+    
+    // detect a uniform grid, which allows O(1) interval lookup
+    const double h_mean = (this->x.back() - this->x.front()) / static_cast<double>(this->intervals);
+    this->uniform = true;
+    for(size_t i = 0; i < this->intervals && this->uniform; ++i)
+      {
+        if(std::abs(h[i] - h_mean) > log_cubic_spline_impl::uniform_tolerance * h_mean) this->uniform = false;
+      }
+    this->inv_h = this->uniform ? 1.0/h_mean : 0.0;
+  }
+
+
+void log_cubic_spline::rescale(double factor)
+  {
+    for(double& c : this->coeffs)
+      {
+        c *= factor;
+      }
+  }
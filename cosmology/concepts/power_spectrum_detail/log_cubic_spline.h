@@ -0,0 +1,160 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_LOG_CUBIC_SPLINE_H
+#define LSSEFT_LOG_CUBIC_SPLINE_H
+
+
+#include <vector>
+#include <cmath>
+#include <cstddef>
+
+#include "boost/serialization/serialization.hpp"
+#include "boost/serialization/vector.hpp"
+
+
+// cubic spline for a function sampled at positive abscissae, interpolating in log k;
+// coefficients for each interval are stored contiguously, so evaluation needs no allocation,
+// and the interval containing a point is found in O(1) on a uniform log grid
+// or by a branchless binary search otherwise
+class log_cubic_spline
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! empty constructor; the spline must be fitted before it can be evaluated
+    log_cubic_spline();
+    
+    //! value constructor; k must be strictly increasing and positive
+    log_cubic_spline(const std::vector<double>& k, const std::vector<double>& f);
+    
+    //! destructor is default
+    ~log_cubic_spline() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! fit a natural cubic spline to the samples
+    void fit(const std::vector<double>& k, const std::vector<double>& f);
+    
+    //! multiply the fitted function by a constant; the spline is linear in its sample values,
+    //! so this only rescales the coefficients
+    void rescale(double factor);
+    
+    //! get number of samples
+    size_t size() const { return this->x.size(); }
+    
+    //! evaluate at a single point
+    double operator()(double k) const
+      {
+        const double lx = std::log(k);
+        const size_t i = this->interval(lx);
+        
+        const double* c = this->coeffs.data() + 4*i;
+        const double t = lx - this->x[i];
+        
+        return c[0] + t*(c[1] + t*(c[2] + t*c[3]));
+      }
+    
+    //! evaluate at a batch of points; k and f may be the same array
+    void evaluate(const double* k, double* f, size_t n) const
+      {
+        for(size_t j = 0; j < n; ++j)
+          {
+            f[j] = (*this)(k[j]);
+          }
+      }
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! locate interval containing lx; points outside the sampled range use the first or last interval
+    size_t interval(double lx) const
+      {
+        if(this->uniform)
+          {
+            const double r = (lx - this->x.front()) * this->inv_h;
+            if(!(r > 0.0)) return 0;
+            const size_t i = static_cast<size_t>(r);
+            return i < this->intervals ? i : this->intervals-1;
+          }
+        
+        // branchless search for the last knot <= lx among the left ends of the intervals
+        const double* base = this->x.data();
+        size_t len = this->intervals;
+        while(len > 1)
+          {
+            const size_t half = len / 2;
+            base = (base[half] <= lx) ? base + half : base;
+            len -= half;
+          }
+        
+        return static_cast<size_t>(base - this->x.data());
+      }
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! knot positions, in log k
+    std::vector<double> x;
+    
+    //! polynomial coefficients, four per interval, in powers of (log k - x[i])
+    std::vector<double> coeffs;
+    
+    //! number of intervals
+    size_t intervals;
+    
+    //! are knots uniformly spaced in log k?
+    bool uniform;
+    
+    //! inverse knot spacing, if uniform
+    double inv_h;
+    
+    
+    // enable boost::serialization support, and hence automated packing for transmission over MPI;
+    // coefficients are transmitted with the knots, so receivers never need to refit
+    friend class boost::serialization::access;
+    
+    template <typename Archive>
+    void serialize(Archive& ar, unsigned int version)
+      {
+        ar & x;
+        ar & coeffs;
+        ar & intervals;
+        ar & uniform;
+        ar & inv_h;
+      }
+    
+  };
+
+
+#endif //LSSEFT_LOG_CUBIC_SPLINE_H
@@ -28,10 +28,12 @@
 
 #include <memory>
 #include <fstream>
+#include <vector>
 
 #include "database/Pk_database.h"
 
 #include "generic.h"
+#include "log_cubic_spline.h"
 
 #include "exceptions.h"
 #include "localizations/messages.h"
@@ -40,9 +42,6 @@
 #include "boost/serialization/serialization.hpp"
 #include "boost/serialization/split_member.hpp"
 
-#include "SPLINTER/datatable.h"
-#include "SPLINTER/bspline.h"
-#include "SPLINTER/bsplinebuilder.h"
 
 
 constexpr double SPLINE_PK_DEFAULT_TOP_CLEARANCE = 0.9;
@@ -95,10 +94,15 @@ class splined_Pk: public generic_Pk<Dimension>
   public:
     
     //! set rescaling factor;
-    //! needed (for example) for rescaling a power spectrum from one z to another using the linear scale factor
+    //! needed (for example) for rescaling a power spectrum from one z to another using the linear scale factor.
+    //! The factor is folded into the spline coefficients, so evaluation carries no extra multiply
     splined_Pk& set_rescaling(double f=1.0)
       {
-        if(f > 0.0) this->rescale_factor = std::abs(f);
+        if(f > 0.0)
+          {
+            this->spline.rescale(std::abs(f) / this->rescale_factor);
+            this->rescale_factor = std::abs(f);
+          }
         return *this;
       }
     
@@ -110,6 +114,9 @@ class splined_Pk: public generic_Pk<Dimension>
     //! evaluate
     Dimension operator()(const Mpc_units::energy& k) const override final { return this->evaluate(k); }
     
+    //! evaluate at a batch of points
+    void evaluate_batch(const double* k, double* P, unsigned int n) const override final;
+    
   private:
 
     //! evaluate spline, using k-range protection if enabled
@@ -121,6 +128,9 @@ class splined_Pk: public generic_Pk<Dimension>
     
     //! internal: evaluate spline
     Dimension evaluate_impl(const Mpc_units::energy& k) const;
+    
+    //! internal: throw if k lies outside the protected range of the spline
+    void check_range(const Mpc_units::energy& k) const;
 
 
     // INTERNAL API
@@ -138,11 +148,11 @@ class splined_Pk: public generic_Pk<Dimension>
     //! power spectrum
     Pk_database<Dimension> database;
 
-    //! splines representing power spectrum
-    std::unique_ptr<SPLINTER::DataTable> table;
-    std::unique_ptr<SPLINTER::BSpline> spline;
+    //! spline representing power spectrum, in units of DimensionTraits<Dimension>().unit();
+    //! its coefficients include the rescaling factor
+    log_cubic_spline spline;
     
-    //! rescaling factor
+    //! rescaling factor currently applied to the spline
     double rescale_factor;
 
 
@@ -155,6 +165,7 @@ class splined_Pk: public generic_Pk<Dimension>
       {
         ar << database;
         ar << rescale_factor;
+        ar << spline;
       }
     
     template <typename Archive>
@@ -162,7 +173,13 @@ class splined_Pk: public generic_Pk<Dimension>
       {
         ar >> database;
         ar >> rescale_factor;
-        if(database.size() > 0) this->recalculate_spline();
+        ar >> spline;
+        
+        // the fitted spline travels with the samples, so a refit is needed only if it is missing
+        if(database.size() > 0 && spline.size() != database.size())
+          {
+            this->recalculate_spline();
+          }
       }
     
     BOOST_SERIALIZATION_SPLIT_MEMBER()
@@ -182,30 +199,24 @@ splined_Pk<Tag, Dimension, protect>::splined_Pk(const Pk_database<Dimension>& db
 template <typename Tag, typename Dimension, bool protect>
 void splined_Pk<Tag, Dimension, protect>::recalculate_spline()
   {
-    this->table.release();
-    this->spline.release();
-    
-    this->table = std::make_unique<SPLINTER::DataTable>();
+    std::vector<double> k;
+    std::vector<double> Pk;
+    k.reserve(this->database.size());
+    Pk.reserve(this->database.size());
     
     for(typename Pk_database<Dimension>::const_record_iterator t = this->database.record_begin(); t != this->database.record_end(); ++t)
       {
-        this->table->addSample(t->get_wavenumber() * Mpc_units::Mpc, t->get_Pk() / Pk_database_impl::DimensionTraits<Dimension>().unit());
+        k.push_back(t->get_wavenumber() * Mpc_units::Mpc);
+        Pk.push_back(t->get_Pk() / Pk_database_impl::DimensionTraits<Dimension>().unit());
       }
     
-    try
-      {
-        this->spline = std::make_unique<SPLINTER::BSpline>(SPLINTER::BSpline::Builder(*this->table).degree(3).build());
-      }
-    catch(SPLINTER::Exception& xe)
-      {
-        throw runtime_exception(exception_type::spline_error, xe.what());
-      }
+    this->spline.fit(k, Pk);
+    this->spline.rescale(this->rescale_factor);
   }
 
 
 template <typename Tag, typename Dimension, bool protect>
-template <bool P, typename std::enable_if<P>::type*>
-Dimension splined_Pk<Tag, Dimension, protect>::evaluate(const Mpc_units::energy& k) const
+void splined_Pk<Tag, Dimension, protect>::check_range(const Mpc_units::energy& k) const
   {
     if(k > SPLINE_PK_DEFAULT_TOP_CLEARANCE * this->database.get_k_max())
       {
@@ -222,7 +233,14 @@ Dimension splined_Pk<Tag, Dimension, protect>::evaluate(const Mpc_units::energy&
             << this->database.get_k_min() * Mpc_units::Mpc << " h/Mpc)";
         throw std::overflow_error(msg.str());
       }
-    
+  }
+
+
+template <typename Tag, typename Dimension, bool protect>
+template <bool P, typename std::enable_if<P>::type*>
+Dimension splined_Pk<Tag, Dimension, protect>::evaluate(const Mpc_units::energy& k) const
+  {
+    this->check_range(k);
     return this->evaluate_impl(k);
   }
 
@@ -238,10 +256,23 @@ Dimension splined_Pk<Tag, Dimension, protect>::evaluate(const Mpc_units::energy&
 template <typename Tag, typename Dimension, bool protect>
 Dimension splined_Pk<Tag, Dimension, protect>::evaluate_impl(const Mpc_units::energy& k) const
   {
-    SPLINTER::DenseVector x(1);
-    x(0) = k * Mpc_units::Mpc;
+    return(this->spline(k * Mpc_units::Mpc) * Pk_database_impl::DimensionTraits<Dimension>().unit());
+  }
+
+
+template <typename Tag, typename Dimension, bool protect>
+void splined_Pk<Tag, Dimension, protect>::evaluate_batch(const double* k, double* P, unsigned int n) const
+  {
+    if(protect)
+      {
+        for(unsigned int i = 0; i < n; ++i)
+          {
+            this->check_range(k[i] / Mpc_units::Mpc);
+          }
+      }
     
-    return(this->rescale_factor * this->spline->eval(x) * Pk_database_impl::DimensionTraits<Dimension>().unit());
+    // batch values are measured in the same power of Mpc as the spline, so no conversion is needed
+    this->spline.evaluate(k, P, n);
   }
 
 
@@ -41,6 +41,19 @@ Mpc_units::inverse_energy3 wiggle_Pk_raw_adapter::operator()(const Mpc_units::en
   }
 
 
+void wiggle_Pk_raw_adapter::evaluate_batch(const double* k, double* P, unsigned int n) const
+  {
+    const double lo = this->klo * Mpc_units::Mpc;
+    const double hi = this->khi * Mpc_units::Mpc;
+    
+    // container is evaluated directly, so there is no virtual dispatch inside the loop
+    for(unsigned int i = 0; i < n; ++i)
+      {
+        P[i] = (k[i] < lo || k[i] > hi) ? 0.0 : static_cast<double>(this->container.Pk_raw(k[i] / Mpc_units::Mpc));
+      }
+  }
+
+
 wiggle_Pk_wiggle_adapter::wiggle_Pk_wiggle_adapter(const initial_filtered_Pk& w, const Mpc_units::energy& klo_, const Mpc_units::energy& khi_)
   : container(w),
     klo(klo_),
@@ -56,6 +69,19 @@ Mpc_units::inverse_energy3 wiggle_Pk_wiggle_adapter::operator()(const Mpc_units:
   }
 
 
+void wiggle_Pk_wiggle_adapter::evaluate_batch(const double* k, double* P, unsigned int n) const
+  {
+    const double lo = this->klo * Mpc_units::Mpc;
+    const double hi = this->khi * Mpc_units::Mpc;
+    
+    // container is evaluated directly, so there is no virtual dispatch inside the loop
+    for(unsigned int i = 0; i < n; ++i)
+      {
+        P[i] = (k[i] < lo || k[i] > hi) ? 0.0 : static_cast<double>(this->container.Pk_wiggle(k[i] / Mpc_units::Mpc));
+      }
+  }
+
+
 wiggle_Pk_nowiggle_adapter::wiggle_Pk_nowiggle_adapter(const initial_filtered_Pk& w, const Mpc_units::energy& klo_, const Mpc_units::energy& khi_)
   : container(w),
     klo(klo_),
@@ -69,3 +95,16 @@ Mpc_units::inverse_energy3 wiggle_Pk_nowiggle_adapter::operator()(const Mpc_unit
     if(k < this->klo || k > this->khi) return 0.0;
     return this->container.Pk_nowiggle(k);
   }
+
+
+void wiggle_Pk_nowiggle_adapter::evaluate_batch(const double* k, double* P, unsigned int n) const
+  {
+    const double lo = this->klo * Mpc_units::Mpc;
+    const double hi = this->khi * Mpc_units::Mpc;
+    
+    // container is evaluated directly, so there is no virtual dispatch inside the loop
+    for(unsigned int i = 0; i < n; ++i)
+      {
+        P[i] = (k[i] < lo || k[i] > hi) ? 0.0 : static_cast<double>(this->container.Pk_nowiggle(k[i] / Mpc_units::Mpc));
+      }
+  }
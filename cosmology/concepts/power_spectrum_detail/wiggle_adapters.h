@@ -27,6 +27,9 @@
 #define LSSEFT_POWER_SPECTRUM_SPLINE_H
 
 
+#include <algorithm>
+#include <limits>
+
 #include "units/Mpc_units.h"
 
 #include "generic.h"
@@ -55,6 +58,9 @@ class wiggle_Pk_raw_adapter: public generic_Pk<Mpc_units::inverse_energy3>
     //! evaluate spline
     Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final;
     
+    //! evaluate spline at a batch of points
+    void evaluate_batch(const double* k, double* P, unsigned int n) const override final;
+    
     
     // INTERNAL DATA
     
@@ -93,6 +99,9 @@ class wiggle_Pk_wiggle_adapter: public generic_Pk<Mpc_units::inverse_energy3>
     //! evaluate spline
     Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final;
     
+    //! evaluate spline at a batch of points
+    void evaluate_batch(const double* k, double* P, unsigned int n) const override final;
+    
     
     // INTERNAL DATA
   
@@ -131,6 +140,9 @@ class wiggle_Pk_nowiggle_adapter: public generic_Pk<Mpc_units::inverse_energy3>
     //! evaluate spline
     Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final;
     
+    //! evaluate spline at a batch of points
+    void evaluate_batch(const double* k, double* P, unsigned int n) const override final;
+    
     
     // INTERNAL DATA
   
@@ -148,4 +160,77 @@ class wiggle_Pk_nowiggle_adapter: public generic_Pk<Mpc_units::inverse_energy3>
   };
 
 
+// adapter which records the range of wavenumbers at which an underlying power spectrum is evaluated;
+// applying a window afterwards to that range is equivalent to having evaluated a windowed spectrum
+class range_recording_Pk_adapter: public generic_Pk<Mpc_units::inverse_energy3>
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+  
+  public:
+    
+    //! constructor captures underlying power spectrum
+    range_recording_Pk_adapter(const generic_Pk<Mpc_units::inverse_energy3>& P)
+      : Pk(P)
+      {
+        this->reset();
+      }
+    
+    //! destructor is default
+    ~range_recording_Pk_adapter() = default;
+    
+    
+    // INTERFACE
+  
+  public:
+    
+    //! forget recorded wavenumbers
+    void reset()
+      {
+        this->k_min = std::numeric_limits<double>::max();
+        this->k_max = 0.0;
+      }
+    
+    //! get smallest recorded wavenumber, measured in 1/Mpc
+    double get_min() const { return this->k_min; }
+    
+    //! get largest recorded wavenumber, measured in 1/Mpc
+    double get_max() const { return this->k_max; }
+    
+    //! evaluate spline
+    Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final
+      {
+        const double kv = k * Mpc_units::Mpc;
+        this->k_min = std::min(this->k_min, kv);
+        this->k_max = std::max(this->k_max, kv);
+        return this->Pk(k);
+      }
+    
+    //! evaluate at a batch of points
+    void evaluate_batch(const double* k, double* P, unsigned int n) const override final
+      {
+        for(unsigned int i = 0; i < n; ++i)
+          {
+            this->k_min = std::min(this->k_min, k[i]);
+            this->k_max = std::max(this->k_max, k[i]);
+          }
+        this->Pk.evaluate_batch(k, P, n);
+      }
+    
+    
+    // INTERNAL DATA
+  
+  private:
+    
+    //! capture underlying power spectrum
+    const generic_Pk<Mpc_units::inverse_energy3>& Pk;
+    
+    //! smallest recorded wavenumber, measured in 1/Mpc
+    mutable double k_min;
+    
+    //! largest recorded wavenumber, measured in 1/Mpc
+    mutable double k_max;
+    
+  };
+
 #endif //LSSEFT_POWER_SPECTRUM_SPLINE_H
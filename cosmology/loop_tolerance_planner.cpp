@@ -0,0 +1,178 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+
+#include "loop_tolerance_planner.h"
+
+#include "defaults.h"
+
+#include "localizations/messages.h"
+
+
+namespace loop_tolerance_planner_impl
+  {
+    
+    //! the cost of an adaptive integral is modelled as growing like (relative tolerance)^(-p); Cuhre's degree-7
+    //! rule in two dimensions has error falling roughly as the inverse cube of the number of regions
+    constexpr double cost_exponent = 1.0/3.0;
+    
+  }   // namespace loop_tolerance_planner_impl
+
+
+loop_tolerance_planner::loop_tolerance_planner(const loop_integral_params& p, error_handler& e)
+  : params(p),
+    complete(false),
+    err_handler(e)
+  {
+  }
+
+
+void loop_tolerance_planner::observe(const std::string& name, loop_integral_type type, const Mpc_units::energy& k,
+                                     double value)
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    loop_tolerance_planner_impl::kernel_record& rec = this->kernels[name];
+    rec.type = type;
+    rec.samples[k * Mpc_units::Mpc] = std::abs(value);
+  }
+
+
+void loop_tolerance_planner::mark_complete()
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->complete = !this->kernels.empty();
+  }
+
+
+double loop_tolerance_planner::relerr(const std::string& name, loop_integral_type type, const Mpc_units::energy& k,
+                                      double Ptree) const
+  {
+    using loop_tolerance_planner_impl::cost_exponent;
+    
+    const double floor = (type == loop_integral_type::P13 ? this->params.get_relerr_13() : this->params.get_relerr_22());
+    const double ceiling = std::max(floor, LSSEFT_DEFAULT_LOOP_TOLERANCE_CEILING);
+    
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    if(!this->complete || this->params.get_target_err() <= 0.0) return floor;
+    
+    auto t = this->kernels.find(name);
+    if(t == this->kernels.end()) return floor;
+    
+    const double k_Mpc = k * Mpc_units::Mpc;
+    
+    // minimizing the total cost sum_i (m_i/delta_i)^p, subject to the weighted errors a_i delta_i adding in
+    // quadrature to the budget, gives absolute errors delta_i proportional to (m_i^p / a_i^2)^(1/(p+2))
+    auto share = [&](double m, double a) -> double
+      {
+        return std::pow(std::pow(m, cost_exponent) / (a*a), 1.0 / (cost_exponent + 2.0));
+      };
+    
+    double total = 0.0;
+    for(const auto& u : this->kernels)
+      {
+        const double m = this->magnitude(u.second, k_Mpc);
+        const double a = this->sensitivity(u.second.type, Ptree);
+        if(m <= 0.0 || a <= 0.0) continue;
+        
+        const double s = a * share(m, a);
+        total += s*s;
+      }
+    
+    const double m = this->magnitude(t->second, k_Mpc);
+    const double a = this->sensitivity(type, Ptree);
+    
+    // a kernel which vanishes is controlled by the absolute tolerance alone
+    if(m <= 0.0 || a <= 0.0 || total <= 0.0) return ceiling;
+    
+    const double budget = this->params.get_target_err() * std::abs(Ptree);
+    const double delta = budget * share(m, a) / std::sqrt(total);
+    
+    // the budget cannot be met at the parameter block's tolerance; report this once per kernel
+    if(delta / m < floor && this->below_floor.insert(name).second)
+      {
+        std::ostringstream msg;
+        msg << WARNING_LOOP_TOLERANCE_BELOW_FLOOR_A << " " << name << ", " << WARNING_LOOP_TOLERANCE_BELOW_FLOOR_B << " "
+            << k_Mpc << ", " << WARNING_LOOP_TOLERANCE_BELOW_FLOOR_C << " " << delta / m << ", "
+            << WARNING_LOOP_TOLERANCE_BELOW_FLOOR_D << " " << floor;
+        this->err_handler.warn(msg.str());
+      }
+    
+    return std::min(ceiling, std::max(floor, delta / m));
+  }
+
+
+double loop_tolerance_planner::magnitude(const loop_tolerance_planner_impl::kernel_record& rec, double k) const
+  {
+    if(rec.samples.empty()) return 0.0;
+    
+    auto t = rec.samples.lower_bound(k);
+    if(t == rec.samples.end()) return std::prev(t)->second;
+    if(t == rec.samples.begin()) return t->second;
+    
+    auto s = std::prev(t);
+    return std::log(t->first / k) < std::log(k / s->first) ? t->second : s->second;
+  }
+
+
+double loop_tolerance_planner::sensitivity(loop_integral_type type, double Ptree) const
+  {
+    return type == loop_integral_type::P13 ? this->params.get_weight_13() * std::abs(Ptree) : this->params.get_weight_22();
+  }
+
+
+std::pair<double, double> loop_tolerance_planner::growth_weights(const oneloop_growth& gf)
+  {
+    double w_13 = 0.0;
+    double w_22 = 0.0;
+    
+    for(const oneloop_value& val : gf)
+      {
+        const oneloop_growth_record& r = val.second;
+        
+        const double D2 = r.D_lin * r.D_lin;
+        if(D2 <= 0.0) continue;
+        
+        // 13 terms pair a linear factor with a third-order one; 22 terms pair two second-order factors.
+        // Redshift-space multipoles also use the growth-rate weighted factors
+        const double g1 = std::abs(r.D_lin) * std::max(1.0, std::abs(r.f_lin));
+        const double g2 = std::max({ D2, std::abs(r.A), std::abs(r.B), std::abs(r.fA), std::abs(r.fB) });
+        const double g3 = std::max({ std::abs(r.D), std::abs(r.E), std::abs(r.F), std::abs(r.G), std::abs(r.J),
+                                     std::abs(r.fD), std::abs(r.fE), std::abs(r.fF), std::abs(r.fG), std::abs(r.fJ) });
+        
+        w_13 = std::max(w_13, g1 * g3 / D2);
+        w_22 = std::max(w_22, g2 * g2 / D2);
+      }
+    
+    // without any redshift samples, weight every kernel equally with the tree-level term
+    if(w_13 <= 0.0) w_13 = 1.0;
+    if(w_22 <= 0.0) w_22 = 1.0;
+    
+    return std::make_pair(w_13, w_22);
+  }
@@ -0,0 +1,143 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_LOOP_TOLERANCE_PLANNER_H
+#define LSSEFT_LOOP_TOLERANCE_PLANNER_H
+
+
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <mutex>
+
+#include "cosmology/oneloop_momentum_integrator.h"
+#include "cosmology/concepts/oneloop_growth.h"
+
+#include "error/error_handler.h"
+
+#include "units/Mpc_units.h"
+
+
+namespace loop_tolerance_planner_impl
+  {
+    
+    //! magnitudes of a single kernel, indexed by the wavenumber (in 1/Mpc) at which they were observed
+    class kernel_record
+      {
+        
+      public:
+        
+        //! kernel type
+        loop_integral_type type;
+        
+        //! absolute values of the raw kernel
+        std::map<double, double> samples;
+        
+      };
+    
+  }   // namespace loop_tolerance_planner_impl
+
+
+//! allocates relative tolerances to individual loop kernels from an error budget on the final power spectra.
+//! Each kernel enters the one-loop spectra multiplied by growth factors, so its absolute error is weighted
+//! by the largest of these relative to the tree-level growth factor. Kernel magnitudes are taken from earlier
+//! results for the same parameters, spectrum and cutoffs, so tolerances are planned only once a complete set
+//! of kernels has been observed. The budget is shared to minimize the total integration effort, which loosens
+//! the tolerance of small or lightly-weighted kernels. The parameter block's tolerances act as a floor, and a
+//! warning is issued the first time the budget asks for a kernel to be integrated more tightly than this.
+//! Allocations apply to every backend: precomputed P13 matrices, FFTLog decompositions and cutoff sweeps are
+//! built to the parameter block's tolerances and accepted against the allocation
+class loop_tolerance_planner
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor captures parameter block, which supplies the target accuracy and growth-factor weights,
+    //! and error handler
+    loop_tolerance_planner(const loop_integral_params& p, error_handler& e);
+    
+    //! destructor is default
+    ~loop_tolerance_planner() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! record the raw value of a kernel computed at k. Safe to call from multiple threads
+    void observe(const std::string& name, loop_integral_type type, const Mpc_units::energy& k, double value);
+    
+    //! mark the kernels observed so far as the complete set, after which tolerances are planned
+    void mark_complete();
+    
+    //! get the relative tolerance allocated to a kernel at k, given the tree-level power spectrum there
+    //! (measured in Mpc^3); until planning begins this is the parameter block's tolerance
+    double relerr(const std::string& name, loop_integral_type type, const Mpc_units::energy& k, double Ptree) const;
+    
+    //! compute the largest growth-factor weights of 13 and 22 kernels over a sample of growth factors,
+    //! relative to the tree-level factor D^2
+    static std::pair<double, double> growth_weights(const oneloop_growth& gf);
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! get magnitude of a kernel from the sample nearest to k in log k
+    double magnitude(const loop_tolerance_planner_impl::kernel_record& rec, double k) const;
+    
+    //! get sensitivity of the final spectra to a kernel; P13 kernels are dimensionless and multiply the
+    //! linear spectrum at k, whereas P22 kernels contribute directly
+    double sensitivity(loop_integral_type type, double Ptree) const;
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! parameter block
+    loop_integral_params params;
+    
+    //! observed kernels, indexed by name
+    std::map< std::string, loop_tolerance_planner_impl::kernel_record > kernels;
+    
+    //! has a complete set of kernels been observed?
+    bool complete;
+    
+    //! kernels for which the floor has already been reported
+    mutable std::set<std::string> below_floor;
+    
+    //! error handler
+    error_handler& err_handler;
+    
+    //! serialize access to the observations
+    mutable std::mutex lock;
+    
+  };
+
+
+#endif //LSSEFT_LOOP_TOLERANCE_PLANNER_H
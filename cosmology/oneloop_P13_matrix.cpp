@@ -0,0 +1,186 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "oneloop_P13_matrix.h"
+#include "oneloop_integrands/shared.h"
+
+#include "utilities/gauss_legendre.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+oneloop_P13_matrix::oneloop_P13_matrix(const FRW_model& m, const std::vector<Mpc_units::energy>& k,
+                                       const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                                       const initial_filtered_Pk& Pk, unsigned int n, double ae, double re)
+  : model(m),
+    k_grid(k),
+    UV_cutoff(UV),
+    IR_cutoff(IR),
+    abserr(ae),
+    relerr(re),
+    evaluations(0)
+  {
+    // spectra are sampled once, when the tables are built, and shared by every kernel and every k
+    wiggle_Pk_raw_adapter raw(Pk, IR_cutoff, UV_cutoff);
+    wiggle_Pk_nowiggle_adapter nw(Pk, IR_cutoff, UV_cutoff);
+    
+    this->build_rule(n, this->u_coarse, this->Pw_coarse, raw, nw);
+    this->build_rule(2*n, this->u_fine, this->Pw_fine, raw, nw);
+    
+    this->evaluations = 3*n;
+  }
+
+
+void oneloop_P13_matrix::build_rule(unsigned int n, std::vector<double>& u, Eigen::MatrixXd& Pw,
+                                    const generic_Pk<Mpc_units::inverse_energy3>& raw,
+                                    const generic_Pk<Mpc_units::inverse_energy3>& nw)
+  {
+    const gauss_legendre_rule& rule = gauss_legendre(n);
+    const std::vector<double>& z = rule.get_nodes();
+    const std::vector<double>& w = rule.get_weights();
+    
+    // nodes are uniform in log q; each weight carries the Jacobian dq/dlog q = q and the
+    // normalization of the unit interval used by the integrands
+    const double log_lo = std::log(this->IR_cutoff * Mpc_units::Mpc);
+    const double log_hi = std::log(this->UV_cutoff * Mpc_units::Mpc);
+    const double log_half = (log_hi - log_lo) / 2.0;
+    const double log_mid = (log_hi + log_lo) / 2.0;
+    const double q_range = (this->UV_cutoff - this->IR_cutoff) * Mpc_units::Mpc;
+    
+    std::vector<double> q(n);
+    for(unsigned int j = 0; j < n; ++j)
+      {
+        q[j] = std::exp(log_mid + log_half*z[j]);
+      }
+    
+    std::vector<double> P_raw(n);
+    std::vector<double> P_nw(n);
+    raw.evaluate_batch(q.data(), P_raw.data(), n);
+    nw.evaluate_batch(q.data(), P_nw.data(), n);
+    
+    u.resize(n);
+    Pw.resize(n, 2);
+    for(unsigned int j = 0; j < n; ++j)
+      {
+        u[j] = (q[j] - this->IR_cutoff * Mpc_units::Mpc) / q_range;
+        
+        const double W = log_half * w[j] * q[j] / q_range;
+        Pw(j, 0) = W * P_raw[j];
+        Pw(j, 1) = W * P_nw[j];
+      }
+  }
+
+
+Eigen::MatrixXd oneloop_P13_matrix::kernel_matrix(integrand_t integrand, const std::vector<double>& u) const
+  {
+    oneloop_momentum_impl::unit_Pk unit;
+    
+    const int ndim = oneloop_momentum_impl::dimensions;
+    const int ncomp = 1;
+    cubareal x[oneloop_momentum_impl::dimensions];
+    x[1] = oneloop_momentum_impl::trivial_angular_node;
+    
+    Eigen::MatrixXd K(this->k_grid.size(), u.size());
+    for(unsigned int i = 0; i < this->k_grid.size(); ++i)
+      {
+        oneloop_momentum_impl::integrand_data data(this->model, this->k_grid[i], this->UV_cutoff, this->IR_cutoff, unit);
+        
+        for(unsigned int j = 0; j < u.size(); ++j)
+          {
+            cubareal f;
+            x[0] = u[j];
+            integrand(&ndim, x, &ncomp, &f, &data);
+            K(i, j) = f;
+          }
+      }
+    
+    return K;
+  }
+
+
+std::vector<P13_matrix_value> oneloop_P13_matrix::evaluate(integrand_t integrand) const
+  {
+    boost::timer::cpu_timer timer;
+    
+    // one product per rule gives every wavenumber, for both spectra; the doubled rule is the
+    // estimate and its difference from the base rule is the error
+    Eigen::MatrixXd coarse = this->kernel_matrix(integrand, this->u_coarse) * this->Pw_coarse;
+    Eigen::MatrixXd fine = this->kernel_matrix(integrand, this->u_fine) * this->Pw_fine;
+    
+    const double norm = 8.0 * M_PI * M_PI;
+    
+    std::vector<P13_matrix_value> values(this->k_grid.size());
+    for(unsigned int i = 0; i < this->k_grid.size(); ++i)
+      {
+        P13_matrix_value& v = values[i];
+        
+        v.raw = fine(i, 0) / norm;
+        v.nowiggle = fine(i, 1) / norm;
+        v.raw_error = std::abs(fine(i, 0) - coarse(i, 0)) / norm;
+        v.nowiggle_error = std::abs(fine(i, 1) - coarse(i, 1)) / norm;
+        
+        v.converged = v.raw_error <= std::max(this->abserr, this->relerr * std::abs(v.raw))
+                      && v.nowiggle_error <= std::max(this->abserr, this->relerr * std::abs(v.nowiggle));
+      }
+    
+    timer.stop();
+    
+    // the cost of the matrix products is shared between all grid points
+    boost::timer::nanosecond_type time = timer.elapsed().wall / std::max(static_cast<size_t>(1), this->k_grid.size());
+    for(P13_matrix_value& v : values)
+      {
+        v.time = time;
+      }
+    
+    return values;
+  }
+
+
+const P13_matrix_value& oneloop_P13_matrix::get(integrand_t integrand, const Mpc_units::energy& k)
+  {
+    auto t = std::find_if(this->k_grid.cbegin(), this->k_grid.cend(),
+                          [&](const Mpc_units::energy& g) -> bool { return g.val == k.val; });
+    
+    if(t == this->k_grid.cend())
+      {
+        std::ostringstream msg;
+        msg << ERROR_P13_MATRIX_K_NOT_IN_GRID << " " << k * Mpc_units::Mpc;
+        throw runtime_exception(exception_type::runtime_error, msg.str());
+      }
+    
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    auto u = this->values.find(integrand);
+    if(u == this->values.end())
+      {
+        u = this->values.emplace(integrand, this->evaluate(integrand)).first;
+      }
+    
+    return u->second[t - this->k_grid.cbegin()];
+  }
@@ -0,0 +1,171 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ONELOOP_P13_MATRIX_H
+#define LSSEFT_ONELOOP_P13_MATRIX_H
+
+
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "FRW_model.h"
+#include "cosmology/concepts/power_spectrum.h"
+
+#include "units/Mpc_units.h"
+
+#include "cuba.h"
+
+#include "Eigen/Dense"
+
+#include "boost/timer/timer.hpp"
+
+
+//! result of a P13 kernel at a single wavenumber, for both the raw and no-wiggle spectra
+class P13_matrix_value
+  {
+    
+  public:
+    
+    //! raw value
+    double raw;
+    
+    //! raw error estimate
+    double raw_error;
+    
+    //! no-wiggle value
+    double nowiggle;
+    
+    //! no-wiggle error estimate
+    double nowiggle_error;
+    
+    //! time per grid point, shared between the raw and no-wiggle values
+    boost::timer::nanosecond_type time;
+    
+    //! did both values meet the requested tolerance?
+    bool converged;
+    
+  };
+
+
+//! evaluates P13-type kernels at every wavenumber in a grid at once.
+//! Once the angular integral is done the P13 kernels are linear in P(q), ie. of the form
+//! int dq K(k,q) P(q), so on a fixed set of Gauss-Legendre nodes q_j each kernel reduces to a
+//! matrix K(k_i, q_j) multiplied by the weighted spectra; the raw and no-wiggle spectra
+//! are the two columns of a single matrix product
+class oneloop_P13_matrix
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor captures the wavenumber grid and builds the quadrature tables
+    oneloop_P13_matrix(const FRW_model& m, const std::vector<Mpc_units::energy>& k, const Mpc_units::energy& UV,
+                       const Mpc_units::energy& IR, const initial_filtered_Pk& Pk, unsigned int n, double ae, double re);
+    
+    //! destructor is default
+    ~oneloop_P13_matrix() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! get value of a kernel at the grid point k; the kernel is evaluated over the whole
+    //! grid the first time it is requested. Safe to call from multiple threads
+    const P13_matrix_value& get(integrand_t integrand, const Mpc_units::energy& k);
+    
+    //! get number of kernel evaluations used for each grid point
+    unsigned int get_evaluations() const { return this->evaluations; }
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! fill node and weighted-spectrum tables for an n-point rule
+    void build_rule(unsigned int n, std::vector<double>& u, Eigen::MatrixXd& Pw,
+                    const generic_Pk<Mpc_units::inverse_energy3>& raw, const generic_Pk<Mpc_units::inverse_energy3>& nw);
+    
+    //! build the kernel matrix K(k_i, q_j) for one kernel on a given set of nodes
+    Eigen::MatrixXd kernel_matrix(integrand_t integrand, const std::vector<double>& u) const;
+    
+    //! evaluate a kernel over the whole grid
+    std::vector<P13_matrix_value> evaluate(integrand_t integrand) const;
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! FRW model
+    const FRW_model& model;
+    
+    //! wavenumber grid
+    std::vector<Mpc_units::energy> k_grid;
+    
+    //! UV cutoff
+    Mpc_units::energy UV_cutoff;
+    
+    //! IR cutoff
+    Mpc_units::energy IR_cutoff;
+    
+    //! absolute tolerance
+    double abserr;
+    
+    //! relative tolerance
+    double relerr;
+    
+    
+    // QUADRATURE TABLES
+    
+    //! positions of the nodes of the base rule, expressed as (q-IR)/(UV-IR)
+    std::vector<double> u_coarse;
+    
+    //! positions of the nodes of the doubled rule
+    std::vector<double> u_fine;
+    
+    //! weighted raw and no-wiggle spectra at the nodes of the base rule, one column each
+    Eigen::MatrixXd Pw_coarse;
+    
+    //! weighted raw and no-wiggle spectra at the nodes of the doubled rule
+    Eigen::MatrixXd Pw_fine;
+    
+    
+    // CACHED RESULTS
+    
+    //! values for each kernel which has been evaluated, indexed by grid point
+    std::map<integrand_t, std::vector<P13_matrix_value> > values;
+    
+    //! serialize evaluation of new kernels
+    std::mutex lock;
+    
+    //! number of kernel evaluations per grid point
+    unsigned int evaluations;
+    
+  };
+
+
+#endif //LSSEFT_ONELOOP_P13_MATRIX_H
@@ -0,0 +1,397 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+#include "oneloop_cutoff_sweep.h"
+#include "oneloop_integrands/shared.h"
+
+#include "utilities/gauss_legendre.h"
+
+#include "defaults.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+namespace oneloop_cutoff_sweep_impl
+  {
+    
+    //! minimum number of nodes in a panel of the composite rule
+    constexpr unsigned int min_panel_nodes = 16;
+    
+    //! number of nodes for a panel occupying a fraction of the full range, when the full range would use n;
+    //! the floor is applied before scaling, so that a doubled rule doubles every panel
+    inline unsigned int panel_nodes(unsigned int n, unsigned int scale, double fraction)
+      {
+        return scale * std::max(min_panel_nodes, static_cast<unsigned int>(std::ceil(n * fraction)));
+      }
+    
+    //! find the position of a cutoff in an ordered list; returns the list size if it is absent
+    inline size_t find_cutoff(const std::vector<Mpc_units::energy>& list, const Mpc_units::energy& c)
+      {
+        return static_cast<size_t>(std::find_if(list.cbegin(), list.cend(),
+                                                [&](const Mpc_units::energy& e) -> bool { return e.val == c.val; }) - list.cbegin());
+      }
+    
+  }   // namespace oneloop_cutoff_sweep_impl
+
+
+oneloop_cutoff_sweep::oneloop_cutoff_sweep(const FRW_model& m, const Mpc_units::energy& _k,
+                                           const std::vector<Mpc_units::energy>& UV, const std::vector<Mpc_units::energy>& IR,
+                                           const initial_filtered_Pk& _Pk, const loop_integral_params& p)
+  : model(m),
+    k(_k),
+    UV_cutoffs(UV),
+    IR_cutoffs(IR),
+    Pk(_Pk),
+    params(p)
+  {
+    auto less = [](const Mpc_units::energy& a, const Mpc_units::energy& b) -> bool { return a.val < b.val; };
+    auto equal = [](const Mpc_units::energy& a, const Mpc_units::energy& b) -> bool { return a.val == b.val; };
+    
+    std::sort(this->UV_cutoffs.begin(), this->UV_cutoffs.end(), less);
+    this->UV_cutoffs.erase(std::unique(this->UV_cutoffs.begin(), this->UV_cutoffs.end(), equal), this->UV_cutoffs.end());
+    
+    std::sort(this->IR_cutoffs.begin(), this->IR_cutoffs.end(), less);
+    this->IR_cutoffs.erase(std::unique(this->IR_cutoffs.begin(), this->IR_cutoffs.end(), equal), this->IR_cutoffs.end());
+    
+    // panel edges are every cutoff inside the widest range
+    const double lo = this->IR_cutoffs.front() * Mpc_units::Mpc;
+    const double hi = this->UV_cutoffs.back() * Mpc_units::Mpc;
+    for(const Mpc_units::energy& c : this->UV_cutoffs)
+      {
+        this->edges.push_back(c * Mpc_units::Mpc);
+      }
+    for(const Mpc_units::energy& c : this->IR_cutoffs)
+      {
+        this->edges.push_back(c * Mpc_units::Mpc);
+      }
+    
+    std::sort(this->edges.begin(), this->edges.end());
+    this->edges.erase(std::unique(this->edges.begin(), this->edges.end()), this->edges.end());
+    this->edges.erase(std::remove_if(this->edges.begin(), this->edges.end(),
+                                     [&](double e) -> bool { return e < lo || e > hi; }), this->edges.end());
+  }
+
+
+std::vector<double> oneloop_cutoff_sweep::accumulate(integrand_t integrand, loop_integral_type type, int orientation,
+                                                     unsigned int n, unsigned int scale, unsigned int& evaluations) const
+  {
+    const unsigned int nIR = static_cast<unsigned int>(this->IR_cutoffs.size());
+    const unsigned int nUV = static_cast<unsigned int>(this->UV_cutoffs.size());
+    const unsigned int ncomp = oneloop_momentum_impl::components_per_kernel;
+    
+    std::vector<double> table((nIR+1)*(nUV+1)*ncomp, 0.0);
+    
+    const Mpc_units::energy& IR_min = this->IR_cutoffs.front();
+    const Mpc_units::energy& UV_max = this->UV_cutoffs.back();
+    if(this->edges.size() < 2) return table;
+    
+    // the integrands see the widest range; narrower ranges are selected by the windows recorded at each point
+    wiggle_Pk_raw_adapter raw(this->Pk, IR_min, UV_max);
+    wiggle_Pk_nowiggle_adapter nw(this->Pk, IR_min, UV_max);
+    range_recording_Pk_adapter raw_recorder(raw);
+    
+    oneloop_momentum_impl::integrand_data raw_data(this->model, this->k, UV_max, IR_min, raw_recorder);
+    oneloop_momentum_impl::integrand_data nw_data(this->model, this->k, UV_max, IR_min, nw);
+    
+    std::vector<double> IR(nIR);
+    std::transform(this->IR_cutoffs.cbegin(), this->IR_cutoffs.cend(), IR.begin(),
+                   [](const Mpc_units::energy& c) -> double { return c * Mpc_units::Mpc; });
+    std::vector<double> UV(nUV);
+    std::transform(this->UV_cutoffs.cbegin(), this->UV_cutoffs.cend(), UV.begin(),
+                   [](const Mpc_units::energy& c) -> double { return c * Mpc_units::Mpc; });
+    
+    const double kk = this->k * Mpc_units::Mpc;
+    const double q_lo = IR_min * Mpc_units::Mpc;
+    const double q_range = (UV_max - IR_min) * Mpc_units::Mpc;
+    const double log_total = std::log(this->edges.back() / this->edges.front());
+    
+    const int ndim = oneloop_momentum_impl::dimensions;
+    const int single = 1;
+    cubareal x[oneloop_momentum_impl::dimensions];
+    
+    // evaluate raw and no-wiggle parts at one point, and file them under the tightest window containing
+    // every wavenumber the integrand used, including q itself
+    auto sample = [&](double q, double v, double W) -> void
+      {
+        x[0] = (q - q_lo) / q_range;
+        x[1] = v;
+        
+        cubareal f_raw = 0.0;
+        cubareal f_nw = 0.0;
+        raw_recorder.reset();
+        integrand(&ndim, x, &single, &f_raw, &raw_data);
+        integrand(&ndim, x, &single, &f_nw, &nw_data);
+        ++evaluations;
+        
+        const double lo = std::min(q, raw_recorder.get_min());
+        const double hi = std::max(q, raw_recorder.get_max());
+        
+        // a = number of IR cutoffs at or below the window; b = first UV cutoff at or above it
+        const size_t a = static_cast<size_t>(std::upper_bound(IR.cbegin(), IR.cend(), lo) - IR.cbegin());
+        const size_t b = static_cast<size_t>(std::lower_bound(UV.cbegin(), UV.cend(), hi) - UV.cbegin());
+        if(a == 0 || b == nUV) return;
+        
+        table[(a*(nUV+1) + b)*ncomp + 0] += W * f_raw;
+        table[(a*(nUV+1) + b)*ncomp + 1] += W * f_nw;
+      };
+    
+    // the q integrand is smooth between the cutoffs, except at q = k, where P13 kernels have logarithmic
+    // singularities and the lower limit of |k-q| turns over, and for P22 kernels where the range of |k-q|
+    // starts to cross a cutoff, at q = |k +/- c|
+    std::vector<double> q_edges = this->edges;
+    std::vector<double> extra = { kk };
+    if(type == loop_integral_type::P22)
+      {
+        for(double c : this->edges)
+          {
+            extra.push_back(std::abs(kk - c));
+            extra.push_back(kk + c);
+          }
+      }
+    
+    for(double e : extra)
+      {
+        if(e > this->edges.front() && e < this->edges.back()) q_edges.push_back(e);
+      }
+    
+    std::sort(q_edges.begin(), q_edges.end());
+    q_edges.erase(std::unique(q_edges.begin(), q_edges.end()), q_edges.end());
+    
+    for(unsigned int i = 0; i+1 < q_edges.size(); ++i)
+      {
+        // nodes are uniform in log q within each panel, so each weight carries the Jacobian dq/dlog q = q
+        const double log_a = std::log(q_edges[i]);
+        const double log_b = std::log(q_edges[i+1]);
+        const double log_half = (log_b - log_a) / 2.0;
+        const double log_mid = (log_b + log_a) / 2.0;
+        
+        const gauss_legendre_rule& q_rule = gauss_legendre(oneloop_cutoff_sweep_impl::panel_nodes(n, scale, 2.0*log_half / log_total));
+        const std::vector<double>& zq = q_rule.get_nodes();
+        const std::vector<double>& wq = q_rule.get_weights();
+        
+        for(unsigned int j = 0; j < q_rule.size(); ++j)
+          {
+            const double q = std::exp(log_mid + log_half*zq[j]);
+            const double Wq = log_half * wq[j] * q / q_range;
+            
+            // the angular direction is trivial for P13 kernels
+            if(type == loop_integral_type::P13)
+              {
+                sample(q, oneloop_momentum_impl::trivial_angular_node, Wq);
+                continue;
+              }
+            
+            // when the orientation of the angular variable is known, integrate over log |k-q| between the window
+            // edges; P(|k-q|) vanishes outside the widest window, and nodes uniform in log |k-q| resolve the
+            // power-law behaviour of the kernels where |k-q| is small
+            if(orientation != 0)
+              {
+                const double p_lo = std::max(std::abs(kk - q), this->edges.front());
+                const double p_hi = std::min(kk + q, this->edges.back());
+                if(p_hi <= p_lo) continue;
+                
+                std::vector<double> p_edges = { p_lo, p_hi };
+                for(double c : this->edges)
+                  {
+                    if(c > p_lo && c < p_hi) p_edges.push_back(c);
+                  }
+                std::sort(p_edges.begin(), p_edges.end());
+                
+                for(unsigned int l = 0; l+1 < p_edges.size(); ++l)
+                  {
+                    const double lp_a = std::log(p_edges[l]);
+                    const double lp_b = std::log(p_edges[l+1]);
+                    const double lp_half = (lp_b - lp_a) / 2.0;
+                    const double lp_mid = (lp_b + lp_a) / 2.0;
+                    
+                    const gauss_legendre_rule& p_rule = gauss_legendre(oneloop_cutoff_sweep_impl::panel_nodes(n, scale, 2.0*lp_half / log_total));
+                    const std::vector<double>& zp = p_rule.get_nodes();
+                    const std::vector<double>& wp = p_rule.get_weights();
+                    
+                    for(unsigned int m = 0; m < p_rule.size(); ++m)
+                      {
+                        // dv = |d cos theta|/2 = p^2 dlog p / 2kq
+                        const double p = std::exp(lp_mid + lp_half*zp[m]);
+                        const double cos_theta = (kk*kk + q*q - p*p) / (2.0*kk*q);
+                        const double v = (1.0 + orientation*cos_theta) / 2.0;
+                        sample(q, v, Wq * lp_half * wp[m] * p*p / (2.0*kk*q));
+                      }
+                  }
+                
+                continue;
+              }
+            
+            // otherwise |k-q| passes through a cutoff c where cos theta = (k^2 + q^2 - c^2)/2kq; break the angular
+            // integral there for either orientation of the angular variable, so that panels never straddle a window edge
+            std::vector<double> v_edges = { 0.0, 1.0 };
+            for(double c : this->edges)
+              {
+                const double cos_theta = (kk*kk + q*q - c*c) / (2.0*kk*q);
+                if(std::abs(cos_theta) < 1.0)
+                  {
+                    v_edges.push_back((1.0 + cos_theta) / 2.0);
+                    v_edges.push_back((1.0 - cos_theta) / 2.0);
+                  }
+              }
+            std::sort(v_edges.begin(), v_edges.end());
+            v_edges.erase(std::unique(v_edges.begin(), v_edges.end()), v_edges.end());
+            
+            for(unsigned int l = 0; l+1 < v_edges.size(); ++l)
+              {
+                const double v_half = (v_edges[l+1] - v_edges[l]) / 2.0;
+                const double v_mid = (v_edges[l+1] + v_edges[l]) / 2.0;
+                
+                const gauss_legendre_rule& v_rule = gauss_legendre(oneloop_cutoff_sweep_impl::panel_nodes(n, scale, 2.0*v_half));
+                const std::vector<double>& zv = v_rule.get_nodes();
+                const std::vector<double>& wv = v_rule.get_weights();
+                
+                for(unsigned int m = 0; m < v_rule.size(); ++m)
+                  {
+                    sample(q, v_mid + v_half*zv[m], Wq * v_half * wv[m]);
+                  }
+              }
+          }
+      }
+    
+    return table;
+  }
+
+
+std::vector<cutoff_sweep_value> oneloop_cutoff_sweep::evaluate(integrand_t integrand, loop_integral_type type) const
+  {
+    boost::timer::cpu_timer timer;
+    
+    const unsigned int nIR = static_cast<unsigned int>(this->IR_cutoffs.size());
+    const unsigned int nUV = static_cast<unsigned int>(this->UV_cutoffs.size());
+    const unsigned int ncomp = oneloop_momentum_impl::components_per_kernel;
+    
+    const double ae = (type == loop_integral_type::P13 ? this->params.get_abserr_13() : this->params.get_abserr_22());
+    const double re = (type == loop_integral_type::P13 ? this->params.get_relerr_13() : this->params.get_relerr_22());
+    const double norm = 8.0 * M_PI * M_PI;
+    
+    // the integral for IR cutoff i and UV cutoff j collects every table entry with a > i and b <= j
+    auto cumulate = [&](const std::vector<double>& table) -> std::vector<double>
+      {
+        std::vector<double> result(nIR*nUV*ncomp, 0.0);
+        for(unsigned int c = 0; c < ncomp; ++c)
+          {
+            for(unsigned int i = 0; i < nIR; ++i)
+              {
+                double running = 0.0;
+                for(unsigned int j = 0; j < nUV; ++j)
+                  {
+                    for(unsigned int a = i+1; a <= nIR; ++a)
+                      {
+                        running += table[(a*(nUV+1) + j)*ncomp + c];
+                      }
+                    result[(i*nUV + j)*ncomp + c] = running / norm;
+                  }
+              }
+          }
+        return result;
+      };
+    
+    // estimate error by comparison with a rule of twice the order, doubling until converged
+    const int orient = type == loop_integral_type::P22
+                       ? oneloop_momentum_impl::angular_orientation(integrand, this->model, this->k,
+                                                                    this->UV_cutoffs.back(), this->IR_cutoffs.front())
+                       : 0;
+    
+    const unsigned int n = this->params.get_gl_points();
+    unsigned int scale = 1;
+    unsigned int evaluations = 0;
+    std::vector<double> coarse = cumulate(this->accumulate(integrand, type, orient, n, scale, evaluations));
+    std::vector<double> fine;
+    std::vector<double> error(coarse.size(), 0.0);
+    
+    bool converged = false;
+    for(unsigned int d = 0; !converged && d < LSSEFT_DEFAULT_GAUSS_LEGENDRE_DOUBLINGS; ++d)
+      {
+        scale *= 2;
+        fine = cumulate(this->accumulate(integrand, type, orient, n, scale, evaluations));
+        
+        converged = true;
+        for(unsigned int c = 0; c < fine.size(); ++c)
+          {
+            error[c] = std::abs(fine[c] - coarse[c]);
+            if(error[c] > std::max(ae, re * std::abs(fine[c]))) converged = false;
+          }
+        
+        coarse.swap(fine);
+      }
+    
+    timer.stop();
+    
+    // the cost of the pass is shared between all cutoff pairs
+    const unsigned int pairs = std::max(1u, nIR*nUV);
+    const boost::timer::nanosecond_type time = timer.elapsed().wall / pairs;
+    
+    std::vector<cutoff_sweep_value> values(nIR*nUV);
+    for(unsigned int p = 0; p < values.size(); ++p)
+      {
+        cutoff_sweep_value& v = values[p];
+        
+        v.raw = coarse[p*ncomp + 0];
+        v.nowiggle = coarse[p*ncomp + 1];
+        v.raw_error = error[p*ncomp + 0];
+        v.nowiggle_error = error[p*ncomp + 1];
+        v.time = time;
+        v.evaluations = evaluations / pairs;
+        
+        v.converged = v.raw_error <= std::max(ae, re * std::abs(v.raw))
+                      && v.nowiggle_error <= std::max(ae, re * std::abs(v.nowiggle));
+      }
+    
+    return values;
+  }
+
+
+const cutoff_sweep_value& oneloop_cutoff_sweep::get(integrand_t integrand, loop_integral_type type,
+                                                    const Mpc_units::energy& UV, const Mpc_units::energy& IR)
+  {
+    const size_t i = oneloop_cutoff_sweep_impl::find_cutoff(this->IR_cutoffs, IR);
+    const size_t j = oneloop_cutoff_sweep_impl::find_cutoff(this->UV_cutoffs, UV);
+    
+    if(i == this->IR_cutoffs.size() || j == this->UV_cutoffs.size())
+      {
+        std::ostringstream msg;
+        msg << ERROR_CUTOFF_SWEEP_NOT_IN_GRID << " " << UV * Mpc_units::Mpc << ", " << IR * Mpc_units::Mpc;
+        throw runtime_exception(exception_type::runtime_error, msg.str());
+      }
+    
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    auto t = this->values.find(integrand);
+    if(t == this->values.end())
+      {
+        t = this->values.emplace(integrand, this->evaluate(integrand, type)).first;
+      }
+    
+    return t->second[i*this->UV_cutoffs.size() + j];
+  }
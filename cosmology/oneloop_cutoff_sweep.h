@@ -0,0 +1,154 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ONELOOP_CUTOFF_SWEEP_H
+#define LSSEFT_ONELOOP_CUTOFF_SWEEP_H
+
+
+#include <vector>
+#include <map>
+#include <mutex>
+
+#include "FRW_model.h"
+#include "cosmology/concepts/power_spectrum.h"
+#include "cosmology/oneloop_momentum_integrator.h"
+
+#include "units/Mpc_units.h"
+
+#include "cuba.h"
+
+#include "boost/timer/timer.hpp"
+
+
+//! result of a kernel for a single pair of cutoffs, for both the raw and no-wiggle spectra
+class cutoff_sweep_value
+  {
+    
+  public:
+    
+    //! raw value
+    double raw;
+    
+    //! raw error estimate
+    double raw_error;
+    
+    //! no-wiggle value
+    double nowiggle;
+    
+    //! no-wiggle error estimate
+    double nowiggle_error;
+    
+    //! time per cutoff pair, shared between the raw and no-wiggle values
+    boost::timer::nanosecond_type time;
+    
+    //! number of kernel evaluations per cutoff pair
+    unsigned int evaluations;
+    
+    //! did both values meet the requested tolerance?
+    bool converged;
+    
+  };
+
+
+//! evaluates one-loop kernels at a fixed k for every combination of a set of UV and IR cutoffs in a single pass.
+//! The cutoffs enter only through the window applied to P(k), so the integral over the widest range
+//! contains every narrower one: each sample point belongs to exactly those (IR, UV) pairs whose window
+//! covers every wavenumber at which the integrand evaluated the spectrum. Nodes of a composite
+//! Gauss-Legendre rule are placed so that panel edges fall on each cutoff, both in q and, for P22 kernels,
+//! in |k-q|, so the window never cuts through a panel
+class oneloop_cutoff_sweep
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor captures the cutoffs; kernels are integrated when first requested
+    oneloop_cutoff_sweep(const FRW_model& m, const Mpc_units::energy& k, const std::vector<Mpc_units::energy>& UV,
+                         const std::vector<Mpc_units::energy>& IR, const initial_filtered_Pk& Pk,
+                         const loop_integral_params& p);
+    
+    //! destructor is default
+    ~oneloop_cutoff_sweep() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! get value of a kernel for a pair of cutoffs; the kernel is integrated for every pair the first
+    //! time it is requested. Safe to call from multiple threads
+    const cutoff_sweep_value& get(integrand_t integrand, loop_integral_type type, const Mpc_units::energy& UV,
+                                  const Mpc_units::energy& IR);
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! sum contributions from an n-point base rule, with every panel scaled by 'scale', into the cumulative table; entry [a][b] of the table
+    //! collects sample points whose window lies above the first a IR cutoffs and below UV cutoff b onwards.
+    //! For P22 kernels with known orientation the angular integral is taken over log |k-q|
+    std::vector<double> accumulate(integrand_t integrand, loop_integral_type type, int orientation, unsigned int n,
+                                   unsigned int scale, unsigned int& evaluations) const;
+    
+    //! integrate a kernel for every pair of cutoffs
+    std::vector<cutoff_sweep_value> evaluate(integrand_t integrand, loop_integral_type type) const;
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! FRW model
+    const FRW_model& model;
+    
+    //! wavenumber
+    Mpc_units::energy k;
+    
+    //! UV cutoffs, in increasing order
+    std::vector<Mpc_units::energy> UV_cutoffs;
+    
+    //! IR cutoffs, in increasing order
+    std::vector<Mpc_units::energy> IR_cutoffs;
+    
+    //! all cutoffs, in increasing order without duplicates, measured in 1/Mpc; these are the panel edges
+    std::vector<double> edges;
+    
+    //! power spectrum
+    const initial_filtered_Pk& Pk;
+    
+    //! parameter block, supplying tolerances and the base node count
+    loop_integral_params params;
+    
+    //! kernel values for each (IR, UV) pair, stored with the UV index varying fastest
+    std::map< integrand_t, std::vector<cutoff_sweep_value> > values;
+    
+    //! serialize evaluation of kernels
+    std::mutex lock;
+    
+  };
+
+
+#endif //LSSEFT_ONELOOP_CUTOFF_SWEEP_H
@@ -0,0 +1,771 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <tuple>
+
+#include "oneloop_fftlog.h"
+#include "oneloop_integrands/shared.h"
+
+#include "utilities/fft.h"
+#include "utilities/gauss_legendre.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+namespace oneloop_fftlog_impl
+  {
+    
+    typedef std::complex<double> complex;
+    
+    //! P22 kernels are fitted with powers q^2a |k-q|^2b for -max_power <= a, b <= max_power
+    constexpr int fit_max_power = 3;
+    
+    //! number of sample points used to fit P22 kernels, and to check the fit
+    constexpr unsigned int fit_samples = 400;
+    constexpr unsigned int check_samples = 100;
+    
+    //! sample points for the fit have q/k and |k-q|/k in this range, where the basis is well conditioned
+    constexpr double fit_lo = 0.3;
+    constexpr double fit_hi = 3.0;
+    
+    //! seed for the sample points, so that fits are reproducible
+    constexpr unsigned int fit_seed = 1;
+    
+    //! maximum residual of an acceptable fit, relative to the largest sampled value of the kernel
+    constexpr double fit_tolerance = 1E-8;
+    
+    //! tolerance when checking that a kernel is homogeneous
+    constexpr double homogeneity_tolerance = 1E-6;
+    
+    //! minimum width of the range of biases for which a P22 decomposition converges
+    constexpr double min_bias_window = 0.2;
+    
+    //! fraction of the P22 coefficients left untapered; the hard cutoffs otherwise cause ringing
+    constexpr double taper_fraction = 0.75;
+    
+    //! Gauss-Legendre nodes per cell of the P13 Mellin tables
+    constexpr unsigned int cell_nodes = 8;
+    
+    //! extra cells at each end of the P13 Mellin tables, allowing k slightly outside the cutoffs
+    constexpr unsigned int table_margin = 2;
+    
+    
+    //! log Gamma for complex argument, by the Lanczos approximation
+    complex log_gamma(complex z)
+      {
+        static const double c[] = { 0.99999999999980993, 676.5203681218851, -1259.1392167224028,
+                                     771.32342877765313, -176.61502916214059, 12.507343278686905,
+                                     -0.13857109526572012, 9.9843695780195716E-6, 1.5056327351493116E-7 };
+        
+        // use reflection formula in the left half-plane
+        if(z.real() < 0.5) return std::log(M_PI / std::sin(M_PI * z)) - log_gamma(1.0 - z);
+        
+        z -= 1.0;
+        complex x = c[0];
+        for(unsigned int i = 1; i < 9; ++i)
+          {
+            x += c[i] / (z + static_cast<double>(i));
+          }
+        
+        const complex t = z + 7.5;
+        return 0.5*std::log(2.0*M_PI) + (z + 0.5)*std::log(t) - t + std::log(x);
+      }
+    
+    
+    //! compute power-law coefficients c_m, |m| <= n/2, of every stride-th sample taken on a uniform grid in log q
+    //! with first point log_q0 and spacing delta; the grid has period 'period' in log q, and coefficients are
+    //! stored at index m + N/2
+    void decompose(const std::vector<double>& samples, unsigned int stride, double log_q0, double delta, double period,
+                   double bias, bool taper, unsigned int N, std::vector<complex>& c)
+      {
+        const unsigned int n = static_cast<unsigned int>(samples.size()) / stride;
+        
+        std::vector<complex> a(n);
+        for(unsigned int j = 0; j < n; ++j)
+          {
+            a[j] = samples[j*stride] * std::exp(-bias * (log_q0 + j*stride*delta));
+          }
+        
+        fft(a);
+        
+        c.assign(N+1, 0.0);
+        const int half = static_cast<int>(n/2);
+        for(int m = -half; m <= half; ++m)
+          {
+            const double eta = 2.0*M_PI*m / period;
+            complex cm = a[(m + static_cast<int>(n)) % n] / static_cast<double>(n) * std::exp(complex(0.0, -eta*log_q0));
+            
+            // the Nyquist frequency is shared between m = +n/2 and m = -n/2
+            if(std::abs(m) == half) cm *= 0.5;
+            
+            const double f = static_cast<double>(std::abs(m)) / half;
+            if(taper && f > taper_fraction)
+              {
+                const double w = (f - taper_fraction) / (1.0 - taper_fraction);
+                cm *= 1.0 - w + std::sin(2.0*M_PI*w) / (2.0*M_PI);
+              }
+            
+            c[m + static_cast<int>(N/2)] = cm;
+          }
+      }
+    
+    
+    //! evaluate a P13 integrand as a kernel K(k, q), with k and q measured in 1/Mpc
+    double kernel_13(integrand_t integrand, const FRW_model& model, double k, double q)
+      {
+        oneloop_momentum_impl::unit_Pk unit;
+        
+        // a unit range makes u = q and the Jacobian equal to one
+        const Mpc_units::energy k_e = k / Mpc_units::Mpc;
+        const Mpc_units::energy UV = 1.0 / Mpc_units::Mpc;
+        const Mpc_units::energy IR = 0.0 / Mpc_units::Mpc;
+        oneloop_momentum_impl::integrand_data data(model, k_e, UV, IR, unit);
+        
+        const int ndim = oneloop_momentum_impl::dimensions;
+        const int ncomp = 1;
+        cubareal x[oneloop_momentum_impl::dimensions] = { q, oneloop_momentum_impl::trivial_angular_node };
+        cubareal f = 0.0;
+        integrand(&ndim, x, &ncomp, &f, &data);
+        
+        return f;
+      }
+    
+    
+    //! evaluate a P22 integrand as a kernel G(k, q, |k-q|) against the measure d^3q, with x the cosine of the
+    //! angle between k and q; 'flip' selects whether the angular variable of the integrand runs with x or against it
+    double kernel_22(integrand_t integrand, const FRW_model& model, double k, double q, double x, bool flip)
+      {
+        oneloop_momentum_impl::unit_Pk unit;
+        
+        const Mpc_units::energy k_e = k / Mpc_units::Mpc;
+        const Mpc_units::energy UV = 1.0 / Mpc_units::Mpc;
+        const Mpc_units::energy IR = 0.0 / Mpc_units::Mpc;
+        oneloop_momentum_impl::integrand_data data(model, k_e, UV, IR, unit);
+        
+        const int ndim = oneloop_momentum_impl::dimensions;
+        const int ncomp = 1;
+        cubareal v[oneloop_momentum_impl::dimensions] = { q, flip ? (1.0 - x)/2.0 : (1.0 + x)/2.0 };
+        cubareal f = 0.0;
+        integrand(&ndim, v, &ncomp, &f, &data);
+        
+        // du dv = dq dx / 2 on a unit range, and d^3q = 2 pi q^2 dq dx
+        return f / (2.0 * 2.0*M_PI * q*q);
+      }
+    
+    
+    //! determine the degree of a homogeneous function from its values at a set of points and at
+    //! the same points scaled by 2; returns false if the degree is inconsistent
+    bool homogeneity(const std::vector<double>& base, const std::vector<double>& scaled, double& degree)
+      {
+        std::vector<double> d;
+        for(unsigned int i = 0; i < base.size(); ++i)
+          {
+            if(base[i] == 0.0 || !std::isfinite(base[i]) || !std::isfinite(scaled[i])) continue;
+            if(scaled[i] / base[i] <= 0.0) return false;
+            d.push_back(std::log(scaled[i] / base[i]) / std::log(2.0));
+          }
+        
+        if(d.empty()) return false;
+        
+        auto range = std::minmax_element(d.begin(), d.end());
+        if(*range.second - *range.first > homogeneity_tolerance) return false;
+        
+        // kernels are rational functions of the momenta, so the degree should be an integer
+        degree = d.front();
+        if(std::abs(degree - std::round(degree)) < homogeneity_tolerance) degree = std::round(degree);
+        
+        return true;
+      }
+    
+    
+    //! power-law index of |f| between two points separated by a factor 2
+    double power_law_index(double f1, double f2, double fallback)
+      {
+        if(f1 == 0.0 || f2 == 0.0 || !std::isfinite(f1) || !std::isfinite(f2)) return fallback;
+        return std::log(std::abs(f2 / f1)) / std::log(2.0);
+      }
+    
+    
+    //! fit a P22 kernel at k=1 to sum C_ab q^2a p^2b; returns the maximum residual relative to the kernel
+    double fit_22(integrand_t integrand, const FRW_model& model, bool flip, std::vector< std::tuple<int, int, double> >& terms)
+      {
+        std::mt19937 gen(fit_seed);
+        std::uniform_real_distribution<double> log_r(std::log(fit_lo), std::log(fit_hi));
+        std::uniform_real_distribution<double> cos_theta(-1.0, 1.0);
+        
+        // draw (q, x) with both q and |k-q| inside the fitting range
+        auto sample = [&](double& q, double& p, double& x) -> void
+          {
+            do
+              {
+                q = std::exp(log_r(gen));
+                x = cos_theta(gen);
+                p = std::sqrt(1.0 + q*q - 2.0*q*x);
+              }
+            while(p < fit_lo || p > fit_hi);
+          };
+        
+        const unsigned int width = 2*fit_max_power + 1;
+        Eigen::MatrixXd A(fit_samples, width*width);
+        Eigen::VectorXd G(fit_samples);
+        
+        for(unsigned int i = 0; i < fit_samples; ++i)
+          {
+            double q, p, x;
+            sample(q, p, x);
+            
+            for(int a = -fit_max_power; a <= fit_max_power; ++a)
+              {
+                for(int b = -fit_max_power; b <= fit_max_power; ++b)
+                  {
+                    A(i, (a + fit_max_power)*width + (b + fit_max_power)) = std::pow(q, 2*a) * std::pow(p, 2*b);
+                  }
+              }
+            G(i) = kernel_22(integrand, model, 1.0, q, x, flip);
+          }
+        
+        if(!G.allFinite()) return std::numeric_limits<double>::infinity();
+        
+        // powers span several decades, so balance the columns before solving
+        Eigen::VectorXd scale = A.colwise().norm();
+        for(unsigned int j = 0; j < A.cols(); ++j)
+          {
+            A.col(j) /= scale(j);
+          }
+        Eigen::VectorXd C = A.colPivHouseholderQr().solve(G);
+        C = C.cwiseQuotient(scale);
+        
+        // drop terms which are zero to within the accuracy of the fit
+        terms.clear();
+        const double C_max = C.cwiseAbs().maxCoeff();
+        for(int a = -fit_max_power; a <= fit_max_power; ++a)
+          {
+            for(int b = -fit_max_power; b <= fit_max_power; ++b)
+              {
+                double c = C((a + fit_max_power)*width + (b + fit_max_power));
+                if(std::abs(c) > fit_tolerance * C_max) terms.emplace_back(a, b, c);
+              }
+          }
+        
+        // check the fit at points it has not seen
+        double residual = 0.0;
+        double G_max = G.cwiseAbs().maxCoeff();
+        for(unsigned int i = 0; i < check_samples; ++i)
+          {
+            double q, p, x;
+            sample(q, p, x);
+            
+            double fit = 0.0;
+            for(const auto& t : terms)
+              {
+                fit += std::get<2>(t) * std::pow(q, 2*std::get<0>(t)) * std::pow(p, 2*std::get<1>(t));
+              }
+            
+            residual = std::max(residual, std::abs(fit - kernel_22(integrand, model, 1.0, q, x, flip)));
+          }
+        
+        return G_max > 0.0 ? residual / G_max : std::numeric_limits<double>::infinity();
+      }
+    
+    
+    //! decompose a P22 kernel for a given number of samples and period in log q
+    std::unique_ptr<fftlog_P22_kernel> build_P22_kernel(integrand_t integrand, const FRW_model& model, unsigned int N, double period)
+      {
+        auto kernel = std::make_unique<fftlog_P22_kernel>();
+        kernel->valid = false;
+        
+        // the kernel must be homogeneous, so that k can be scaled out
+        const std::vector< std::pair<double, double> > points = { {0.7, 0.2}, {1.3, -0.4}, {2.1, 0.6} };
+        std::vector<double> base;
+        std::vector<double> scaled;
+        for(const auto& pt : points)
+          {
+            base.push_back(kernel_22(integrand, model, 1.0, pt.first, pt.second, false));
+            scaled.push_back(kernel_22(integrand, model, 2.0, 2.0*pt.first, pt.second, false));
+          }
+        if(!homogeneity(base, scaled, kernel->degree)) return kernel;
+        
+        // the orientation of the angular variable is not known, so try both
+        std::vector< std::tuple<int, int, double> > terms;
+        std::vector< std::tuple<int, int, double> > flipped_terms;
+        double residual = fit_22(integrand, model, false, terms);
+        double flipped_residual = fit_22(integrand, model, true, flipped_terms);
+        
+        bool flip = flipped_residual < residual;
+        if(flip)
+          {
+            terms.swap(flipped_terms);
+            residual = flipped_residual;
+          }
+        if(!(residual < fit_tolerance)) return kernel;
+        
+        // choose a bias for which the integral converges at q -> 0, |k-q| -> 0 and q -> infinity;
+        // if a limit vanishes identically it imposes no constraint
+        const double alpha_q = power_law_index(kernel_22(integrand, model, 1.0, 1E-3, 0.3, flip),
+                                               kernel_22(integrand, model, 1.0, 2E-3, 0.3, flip), 10.0);
+        const double alpha_p = power_law_index(kernel_22(integrand, model, 1.0, 1.0, 1.0 - 0.5E-6, flip),
+                                               kernel_22(integrand, model, 1.0, 1.0, 1.0 - 2.0E-6, flip), 10.0);
+        const double alpha_inf = power_law_index(kernel_22(integrand, model, 1.0, 1E3, 0.3, flip),
+                                                 kernel_22(integrand, model, 1.0, 2E3, 0.3, flip), -10.0);
+        
+        const double bias_lo = std::max(-3.0 - alpha_q, -3.0 - alpha_p);
+        const double bias_hi = -(3.0 + alpha_inf) / 2.0;
+        if(bias_hi - bias_lo < min_bias_window) return kernel;
+        
+        // keep away from half-integers, where individual Gamma functions in the master integral have poles
+        double bias = (bias_lo + bias_hi) / 2.0;
+        if(std::abs(2.0*bias - std::round(2.0*bias)) < 0.2) bias += (bias + 0.1 < bias_hi ? 0.1 : -0.1);
+        kernel->bias = bias;
+        
+        // tabulate the Gamma-function factors: those depending on a single frequency, and those depending on the
+        // sum of frequencies, for each power which occurs
+        auto s = [&](int m) -> complex { return complex(bias, 2.0*M_PI*(m - static_cast<int>(N/2)) / period); };
+        
+        std::map<int, unsigned int> single;
+        std::map<int, unsigned int> pair;
+        
+        auto single_table = [&](int power) -> unsigned int
+          {
+            auto t = single.find(power);
+            if(t != single.end()) return t->second;
+            
+            std::vector<complex> table(N+1);
+            for(unsigned int m = 0; m <= N; ++m)
+              {
+                const complex nu = -static_cast<double>(power) - s(m)/2.0;
+                table[m] = std::exp(log_gamma(1.5 - nu) - log_gamma(nu));
+              }
+            
+            kernel->single.push_back(std::move(table));
+            return single[power] = static_cast<unsigned int>(kernel->single.size() - 1);
+          };
+        
+        auto pair_table = [&](int total) -> unsigned int
+          {
+            auto t = pair.find(total);
+            if(t != pair.end()) return t->second;
+            
+            std::vector<complex> table(2*N+1);
+            for(unsigned int j = 0; j <= 2*N; ++j)
+              {
+                // s_m1 + s_m2 depends only on m1 + m2 = j
+                const complex nu12 = -static_cast<double>(total) - bias - complex(0.0, M_PI*(static_cast<int>(j) - static_cast<int>(N)) / period);
+                table[j] = std::exp(log_gamma(nu12 - 1.5) - log_gamma(3.0 - nu12));
+              }
+            
+            kernel->pair.push_back(std::move(table));
+            return pair[total] = static_cast<unsigned int>(kernel->pair.size() - 1);
+          };
+        
+        // int d^3q q^-2nu1 |k-q|^-2nu2 = pi^3/2 k^(3-2nu1-2nu2) Gamma(3/2-nu1) Gamma(3/2-nu2) Gamma(nu1+nu2-3/2)
+        //                                / [Gamma(nu1) Gamma(nu2) Gamma(3-nu1-nu2)]
+        const double norm = std::pow(M_PI, 1.5);
+        for(const auto& t : terms)
+          {
+            fftlog_P22_term term;
+            term.left = single_table(std::get<0>(t));
+            term.right = single_table(std::get<1>(t));
+            term.pair = pair_table(std::get<0>(t) + std::get<1>(t));
+            term.coeff = norm * std::get<2>(t);
+            kernel->terms.push_back(term);
+          }
+        
+        // terms sharing a pair table are summed before the inverse transform
+        std::stable_sort(kernel->terms.begin(), kernel->terms.end(),
+                         [](const fftlog_P22_term& a, const fftlog_P22_term& b) -> bool { return a.pair < b.pair; });
+        
+        kernel->length = 1;
+        while(kernel->length < 2*N+1) kernel->length *= 2;
+        
+        auto finite = [](const std::vector<complex>& table) -> bool
+          {
+            return std::all_of(table.begin(), table.end(),
+                               [](const complex& z) -> bool { return std::isfinite(z.real()) && std::isfinite(z.imag()); });
+          };
+        
+        kernel->valid = std::all_of(kernel->single.begin(), kernel->single.end(), finite)
+                        && std::all_of(kernel->pair.begin(), kernel->pair.end(), finite);
+        return kernel;
+      }
+    
+    
+    //! evaluate sum_terms C sum_j S(j) sum_(m1+m2=j) A(m1) x_m1 B(m2) x_m2 for a P22 kernel;
+    //! each convolution costs O(N log N), so the whole contraction is O(N log N) rather than O(N^2)
+    double contract_22(const fftlog_P22_kernel& kernel, const std::vector<complex>& x)
+      {
+        const unsigned int L = kernel.length;
+        const size_t n = x.size();
+        
+        // transform A x for each single-frequency table
+        std::vector< std::vector<complex> > F(kernel.single.size());
+        for(unsigned int p = 0; p < kernel.single.size(); ++p)
+          {
+            F[p].assign(L, 0.0);
+            for(size_t m = 0; m < n; ++m) F[p][m] = kernel.single[p][m] * x[m];
+            fft(F[p]);
+          }
+        
+        complex total = 0.0;
+        std::vector<complex> W;
+        
+        auto t = kernel.terms.cbegin();
+        while(t != kernel.terms.cend())
+          {
+            const unsigned int pair = t->pair;
+            
+            // accumulate the convolutions for every term sharing this pair table in Fourier space;
+            // the inverse transform is computed as the conjugate of a forward transform
+            W.assign(L, 0.0);
+            for(; t != kernel.terms.cend() && t->pair == pair; ++t)
+              {
+                const std::vector<complex>& Fa = F[t->left];
+                const std::vector<complex>& Fb = F[t->right];
+                for(unsigned int j = 0; j < L; ++j) W[j] += t->coeff * std::conj(Fa[j] * Fb[j]);
+              }
+            
+            fft(W);
+            
+            const std::vector<complex>& S = kernel.pair[pair];
+            for(size_t j = 0; j < S.size(); ++j) total += S[j] * std::conj(W[j]);
+          }
+        
+        return total.real() / static_cast<double>(L);
+      }
+    
+  }   // namespace oneloop_fftlog_impl
+
+
+oneloop_fftlog::oneloop_fftlog(const FRW_model& m, const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                               const initial_filtered_Pk& Pk, unsigned int n)
+  : model(m),
+    UV_cutoff(UV),
+    IR_cutoff(IR),
+    N(n),
+    log_range(std::log(UV / IR)),
+    bias_13(0.0)
+  {
+    if(!is_power_of_two(this->N) || this->N < 8) throw runtime_exception(exception_type::runtime_error, ERROR_FFT_LENGTH);
+    
+    wiggle_Pk_raw_adapter raw(Pk, IR_cutoff, UV_cutoff);
+    wiggle_Pk_nowiggle_adapter nw(Pk, IR_cutoff, UV_cutoff);
+    
+    const double log_IR = std::log(this->IR_cutoff * Mpc_units::Mpc);
+    
+    // P13 integrals are taken over [IR, UV] directly, so sample exactly that range; choosing the bias to match
+    // the end points of P(q) q^-bias makes its periodic extension continuous, and the decomposition converges quickly
+    std::vector<double> q(this->N);
+    const double delta_13 = this->log_range / this->N;
+    for(unsigned int j = 0; j < this->N; ++j)
+      {
+        q[j] = std::exp(log_IR + j*delta_13);
+      }
+    q.front() = this->IR_cutoff * Mpc_units::Mpc;
+    
+    std::vector<double> raw_13(this->N);
+    std::vector<double> nowiggle_13(this->N);
+    raw.evaluate_batch(q.data(), raw_13.data(), this->N);
+    nw.evaluate_batch(q.data(), nowiggle_13.data(), this->N);
+    
+    const double q_UV = this->UV_cutoff * Mpc_units::Mpc;
+    double P_UV = 0.0;
+    nw.evaluate_batch(&q_UV, &P_UV, 1);
+    if(nowiggle_13.front() > 0.0 && P_UV > 0.0) this->bias_13 = std::log(P_UV / nowiggle_13.front()) / this->log_range;
+    
+    using oneloop_fftlog_impl::decompose;
+    decompose(raw_13, 1, log_IR, delta_13, this->log_range, this->bias_13, false, this->N, this->coeffs_13.raw);
+    decompose(nowiggle_13, 1, log_IR, delta_13, this->log_range, this->bias_13, false, this->N, this->coeffs_13.nowiggle);
+    decompose(raw_13, 2, log_IR, delta_13, this->log_range, this->bias_13, false, this->N, this->coeffs_13.raw_coarse);
+    decompose(nowiggle_13, 2, log_IR, delta_13, this->log_range, this->bias_13, false, this->N, this->coeffs_13.nowiggle_coarse);
+    
+    // P22 decompositions run over all q, so pad the range by half its width at each end, where the windowed
+    // spectrum vanishes; the cutoffs fall on samples, which carry half weight
+    const double delta_22 = 2.0 * this->log_range / this->N;
+    const double log_q0 = log_IR - this->log_range / 2.0;
+    for(unsigned int j = 0; j < this->N; ++j)
+      {
+        q[j] = std::exp(log_q0 + j*delta_22);
+      }
+    q[this->N/4] = this->IR_cutoff * Mpc_units::Mpc;
+    q[3*this->N/4] = this->UV_cutoff * Mpc_units::Mpc;
+    
+    this->raw_22.resize(this->N);
+    this->nowiggle_22.resize(this->N);
+    raw.evaluate_batch(q.data(), this->raw_22.data(), this->N);
+    nw.evaluate_batch(q.data(), this->nowiggle_22.data(), this->N);
+    
+    for(unsigned int j : { this->N/4, 3*this->N/4 })
+      {
+        this->raw_22[j] /= 2.0;
+        this->nowiggle_22[j] /= 2.0;
+      }
+  }
+
+
+const fftlog_P13_kernel& oneloop_fftlog::get_P13_kernel(integrand_t integrand)
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    auto t = this->kernels_13.find(integrand);
+    if(t != this->kernels_13.end()) return *t->second;
+    
+    auto kernel = std::make_unique<fftlog_P13_kernel>();
+    kernel->valid = false;
+    
+    // the kernel must be homogeneous, so that k can be scaled out
+    const std::vector<double> points = { 0.2, 0.7, 1.6, 4.3 };
+    std::vector<double> base;
+    std::vector<double> scaled;
+    for(double r : points)
+      {
+        base.push_back(oneloop_fftlog_impl::kernel_13(integrand, this->model, 1.0, r));
+        scaled.push_back(oneloop_fftlog_impl::kernel_13(integrand, this->model, 2.0, 2.0*r));
+      }
+    
+    if(oneloop_fftlog_impl::homogeneity(base, scaled, kernel->degree))
+      {
+        // tabulate F_m(t) at the boundaries of cells of width log_range/N, covering every t = log(q/k)
+        // which occurs for IR <= k <= UV, with a small margin
+        const unsigned int cells = 2*this->N + 2*oneloop_fftlog_impl::table_margin;
+        const double delta = this->log_range / this->N;
+        const double t0 = -this->log_range - oneloop_fftlog_impl::table_margin*delta;
+        
+        const gauss_legendre_rule& rule = gauss_legendre(oneloop_fftlog_impl::cell_nodes);
+        const std::vector<double>& z = rule.get_nodes();
+        const std::vector<double>& w = rule.get_weights();
+        
+        const unsigned int width = this->N+1;
+        kernel->F.assign((cells+1)*width, 0.0);
+        
+        bool finite = true;
+        for(unsigned int i = 0; finite && i < cells; ++i)
+          {
+            const double mid = t0 + (i + 0.5)*delta;
+            
+            std::vector< std::complex<double> > cell(width, 0.0);
+            for(unsigned int j = 0; j < z.size(); ++j)
+              {
+                const double t = mid + z[j]*delta/2.0;
+                const double K = oneloop_fftlog_impl::kernel_13(integrand, this->model, 1.0, std::exp(t));
+                if(!std::isfinite(K))
+                  {
+                    finite = false;
+                    break;
+                  }
+                
+                const double W = w[j] * delta/2.0 * K * std::exp((this->bias_13 + 1.0)*t);
+                for(unsigned int m = 0; m < width; ++m)
+                  {
+                    const double eta = 2.0*M_PI*(static_cast<int>(m) - static_cast<int>(this->N/2)) / this->log_range;
+                    cell[m] += W * std::exp(std::complex<double>(0.0, eta*t));
+                  }
+              }
+            
+            for(unsigned int m = 0; m < width; ++m)
+              {
+                kernel->F[(i+1)*width + m] = kernel->F[i*width + m] + cell[m];
+              }
+          }
+        
+        kernel->valid = finite;
+      }
+    
+    auto res = this->kernels_13.emplace(integrand, std::move(kernel));
+    return *res.first->second;
+  }
+
+
+bool oneloop_fftlog::interpolate_P13(integrand_t integrand, const fftlog_P13_kernel& kernel, double t,
+                                     std::vector< std::complex<double> >& F) const
+  {
+    const unsigned int cells = 2*this->N + 2*oneloop_fftlog_impl::table_margin;
+    const double delta = this->log_range / this->N;
+    const double t0 = -this->log_range - oneloop_fftlog_impl::table_margin*delta;
+    
+    const double x = (t - t0) / delta;
+    if(x < 0.0 || x > cells) return false;
+    
+    // start from the nearest tabulated boundary and integrate the remainder directly
+    const unsigned int i = static_cast<unsigned int>(std::round(x));
+    const double tb = t0 + i*delta;
+    
+    const unsigned int width = this->N+1;
+    F.assign(kernel.F.begin() + i*width, kernel.F.begin() + (i+1)*width);
+    
+    if(t == tb) return true;
+    
+    const gauss_legendre_rule& rule = gauss_legendre(oneloop_fftlog_impl::cell_nodes);
+    const std::vector<double>& z = rule.get_nodes();
+    const std::vector<double>& w = rule.get_weights();
+    
+    const double mid = (t + tb) / 2.0;
+    const double half = (t - tb) / 2.0;
+    for(unsigned int j = 0; j < z.size(); ++j)
+      {
+        const double s = mid + z[j]*half;
+        const double K = oneloop_fftlog_impl::kernel_13(integrand, this->model, 1.0, std::exp(s));
+        if(!std::isfinite(K)) return false;
+        
+        const double W = w[j] * half * K * std::exp((this->bias_13 + 1.0)*s);
+        for(unsigned int m = 0; m < width; ++m)
+          {
+            const double eta = 2.0*M_PI*(static_cast<int>(m) - static_cast<int>(this->N/2)) / this->log_range;
+            F[m] += W * std::exp(std::complex<double>(0.0, eta*s));
+          }
+      }
+    
+    return true;
+  }
+
+
+bool oneloop_fftlog::P13(integrand_t integrand, const Mpc_units::energy& k, fftlog_value& value)
+  {
+    boost::timer::cpu_timer timer;
+    
+    const fftlog_P13_kernel& kernel = this->get_P13_kernel(integrand);
+    if(!kernel.valid) return false;
+    
+    // int_IR^UV dq K(k, q) P(q) = k^(p+1) sum_m c_m k^s_m [F_m(log UV/k) - F_m(log IR/k)]
+    const double kk = k * Mpc_units::Mpc;
+    const double log_k = std::log(kk);
+    
+    std::vector< std::complex<double> > F_UV;
+    std::vector< std::complex<double> > F_IR;
+    if(!this->interpolate_P13(integrand, kernel, std::log(this->UV_cutoff * Mpc_units::Mpc) - log_k, F_UV)) return false;
+    if(!this->interpolate_P13(integrand, kernel, std::log(this->IR_cutoff * Mpc_units::Mpc) - log_k, F_IR)) return false;
+    
+    std::complex<double> raw = 0.0;
+    std::complex<double> nowiggle = 0.0;
+    std::complex<double> raw_coarse = 0.0;
+    std::complex<double> nowiggle_coarse = 0.0;
+    for(unsigned int m = 0; m <= this->N; ++m)
+      {
+        const double eta = 2.0*M_PI*(static_cast<int>(m) - static_cast<int>(this->N/2)) / this->log_range;
+        const std::complex<double> x = (F_UV[m] - F_IR[m]) * std::exp(std::complex<double>(0.0, eta*log_k));
+        
+        raw += this->coeffs_13.raw[m] * x;
+        nowiggle += this->coeffs_13.nowiggle[m] * x;
+        raw_coarse += this->coeffs_13.raw_coarse[m] * x;
+        nowiggle_coarse += this->coeffs_13.nowiggle_coarse[m] * x;
+      }
+    
+    const double norm = std::pow(kk, kernel.degree + 1.0 + this->bias_13) / (8.0 * M_PI * M_PI);
+    
+    value.raw = norm * raw.real();
+    value.nowiggle = norm * nowiggle.real();
+    value.raw_error = std::abs(norm * (raw.real() - raw_coarse.real()));
+    value.nowiggle_error = std::abs(norm * (nowiggle.real() - nowiggle_coarse.real()));
+    
+    timer.stop();
+    value.time = timer.elapsed().wall;
+    
+    return std::isfinite(value.raw) && std::isfinite(value.nowiggle);
+  }
+
+
+const fftlog_P22_kernel& oneloop_fftlog::get_P22_kernel(integrand_t integrand)
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    auto t = this->kernels_22.find(integrand);
+    if(t != this->kernels_22.end()) return *t->second;
+    
+    auto res = this->kernels_22.emplace(integrand, oneloop_fftlog_impl::build_P22_kernel(integrand, this->model, this->N,
+                                                                                         2.0 * this->log_range));
+    return *res.first->second;
+  }
+
+
+const fftlog_coefficients& oneloop_fftlog::get_P22_coefficients(double bias)
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    
+    auto t = this->coeffs_22.find(bias);
+    if(t != this->coeffs_22.end()) return *t->second;
+    
+    const double period = 2.0 * this->log_range;
+    const double delta = period / this->N;
+    const double log_q0 = std::log(this->IR_cutoff * Mpc_units::Mpc) - this->log_range / 2.0;
+    
+    auto c = std::make_unique<fftlog_coefficients>();
+    
+    using oneloop_fftlog_impl::decompose;
+    decompose(this->raw_22, 1, log_q0, delta, period, bias, true, this->N, c->raw);
+    decompose(this->nowiggle_22, 1, log_q0, delta, period, bias, true, this->N, c->nowiggle);
+    decompose(this->raw_22, 2, log_q0, delta, period, bias, true, this->N, c->raw_coarse);
+    decompose(this->nowiggle_22, 2, log_q0, delta, period, bias, true, this->N, c->nowiggle_coarse);
+    
+    auto res = this->coeffs_22.emplace(bias, std::move(c));
+    return *res.first->second;
+  }
+
+
+bool oneloop_fftlog::P22(integrand_t integrand, const Mpc_units::energy& k, fftlog_value& value)
+  {
+    boost::timer::cpu_timer timer;
+    
+    const double period = 2.0 * this->log_range;
+    
+    const fftlog_P22_kernel& kernel = this->get_P22_kernel(integrand);
+    if(!kernel.valid) return false;
+    
+    const fftlog_coefficients& c = this->get_P22_coefficients(kernel.bias);
+    
+    // P22(k) = k^(d+3+2 bias) x^T M x, with x_m = c_m k^(i eta_m)
+    const double kk = k * Mpc_units::Mpc;
+    const double log_k = std::log(kk);
+    
+    std::vector< std::complex<double> > phase(this->N+1);
+    for(unsigned int m = 0; m <= this->N; ++m)
+      {
+        const double eta = 2.0*M_PI*(static_cast<int>(m) - static_cast<int>(this->N/2)) / period;
+        phase[m] = std::exp(std::complex<double>(0.0, eta*log_k));
+      }
+    
+    std::vector< std::complex<double> > x(this->N+1);
+    auto contract = [&](const std::vector< std::complex<double> >& coeffs) -> double
+      {
+        for(unsigned int m = 0; m <= this->N; ++m) x[m] = coeffs[m] * phase[m];
+        return oneloop_fftlog_impl::contract_22(kernel, x);
+      };
+    
+    const double norm = std::pow(kk, kernel.degree + 3.0 + 2.0*kernel.bias) / (8.0 * M_PI * M_PI);
+    
+    const double raw = contract(c.raw);
+    const double nowiggle = contract(c.nowiggle);
+    
+    value.raw = norm * raw;
+    value.nowiggle = norm * nowiggle;
+    value.raw_error = std::abs(norm * (raw - contract(c.raw_coarse)));
+    value.nowiggle_error = std::abs(norm * (nowiggle - contract(c.nowiggle_coarse)));
+    
+    timer.stop();
+    value.time = timer.elapsed().wall;
+    
+    return std::isfinite(value.raw) && std::isfinite(value.nowiggle);
+  }
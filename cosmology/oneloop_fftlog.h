@@ -0,0 +1,273 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ONELOOP_FFTLOG_H
+#define LSSEFT_ONELOOP_FFTLOG_H
+
+
+#include <complex>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "FRW_model.h"
+#include "cosmology/concepts/power_spectrum.h"
+
+#include "units/Mpc_units.h"
+
+#include "defaults.h"
+
+#include "cuba.h"
+
+#include "Eigen/Dense"
+
+#include "boost/timer/timer.hpp"
+
+
+//! result of a kernel at a single wavenumber, for both the raw and no-wiggle spectra
+class fftlog_value
+  {
+    
+  public:
+    
+    //! raw value
+    double raw;
+    
+    //! raw error estimate
+    double raw_error;
+    
+    //! no-wiggle value
+    double nowiggle;
+    
+    //! no-wiggle error estimate
+    double nowiggle_error;
+    
+    //! time to evaluate, shared between the raw and no-wiggle values
+    boost::timer::nanosecond_type time;
+    
+  };
+
+
+//! power-law decomposition P(q) = sum_m c_m q^(bias + i eta_m) of the raw and no-wiggle spectra;
+//! the coarse coefficients use every second sample and provide the error estimate
+class fftlog_coefficients
+  {
+    
+  public:
+    
+    //! raw coefficients, indexed by m + N/2
+    std::vector< std::complex<double> > raw;
+    
+    //! no-wiggle coefficients
+    std::vector< std::complex<double> > nowiggle;
+    
+    //! raw coefficients from half the samples; zero for |m| > N/4
+    std::vector< std::complex<double> > raw_coarse;
+    
+    //! no-wiggle coefficients from half the samples
+    std::vector< std::complex<double> > nowiggle_coarse;
+    
+  };
+
+
+//! Mellin table for a P13 kernel over a finite range; depends on the cutoffs and spectrum bias
+class fftlog_P13_kernel
+  {
+    
+  public:
+    
+    //! can this kernel be evaluated by FFTLog?
+    bool valid;
+    
+    //! homogeneity degree p, with K(lambda k, lambda q) = lambda^p K(k, q)
+    double degree;
+    
+    //! cumulative integrals F_m(t) = int^t dt' K(1, e^t') e^{(s_m+1) t'} at the cell boundaries,
+    //! stored with m varying fastest
+    std::vector< std::complex<double> > F;
+    
+  };
+
+
+//! single term C q^-2a |k-q|^-2b of a P22 kernel, identified by its entries in the Gamma-function tables
+class fftlog_P22_term
+  {
+    
+  public:
+    
+    //! Gamma-function table for the power of q
+    unsigned int left;
+    
+    //! Gamma-function table for the power of |k-q|
+    unsigned int right;
+    
+    //! Gamma-function table for the sum of the powers
+    unsigned int pair;
+    
+    //! coefficient, including the normalization of the master integral
+    double coeff;
+    
+  };
+
+
+//! P22 kernel written as a sum of power laws in q^2, |k-q|^2 and k^2, contracted with the
+//! analytic one-loop master integral; independent of the spectrum, so shared by every k evaluated by an engine.
+//! With x_m = c_m k^(i eta_m), P22(k) = k^(d+3+2 bias) sum_terms C sum_j S(j) sum_(m1+m2=j) A(m1) x_m1 B(m2) x_m2;
+//! the inner sum is a convolution, evaluated by FFT
+class fftlog_P22_kernel
+  {
+    
+  public:
+    
+    //! can this kernel be evaluated by FFTLog?
+    bool valid;
+    
+    //! homogeneity degree d of the kernel, excluding the measure
+    double degree;
+    
+    //! bias needed for the decomposition of P(q) to converge against this kernel
+    double bias;
+    
+    //! FFT length for the convolutions; a power of two, at least 2N+1
+    unsigned int length;
+    
+    //! Gamma-function factors depending on a single frequency, one table of N+1 entries per power
+    std::vector< std::vector< std::complex<double> > > single;
+    
+    //! Gamma-function factors depending on the sum of frequencies, one table of 2N+1 entries per total power
+    std::vector< std::vector< std::complex<double> > > pair;
+    
+    //! terms of the kernel, ordered by their pair table
+    std::vector<fftlog_P22_term> terms;
+    
+  };
+
+
+//! evaluates one-loop kernels by FFTLog, from a power-law decomposition of the linear spectrum.
+//! The kernels are generated code, so they are decomposed numerically from evaluations against a unit
+//! spectrum: P13 kernels through finite-range Mellin transforms of K(1, q/k), and P22 kernels through an
+//! exact fit to power laws in q^2, |k-q|^2 and k^2. Kernels which admit neither are reported as
+//! unsuitable, and should be integrated directly
+class oneloop_fftlog
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor samples the spectrum and computes the P13 decomposition
+    oneloop_fftlog(const FRW_model& m, const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                   const initial_filtered_Pk& Pk, unsigned int n=LSSEFT_DEFAULT_FFTLOG_POINTS);
+    
+    //! destructor is default
+    ~oneloop_fftlog() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! evaluate a P13 kernel at k; returns false if the kernel or k is unsuitable.
+    //! Safe to call from multiple threads
+    bool P13(integrand_t integrand, const Mpc_units::energy& k, fftlog_value& value);
+    
+    //! evaluate a P22 kernel at k; returns false if the kernel is unsuitable.
+    //! Safe to call from multiple threads
+    bool P22(integrand_t integrand, const Mpc_units::energy& k, fftlog_value& value);
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! get Mellin table for a P13 kernel, building it on first use
+    const fftlog_P13_kernel& get_P13_kernel(integrand_t integrand);
+    
+    //! get decomposed P22 kernel, building it on first use
+    const fftlog_P22_kernel& get_P22_kernel(integrand_t integrand);
+    
+    //! get spectrum decomposition for P22 with a given bias, building it on first use
+    const fftlog_coefficients& get_P22_coefficients(double bias);
+    
+    //! evaluate F_m(t) for all m, at an arbitrary point; returns false if t lies outside the table
+    bool interpolate_P13(integrand_t integrand, const fftlog_P13_kernel& kernel, double t,
+                         std::vector< std::complex<double> >& F) const;
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! FRW model
+    const FRW_model& model;
+    
+    //! UV cutoff
+    Mpc_units::energy UV_cutoff;
+    
+    //! IR cutoff
+    Mpc_units::energy IR_cutoff;
+    
+    //! number of samples
+    unsigned int N;
+    
+    //! log(UV/IR)
+    double log_range;
+    
+    
+    // P13 DECOMPOSITION
+    
+    //! bias for P13; chosen so that P(q) q^-bias is continuous when extended periodically in log q
+    double bias_13;
+    
+    //! spectrum decomposition for P13, sampled on [IR, UV)
+    fftlog_coefficients coeffs_13;
+    
+    //! Mellin tables for P13 kernels
+    std::map< integrand_t, std::unique_ptr<fftlog_P13_kernel> > kernels_13;
+    
+    
+    // P22 DECOMPOSITION
+    
+    //! raw spectrum sampled on the padded P22 grid, with half weight at the cutoffs
+    std::vector<double> raw_22;
+    
+    //! no-wiggle spectrum sampled on the padded P22 grid
+    std::vector<double> nowiggle_22;
+    
+    //! spectrum decompositions for P22, indexed by bias
+    std::map< double, std::unique_ptr<fftlog_coefficients> > coeffs_22;
+    
+    //! decomposed P22 kernels; they depend only on the sampling, but are kept with the engine so that
+    //! they are released with it
+    std::map< integrand_t, std::unique_ptr<fftlog_P22_kernel> > kernels_22;
+    
+    
+    //! serialize construction of tables
+    std::mutex lock;
+    
+  };
+
+
+#endif //LSSEFT_ONELOOP_FFTLOG_H
@@ -0,0 +1,98 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <cmath>
+#include <sstream>
+
+#include "oneloop_gauss_legendre_nodes.h"
+
+#include "utilities/gauss_legendre.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+oneloop_gauss_legendre_nodes::oneloop_gauss_legendre_nodes(const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                                                           const generic_Pk<Mpc_units::inverse_energy3>& raw,
+                                                           const generic_Pk<Mpc_units::inverse_energy3>& nw,
+                                                           unsigned int n, unsigned int doublings)
+  : UV_cutoff(UV),
+    IR_cutoff(IR)
+  {
+    // every table is built here, so lookups never modify the container
+    for(unsigned int d = 0; d <= doublings; ++d, n *= 2)
+      {
+        this->build_rule(n, raw, nw);
+      }
+  }
+
+
+void oneloop_gauss_legendre_nodes::build_rule(unsigned int n, const generic_Pk<Mpc_units::inverse_energy3>& raw,
+                                              const generic_Pk<Mpc_units::inverse_energy3>& nw)
+  {
+    const gauss_legendre_rule& rule = gauss_legendre(n);
+    const std::vector<double>& z = rule.get_nodes();
+    const std::vector<double>& w = rule.get_weights();
+    
+    const double log_lo = std::log(this->IR_cutoff * Mpc_units::Mpc);
+    const double log_hi = std::log(this->UV_cutoff * Mpc_units::Mpc);
+    const double log_half = (log_hi - log_lo) / 2.0;
+    const double log_mid = (log_hi + log_lo) / 2.0;
+    const Mpc_units::energy q_range = this->UV_cutoff - this->IR_cutoff;
+    
+    gauss_legendre_node_table& table = this->tables[n];
+    table.u.resize(n);
+    table.q.resize(n);
+    table.weight.resize(n);
+    table.P_raw.resize(n);
+    table.P_nw.resize(n);
+    
+    for(unsigned int j = 0; j < n; ++j)
+      {
+        const double q = std::exp(log_mid + log_half*z[j]);
+        table.u[j] = (q / Mpc_units::Mpc - this->IR_cutoff) / q_range;
+        table.weight[j] = log_half * w[j] * q / (q_range * Mpc_units::Mpc);
+        
+        // the integrands reconstruct q from u, so sample the spectra at exactly the wavenumber they will request
+        table.q[j] = (this->IR_cutoff + table.u[j] * q_range) * Mpc_units::Mpc;
+      }
+    
+    raw.evaluate_batch(table.q.data(), table.P_raw.data(), n);
+    nw.evaluate_batch(table.q.data(), table.P_nw.data(), n);
+  }
+
+
+const gauss_legendre_node_table& oneloop_gauss_legendre_nodes::get(unsigned int n) const
+  {
+    auto t = this->tables.find(n);
+    
+    if(t == this->tables.end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_GAUSS_LEGENDRE_ORDER_NOT_IN_TABLE << " " << n;
+        throw runtime_exception(exception_type::runtime_error, msg.str());
+      }
+    
+    return t->second;
+  }
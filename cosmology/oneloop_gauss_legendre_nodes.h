@@ -0,0 +1,114 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ONELOOP_GAUSS_LEGENDRE_NODES_H
+#define LSSEFT_ONELOOP_GAUSS_LEGENDRE_NODES_H
+
+
+#include <vector>
+#include <map>
+
+#include "cosmology/concepts/power_spectrum.h"
+
+#include "units/Mpc_units.h"
+
+
+//! nodes of a single Gauss-Legendre rule in log q, with the raw and no-wiggle spectra sampled there
+class gauss_legendre_node_table
+  {
+    
+  public:
+    
+    //! positions of the nodes, expressed as (q-IR)/(UV-IR)
+    std::vector<double> u;
+    
+    //! wavenumbers of the nodes, measured in 1/Mpc, computed from u exactly as the integrands do
+    std::vector<double> q;
+    
+    //! weights, including the Jacobian dq/dlog q = q and the normalization of the unit interval
+    std::vector<double> weight;
+    
+    //! raw spectrum at the nodes
+    std::vector<double> P_raw;
+    
+    //! no-wiggle spectrum at the nodes
+    std::vector<double> P_nw;
+    
+  };
+
+
+//! P(q) at the radial nodes of the fixed-node loop integrals, for a base rule and each of its doublings.
+//! The nodes depend only on the cutoffs, so a single table serves every k integrated with the same
+//! spectrum, cutoffs and parameters
+class oneloop_gauss_legendre_nodes
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor samples the spectra at the nodes of an n-point rule and its doublings;
+    //! the IR cutoff must be positive
+    oneloop_gauss_legendre_nodes(const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                                 const generic_Pk<Mpc_units::inverse_energy3>& raw,
+                                 const generic_Pk<Mpc_units::inverse_energy3>& nw, unsigned int n, unsigned int doublings);
+    
+    //! destructor is default
+    ~oneloop_gauss_legendre_nodes() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! get table for an n-point rule; safe to call from multiple threads
+    const gauss_legendre_node_table& get(unsigned int n) const;
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! fill the table for an n-point rule
+    void build_rule(unsigned int n, const generic_Pk<Mpc_units::inverse_energy3>& raw,
+                    const generic_Pk<Mpc_units::inverse_energy3>& nw);
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! UV cutoff
+    Mpc_units::energy UV_cutoff;
+    
+    //! IR cutoff
+    Mpc_units::energy IR_cutoff;
+    
+    //! tables, indexed by number of nodes
+    std::map<unsigned int, gauss_legendre_node_table> tables;
+    
+  };
+
+
+#endif //LSSEFT_ONELOOP_GAUSS_LEGENDRE_NODES_H
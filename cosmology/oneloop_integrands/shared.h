@@ -28,19 +28,24 @@
 
 
 #include <cmath>
+#include <cassert>
+#include <vector>
+#include <algorithm>
 
 #include "cosmology/FRW_model.h"
 #include "cosmology/concepts/power_spectrum.h"
 
 #include "units/Mpc_units.h"
 
+#include "cuba.h"
+
 
 namespace oneloop_momentum_impl
   {
     
     constexpr unsigned int dimensions            = 2;   // integrals are dq dx, even where the x integral is trivial; Cuhre seems to have issues in one dimension
     constexpr unsigned int components            = 1;
-    constexpr unsigned int points_per_invocation = 1;
+    constexpr unsigned int points_per_invocation = 65;  // enough for a complete degree-13 rule in 2 dimensions, so each region is sampled in one call
     
     constexpr unsigned int verbosity_none        = 0;
     constexpr unsigned int verbosity_reasonable  = 1;
@@ -104,6 +109,391 @@ namespace oneloop_momentum_impl
         Mpc_units::energy2 k_sq;
       };
     
+    
+    //! unit power spectrum; substituting it into an integrand leaves just the kernel, which is
+    //! how the batched and FFTLog engines decompose the generated integrands
+    class unit_Pk: public generic_Pk<Mpc_units::inverse_energy3>
+      {
+        
+      public:
+        
+        //! evaluate spline
+        Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final
+          {
+            return Mpc_units::inverse_energy3(1.0);
+          }
+        
+      };
+    
+    
+    //! the angular direction is trivial for P13 kernels, so it can be sampled at a single point
+    constexpr double trivial_angular_node = 0.5;
+    
+    
+    //! each kernel contributes a raw and a no-wiggle component to a grouped integral
+    constexpr unsigned int components_per_kernel = 2;
+    
+    //! component index for the raw part of kernel i
+    constexpr unsigned int raw_component(unsigned int i) { return components_per_kernel*i; }
+    
+    //! component index for the no-wiggle part of kernel i
+    constexpr unsigned int nowiggle_component(unsigned int i) { return components_per_kernel*i + 1; }
+    
+    
+    //! unit power spectrum which records the wavenumbers at which it is evaluated; substituting it into an
+    //! integrand separates the kernel from the product of spectra which multiplies it, so the same kernel
+    //! value can be combined with more than one spectrum
+    class factor_recording_Pk: public generic_Pk<Mpc_units::inverse_energy3>
+      {
+        
+      public:
+        
+        //! largest number of spectrum factors in a one-loop integrand
+        static constexpr unsigned int max_factors = 4;
+        
+        factor_recording_Pk()
+          : count(0)
+          {
+          }
+        
+        //! forget recorded wavenumbers
+        void reset() { this->count = 0; }
+        
+        //! get number of recorded wavenumbers
+        unsigned int size() const { return this->count; }
+        
+        //! get recorded wavenumbers, measured in 1/Mpc
+        const double* get() const { return this->factors; }
+        
+        //! evaluate spline
+        Mpc_units::inverse_energy3 operator()(const Mpc_units::energy& k) const override final
+          {
+            assert(this->count < max_factors);
+            this->factors[this->count++] = k * Mpc_units::Mpc;
+            return Mpc_units::inverse_energy3(1.0);
+          }
+        
+      private:
+        
+        mutable double factors[max_factors];
+        mutable unsigned int count;
+      };
+    
+    
+    //! data block for a group of kernels integrated together as the components of a single vector-valued integral;
+    //! each kernel is evaluated once per point, against a recording unit spectrum, and its value then combined
+    //! with both the raw and no-wiggle spectra
+    class kernel_group_data
+      {
+      
+      public:
+        
+        kernel_group_data(const std::vector<integrand_t>& i, const FRW_model& m, const Mpc_units::energy& _k,
+                          const Mpc_units::energy& UV, const Mpc_units::energy& IR,
+                          const generic_Pk<Mpc_units::inverse_energy3>& r, const generic_Pk<Mpc_units::inverse_energy3>& n)
+          : integrands(i),
+            raw(r),
+            nowiggle(n),
+            kernel(m, _k, UV, IR, factors),
+            presets(0),
+            preset_k(0.0),
+            preset_raw(0.0),
+            preset_nw(0.0)
+          {
+          }
+        
+        //! supply the spectra at a wavenumber, measured in 1/Mpc, which every point in the following
+        //! batches requests; used by fixed-node rules, which know P(q) at their radial nodes in advance
+        void preset(double q, double P_raw, double P_nw)
+          {
+            this->presets = 1;
+            this->preset_k = q;
+            this->preset_raw = P_raw;
+            this->preset_nw = P_nw;
+          }
+        
+        const std::vector<integrand_t>& integrands;
+        const generic_Pk<Mpc_units::inverse_energy3>& raw;
+        const generic_Pk<Mpc_units::inverse_energy3>& nowiggle;
+        
+        factor_recording_Pk factors;
+        integrand_data kernel;
+        
+        //! distinct wavenumbers requested over a batch, measured in 1/Mpc, and the spectra evaluated there
+        std::vector<double> wavenumbers;
+        std::vector<double> P_raw;
+        std::vector<double> P_nw;
+        
+        //! for each point and kernel, the number of spectrum factors and their positions in 'wavenumbers'
+        std::vector<unsigned int> factor_count;
+        std::vector<unsigned int> factor_index;
+        
+        //! number of preset wavenumbers, which occupy the start of 'wavenumbers', and their spectra
+        unsigned int presets;
+        double preset_k;
+        double preset_raw;
+        double preset_nw;
+      };
+    
+    
+    //! evaluate every kernel in a group at a batch of nvec sample points, against both the raw and no-wiggle spectra;
+    //! points are laid out as x[p*ndim + d] and f[p*ncomp + c].
+    //! Kernels are evaluated first, collecting the wavenumbers at which they need the spectra; each spectrum is then
+    //! looked up for the whole batch in a single call. Kernels at the same point share q and |k-q|, and fixed-node
+    //! rules repeat q between neighbouring points, so lookups are shared within a point and with its predecessor,
+    //! and preset wavenumbers are not looked up at all
+    inline int kernel_group_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                      const int* nvec, const int* core)
+      {
+        kernel_group_data* group = static_cast<kernel_group_data*>(userdata);
+        
+        const int single = 1;
+        const unsigned int N = static_cast<unsigned int>(*ncomp) / components_per_kernel;
+        const unsigned int slots = static_cast<unsigned int>(*nvec) * N;
+        
+        group->wavenumbers.clear();
+        group->factor_count.resize(slots);
+        group->factor_index.resize(slots * factor_recording_Pk::max_factors);
+        
+        const size_t presets = group->presets;
+        if(presets > 0) group->wavenumbers.push_back(group->preset_k);
+        
+        size_t previous_start = presets;
+        for(int p = 0; p < *nvec; ++p)
+          {
+            const cubareal* xp = x + p*(*ndim);
+            cubareal* fp = f + p*(*ncomp);
+            const size_t start = group->wavenumbers.size();
+            
+            for(unsigned int i = 0; i < N; ++i)
+              {
+                group->factors.reset();
+                
+                // the kernel value is held in the raw slot until the spectra are available
+                int status = group->integrands[i](ndim, xp, &single, fp+raw_component(i), &group->kernel);
+                if(status != 0) return status;
+                
+                const unsigned int slot = p*N + i;
+                group->factor_count[slot] = group->factors.size();
+                
+                for(unsigned int j = 0; j < group->factors.size(); ++j)
+                  {
+                    const double q = group->factors.get()[j];
+                    
+                    size_t index = 0;
+                    while(index < presets && group->wavenumbers[index] != q) ++index;
+                    
+                    if(index == presets)
+                      {
+                        index = previous_start;
+                        while(index < group->wavenumbers.size() && group->wavenumbers[index] != q) ++index;
+                        if(index == group->wavenumbers.size()) group->wavenumbers.push_back(q);
+                      }
+                    
+                    group->factor_index[slot*factor_recording_Pk::max_factors + j] = static_cast<unsigned int>(index);
+                  }
+              }
+            
+            previous_start = start;
+          }
+        
+        const unsigned int n = static_cast<unsigned int>(group->wavenumbers.size());
+        group->P_raw.resize(n);
+        group->P_nw.resize(n);
+        if(presets > 0)
+          {
+            group->P_raw[0] = group->preset_raw;
+            group->P_nw[0] = group->preset_nw;
+          }
+        
+        group->raw.evaluate_batch(group->wavenumbers.data() + presets, group->P_raw.data() + presets, n - presets);
+        group->nowiggle.evaluate_batch(group->wavenumbers.data() + presets, group->P_nw.data() + presets, n - presets);
+        
+        for(int p = 0; p < *nvec; ++p)
+          {
+            cubareal* fp = f + p*(*ncomp);
+            
+            for(unsigned int i = 0; i < N; ++i)
+              {
+                const unsigned int slot = p*N + i;
+                const unsigned int* index = group->factor_index.data() + slot*factor_recording_Pk::max_factors;
+                
+                double raw = fp[raw_component(i)];
+                double nw = raw;
+                for(unsigned int j = 0; j < group->factor_count[slot]; ++j)
+                  {
+                    raw *= group->P_raw[index[j]];
+                    nw *= group->P_nw[index[j]];
+                  }
+                
+                fp[raw_component(i)] = raw;
+                fp[nowiggle_component(i)] = nw;
+              }
+          }
+        
+        return 0;
+      }
+    
+    //! relative tolerance when identifying the orientation or symmetry of an integrand by probing it
+    constexpr double probe_tolerance = 1E-8;
+    
+    
+    //! determine whether the angular variable of a P22 integrand runs with cos theta (+1) or against it (-1),
+    //! from the wavenumbers at which it evaluates the spectrum; returns 0 if this cannot be decided
+    inline int angular_orientation(integrand_t integrand, const FRW_model& model, const Mpc_units::energy& k,
+                                   const Mpc_units::energy& UV_cutoff, const Mpc_units::energy& IR_cutoff)
+      {
+        // at q = k and v = 1/4, |k-q| is sqrt(3) k if v runs with cos theta, and k if it runs against it
+        unit_Pk unit;
+        range_recording_Pk_adapter recorder(unit);
+        integrand_data data(model, k, UV_cutoff, IR_cutoff, recorder);
+        
+        const int ndim = dimensions;
+        const int single = 1;
+        cubareal x[dimensions] = { (k - IR_cutoff) / (UV_cutoff - IR_cutoff), 0.25 };
+        cubareal f = 0.0;
+        integrand(&ndim, x, &single, &f, &data);
+        
+        const double kk = k * Mpc_units::Mpc;
+        const double p_max = recorder.get_max();
+        
+        if(std::abs(p_max - std::sqrt(3.0)*kk) < probe_tolerance*kk) return +1;
+        if(std::abs(p_max - kk) < probe_tolerance*kk) return -1;
+        return 0;
+      }
+    
+    
+    //! determine whether a P22 integrand is symmetric under exchange of q and k-q, by comparing its density in
+    //! (q, |k-q|) at mirrored pairs of points; the orientation of its angular variable must be known
+    inline bool exchange_symmetric(integrand_t integrand, const FRW_model& model, const Mpc_units::energy& k,
+                                   const Mpc_units::energy& UV_cutoff, const Mpc_units::energy& IR_cutoff, int orientation)
+      {
+        unit_Pk unit;
+        integrand_data data(model, k, UV_cutoff, IR_cutoff, unit);
+        
+        const int ndim = dimensions;
+        const int single = 1;
+        const double kk = k * Mpc_units::Mpc;
+        const double IR = IR_cutoff * Mpc_units::Mpc;
+        const double range = (UV_cutoff - IR_cutoff) * Mpc_units::Mpc;
+        
+        // density with respect to dq d|k-q|; dv = |k-q| d|k-q| / 2kq
+        auto density = [&](double q, double p) -> double
+          {
+            const double cos_theta = (kk*kk + q*q - p*p) / (2.0*kk*q);
+            cubareal x[dimensions] = { (q - IR) / range, (1.0 + orientation*cos_theta) / 2.0 };
+            cubareal f = 0.0;
+            integrand(&ndim, x, &single, &f, &data);
+            return f * p / (2.0*kk*q*range);
+          };
+        
+        // pairs satisfying the triangle inequality in either order, measured in units of k
+        constexpr double probes[][2] = { { 0.7, 1.1 }, { 0.6, 1.3 }, { 2.0, 2.5 } };
+        
+        for(const auto& probe : probes)
+          {
+            const double a = density(probe[0]*kk, probe[1]*kk);
+            const double b = density(probe[1]*kk, probe[0]*kk);
+            if(std::abs(a - b) > probe_tolerance * std::max(std::abs(a), std::abs(b))) return false;
+          }
+        
+        return true;
+      }
+    
+    
+    //! data block for a group of P22 kernels integrated over (log q, log |k-q|), which places the ridge where |k-q|
+    //! is small on a boundary of the domain rather than leaving Cuhre to locate it. When every kernel is symmetric
+    //! under q <-> k-q only the half q < |k-q| is integrated, and the result doubled; the ridge is then mirrored
+    //! onto the IR boundary of the q integral
+    class ridge_map_data
+      {
+      
+      public:
+        
+        ridge_map_data(kernel_group_data& g, const Mpc_units::energy& _k, const Mpc_units::energy& UV,
+                       const Mpc_units::energy& IR, int o, bool s)
+          : group(g),
+            k(_k * Mpc_units::Mpc),
+            UV_cutoff(UV * Mpc_units::Mpc),
+            IR_cutoff(IR * Mpc_units::Mpc),
+            log_q_range(std::log(UV / IR)),
+            orientation(o),
+            symmetric(s)
+          {
+          }
+        
+        kernel_group_data& group;
+        
+        double k;
+        double UV_cutoff;
+        double IR_cutoff;
+        double log_q_range;
+        
+        int    orientation;
+        bool   symmetric;
+        
+        //! sample points mapped back to the unit square on which the integrands are written, and their Jacobians
+        std::vector<cubareal> x;
+        std::vector<double>   jacobian;
+      };
+    
+    
+    //! evaluate a group of P22 kernels at a batch of points given in (log q, log |k-q|)
+    inline int ridge_map_integrand(const int* ndim, const cubareal* x, const int* ncomp, cubareal* f, void* userdata,
+                                   const int* nvec, const int* core)
+      {
+        ridge_map_data* data = static_cast<ridge_map_data*>(userdata);
+        
+        const double kk = data->k;
+        const double IR = data->IR_cutoff;
+        const double UV = data->UV_cutoff;
+        const double multiplicity = data->symmetric ? 2.0 : 1.0;
+        
+        data->x.resize(static_cast<size_t>(*nvec) * (*ndim));
+        data->jacobian.resize(static_cast<size_t>(*nvec));
+        
+        for(int n = 0; n < *nvec; ++n)
+          {
+            const cubareal* xn = x + n*(*ndim);
+            cubareal* yn = data->x.data() + n*(*ndim);
+            
+            const double q = IR * std::exp(xn[0] * data->log_q_range);
+            yn[0] = (q - IR) / (UV - IR);
+            
+            // P(|k-q|) vanishes outside the window
+            double p_lo = std::max(std::abs(kk - q), IR);
+            const double p_hi = std::min(kk + q, UV);
+            if(data->symmetric) p_lo = std::max(p_lo, q);
+            
+            if(p_hi <= p_lo)
+              {
+                yn[1] = 0.5;
+                data->jacobian[n] = 0.0;
+                continue;
+              }
+            
+            const double log_p_range = std::log(p_hi / p_lo);
+            const double p = p_lo * std::exp(xn[1] * log_p_range);
+            const double cos_theta = (kk*kk + q*q - p*p) / (2.0*kk*q);
+            yn[1] = std::min(1.0, std::max(0.0, (1.0 + data->orientation*cos_theta) / 2.0));
+            
+            // du = q dlog q / (UV-IR) and dv = p^2 dlog p / 2kq
+            data->jacobian[n] = multiplicity * data->log_q_range * log_p_range * p*p / (2.0*kk*(UV - IR));
+          }
+        
+        int status = kernel_group_integrand(ndim, data->x.data(), ncomp, f, &data->group, nvec, core);
+        
+        for(int n = 0; n < *nvec; ++n)
+          {
+            for(int c = 0; c < *ncomp; ++c)
+              {
+                f[n*(*ncomp) + c] *= data->jacobian[n];
+              }
+          }
+        
+        return status;
+      }
+    
   }   // namespace oneloop_momentum_impl
 
 #endif //LSSEFT_SHARED_H
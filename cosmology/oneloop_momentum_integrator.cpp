@@ -26,9 +26,21 @@
 
 #include <iostream>
 #include <fstream>
+#include <vector>
+#include <map>
+#include <cmath>
+#include <algorithm>
+#include <limits>
 
 #include "oneloop_momentum_integrator.h"
 #include "oneloop_integrands/integrands.h"
+#include "oneloop_P13_matrix.h"
+#include "oneloop_fftlog.h"
+#include "oneloop_cutoff_sweep.h"
+#include "loop_tolerance_planner.h"
+#include "oneloop_gauss_legendre_nodes.h"
+
+#include "utilities/gauss_legendre.h"
 
 #include "cuba.h"
 
@@ -38,7 +50,9 @@
 
 oneloop_momentum_integrator::oneloop_momentum_integrator(const loop_integral_params& p, error_handler& e)
   : params(p),
-    err_handler(e)
+    err_handler(e),
+    pending_13(nullptr),
+    pending_22(nullptr)
   {
     // seed random number generator
     mersenne_twister.seed(random_device());
@@ -50,8 +64,24 @@ oneloop_momentum_integrator::integrate(const FRW_model& model, const loop_integr
                                        const k_token& k_tok, const Mpc_units::energy& UV_cutoff, const UV_cutoff_token& UV_tok,
                                        const Mpc_units::energy& IR_cutoff, const IR_cutoff_token& IR_tok, const initial_filtered_Pk& Pk)
   {
+    // kernels of each type are queued as they are visited, then integrated together, so that they share
+    // a single adaptive subdivision and a single set of P(q) evaluations
+    loop_kernel_group P13_group(loop_integral_type::P13);
+    loop_kernel_group P22_group(loop_integral_type::P22);
+    this->pending_13 = &P13_group;
+    this->pending_22 = &P22_group;
 
 #include "autogenerated/integrate_stmts.cpp"
+    
+    this->pending_13 = nullptr;
+    this->pending_22 = nullptr;
+    
+    // failures have already been reported to the error handler, kernel by kernel
+    this->kernel_group_integral(model, k, UV_cutoff, IR_cutoff, Pk, P13_group);
+    this->kernel_group_integral(model, k, UV_cutoff, IR_cutoff, Pk, P22_group);
+    
+    // every kernel has now reported a magnitude, so later integrations can be planned
+    if(this->planner) this->planner->mark_complete();
 
     loop_integral container(k_tok, params_tok, Pk.get_token(), UV_tok, IR_tok, ker);
 
@@ -66,104 +96,597 @@ bool oneloop_momentum_integrator::kernel_integral(const FRW_model& model, const
                                                   integrand_t integrand, KernelRecord& result, loop_integral_type type,
                                                   const std::string& name)
   {
+    loop_kernel_group* pending = type == loop_integral_type::P13 ? this->pending_13 : this->pending_22;
+    
+    // the result is written when the pending group is integrated, so no failure can be reported yet
+    if(pending != nullptr)
+      {
+        pending->add(integrand, result, name);
+        return false;
+      }
+    
+    // outside integrate(), a single kernel is a group with one member
+    loop_kernel_group group(type);
+    group.add(integrand, result, name);
+    
+    return this->kernel_group_integral(model, k, UV_cutoff, IR_cutoff, Pk, group);
+  }
+
+
+std::vector<loop_kernel_group> oneloop_momentum_integrator::plan_group(const Mpc_units::energy& k,
+                                                                      const initial_filtered_Pk& Pk,
+                                                                      const loop_kernel_group& group)
+  {
+    const loop_integral_type type = group.get_type();
+    const double Ptree = static_cast<double>(Pk.Pk_raw(k));
+    
+    const std::vector<integrand_t>& integrands = group.get_integrands();
+    const std::vector<std::string>& names = group.get_names();
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    
+    // members of a band are integrated together, so the tightest allocation applies to all of them;
+    // bands are a factor of 2 wide, so no kernel is integrated to more than twice its own accuracy
+    std::map<int, loop_kernel_group> bands;
+    
+    for(unsigned int i = 0; i < integrands.size(); ++i)
+      {
+        const double relerr = this->planner->relerr(names[i], type, k, Ptree);
+        const int bin = relerr > 0.0 ? static_cast<int>(std::floor(std::log2(relerr))) : std::numeric_limits<int>::min();
+        
+        loop_kernel_group& band = bands.emplace(bin, loop_kernel_group(type)).first->second;
+        band.set_relerr(band.get_relerr() ? std::min(*band.get_relerr(), relerr) : relerr);
+        
+        std::shared_ptr<loop_tolerance_planner> T = this->planner;
+        loop_kernel_group::writer_type raw = raw_writers[i];
+        loop_kernel_group::writer_type nw = nw_writers[i];
+        const std::string name = names[i];
+        
+        // a kernel which meets the band's tolerance also meets its own allocation, which is what it records
+        band.add(integrands[i],
+                 [=](double value, double error, unsigned int regions, unsigned int evaluations,
+                     boost::timer::nanosecond_type time, double abs_tol, double rel_tol) -> void
+                   {
+                     raw(value, error, regions, evaluations, time, abs_tol, std::max(rel_tol, relerr));
+                     T->observe(name, type, k, value);
+                   },
+                 [=](double value, double error, unsigned int regions, unsigned int evaluations,
+                     boost::timer::nanosecond_type time, double abs_tol, double rel_tol) -> void
+                   {
+                     nw(value, error, regions, evaluations, time, abs_tol, std::max(rel_tol, relerr));
+                   },
+                 names[i]);
+      }
+    
+    std::vector<loop_kernel_group> planned;
+    for(auto& t : bands)
+      {
+        planned.push_back(std::move(t.second));
+      }
+    
+    return planned;
+  }
+
+
+double oneloop_momentum_integrator::group_relerr(const loop_kernel_group& group) const
+  {
+    if(group.get_relerr()) return *group.get_relerr();
+    return group.get_type() == loop_integral_type::P13 ? this->params.get_relerr_13() : this->params.get_relerr_22();
+  }
+
+
+double oneloop_momentum_integrator::group_abserr(const loop_kernel_group& group) const
+  {
+    return group.get_type() == loop_integral_type::P13 ? this->params.get_abserr_13() : this->params.get_abserr_22();
+  }
+
+
+bool oneloop_momentum_integrator::kernel_group_integral(const FRW_model& model, const Mpc_units::energy& k,
+                                                        const Mpc_units::energy& UV_cutoff,
+                                                        const Mpc_units::energy& IR_cutoff, const initial_filtered_Pk& Pk,
+                                                        loop_kernel_group& group)
+  {
+    if(group.size() == 0) return false;
+    
     // disable CUBA's internal auto-parallelization
     // we're handling multiprocessor activity ourselves via the scheduler,
     // so it's preferable to keep each core fully active rather than have threads
     // trying to manage Cuba's subworkers
     cubacores(0, oneloop_momentum_impl::pcores);
     
+    if(!this->planner) return this->integrate_group(model, k, UV_cutoff, IR_cutoff, Pk, group);
+    
+    // allocate tolerances from the error budget, and integrate each band of similar tolerances separately
+    bool fail = false;
+    for(const loop_kernel_group& band : this->plan_group(k, Pk, group))
+      {
+        fail = this->integrate_group(model, k, UV_cutoff, IR_cutoff, Pk, band) || fail;
+      }
+    
+    return fail;
+  }
+
+
+bool oneloop_momentum_integrator::integrate_group(const FRW_model& model, const Mpc_units::energy& k,
+                                                  const Mpc_units::energy& UV_cutoff,
+                                                  const Mpc_units::energy& IR_cutoff, const initial_filtered_Pk& Pk,
+                                                  const loop_kernel_group& planned)
+  {
+    // P13 kernels may already have been evaluated over the whole k grid, by matrix products
+    if(planned.get_type() == loop_integral_type::P13 && this->P13_matrix)
+      {
+        if(this->read_P13_matrix(k, planned)) return false;
+      }
+    
     wiggle_Pk_raw_adapter raw(Pk, IR_cutoff, UV_cutoff);
     wiggle_Pk_nowiggle_adapter nw(Pk, IR_cutoff, UV_cutoff);
     
-    bool fail_raw = this->evaluate_integral(model, k, UV_cutoff, IR_cutoff, raw, integrand, result.get_raw(), type, name, "raw");
-    bool fail_nw  = this->evaluate_integral(model, k, UV_cutoff, IR_cutoff, nw, integrand, result.get_nowiggle(), type, name, "no-wiggle");
-    
-    return fail_raw || fail_nw;
+    switch(this->params.get_backend())
+      {
+        case loop_integral_backend::gauss_legendre:
+          return this->evaluate_group_gauss_legendre(model, k, UV_cutoff, IR_cutoff, raw, nw, planned);
+        
+        case loop_integral_backend::fftlog:
+          {
+            // without an engine, every kernel is integrated directly
+            if(!this->fftlog) return this->evaluate_group(model, k, UV_cutoff, IR_cutoff, raw, nw, planned);
+            
+            loop_kernel_group residual(planned.get_type());
+            residual.set_relerr(this->group_relerr(planned));
+            this->read_fftlog(k, planned, residual);
+            return this->evaluate_group(model, k, UV_cutoff, IR_cutoff, raw, nw, residual);
+          }
+        
+        case loop_integral_backend::cutoff_sweep:
+          {
+            // without a sweep, this is an ordinary fixed-node integral over one pair of cutoffs
+            if(!this->cutoff_sweep) return this->evaluate_group_gauss_legendre(model, k, UV_cutoff, IR_cutoff, raw, nw, planned);
+            
+            // fall back to adaptive integration where the sweep missed the tolerance
+            if(this->read_cutoff_sweep(UV_cutoff, IR_cutoff, planned)) return false;
+            return this->evaluate_group(model, k, UV_cutoff, IR_cutoff, raw, nw, planned);
+          }
+        
+        case loop_integral_backend::cuhre:
+        default:
+          return this->evaluate_group(model, k, UV_cutoff, IR_cutoff, raw, nw, planned);
+      }
   }
 
 
-template <typename IntegralRecord>
-bool oneloop_momentum_integrator::evaluate_integral(const FRW_model& model, const Mpc_units::energy& k,
-                                                    const Mpc_units::energy& UV_cutoff,
-                                                    const Mpc_units::energy& IR_cutoff,
-                                                    const generic_Pk<Mpc_units::inverse_energy3>& Pk,
-                                                    integrand_t integrand, IntegralRecord& result,
-                                                    loop_integral_type type, const std::string& name,
-                                                    const std::string& component)
+bool oneloop_momentum_integrator::evaluate_group(const FRW_model& model, const Mpc_units::energy& k,
+                                                 const Mpc_units::energy& UV_cutoff,
+                                                 const Mpc_units::energy& IR_cutoff,
+                                                 const generic_Pk<Mpc_units::inverse_energy3>& raw_Pk,
+                                                 const generic_Pk<Mpc_units::inverse_energy3>& nw_Pk,
+                                                 const loop_kernel_group& group)
   {
-    cubareal integral[oneloop_momentum_impl::dimensions];
-    cubareal error[oneloop_momentum_impl::dimensions];
-    cubareal prob[oneloop_momentum_impl::dimensions];
+    const unsigned int N = group.size();
+    if(N == 0) return false;
+    
+    // each kernel contributes a raw and a no-wiggle component, so the raw and no-wiggle
+    // integrals share a single adaptive subdivision and a single set of sample points
+    const unsigned int ncomp = oneloop_momentum_impl::components_per_kernel * N;
+    
+    std::vector<cubareal> integral(ncomp);
+    std::vector<cubareal> error(ncomp);
+    std::vector<cubareal> prob(ncomp);
     
     int regions;
     int evaluations;
     int fail;
-
-    boost::timer::cpu_timer raw_timer;
     
-    auto data = std::make_unique<oneloop_momentum_impl::integrand_data>(model, k, UV_cutoff, IR_cutoff, Pk);
+    boost::timer::cpu_timer group_timer;
+    
+    // every kernel samples P(k) at the same points, so spectrum lookups are shared across the group
+    auto group_data = std::make_unique<oneloop_momentum_impl::kernel_group_data>(group.get_integrands(), model, k, UV_cutoff,
+                                                                                 IR_cutoff, raw_Pk, nw_Pk);
+    
+    const loop_integral_type type = group.get_type();
+    double re = this->group_relerr(group);
+    const double ae = this->group_abserr(group);
     
-    double re = (type == loop_integral_type::P13 ? this->params.get_relerr_13() : this->params.get_relerr_22());
-    double ae = (type == loop_integral_type::P13 ? this->params.get_abserr_13() : this->params.get_abserr_22());
-
     constexpr unsigned int MAX_13_TRIES = 5;
     constexpr unsigned int MAX_22_TRIES = 3;
     unsigned int max_tries = (type == loop_integral_type::P13 ? MAX_13_TRIES : MAX_22_TRIES);
     unsigned int tries = 0;
     
-    while(tries < max_tries)
+    const std::vector<std::string>& names = group.get_names();
+    
+    // P22 kernels are integrated in variables which place the ridge |k-q| -> 0 on a boundary, and over half
+    // the domain when the kernels allow it
+    bool symmetric = false;
+    const int orientation = type == loop_integral_type::P22
+                            ? this->ridge_coordinates(model, k, UV_cutoff, IR_cutoff, group, symmetric) : 0;
+    
+    oneloop_momentum_impl::ridge_map_data ridge_data(*group_data, k, UV_cutoff, IR_cutoff, orientation, symmetric);
+    integrand_t integrand = reinterpret_cast<integrand_t>(orientation != 0 ? oneloop_momentum_impl::ridge_map_integrand
+                                                                           : oneloop_momentum_impl::kernel_group_integrand);
+    void* userdata = orientation != 0 ? static_cast<void*>(&ridge_data) : static_cast<void*>(group_data.get());
+    
+    // Cuhre only terminates when every component meets the requested tolerance,
+    // so convergence is controlled by the worst component
+    Cuhre(oneloop_momentum_impl::dimensions,
+          static_cast<int>(ncomp),
+          integrand, userdata,
+          oneloop_momentum_impl::points_per_invocation,
+          re, ae,
+          oneloop_momentum_impl::verbosity_none | oneloop_momentum_impl::samples_last,
+          oneloop_momentum_impl::min_eval, oneloop_momentum_impl::max_eval,
+          oneloop_momentum_impl::cuhre_key,
+          nullptr, nullptr,
+          &regions, &evaluations, &fail,
+          integral.data(), error.data(), prob.data());
+    
+    // apply Cuhre's own termination test to the estimate in hand
+    auto meets = [&](double tol) -> bool
       {
-        if(tries > 0)
+        for(unsigned int i = 0; i < ncomp; ++i)
+          {
+            if(error[i] > std::max(ae, tol * std::abs(integral[i]))) return false;
+          }
+        return true;
+      };
+    
+    // Cuhre stops at the evaluation limit, so a rerun with a relaxed tolerance either accepts the subdivision
+    // it already had or stops again at the same limit; rather than repeat that work from scratch, test the
+    // best estimate against each relaxed tolerance in turn
+    if(fail > 0)
+      {
+        while(++tries < max_tries)
           {
             re = re * 4.0;
             std::ostringstream msg;
-            msg << "relaxing error tolerance for kernel = " << name << " (" << component << "), attempt "
-                << tries << ", now abstol = " << ae << ", reltol = " << re;
+            msg << "relaxing error tolerance for kernel = " << names.front();
+            if(N > 1) msg << " and " << N-1 << " others";
+            msg << ", attempt " << tries << ", now abstol = " << ae << ", reltol = " << re;
             this->err_handler.info(msg.str());
+            
+            if(meets(re)) break;
+          }
+      }
+    else if(fail < 0)
+      {
+        tries = max_tries;
+      }
+    
+    group_timer.stop();
+    
+    // the cost of the integration is shared between all components;
+    // split it evenly so that summed timings remain comparable with separate integrations
+    boost::timer::nanosecond_type time = group_timer.elapsed().wall / ncomp;
+    
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    
+    // if no tolerance on the ladder is met, the estimate at the evaluation limit is still the best available;
+    // it is recorded with the relative tolerance it actually achieves, which may be looser than the last rung
+    double rel_tol = re;
+    if(tries >= max_tries)
+      {
+        rel_tol = 0.0;
+        for(unsigned int i = 0; i < ncomp; ++i)
+          {
+            if(error[i] <= ae) continue;
+            rel_tol = std::max(rel_tol, std::abs(integral[i]) > 0.0 ? error[i] / std::abs(integral[i])
+                                                                    : std::numeric_limits<double>::infinity());
+          }
+      }
+    
+    for(unsigned int i = 0; fail >= 0 && i < N; ++i)
+      {
+        unsigned int r = oneloop_momentum_impl::raw_component(i);
+        unsigned int w = oneloop_momentum_impl::nowiggle_component(i);
+        
+        raw_writers[i](integral[r] / (8.0 * M_PI * M_PI), error[r], regions, evaluations, time, ae, rel_tol);
+        nw_writers[i](integral[w] / (8.0 * M_PI * M_PI), error[w], regions, evaluations, time, ae, rel_tol);
+      }
+    
+    if(tries >= max_tries)
+      {
+        // report the component furthest from its tolerance
+        unsigned int worst = 0;
+        double worst_ratio = 0.0;
+        for(unsigned int i = 0; i < ncomp; ++i)
+          {
+            double ratio = error[i] / std::max(ae, re * std::abs(integral[i]));
+            if(ratio > worst_ratio)
+              {
+                worst = i;
+                worst_ratio = ratio;
+              }
           }
+        
+        std::ostringstream msg;
+        msg << "integration failure: kernel = " << names[worst / oneloop_momentum_impl::components_per_kernel] << " ("
+            << (worst == oneloop_momentum_impl::raw_component(worst / oneloop_momentum_impl::components_per_kernel) ? "raw" : "no-wiggle") << ")";
+        if(N > 1) msg << " in group of " << N << " kernels";
+        msg << ", regions = " << regions << ", evaluations = " << evaluations << ", fail = "
+            << fail << ", value = " << integral[worst] << ", error = " << error[worst] << ", probability = " << prob[worst];
+        this->err_handler.warn(msg.str());
+      }
+    
+    return (tries >= max_tries);
+  }
 
-        Cuhre(oneloop_momentum_impl::dimensions,
-              oneloop_momentum_impl::components,
-              integrand, data.get(),
-              oneloop_momentum_impl::points_per_invocation,
-              re, ae,
-              oneloop_momentum_impl::verbosity_none | oneloop_momentum_impl::samples_last,
-              oneloop_momentum_impl::min_eval, oneloop_momentum_impl::max_eval,
-              oneloop_momentum_impl::cuhre_key,
-              nullptr, nullptr,
-              &regions, &evaluations, &fail,
-              integral, error, prob);
-        
-        if(fail == 0)
+int oneloop_momentum_integrator::ridge_coordinates(const FRW_model& model, const Mpc_units::energy& k,
+                                                   const Mpc_units::energy& UV_cutoff, const Mpc_units::energy& IR_cutoff,
+                                                   const loop_kernel_group& group, bool& symmetric) const
+  {
+    symmetric = false;
+    
+    // logarithmic variables need a positive IR cutoff
+    if(!(IR_cutoff > Mpc_units::energy(0.0))) return 0;
+    
+    const std::vector<integrand_t>& integrands = group.get_integrands();
+    
+    int orientation = 0;
+    for(integrand_t integrand : integrands)
+      {
+        const int o = oneloop_momentum_impl::angular_orientation(integrand, model, k, UV_cutoff, IR_cutoff);
+        if(o == 0 || (orientation != 0 && o != orientation)) return 0;
+        orientation = o;
+      }
+    
+    symmetric = std::all_of(integrands.cbegin(), integrands.cend(), [&](integrand_t integrand) -> bool
+      {
+        return oneloop_momentum_impl::exchange_symmetric(integrand, model, k, UV_cutoff, IR_cutoff, orientation);
+      });
+    
+    return orientation;
+  }
+
+
+bool oneloop_momentum_integrator::evaluate_group_gauss_legendre(const FRW_model& model, const Mpc_units::energy& k,
+                                                                const Mpc_units::energy& UV_cutoff,
+                                                                const Mpc_units::energy& IR_cutoff,
+                                                                const generic_Pk<Mpc_units::inverse_energy3>& raw_Pk,
+                                                                const generic_Pk<Mpc_units::inverse_energy3>& nw_Pk,
+                                                                const loop_kernel_group& group)
+  {
+    const unsigned int N = group.size();
+    if(N == 0) return false;
+    
+    // nodes are placed uniformly in log q, which needs a positive IR cutoff
+    if(!(IR_cutoff > Mpc_units::energy(0.0))) return this->evaluate_group(model, k, UV_cutoff, IR_cutoff, raw_Pk, nw_Pk, group);
+    
+    const int ncomp = static_cast<int>(oneloop_momentum_impl::components_per_kernel * N);
+    const int ndim = oneloop_momentum_impl::dimensions;
+    const int core = 0;
+    
+    boost::timer::cpu_timer group_timer;
+    
+    auto group_data = std::make_unique<oneloop_momentum_impl::kernel_group_data>(group.get_integrands(), model, k, UV_cutoff,
+                                                                                 IR_cutoff, raw_Pk, nw_Pk);
+    
+    const double re = this->group_relerr(group);
+    const double ae = this->group_abserr(group);
+    
+    // P(q) at the radial nodes does not depend on k, so is normally sampled once for the whole batch
+    std::shared_ptr<oneloop_gauss_legendre_nodes> nodes = this->gl_nodes;
+    if(!nodes) nodes = std::make_shared<oneloop_gauss_legendre_nodes>(UV_cutoff, IR_cutoff, raw_Pk, nw_Pk, this->params.get_gl_points(),
+                                                                      LSSEFT_DEFAULT_GAUSS_LEGENDRE_DOUBLINGS);
+    
+    // P13 kernels do not depend on the angular variable, so a single angular node suffices
+    const bool P13 = group.get_type() == loop_integral_type::P13;
+    
+    // the integrands are written on the unit square, with u = (q-IR)/(UV-IR) and v parametrizing the angle
+    auto rule_sum = [&](unsigned int n) -> std::vector<double>
+      {
+        const gauss_legendre_node_table& radial = nodes->get(n);
+        const gauss_legendre_rule& rule = gauss_legendre(n);
+        const std::vector<double>& z = rule.get_nodes();
+        const std::vector<double>& w = rule.get_weights();
+        
+        const unsigned int n_angular = P13 ? 1 : n;
+        
+        std::vector<double> sum(static_cast<size_t>(ncomp), 0.0);
+        std::vector<cubareal> x(static_cast<size_t>(ndim)*n_angular);
+        std::vector<cubareal> f(static_cast<size_t>(ncomp)*n_angular);
+        const int nvec = static_cast<int>(n_angular);
+        
+        // angular nodes are the same for every q
+        for(unsigned int m = 0; m < n_angular; ++m)
+          {
+            x[ndim*m + 1] = P13 ? oneloop_momentum_impl::trivial_angular_node : (1.0 + z[m]) / 2.0;
+          }
+        
+        for(unsigned int j = 0; j < n; ++j)
           {
-            raw_timer.stop();
-    
-            // write values into return structure
-            result.value = typename IntegralRecord::value_type(integral[0] / (8.0 * M_PI * M_PI));
-            result.regions = regions;
-            result.evaluations = evaluations;
-            result.error = typename IntegralRecord::value_type(error[0]);
-            result.time = raw_timer.elapsed().wall;
+            // every angular node and every kernel at this q reads the same P(q), which is taken from the table
+            group_data->preset(radial.q[j], radial.P_raw[j], radial.P_nw[j]);
+            
+            for(unsigned int m = 0; m < n_angular; ++m)
+              {
+                x[ndim*m] = radial.u[j];
+              }
             
-            break;
+            oneloop_momentum_impl::kernel_group_integrand(&ndim, x.data(), &ncomp, f.data(), group_data.get(), &nvec, &core);
+            
+            for(unsigned int m = 0; m < n_angular; ++m)
+              {
+                const double Wm = radial.weight[j] * (P13 ? 1.0 : w[m] / 2.0);
+                for(int c = 0; c < ncomp; ++c)
+                  {
+                    sum[c] += Wm * f[ncomp*m + c];
+                  }
+              }
+          }
+        
+        return sum;
+      };
+    
+    // estimate error by comparison with a rule of twice the order, doubling until converged
+    unsigned int n = this->params.get_gl_points();
+    unsigned int evaluations = P13 ? n : n*n;
+    std::vector<double> coarse = rule_sum(n);
+    std::vector<double> fine;
+    std::vector<double> error(static_cast<size_t>(ncomp), 0.0);
+    
+    bool converged = false;
+    for(unsigned int d = 0; !converged && d < LSSEFT_DEFAULT_GAUSS_LEGENDRE_DOUBLINGS; ++d)
+      {
+        n *= 2;
+        fine = rule_sum(n);
+        evaluations += P13 ? n : n*n;
+        
+        converged = true;
+        for(int c = 0; c < ncomp; ++c)
+          {
+            error[c] = std::abs(fine[c] - coarse[c]);
+            if(error[c] > std::max(ae, re * std::abs(fine[c]))) converged = false;
           }
         
-        ++tries;
+        coarse.swap(fine);
       }
     
-    if(tries >= max_tries)
+    group_timer.stop();
+    
+    // the cost of the integration is shared between all components
+    boost::timer::nanosecond_type time = group_timer.elapsed().wall / ncomp;
+    
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    
+    // the highest-order rule gives the best estimate; a fixed rule has a single region
+    for(unsigned int i = 0; i < N; ++i)
       {
+        unsigned int r = oneloop_momentum_impl::raw_component(i);
+        unsigned int w = oneloop_momentum_impl::nowiggle_component(i);
+        
+        raw_writers[i](coarse[r] / (8.0 * M_PI * M_PI), error[r], 1, evaluations, time, ae, re);
+        nw_writers[i](coarse[w] / (8.0 * M_PI * M_PI), error[w], 1, evaluations, time, ae, re);
+      }
+    
+    if(!converged)
+      {
+        const std::vector<std::string>& names = group.get_names();
+        
+        unsigned int worst = 0;
+        double worst_ratio = 0.0;
+        for(int c = 0; c < ncomp; ++c)
+          {
+            double ratio = error[c] / std::max(ae, re * std::abs(coarse[c]));
+            if(ratio > worst_ratio)
+              {
+                worst = static_cast<unsigned int>(c);
+                worst_ratio = ratio;
+              }
+          }
+        
         std::ostringstream msg;
-        msg << "integration failure: kernel = " << name << " (" << component << "), "
-            << "regions = " << regions << ", evaluations = " << evaluations << ", fail = "
-            << fail << ", value = " << integral[0] << ", error = " << error[0] << ", probability = " << prob[0];
+        msg << "Gauss-Legendre rule did not converge: kernel = " << names[worst / oneloop_momentum_impl::components_per_kernel] << " ("
+            << (worst == oneloop_momentum_impl::raw_component(worst / oneloop_momentum_impl::components_per_kernel) ? "raw" : "no-wiggle") << ")";
+        if(N > 1) msg << " in group of " << N << " kernels";
+        msg << ", nodes = " << n;
+        if(!P13) msg << "x" << n;
+        msg << ", value = " << coarse[worst] << ", error = " << error[worst];
         this->err_handler.warn(msg.str());
       }
     
+    return !converged;
+  }
+
+bool oneloop_momentum_integrator::read_P13_matrix(const Mpc_units::energy& k, const loop_kernel_group& group)
+  {
+    const std::vector<integrand_t>& integrands = group.get_integrands();
+    
+    // the grid evaluation is built to the parameter block's tolerances, but is accepted against the
+    // group's allocated tolerance
+    const double ae = this->group_abserr(group);
+    const double re = this->group_relerr(group);
     
-    return (tries >= max_tries);
+    std::vector<const P13_matrix_value*> values;
+    for(integrand_t integrand : integrands)
+      {
+        const P13_matrix_value& v = this->P13_matrix->get(integrand, k);
+        
+        // fall back to integrating this group directly at k
+        if(!v.converged || v.raw_error > std::max(ae, re * std::abs(v.raw))
+           || v.nowiggle_error > std::max(ae, re * std::abs(v.nowiggle))) return false;
+        values.push_back(&v);
+      }
+    
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    const unsigned int evaluations = this->P13_matrix->get_evaluations();
+    
+    for(unsigned int i = 0; i < values.size(); ++i)
+      {
+        raw_writers[i](values[i]->raw, values[i]->raw_error, 1, evaluations, values[i]->time / 2, ae, re);
+        nw_writers[i](values[i]->nowiggle, values[i]->nowiggle_error, 1, evaluations, values[i]->time / 2, ae, re);
+      }
+    
+    return true;
   }
 
+
+void oneloop_momentum_integrator::read_fftlog(const Mpc_units::energy& k, const loop_kernel_group& group,
+                                              loop_kernel_group& residual)
+  {
+    const bool P13 = group.get_type() == loop_integral_type::P13;
+    const double abserr = this->group_abserr(group);
+    const double relerr = this->group_relerr(group);
+    
+    const std::vector<integrand_t>& integrands = group.get_integrands();
+    const std::vector<std::string>& names = group.get_names();
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    
+    for(unsigned int i = 0; i < integrands.size(); ++i)
+      {
+        fftlog_value v;
+        bool ok = P13 ? this->fftlog->P13(integrands[i], k, v) : this->fftlog->P22(integrands[i], k, v);
+        
+        ok = ok && v.raw_error <= std::max(abserr, relerr * std::abs(v.raw))
+                && v.nowiggle_error <= std::max(abserr, relerr * std::abs(v.nowiggle));
+        
+        if(!ok)
+          {
+            residual.add(integrands[i], raw_writers[i], nw_writers[i], names[i]);
+            continue;
+          }
+        
+        // no function evaluations are made at k; the cost lies in building the decomposition
+        raw_writers[i](v.raw, v.raw_error, 1, 0, v.time / 2, abserr, relerr);
+        nw_writers[i](v.nowiggle, v.nowiggle_error, 1, 0, v.time / 2, abserr, relerr);
+      }
+  }
+
+
+bool oneloop_momentum_integrator::read_cutoff_sweep(const Mpc_units::energy& UV_cutoff, const Mpc_units::energy& IR_cutoff,
+                                                    const loop_kernel_group& group)
+  {
+    const std::vector<integrand_t>& integrands = group.get_integrands();
+    
+    // the sweep is built to the parameter block's tolerances, but is accepted against the group's
+    // allocated tolerance
+    const double ae = this->group_abserr(group);
+    const double re = this->group_relerr(group);
+    
+    std::vector<const cutoff_sweep_value*> values;
+    for(integrand_t integrand : integrands)
+      {
+        const cutoff_sweep_value& v = this->cutoff_sweep->get(integrand, group.get_type(), UV_cutoff, IR_cutoff);
+        
+        if(!v.converged || v.raw_error > std::max(ae, re * std::abs(v.raw))
+           || v.nowiggle_error > std::max(ae, re * std::abs(v.nowiggle))) return false;
+        values.push_back(&v);
+      }
+    
+    const std::vector<loop_kernel_group::writer_type>& raw_writers = group.get_raw_writers();
+    const std::vector<loop_kernel_group::writer_type>& nw_writers = group.get_nowiggle_writers();
+    
+    for(unsigned int i = 0; i < values.size(); ++i)
+      {
+        raw_writers[i](values[i]->raw, values[i]->raw_error, 1, values[i]->evaluations, values[i]->time / 2, ae, re);
+        nw_writers[i](values[i]->nowiggle, values[i]->nowiggle_error, 1, values[i]->evaluations, values[i]->time / 2, ae, re);
+      }
+    
+    return true;
+  }
+
+
 // Alternative Divonne integrator
 
 //    Divonne(oneloop_momentum_impl::dimensions, oneloop_momentum_impl::components,
@@ -28,6 +28,10 @@
 
 
 #include <random>
+#include <vector>
+#include <string>
+#include <functional>
+#include <memory>
 #include <error/error_handler.h>
 
 #include "FRW_model.h"
@@ -43,12 +47,165 @@
 #include "cuba.h"
 
 #include "boost/timer/timer.hpp"
+#include "boost/optional.hpp"
 #include "boost/serialization/serialization.hpp"
 
 
 enum class loop_integral_type { P13, P22 };
 
 
+// forward-declare batched P13 evaluator
+class oneloop_P13_matrix;
+
+// forward-declare FFTLog evaluator
+class oneloop_fftlog;
+
+// forward-declare single-pass cutoff sweep evaluator
+class oneloop_cutoff_sweep;
+
+// forward-declare per-kernel tolerance planner
+class loop_tolerance_planner;
+
+// forward-declare shared Gauss-Legendre node table
+class oneloop_gauss_legendre_nodes;
+
+
+//! numerical backend used for one-loop momentum integrals; values are recorded in the database
+enum class loop_integral_backend { cuhre=0, gauss_legendre=1, fftlog=2, cutoff_sweep=3 };
+
+
+//! collects kernels of a single type which are to be integrated together, as the components of
+//! one vector-valued Cuhre integral at a fixed k
+class loop_kernel_group
+  {
+    
+  public:
+    
+    //! writer for one component of the integration result, including the tolerances to which it was accepted
+    typedef std::function<void(double value, double error, unsigned int regions, unsigned int evaluations,
+                               boost::timer::nanosecond_type time, double abs_tol, double rel_tol)> writer_type;
+    
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor sets kernel type; all members of a group share the same tolerances
+    loop_kernel_group(loop_integral_type t)
+      : type(t)
+      {
+      }
+    
+    //! destructor is default
+    ~loop_kernel_group() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! add a kernel to the group; the record must remain valid until the group has been integrated
+    template <typename KernelRecord>
+    void add(integrand_t integrand, KernelRecord& record, const std::string& name);
+    
+    //! add a kernel to the group, using existing writers for its results
+    void add(integrand_t integrand, const writer_type& raw, const writer_type& nw, const std::string& name)
+      {
+        this->integrands.push_back(integrand);
+        this->names.push_back(name);
+        this->raw_writers.push_back(raw);
+        this->nw_writers.push_back(nw);
+      }
+    
+    //! get number of kernels in the group
+    unsigned int size() const { return static_cast<unsigned int>(this->integrands.size()); }
+    
+    //! get kernel type
+    loop_integral_type get_type() const { return this->type; }
+    
+    //! get integrands
+    const std::vector<integrand_t>& get_integrands() const { return this->integrands; }
+    
+    //! get kernel names
+    const std::vector<std::string>& get_names() const { return this->names; }
+    
+    //! get writers for raw results
+    const std::vector<writer_type>& get_raw_writers() const { return this->raw_writers; }
+    
+    //! get writers for no-wiggle results
+    const std::vector<writer_type>& get_nowiggle_writers() const { return this->nw_writers; }
+    
+    //! set relative tolerance allocated to the group, replacing the parameter block's tolerance
+    void set_relerr(double r) { this->relerr = r; }
+    
+    //! get allocated relative tolerance, if there is one
+    const boost::optional<double>& get_relerr() const { return this->relerr; }
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! build a writer for a single integral record, which also records the kernel type
+    template <typename IntegralRecord>
+    static writer_type make_writer(IntegralRecord& result, loop_integral_type t);
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! kernel type
+    loop_integral_type type;
+    
+    //! integrands, one per component
+    std::vector<integrand_t> integrands;
+    
+    //! kernel names, used for reporting
+    std::vector<std::string> names;
+    
+    //! writers for raw results
+    std::vector<writer_type> raw_writers;
+    
+    //! writers for no-wiggle results
+    std::vector<writer_type> nw_writers;
+    
+    //! allocated relative tolerance, if any
+    boost::optional<double> relerr;
+    
+  };
+
+
+template <typename KernelRecord>
+void loop_kernel_group::add(integrand_t integrand, KernelRecord& record, const std::string& name)
+  {
+    this->integrands.push_back(integrand);
+    this->names.push_back(name);
+    this->raw_writers.push_back(make_writer(record.get_raw(), this->type));
+    this->nw_writers.push_back(make_writer(record.get_nowiggle(), this->type));
+  }
+
+
+template <typename IntegralRecord>
+loop_kernel_group::writer_type loop_kernel_group::make_writer(IntegralRecord& result, loop_integral_type t)
+  {
+    const unsigned int type = (t == loop_integral_type::P13 ? 13 : 22);
+    
+    return [&result, type](double value, double error, unsigned int regions, unsigned int evaluations,
+                     boost::timer::nanosecond_type time, double abs_tol, double rel_tol) -> void
+      {
+        result.value = typename IntegralRecord::value_type(value);
+        result.regions = regions;
+        result.evaluations = evaluations;
+        result.error = typename IntegralRecord::value_type(error);
+        result.time = time;
+        result.abs_tol = abs_tol;
+        result.rel_tol = rel_tol;
+        result.type = type;
+      };
+  }
+
+
 class loop_integral_params
   {
     
@@ -58,11 +215,19 @@ class loop_integral_params
     
     //! constructor
     loop_integral_params(double a_13=LSSEFT_DEFAULT_INTEGRAL_ABS_ERR_13, double r_13=LSSEFT_DEFAULT_INTEGRAL_REL_ERR_13,
-                         double a_22=LSSEFT_DEFAULT_INTEGRAL_ABS_ERR_22, double r_22=LSSEFT_DEFAULT_INTEGRAL_REL_ERR_22)
+                         double a_22=LSSEFT_DEFAULT_INTEGRAL_ABS_ERR_22, double r_22=LSSEFT_DEFAULT_INTEGRAL_REL_ERR_22,
+                         loop_integral_backend b=loop_integral_backend::cuhre,
+                         unsigned int n=LSSEFT_DEFAULT_GAUSS_LEGENDRE_POINTS,
+                         double t=LSSEFT_DEFAULT_LOOP_TARGET_ERR)
       : abs_err_13(a_13),
         rel_err_13(r_13),
         abs_err_22(a_22),
-        rel_err_22(r_22)
+        rel_err_22(r_22),
+        backend(b),
+        gl_points(n),
+        target_err(t),
+        weight_13(1.0),
+        weight_22(1.0)
       {
       }
    
@@ -86,6 +251,26 @@ class loop_integral_params
     //! get 22 relerr
     double get_relerr_22() const { return this->rel_err_22; }
     
+    //! get integration backend
+    loop_integral_backend get_backend() const { return this->backend; }
+    
+    //! get number of Gauss-Legendre nodes per dimension, before doubling
+    unsigned int get_gl_points() const { return this->gl_points; }
+    
+    //! get target accuracy of the final power spectra, relative to the tree-level term; zero if
+    //! per-kernel tolerances are not to be allocated
+    double get_target_err() const { return this->target_err; }
+    
+    //! get largest growth-factor weight of a 13 kernel, relative to the tree-level growth factor
+    double get_weight_13() const { return this->weight_13; }
+    
+    //! get largest growth-factor weight of a 22 kernel, relative to the tree-level growth factor
+    double get_weight_22() const { return this->weight_22; }
+    
+    //! set growth-factor weights; these depend on the redshifts requested, rather than identifying
+    //! the parameter set, so are not recorded in the database
+    void set_growth_weights(double w_13, double w_22) { this->weight_13 = w_13; this->weight_22 = w_22; }
+    
     
     // INTERNAL DATA
   
@@ -103,6 +288,21 @@ class loop_integral_params
     //! relative tolerance for 22 integrals
     double rel_err_22;
     
+    //! integration backend
+    loop_integral_backend backend;
+    
+    //! number of Gauss-Legendre nodes per dimension, before doubling
+    unsigned int gl_points;
+    
+    //! target accuracy of the final power spectra
+    double target_err;
+    
+    //! growth-factor weight of 13 kernels
+    double weight_13;
+    
+    //! growth-factor weight of 22 kernels
+    double weight_22;
+    
     // enable boost::serialization support, and hence automated packing for transmission over MPI
     friend class boost::serialization::access;
     
@@ -113,6 +313,15 @@ class loop_integral_params
         ar & rel_err_13;
         ar & abs_err_22;
         ar & rel_err_22;
+        
+        unsigned int b = static_cast<unsigned int>(backend);
+        ar & b;
+        backend = static_cast<loop_integral_backend>(b);
+        
+        ar & gl_points;
+        ar & target_err;
+        ar & weight_13;
+        ar & weight_22;
       }
     
   };
@@ -140,23 +349,91 @@ class oneloop_momentum_integrator
     loop_integral integrate(const FRW_model& model, const loop_integral_params_token& params_tok, const Mpc_units::energy& k,
                                 const k_token& k_tok, const Mpc_units::energy& UV_cutoff, const UV_cutoff_token& UV_tok,
                                 const Mpc_units::energy& IR_cutoff, const IR_cutoff_token& IR_tok, const initial_filtered_Pk& Pk);
+    
+    //! take P13 kernels from a precomputed evaluation over a grid of wavenumbers, rather than integrating
+    //! them at each k separately; the grid must contain every k subsequently passed to integrate()
+    void use_P13_matrix(std::shared_ptr<oneloop_P13_matrix> M) { this->P13_matrix = std::move(M); }
+    
+    //! evaluate kernels by FFTLog, when the backend requests it; the engine must have been built for
+    //! the same cutoffs and spectrum as are subsequently passed to integrate()
+    void use_fftlog(std::shared_ptr<oneloop_fftlog> F) { this->fftlog = std::move(F); }
+    
+    //! take kernels from a single-pass evaluation over a set of cutoffs at fixed k, when the backend
+    //! requests it; the sweep must contain every (UV, IR) pair subsequently passed to integrate()
+    void use_cutoff_sweep(std::shared_ptr<oneloop_cutoff_sweep> S) { this->cutoff_sweep = std::move(S); }
+    
+    //! allocate relative tolerances to each kernel from an error budget on the final power spectra;
+    //! the planner learns kernel magnitudes from every integral performed, so should be shared between
+    //! integrations with the same parameters, spectrum and cutoffs
+    void use_tolerance_planner(std::shared_ptr<loop_tolerance_planner> T) { this->planner = std::move(T); }
+    
+    //! take P(q) at the radial nodes of the fixed-node rules from a shared table, rather than sampling
+    //! it at each k; the table must have been built for the same cutoffs, spectrum and parameters
+    void use_gauss_legendre_nodes(std::shared_ptr<oneloop_gauss_legendre_nodes> G) { this->gl_nodes = std::move(G); }
 
     // INTERNAL API
 
   private:
 
-    //! perform a kernel integral, both raw and wiggle parts
+    //! queue a kernel integral, both raw and wiggle parts, in the pending group for its type;
+    //! the group is integrated once every kernel at this k has been queued
     template <typename KernelRecord>
     bool kernel_integral(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
                          const Mpc_units::energy& IR_cutoff, const initial_filtered_Pk& Pk, integrand_t interand,
                          KernelRecord& result, loop_integral_type type, const std::string& name);
     
-    //! perform a single kernel integral of either raw or wiggle type, depending on which spline is supplied
-    template <typename IntegralRecord>
-    bool evaluate_integral(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
-                           const Mpc_units::energy& IR_cutoff, const generic_Pk<Mpc_units::inverse_energy3>& Pk,
-                           integrand_t integrand, IntegralRecord& result, loop_integral_type type,
-                           const std::string& name, const std::string& component);
+    //! split a group into bands whose tolerances, allocated by the planner, agree to within a factor of 2;
+    //! each kernel records its own allocation, and its results are reported back to the planner
+    std::vector<loop_kernel_group> plan_group(const Mpc_units::energy& k, const initial_filtered_Pk& Pk,
+                                              const loop_kernel_group& group);
+    
+    //! get relative tolerance for a group: its allocated tolerance if it has one, otherwise the parameter block's
+    double group_relerr(const loop_kernel_group& group) const;
+    
+    //! get absolute tolerance for a group
+    double group_abserr(const loop_kernel_group& group) const;
+    
+    //! perform a group of kernel integrals, both raw and wiggle parts;
+    //! returns true if the group failed to converge
+    bool kernel_group_integral(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
+                               const Mpc_units::energy& IR_cutoff, const initial_filtered_Pk& Pk, loop_kernel_group& group);
+    
+    //! perform a group of kernel integrals, whose tolerance has already been allocated, using the
+    //! backend selected by the parameter block; returns true if the group failed to converge
+    bool integrate_group(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
+                         const Mpc_units::energy& IR_cutoff, const initial_filtered_Pk& Pk, const loop_kernel_group& planned);
+    
+    //! perform a group of kernel integrals using Cuhre, with the raw and no-wiggle parts of each kernel
+    //! computed as separate components of a single integral
+    bool evaluate_group(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
+                        const Mpc_units::energy& IR_cutoff, const generic_Pk<Mpc_units::inverse_energy3>& raw_Pk,
+                        const generic_Pk<Mpc_units::inverse_energy3>& nw_Pk, const loop_kernel_group& group);
+    
+    //! decide whether a group of P22 kernels can be integrated over (log q, log |k-q|); returns the orientation
+    //! of their angular variable, or zero if they cannot. 'symmetric' is set if every kernel is also symmetric
+    //! under q <-> k-q, so that half the domain suffices
+    int ridge_coordinates(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
+                          const Mpc_units::energy& IR_cutoff, const loop_kernel_group& group, bool& symmetric) const;
+    
+    //! perform a group of kernel integrals using a fixed-node Gauss-Legendre rule in log q, estimating the
+    //! error by doubling the rule; P22 kernels use a tensor rule in (log q, x), while the angular integral
+    //! of P13 kernels is trivial and is sampled at a single node. Falls back to Cuhre if the IR cutoff is zero
+    bool evaluate_group_gauss_legendre(const FRW_model& model, const Mpc_units::energy& k, const Mpc_units::energy& UV_cutoff,
+                                       const Mpc_units::energy& IR_cutoff, const generic_Pk<Mpc_units::inverse_energy3>& raw_Pk,
+                                       const generic_Pk<Mpc_units::inverse_energy3>& nw_Pk, const loop_kernel_group& group);
+    
+    //! read a group of P13 kernels from the precomputed grid evaluation; returns false, leaving the
+    //! results unwritten, if any kernel failed to meet the tolerance there
+    bool read_P13_matrix(const Mpc_units::energy& k, const loop_kernel_group& group);
+    
+    //! evaluate a group of kernels by FFTLog; kernels which are unsuitable, or which miss the tolerance,
+    //! are collected in 'residual' for direct integration
+    void read_fftlog(const Mpc_units::energy& k, const loop_kernel_group& group, loop_kernel_group& residual);
+    
+    //! read a group of kernels from the single-pass cutoff sweep; returns false, leaving the results
+    //! unwritten, if any kernel failed to meet the tolerance there
+    bool read_cutoff_sweep(const Mpc_units::energy& UV_cutoff, const Mpc_units::energy& IR_cutoff,
+                           const loop_kernel_group& group);
 
 
     // INTERNAL DATA
@@ -168,6 +445,27 @@ class oneloop_momentum_integrator
     
     //! reference to error handler agent
     error_handler& err_handler;
+    
+    //! precomputed P13 kernels, if available
+    std::shared_ptr<oneloop_P13_matrix> P13_matrix;
+    
+    //! FFTLog evaluator, if available
+    std::shared_ptr<oneloop_fftlog> fftlog;
+    
+    //! cutoff sweep, if available
+    std::shared_ptr<oneloop_cutoff_sweep> cutoff_sweep;
+    
+    //! tolerance planner, if available
+    std::shared_ptr<loop_tolerance_planner> planner;
+    
+    //! shared Gauss-Legendre node table, if available
+    std::shared_ptr<oneloop_gauss_legendre_nodes> gl_nodes;
+    
+    //! P13 kernels queued for integration at the current k, if integrate() is in progress
+    loop_kernel_group* pending_13;
+    
+    //! P22 kernels queued for integration at the current k, if integrate() is in progress
+    loop_kernel_group* pending_22;
 
 
     // RANDOM NUMBER GENERATORS
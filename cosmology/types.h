@@ -46,6 +46,8 @@
 
 #include "boost/serialization/serialization.hpp"
 #include "boost/serialization/vector.hpp"
+#include "boost/optional.hpp"
+#include "boost/timer/timer.hpp"
 
 
 //! work record for a transfer function calculation
@@ -113,14 +115,15 @@ class loop_integral_work_record
   public:
 
     //! constructor
-    loop_integral_work_record(const Mpc_units::energy& _k, const k_token& kt, const Mpc_units::energy& _UV,
-                              const UV_cutoff_token& UVt, const Mpc_units::energy& _IR, const IR_cutoff_token& IRt,
-                              const std::shared_ptr<initial_filtered_Pk>& _Pk, const loop_integral_params_token& _pt,
-                              const loop_integral_params& _p)
+    loop_integral_work_record(const Mpc_units::energy& _k, const k_token& kt, const FRW_model_token& mt,
+                              const Mpc_units::energy& _UV, const UV_cutoff_token& UVt, const Mpc_units::energy& _IR,
+                              const IR_cutoff_token& IRt, const std::shared_ptr<initial_filtered_Pk>& _Pk,
+                              const loop_integral_params_token& _pt, const loop_integral_params& _p)
       : k(_k),
         UV_cutoff(_UV),
         IR_cutoff(_IR),
         k_tok(kt),
+        model_tok(mt),
         UV_tok(UVt),
         IR_tok(IRt),
         Pk(_Pk),
@@ -142,6 +145,9 @@ class loop_integral_work_record
 
     //! get wavenumber token
     const k_token& get_k_token() const { return(this->k_tok); }
+    
+    //! get FRW model token
+    const FRW_model_token& get_model_token() const { return this->model_tok; }
 
     //! get UV cutoff
     const Mpc_units::energy& get_UV_cutoff() const { return(this->UV_cutoff); }
@@ -163,6 +169,12 @@ class loop_integral_work_record
     
     //! get parameters block
     const loop_integral_params& get_params() const { return this->params; }
+    
+    //! get predicted integration time, if available
+    const boost::optional<boost::timer::nanosecond_type>& get_predicted_time() const { return this->predicted_time; }
+    
+    //! set predicted integration time
+    void set_predicted_time(boost::timer::nanosecond_type t) { this->predicted_time = t; }
 
 
     // INTERNAL DATA
@@ -180,6 +192,9 @@ class loop_integral_work_record
 
     //! wavenumber token
     k_token k_tok;
+    
+    //! FRW model token
+    FRW_model_token model_tok;
 
     //! UV cutoff token
     UV_cutoff_token UV_tok;
@@ -195,6 +210,9 @@ class loop_integral_work_record
     
     //! parameters block
     loop_integral_params params;
+    
+    //! predicted integration time, if a fitted cost model was available
+    boost::optional<boost::timer::nanosecond_type> predicted_time;
 
   };
 
@@ -423,10 +441,12 @@ class filter_Pk_work_record
   public:
     
     //! constructor
-    filter_Pk_work_record(const Mpc_units::energy& _k, const k_token& kt, std::shared_ptr<filterable_Pk>& Pk,
-                          const linear_Pk_token& Pt, const filter_params_token& pt, const Pk_filter_params& p)
+    filter_Pk_work_record(const Mpc_units::energy& _k, const k_token& kt, const FRW_model_token& mt,
+                          std::shared_ptr<filterable_Pk>& Pk, const linear_Pk_token& Pt, const filter_params_token& pt,
+                          const Pk_filter_params& p)
       : k(_k),
         k_tok(kt),
+        model_tok(mt),
         Pk_lin(Pk),
         Pk_tok(Pt),
         params_tok(pt),
@@ -445,6 +465,9 @@ class filter_Pk_work_record
     //! get wavenumber token
     const k_token& get_k_token() const { return this->k_tok; }
     
+    //! get model token
+    const FRW_model_token& get_model_token() const { return this->model_tok; }
+    
     //! get unfiltered linear power spectrum
     const std::shared_ptr<filterable_Pk>& get_linear_Pk() const { return this->Pk_lin; }
     
@@ -470,6 +493,9 @@ class filter_Pk_work_record
     //! wavenumber token
     k_token k_tok;
     
+    //! FRW model token
+    FRW_model_token model_tok;
+    
     //! unfiltered linear power spectrum
     std::shared_ptr<filterable_Pk> Pk_lin;
     
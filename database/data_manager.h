@@ -56,7 +56,10 @@
 
 #include "controller/argument_cache.h"
 
+#include "defaults.h"
+
 #include "boost/filesystem/operations.hpp"
+#include "boost/timer/timer.hpp"
 
 #include "sqlite3.h"
 
@@ -100,6 +103,17 @@ class data_manager
                                            double bottom_clearance=SPLINE_PK_DEFAULT_BOTTOM_CLEARANCE,
                                            double top_clearance=SPLINE_PK_DEFAULT_TOP_CLEARANCE);
 
+    //! generate a refined wavenumber database for the loop integrals, adding wavenumbers wherever interpolation
+    //! between the one-loop power spectra already computed for k_db would not meet a relative tolerance tol.
+    //! Returns an empty pointer if no refinement is needed.
+    //! generates a new transaction on the database; will fail if a transaction is in progress
+    std::unique_ptr<k_database>
+    refine_loop_k_db(const FRW_model_token& model, const growth_params_token& growth_params,
+                     const loop_integral_params_token& loop_params, z_database& z_db, k_database& k_db,
+                     IR_cutoff_database& IR_db, UV_cutoff_database& UV_db,
+                     std::shared_ptr<initial_filtered_Pk>& Pk_init, std::shared_ptr<final_filtered_Pk>& Pk_final,
+                     double tol);
+
     //! generate IR cutoff database from a set of samples
     std::unique_ptr<IR_cutoff_database> build_IR_cutoff_db(range<Mpc_units::energy>& sample);
 
@@ -141,13 +155,21 @@ class data_manager
     
     //! build a work list representing (k, z, IR, UV) combinations of the one-loop power spectra
     //! that are missing from the SQLite backing store.
+    //! If a list of deferred loop integrals is supplied, configurations which depend on them are omitted;
+    //! their loop integrals are not yet available, so these items must be generated once they have been computed.
     //! generates a new transaction on the database; will fail if a transaction is in progress
     std::unique_ptr<one_loop_Pk_work_list>
     build_one_loop_Pk_work_list(const FRW_model_token& model, const growth_params_token& growth_params,
                                 const loop_integral_params_token& loop_params, z_database& z_db,
                                 k_database& k_db, IR_cutoff_database& IR_db, UV_cutoff_database& UV_db,
                                 std::shared_ptr<initial_filtered_Pk>& Pk_init,
-                                std::shared_ptr<final_filtered_Pk>& Pk_final);
+                                std::shared_ptr<final_filtered_Pk>& Pk_final,
+                                const loop_integral_work_list* deferred = nullptr);
+    
+    //! obtain linear and one-loop growth factors for a set of redshifts
+    //! generates a new transaction on the database; will fail if a transaction is in progress
+    std::shared_ptr<oneloop_growth>
+    find_growth_factors(const FRW_model_token& model, const growth_params_token& growth_params, z_database& z_db);
 
     //! build a work list representing (k, z, IR_cutoff, UV_cutoff, IR_resum) combinations of the one-loop
     //! multipole power spectra that are missing from the SQLite backing store.
@@ -169,8 +191,9 @@ class data_manager
     
     //! build a work list representing k-modes for which we need to produce a filtered wiggle/no-wiggle power spectrum
     std::unique_ptr<filter_Pk_work_list>
-    build_filter_Pk_work_list(const linear_Pk_token& Pk_token, std::shared_ptr<filterable_Pk>& Pk_lin,
-                              const filter_params_token& filter_token, const Pk_filter_params& params);
+    build_filter_Pk_work_list(const FRW_model_token& model, const linear_Pk_token& Pk_token,
+                              std::shared_ptr<filterable_Pk>& Pk_lin, const filter_params_token& filter_token,
+                              const Pk_filter_params& params);
 
     //! build a work list representing counterterms which need to be computed;
     //! at one-loop the UV and IR cutoffs are not needed, but they're included for future compatibility
@@ -331,10 +354,20 @@ class data_manager
 
   public:
 
-    //! store a sample of some kind (the exact behaviour is determined by template specialization)
-    //! generates a new transaction on the database; will fail if a transaction is in progress
+    //! store a sample of some kind (the exact behaviour is determined by template specialization).
+    //! Samples are accumulated in a single group transaction, which is committed once it holds
+    //! LSSEFT_DEFAULT_GROUP_COMMIT_SAMPLES samples or has been open for LSSEFT_DEFAULT_GROUP_COMMIT_INTERVAL.
+    //! Each sample is written inside its own savepoint, so if a store fails only that sample is discarded
+    //! and the rest of the group is kept. Samples not yet committed are lost in a crash, but are then
+    //! missing from the database and will be recomputed by the next run
     template <typename SampleType>
     void store(const FRW_model_token& model, const SampleType& sample);
+
+    //! commit any samples held in the current group transaction; called automatically before
+    //! any other transaction is opened, and before indices are rebuilt by finalize_write().
+    //! The interval is only checked by store(), so callers which may fall idle with a group open
+    //! should also call this periodically
+    void commit_stores();
     
     
     // DATA EXTRACTION
@@ -396,6 +429,15 @@ class data_manager
 
     //! release a transaction
     void release_transaction();
+    
+    //! open a savepoint for a single sample within the group transaction
+    void begin_sample();
+    
+    //! release the savepoint for a sample, keeping its writes in the group transaction
+    void release_sample();
+    
+    //! discard the writes made since the savepoint for a sample was opened, and release it
+    void rollback_sample();
 
 
     // LOOKUP OR INSERT RECORDS
@@ -444,6 +486,15 @@ class data_manager
     //! current transaction manager, if one exists
     std::weak_ptr<transaction_manager> current_transaction;
 
+    //! group transaction used to accumulate stored samples, if one is open
+    std::shared_ptr<transaction_manager> store_transaction;
+
+    //! number of samples held in the group transaction
+    unsigned int stored_samples;
+
+    //! time since the group transaction was opened
+    boost::timer::cpu_timer store_timer;
+
 
     // POLICIES
 
@@ -489,13 +540,35 @@ class data_manager
 template <typename SampleType>
 void data_manager::store(const FRW_model_token& model, const SampleType& sample)
   {
-    // open a transaction on the database
-    auto transaction = this->open_transaction();
+    // join the current group transaction, or open a new one
+    if(!this->store_transaction)
+      {
+        this->store_transaction = this->open_transaction();
+        this->stored_samples = 0;
+        this->store_timer.start();
+      }
 
-    sqlite3_operations::store(this->handle, *transaction, this->policy, model, sample);
+    this->begin_sample();
+    
+    try
+      {
+        sqlite3_operations::store(this->handle, *this->store_transaction, this->policy, model, sample);
+      }
+    catch(...)
+      {
+        // discard only this sample; it remains missing from the database, but the rest of the group is kept
+        this->rollback_sample();
+        throw;
+      }
+    
+    this->release_sample();
 
-    // commit the transaction
-    transaction->commit();
+    ++this->stored_samples;
+    if(this->stored_samples >= LSSEFT_DEFAULT_GROUP_COMMIT_SAMPLES
+       || this->store_timer.elapsed().wall >= LSSEFT_DEFAULT_GROUP_COMMIT_INTERVAL)
+      {
+        this->commit_stores();
+      }
   }
 
 
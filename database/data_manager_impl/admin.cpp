@@ -104,6 +104,8 @@ void data_manager::setup_write(counterterm_work_list& work)
 
 void data_manager::finalize_write(transfer_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
     
     sqlite3_operations::create_index(this->handle, this->policy.transfer_table(), { "mid", "kid", "zid" });
@@ -114,6 +116,8 @@ void data_manager::finalize_write(transfer_work_list& work)
 
 void data_manager::finalize_growth_write()
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
     
     sqlite3_operations::create_index(this->handle, this->policy.D_factor_table(), { "mid", "params_id", "zid" });
@@ -125,6 +129,8 @@ void data_manager::finalize_growth_write()
 
 void data_manager::finalize_write(loop_integral_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
 
 #include "autogenerated/makeidx_kernel_stmts.cpp"
@@ -135,6 +141,8 @@ void data_manager::finalize_write(loop_integral_work_list& work)
 
 void data_manager::finalize_write(filter_Pk_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
 
     sqlite3_operations::create_index(this->handle, this->policy.Pk_linear_table(), "kid");
@@ -143,12 +151,16 @@ void data_manager::finalize_write(filter_Pk_work_list& work)
 
 void data_manager::finalize_write(Matsubara_XY_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
   }
 
 
 void data_manager::finalize_write(one_loop_Pk_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
     
 #include "autogenerated/makeidx_Pk_stmts.cpp"
@@ -159,6 +171,8 @@ void data_manager::finalize_write(one_loop_Pk_work_list& work)
 
 void data_manager::finalize_write(multipole_Pk_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
 
 #include "autogenerated/makeidx_multipole_stmts.cpp"
@@ -169,6 +183,8 @@ void data_manager::finalize_write(multipole_Pk_work_list& work)
 
 void data_manager::finalize_write(counterterm_work_list& work)
   {
+    this->commit_stores();
+
     sqlite3_operations::default_pragmas(this->handle);
 
     sqlite3_operations::create_index(
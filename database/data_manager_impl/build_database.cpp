@@ -32,6 +32,7 @@
 
 #include "database/data_manager.h"
 #include "database/data_manager_impl/types.h"
+#include "database/k_grid_planner.h"
 
 #include "sqlite3_detail/utilities.h"
 #include "sqlite3_detail/operations.h"
@@ -39,6 +40,7 @@
 #include "utilities/formatter.h"
 
 #include "defaults.h"
+#include "localizations/messages.h"
 
 #include "boost/timer/timer.hpp"
 
@@ -70,6 +72,84 @@ std::unique_ptr<k_database> data_manager::build_k_db(range<Mpc_units::energy>& s
   }
 
 
+std::unique_ptr<k_database>
+data_manager::refine_loop_k_db(const FRW_model_token& model, const growth_params_token& growth_params,
+                               const loop_integral_params_token& loop_params, z_database& z_db, k_database& k_db,
+                               IR_cutoff_database& IR_db, UV_cutoff_database& UV_db,
+                               std::shared_ptr<initial_filtered_Pk>& Pk_init,
+                               std::shared_ptr<final_filtered_Pk>& Pk_final, double tol)
+  {
+    // start timer
+    boost::timer::cpu_timer timer;
+    
+    k_grid_planner planner(tol);
+    
+    boost::optional<linear_Pk_token> final_tok;
+    if(Pk_final) final_tok = Pk_final->get_token();
+    
+    // open a transaction on the database
+    auto mgr = this->open_transaction();
+    
+    // set up temporary tables of redshifts and wavenumbers in the current grid, so that samples computed for
+    // other grids do not influence the refinement
+    auto z_table = sqlite3_operations::z_table(this->handle, *mgr, this->policy, z_db);
+    auto k_table = sqlite3_operations::k_table(this->handle, *mgr, this->policy, k_db);
+    
+    // every (IR, UV) combination must meet the tolerance
+    for(auto u = UV_db.record_cbegin(); u != UV_db.record_cend(); ++u)
+      {
+        for(auto v = IR_db.record_cbegin(); v != IR_db.record_cend(); ++v)
+          {
+            planner.examine(sqlite3_operations::find_loop_Pk_samples(this->handle, *mgr, this->policy, model,
+                                                                     growth_params, loop_params,
+                                                                     Pk_init->get_token(), final_tok,
+                                                                     v->get_token(), u->get_token(),
+                                                                     z_table, k_table));
+          }
+      }
+    
+    // drop unneeded temporary tables
+    sqlite3_operations::drop_temp(this->handle, *mgr, k_table);
+    sqlite3_operations::drop_temp(this->handle, *mgr, z_table);
+    
+    // close transaction
+    mgr->commit();
+    
+    timer.stop();
+    std::ostringstream msg;
+    msg << "largest estimated interpolation error of one-loop P(k) on " << k_db.size() << " wavenumbers is "
+        << planner.get_worst_error() << "; refinement adds " << planner.size() << " wavenumbers (time "
+        << format_time(timer.elapsed().wall) << ")";
+    this->err_handler.info(msg.str());
+    
+    if(planner.get_unresolved_error() > tol)
+      {
+        std::ostringstream warn;
+        warn << WARNING_K_GRID_UNRESOLVED << " " << planner.get_unresolved_error();
+        this->err_handler.warn(warn.str());
+      }
+    
+    if(planner.size() == 0) return std::unique_ptr<k_database>();
+    
+    // build refined database; wavenumber_database holds iterators into itself, so it is rebuilt
+    // rather than copied
+    auto refined = std::make_unique<k_database>();
+    
+    for(auto t = k_db.record_cbegin(); t != k_db.record_cend(); ++t)
+      {
+        refined->add_record(*(*t), t->get_token());
+      }
+    
+    for(const Mpc_units::energy& k : planner.get_refinements())
+      {
+        auto tok = this->tokenize<k_token>(k);
+        refined->add_record(k, *tok);
+      }
+    
+    return refined;
+  }
+
+
 std::unique_ptr<IR_cutoff_database> data_manager::build_IR_cutoff_db(range<Mpc_units::energy>& sample)
   {
     return this->build_wavenumber_db<IR_cutoff_token>(sample);
@@ -36,6 +36,7 @@
 
 #include "sqlite3_detail/utilities.h"
 #include "sqlite3_detail/operations.h"
+#include "sqlite3_detail/statement_cache.h"
 
 #include "utilities/formatter.h"
 
@@ -70,6 +71,7 @@ data_manager::data_manager(const boost::filesystem::path& c, error_handler& e, c
   : container(c),
     err_handler(e),
     handle(nullptr),   // try to catch handle-not-initialized errors
+    stored_samples(0),
     arg_cache(ac),
     policy(),
     FRW_model_tol(LSSEFT_DEFAULT_FRW_MODEL_PARAMETER_TOLERANCE),
@@ -104,6 +106,9 @@ data_manager::data_manager(const boost::filesystem::path& c, error_handler& e, c
                 throw runtime_exception(exception_type::database_error, msg.str());
               }
 
+            // add any columns introduced since the container was created
+            sqlite3_operations::upgrade_tables(handle, policy);
+
             report_attach(this->err_handler, container);
             return;
           }
@@ -137,6 +142,20 @@ data_manager::~data_manager()
   {
     assert(this->handle != nullptr);
 
+    // commit any samples still held in a group transaction; if this fails they are
+    // missing from the database, and will be recomputed by the next run
+    try
+      {
+        this->commit_stores();
+      }
+    catch(runtime_exception& xe)
+      {
+        this->err_handler.error(xe.what());
+      }
+
+    // finalize cached prepared statements; sqlite3_close() refuses to release a connection which still has them
+    sqlite3_operations::release_statement_cache(this->handle);
+
     // perform routine maintenance on container and tidy up
     sqlite3_operations::tidy(this->handle);
 
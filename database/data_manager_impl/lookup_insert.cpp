@@ -76,7 +76,22 @@ unsigned int data_manager::lookup_or_insert(transaction_manager& mgr, const Pk_f
 unsigned int data_manager::lookup_or_insert(transaction_manager& mgr, const loop_integral_params& data)
   {
     boost::optional<unsigned int> id = sqlite3_operations::lookup_oneloop_params(this->handle, mgr, data, this->policy, this->oneloop_tol);
-    if(id) return *id;
+    if(id)
+      {
+        // if tighter tolerances have been requested, move to a new precision tier; records computed at
+        // earlier tiers are refined when a loop integral work list is built
+        boost::optional<unsigned int> tier =
+          sqlite3_operations::tighten_oneloop_params(this->handle, mgr, *id, data, this->policy, this->oneloop_tol);
+        
+        if(tier)
+          {
+            std::ostringstream msg;
+            msg << "loop integral parameters " << *id << " moved to precision tier " << *tier;
+            this->err_handler.info(msg.str());
+          }
+        
+        return *id;
+      }
     
     return sqlite3_operations::insert_oneloop_params(this->handle, mgr, data, this->policy);
   }
@@ -48,6 +48,9 @@
 
 std::shared_ptr<transaction_manager> data_manager::open_transaction()
   {
+    // samples accumulated by store() must be committed before anything else can use the database
+    this->commit_stores();
+    
     // check whether a transaction is already in progress; if so, raise an exception
     std::shared_ptr<transaction_manager> check = this->current_transaction.lock();
     if(check) throw runtime_exception(exception_type::transaction_error, ERROR_TRANSACTION_IN_PROGRESS);
@@ -100,3 +103,34 @@ void data_manager::release_transaction()
     
     this->current_transaction.reset();
   }
+
+
+void data_manager::begin_sample()
+  {
+    assert(this->handle != nullptr);
+    sqlite3_operations::exec(this->handle, "SAVEPOINT store_sample");
+  }
+
+
+void data_manager::release_sample()
+  {
+    assert(this->handle != nullptr);
+    sqlite3_operations::exec(this->handle, "RELEASE store_sample");
+  }
+
+
+void data_manager::rollback_sample()
+  {
+    assert(this->handle != nullptr);
+    sqlite3_operations::exec(this->handle, "ROLLBACK TO store_sample");
+    sqlite3_operations::exec(this->handle, "RELEASE store_sample");
+  }
+
+
+void data_manager::commit_stores()
+  {
+    if(!this->store_transaction) return;
+    
+    this->store_transaction->commit();
+    this->store_transaction.reset();
+  }
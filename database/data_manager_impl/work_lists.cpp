@@ -28,7 +28,11 @@
 #include <assert.h>
 
 #include <set>
+#include <map>
 #include <unordered_set>
+#include <vector>
+#include <algorithm>
+#include <tuple>
 
 #include "database/data_manager.h"
 #include "database/data_manager_impl/types.h"
@@ -193,20 +197,73 @@ data_manager::build_loop_momentum_work_list(const FRW_model_token& model, k_data
       sqlite3_operations::missing_loop_integral_configurations(this->handle, *mgr, this->policy, model, params_tok,
                                                                Pk->get_token(), required_configs);
     
-    // add these missing configurations to the work list
+    // configurations computed at an earlier precision tier whose error estimate exceeds the tolerance now
+    // requested are refined; their stored values, and the power spectra built from them, are kept until
+    // the refined values are stored
+    loop_configs stale =
+      sqlite3_operations::stale_loop_integral_configurations(this->handle, *mgr, this->policy, model, params_tok,
+                                                             Pk->get_token(), required_configs);
+    missing.insert(stale.begin(), stale.end());
+    
+    // build a cost model from timings of integrals already computed with these parameters
+    loop_cost_model cost(sqlite3_operations::find_loop_timings(this->handle, *mgr, this->policy, model, params_tok));
+    
+    // close transaction
+    mgr->commit();
+    
+    // order missing configurations longest-first, so that the most expensive integrals are not left
+    // until the end of the run where they would dominate the makespan
+    std::vector< std::pair<double, const loop_configs::value_type*> > ordered;
+    ordered.reserve(missing.size());
     for(const auto& record : missing)
       {
-        work_list->emplace_back(*(*record.k), record.k->get_token(), *(*record.UV_cutoff),
+        ordered.emplace_back(cost(*(*record.k), *(*record.UV_cutoff), *(*record.IR_cutoff)), &record);
+      }
+    
+    std::stable_sort(ordered.begin(), ordered.end(),
+                     [](const std::pair<double, const loop_configs::value_type*>& a,
+                        const std::pair<double, const loop_configs::value_type*>& b) -> bool
+                       { return a.first > b.first; });
+    
+    // a cutoff sweep evaluates every (UV, IR) pair at one k in a single pass, so keep the items for each k
+    // together, ordering the sweeps by their total cost
+    if(params.get_backend() == loop_integral_backend::cutoff_sweep)
+      {
+        std::map<unsigned int, double> sweep_cost;
+        for(const auto& item : ordered)
+          {
+            sweep_cost[item.second->k->get_token().get_id()] += item.first;
+          }
+        
+        std::stable_sort(ordered.begin(), ordered.end(),
+                         [&](const std::pair<double, const loop_configs::value_type*>& a,
+                             const std::pair<double, const loop_configs::value_type*>& b) -> bool
+                           {
+                             const unsigned int ka = a.second->k->get_token().get_id();
+                             const unsigned int kb = b.second->k->get_token().get_id();
+                             const double ca = sweep_cost[ka];
+                             const double cb = sweep_cost[kb];
+                             return ca > cb || (ca == cb && ka < kb);
+                           });
+      }
+    
+    // add these missing configurations to the work list
+    for(const auto& item : ordered)
+      {
+        const auto& record = *item.second;
+        work_list->emplace_back(*(*record.k), record.k->get_token(), model, *(*record.UV_cutoff),
                                 record.UV_cutoff->get_token(), *(*record.IR_cutoff), record.IR_cutoff->get_token(), Pk,
                                 params_tok, params);
+        
+        if(cost.is_fitted()) work_list->back().set_predicted_time(static_cast<boost::timer::nanosecond_type>(item.first));
       }
     
-    // close transaction
-    mgr->commit();
-    
     timer.stop();
     std::ostringstream msg;
     msg << "constructed loop momentum work list (" << work_list->size() << " items) in time " << format_time(timer.elapsed().wall);
+    if(!stale.empty()) msg << "; " << stale.size() << " items refine records from an earlier precision tier";
+    if(cost.is_fitted()) msg << "; ordered using cost model fitted to " << cost.get_samples() << " historical timings";
+    else msg << "; ordered using heuristic cost estimate";
     this->err_handler.info(msg.str());
     
     // release list if it contains no work
@@ -221,7 +278,8 @@ data_manager::build_one_loop_Pk_work_list(const FRW_model_token& model, const gr
                                           const loop_integral_params_token& loop_params, z_database& z_db,
                                           k_database& k_db, IR_cutoff_database& IR_db, UV_cutoff_database& UV_db,
                                           std::shared_ptr<initial_filtered_Pk>& Pk_init,
-                                          std::shared_ptr<final_filtered_Pk>& Pk_final)
+                                          std::shared_ptr<final_filtered_Pk>& Pk_final,
+                                          const loop_integral_work_list* deferred)
   {
     // start timer
     boost::timer::cpu_timer timer;
@@ -229,6 +287,17 @@ data_manager::build_one_loop_Pk_work_list(const FRW_model_token& model, const gr
     // construct an empty work list
     auto work_list = std::make_unique<one_loop_Pk_work_list>();
     
+    // build set of (k, IR, UV) configurations whose loop integrals have not yet been computed
+    std::set< std::tuple<unsigned int, unsigned int, unsigned int> > deferred_configs;
+    if(deferred != nullptr)
+      {
+        for(const auto& item : *deferred)
+          {
+            deferred_configs.emplace(item.get_k_token().get_id(), item.get_IR_token().get_id(),
+                                     item.get_UV_token().get_id());
+          }
+      }
+    
     // open a transaction on the database
     auto mgr = this->open_transaction();
     
@@ -243,6 +312,10 @@ data_manager::build_one_loop_Pk_work_list(const FRW_model_token& model, const gr
 
     for(const auto& record : required_configs)
       {
+        // skip configurations whose loop integrals are not yet available
+        if(deferred_configs.count(std::make_tuple(record.k->get_token().get_id(), record.IR_cutoff->get_token().get_id(),
+                                                  record.UV_cutoff->get_token().get_id())) > 0) continue;
+        
         // find redshifts that are missing for this configuration, if any
         auto missing_zs =
           sqlite3_operations::missing_one_loop_Pk_redshifts(this->handle, *mgr, this->policy, model, growth_params,
@@ -282,6 +355,22 @@ data_manager::build_one_loop_Pk_work_list(const FRW_model_token& model, const gr
   }
 
 
+std::shared_ptr<oneloop_growth>
+data_manager::find_growth_factors(const FRW_model_token& model, const growth_params_token& growth_params, z_database& z_db)
+  {
+    // open a transaction on the database
+    auto mgr = this->open_transaction();
+    
+    // return value of this->find<oneloop_growth> is converted to std::shared_ptr<>
+    std::shared_ptr<oneloop_growth> Df_data = this->find<oneloop_growth>(*mgr, model, growth_params, z_db);
+    
+    // close transaction
+    mgr->commit();
+    
+    return Df_data;
+  }
+
+
 std::unique_ptr<multipole_Pk_work_list>
 data_manager::build_multipole_Pk_work_list(const FRW_model_token& model, const growth_params_token& growth_params,
                                            const loop_integral_params_token& loop_params,
@@ -397,7 +486,8 @@ data_manager::build_Matsubara_XY_work_list(const FRW_model_token& model_tok, IR_
 
 
 std::unique_ptr<filter_Pk_work_list>
-data_manager::build_filter_Pk_work_list(const linear_Pk_token& Pk_token, std::shared_ptr<filterable_Pk>& Pk_lin,
+data_manager::build_filter_Pk_work_list(const FRW_model_token& model, const linear_Pk_token& Pk_token,
+                                        std::shared_ptr<filterable_Pk>& Pk_lin,
                                         const filter_params_token& filter_token, const Pk_filter_params& params)
   {
     // start timer
@@ -422,7 +512,7 @@ data_manager::build_filter_Pk_work_list(const linear_Pk_token& Pk_token, std::sh
         // add these configurations to the work list
         for(auto t = missing->record_cbegin(); t != missing->record_cend(); ++t)
           {
-            work_list->emplace_back(*(*t), t->get_token(), Pk_lin, Pk_token, filter_token, params);
+            work_list->emplace_back(*(*t), t->get_token(), model, Pk_lin, Pk_token, filter_token, params);
           }
       }
     
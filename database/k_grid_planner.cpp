@@ -0,0 +1,159 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <cmath>
+#include <vector>
+#include <array>
+#include <algorithm>
+
+#include "k_grid_planner.h"
+
+
+namespace k_grid_planner_impl
+  {
+    
+    //! multiple of the integration error below which an interpolation error is attributed to noise;
+    //! the leave-one-out prediction combines five noisy samples with total weight of roughly two
+    constexpr double noise_multiple = 3.0;
+    
+    //! intervals narrower than this in ln k are never bisected
+    constexpr double min_log_spacing = 1E-4;
+    
+    //! minimum number of samples needed to estimate the interpolation error
+    constexpr unsigned int min_samples = 5;
+    
+  }   // namespace k_grid_planner_impl
+
+
+k_grid_planner::k_grid_planner(double t)
+  : tol(t),
+    worst(0.0),
+    unresolved(0.0)
+  {
+  }
+
+
+void k_grid_planner::examine(const loop_Pk_samples& samples)
+  {
+    for(const auto& series : samples)
+      {
+        this->examine(series.second);
+      }
+  }
+
+
+void k_grid_planner::examine(const std::map<double, loop_Pk_sample>& series)
+  {
+    if(series.size() < k_grid_planner_impl::min_samples) return;
+    
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> e;
+    std::vector<double> tree;
+    x.reserve(series.size());
+    y.reserve(series.size());
+    e.reserve(series.size());
+    tree.reserve(series.size());
+    
+    for(const auto& s : series)
+      {
+        x.push_back(std::log(s.first));
+        y.push_back(s.second.value);
+        e.push_back(std::abs(s.second.error));
+        tree.push_back(std::abs(s.second.tree));
+      }
+    
+    const size_t N = x.size();
+    for(size_t i = 0; i < N; ++i)
+      {
+        // choose the four samples nearest to i in index, excluding i itself;
+        // these straddle i except at the ends of the grid
+        size_t start = std::min(i >= 2 ? i-2 : 0, N - k_grid_planner_impl::min_samples);
+        
+        std::array<size_t, 4> nbr;
+        unsigned int n = 0;
+        for(size_t j = start; j < start + k_grid_planner_impl::min_samples; ++j)
+          {
+            if(j != i) nbr[n++] = j;
+          }
+        
+        // predict y[i] by Lagrange interpolation through the neighbours
+        double pred = 0.0;
+        for(unsigned int a = 0; a < 4; ++a)
+          {
+            double w = 1.0;
+            for(unsigned int b = 0; b < 4; ++b)
+              {
+                if(b != a) w *= (x[i] - x[nbr[b]]) / (x[nbr[a]] - x[nbr[b]]);
+              }
+            pred += w * y[nbr[a]];
+          }
+        
+        double residual = std::abs(pred - y[i]);
+        double scale = std::max(std::abs(y[i]), tree[i]);
+        if(scale == 0.0) continue;
+        
+        double noise = e[i];
+        for(unsigned int a = 0; a < 4; ++a) noise = std::max(noise, e[nbr[a]]);
+        
+        this->worst = std::max(this->worst, residual / scale);
+        
+        if(residual <= this->tol * scale) continue;
+        
+        // an error hidden by the integration noise cannot be removed by refinement
+        if(residual <= k_grid_planner_impl::noise_multiple * noise)
+          {
+            this->unresolved = std::max(this->unresolved, residual / scale);
+            continue;
+          }
+        
+        bool refined = false;
+        if(i > 0)   refined = this->bisect(x[i-1], x[i]) || refined;
+        if(i < N-1) refined = this->bisect(x[i], x[i+1]) || refined;
+        
+        if(!refined) this->unresolved = std::max(this->unresolved, residual / scale);
+      }
+  }
+
+
+bool k_grid_planner::bisect(double a, double b)
+  {
+    if(b - a < k_grid_planner_impl::min_log_spacing) return false;
+    
+    this->refinements.insert(std::exp((a+b)/2.0));
+    return true;
+  }
+
+
+std::list<Mpc_units::energy> k_grid_planner::get_refinements() const
+  {
+    std::list<Mpc_units::energy> ks;
+    
+    for(double k : this->refinements)
+      {
+        ks.push_back(k / Mpc_units::Mpc);
+      }
+    
+    return ks;
+  }
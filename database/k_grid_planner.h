@@ -0,0 +1,152 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_K_GRID_PLANNER_H
+#define LSSEFT_K_GRID_PLANNER_H
+
+
+#include <map>
+#include <set>
+#include <list>
+#include <string>
+
+#include "units/Mpc_units.h"
+
+
+//! stored value of a one-loop power spectrum at a single wavenumber
+class loop_Pk_sample
+  {
+    
+  public:
+    
+    //! constructor
+    loop_Pk_sample(double v, double e, double t)
+      : value(v),
+        error(e),
+        tree(t)
+      {
+      }
+    
+    //! destructor is default
+    ~loop_Pk_sample() = default;
+    
+    
+    // DATA
+    
+  public:
+    
+    //! one-loop power spectrum, including the tree-level part
+    double value;
+    
+    //! estimated error, inherited from the loop integrals
+    double error;
+    
+    //! tree-level power spectrum at the same wavenumber
+    double tree;
+    
+  };
+
+
+//! samples of the one-loop power spectra for a single (linear P(k), IR cutoff, UV cutoff) configuration,
+//! indexed by series name and then by wavenumber (measured in 1/Mpc) in ascending order; each redshift,
+//! and the raw and no-wiggle parts, are separate series
+typedef std::map< std::string, std::map<double, loop_Pk_sample> > loop_Pk_samples;
+
+
+//! plans refinement of the wavenumber grid on which loop integrals are sampled.
+//! Refinement is judged on the one-loop power spectra, in which the kernels are combined with their growth
+//! factors, since these are what is interpolated downstream.
+//! The interpolation error at each sample is estimated by predicting its value from its four nearest neighbours
+//! by cubic interpolation in ln k. This is the error of interpolating on a grid with that sample removed, so it
+//! overestimates the error made on the full grid. Wherever it exceeds the tolerance, the intervals either side
+//! of the sample are bisected in ln k.
+//! The tolerance is relative to the one-loop spectrum, but is never tighter than the same fraction of the local
+//! tree-level spectrum, so near-cancellations do not demand unlimited resolution. Neither is it tighter than the
+//! integration error, which sets a noise floor below which refinement cannot help
+class k_grid_planner
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor captures tolerance
+    k_grid_planner(double t);
+    
+    //! destructor is default
+    ~k_grid_planner() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! examine the samples for one configuration, scheduling new wavenumbers wherever the tolerance is not met
+    void examine(const loop_Pk_samples& samples);
+    
+    //! get wavenumbers scheduled for insertion, in ascending order
+    std::list<Mpc_units::energy> get_refinements() const;
+    
+    //! get number of wavenumbers scheduled for insertion
+    size_t size() const { return this->refinements.size(); }
+    
+    //! get largest estimated interpolation error seen by examine(), relative to the tolerance scale
+    double get_worst_error() const { return this->worst; }
+    
+    //! get largest estimated interpolation error which could not be reduced, either because it lies below
+    //! the integration noise or because the grid cannot be bisected further, relative to the tolerance scale
+    double get_unresolved_error() const { return this->unresolved; }
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! examine a single series
+    void examine(const std::map<double, loop_Pk_sample>& series);
+    
+    //! schedule bisection of the interval [a, b], measured in ln k; returns false if it is too narrow
+    bool bisect(double a, double b);
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! relative tolerance on interpolated kernels
+    double tol;
+    
+    //! new wavenumbers, measured in 1/Mpc
+    std::set<double> refinements;
+    
+    //! largest estimated interpolation error, relative to the tolerance scale
+    double worst;
+    
+    //! largest estimated interpolation error which refinement cannot reduce, relative to the tolerance scale
+    double unresolved;
+    
+  };
+
+
+#endif //LSSEFT_K_GRID_PLANNER_H
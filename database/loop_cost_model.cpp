@@ -0,0 +1,144 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <cmath>
+#include <algorithm>
+
+#include "loop_cost_model.h"
+
+
+namespace loop_cost_model_impl
+  {
+    
+    //! minimum number of historical timings before we trust a fit
+    constexpr size_t min_samples = 16;
+    
+    //! ridge regularization, relative to the diagonal of the normal matrix; needed because runs usually
+    //! use only one or two UV and IR cutoffs, which makes the unregularized system nearly singular
+    constexpr double ridge = 1E-6;
+    
+  }   // namespace loop_cost_model_impl
+
+
+loop_cost_model::loop_cost_model(const loop_timing_list& samples)
+  : fitted(false),
+    samples(samples.size()),
+    coeffs{ {0.0, 0.0, 0.0, 0.0} }
+  {
+    if(this->samples >= loop_cost_model_impl::min_samples) this->fitted = this->fit(samples);
+  }
+
+
+std::array<double, 4> loop_cost_model::features(const Mpc_units::energy& k, const Mpc_units::energy& UV, const Mpc_units::energy& IR)
+  {
+    // a zero IR cutoff has no logarithm; the domain then extends to q = 0, and its lower end is set by k
+    const Mpc_units::energy& lower = IR > Mpc_units::energy(0.0) ? IR : k;
+    
+    return std::array<double, 4>{ {1.0, std::log(k * Mpc_units::Mpc), std::log(UV * Mpc_units::Mpc), std::log(lower * Mpc_units::Mpc)} };
+  }
+
+
+bool loop_cost_model::fit(const loop_timing_list& samples)
+  {
+    constexpr unsigned int N = 4;
+    
+    // accumulate normal equations A^T A c = A^T y for y = ln(time)
+    double M[N][N+1];
+    for(unsigned int i = 0; i < N; ++i)
+      {
+        for(unsigned int j = 0; j <= N; ++j) M[i][j] = 0.0;
+      }
+    
+    size_t used = 0;
+    for(const loop_timing_sample& s : samples)
+      {
+        // samples with a zero IR cutoff have a different cost structure, so they are not used to fit
+        if(s.time <= 0 || !(s.IR_cutoff > Mpc_units::energy(0.0))) continue;
+        
+        std::array<double, N> x = features(s.k, s.UV_cutoff, s.IR_cutoff);
+        double y = std::log(static_cast<double>(s.time));
+        
+        for(unsigned int i = 0; i < N; ++i)
+          {
+            for(unsigned int j = 0; j < N; ++j) M[i][j] += x[i]*x[j];
+            M[i][N] += x[i]*y;
+          }
+        ++used;
+      }
+    
+    if(used < loop_cost_model_impl::min_samples) return false;
+    
+    for(unsigned int i = 0; i < N; ++i) M[i][i] += loop_cost_model_impl::ridge * std::max(M[i][i], 1.0);
+    
+    // solve by Gaussian elimination with partial pivoting
+    for(unsigned int c = 0; c < N; ++c)
+      {
+        unsigned int pivot = c;
+        for(unsigned int r = c+1; r < N; ++r)
+          {
+            if(std::abs(M[r][c]) > std::abs(M[pivot][c])) pivot = r;
+          }
+        
+        if(std::abs(M[pivot][c]) == 0.0) return false;
+        if(pivot != c) for(unsigned int j = 0; j <= N; ++j) std::swap(M[c][j], M[pivot][j]);
+        
+        for(unsigned int r = c+1; r < N; ++r)
+          {
+            double f = M[r][c] / M[c][c];
+            for(unsigned int j = c; j <= N; ++j) M[r][j] -= f*M[c][j];
+          }
+      }
+    
+    for(int r = N-1; r >= 0; --r)
+      {
+        double sum = M[r][N];
+        for(unsigned int j = r+1; j < N; ++j) sum -= M[r][j]*this->coeffs[j];
+        this->coeffs[r] = sum / M[r][r];
+      }
+    
+    return std::all_of(this->coeffs.begin(), this->coeffs.end(), [](double c) -> bool { return std::isfinite(c); });
+  }
+
+
+double loop_cost_model::operator()(const Mpc_units::energy& k, const Mpc_units::energy& UV, const Mpc_units::energy& IR) const
+  {
+    if(this->fitted)
+      {
+        std::array<double, 4> x = features(k, UV, IR);
+        
+        double lnt = 0.0;
+        for(unsigned int i = 0; i < x.size(); ++i) lnt += this->coeffs[i]*x[i];
+        
+        return std::exp(lnt);
+      }
+    
+    // heuristic: Cuhre needs more regions when the integration domain is wide, and the integrands develop
+    // more structure once k is well separated from the IR cutoff
+    const Mpc_units::energy& lower = IR > Mpc_units::energy(0.0) ? IR : k;
+    
+    double range = std::log(UV/lower);
+    double scale = std::log(std::exp(1.0) + k/lower);
+    
+    return std::max(range, 1.0) * scale;
+  }
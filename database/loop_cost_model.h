@@ -0,0 +1,138 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_LOOP_COST_MODEL_H
+#define LSSEFT_LOOP_COST_MODEL_H
+
+
+#include <array>
+#include <list>
+
+#include "units/Mpc_units.h"
+
+#include "boost/timer/timer.hpp"
+
+
+//! historical timing for a single loop integral configuration, summed over all kernels
+class loop_timing_sample
+  {
+    
+  public:
+    
+    //! constructor
+    loop_timing_sample(const Mpc_units::energy& _k, const Mpc_units::energy& _UV, const Mpc_units::energy& _IR,
+                       boost::timer::nanosecond_type t)
+      : k(_k),
+        UV_cutoff(_UV),
+        IR_cutoff(_IR),
+        time(t)
+      {
+      }
+    
+    //! destructor is default
+    ~loop_timing_sample() = default;
+    
+    
+    // DATA
+    
+  public:
+    
+    //! wavenumber
+    Mpc_units::energy k;
+    
+    //! UV cutoff
+    Mpc_units::energy UV_cutoff;
+    
+    //! IR cutoff
+    Mpc_units::energy IR_cutoff;
+    
+    //! total integration time (raw + no-wiggle) over all kernels
+    boost::timer::nanosecond_type time;
+    
+  };
+
+
+typedef std::list<loop_timing_sample> loop_timing_list;
+
+
+//! predicts the cost of a loop integral configuration.
+//! If enough historical timings are available we fit ln(time) as a linear function of ln k, ln UV and ln IR;
+//! otherwise we fall back on a heuristic which grows with k and with the width of the integration region.
+//! Heuristic costs are in arbitrary units and are useful only for ordering.
+class loop_cost_model
+  {
+    
+    // CONSTRUCTOR, DESTRUCTOR
+    
+  public:
+    
+    //! constructor fits the model to a list of historical timings
+    loop_cost_model(const loop_timing_list& samples);
+    
+    //! destructor is default
+    ~loop_cost_model() = default;
+    
+    
+    // INTERFACE
+    
+  public:
+    
+    //! predicted cost for a given configuration; in nanoseconds if is_fitted() is true
+    double operator()(const Mpc_units::energy& k, const Mpc_units::energy& UV, const Mpc_units::energy& IR) const;
+    
+    //! was the model fitted to historical data?
+    bool is_fitted() const { return this->fitted; }
+    
+    //! number of samples used in the fit
+    size_t get_samples() const { return this->samples; }
+    
+    
+    // INTERNAL API
+    
+  private:
+    
+    //! build the feature vector used by the fit; a zero IR cutoff uses k in place of the cutoff
+    static std::array<double, 4> features(const Mpc_units::energy& k, const Mpc_units::energy& UV, const Mpc_units::energy& IR);
+    
+    //! fit coefficients by least squares; returns false if the fit is unusable
+    bool fit(const loop_timing_list& samples);
+    
+    
+    // INTERNAL DATA
+    
+  private:
+    
+    //! was the model fitted to historical data?
+    bool fitted;
+    
+    //! number of samples
+    size_t samples;
+    
+    //! fitted coefficients for ln(time)
+    std::array<double, 4> coeffs;
+    
+  };
+
+
+#endif //LSSEFT_LOOP_COST_MODEL_H
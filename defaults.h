@@ -62,6 +62,26 @@ constexpr double LSSEFT_DEFAULT_INTEGRAL_REL_ERR_13                 = (1E-6);
 constexpr double LSSEFT_DEFAULT_INTEGRAL_ABS_ERR_22                 = (1E-8);
 constexpr double LSSEFT_DEFAULT_INTEGRAL_REL_ERR_22                 = (1E-6);
 
+// default node count per dimension for the fixed-node Gauss-Legendre loop integral backend,
+// and the number of times the rule may be doubled while estimating its error
+constexpr unsigned int LSSEFT_DEFAULT_GAUSS_LEGENDRE_POINTS         = 48;
+constexpr unsigned int LSSEFT_DEFAULT_GAUSS_LEGENDRE_DOUBLINGS      = 2;
+
+// default number of samples of the linear power spectrum for the FFTLog loop integral backend; must be a power of two
+constexpr unsigned int LSSEFT_DEFAULT_FFTLOG_POINTS                 = 256;
+
+// default target accuracy of the final power spectra, relative to the tree-level term, used to allocate
+// per-kernel loop integral tolerances; zero disables the allocation so every kernel uses the tolerances above.
+// Allocated relative tolerances are never looser than the ceiling
+constexpr double LSSEFT_DEFAULT_LOOP_TARGET_ERR                     = (0.0);
+constexpr double LSSEFT_DEFAULT_LOOP_TOLERANCE_CEILING              = (1E-2);
+
+// default tolerance on the interpolation error of loop integrals between neighbouring wavenumber samples, relative
+// to each kernel; the wavenumber grid is refined adaptively until it is met, or until the maximum number of passes.
+// Zero disables refinement
+constexpr double LSSEFT_DEFAULT_K_GRID_TOLERANCE                    = (1E-3);
+constexpr unsigned int LSSEFT_DEFAULT_K_GRID_REFINEMENTS            = 8;
+
 constexpr double LSSEFT_DEFAULT_FILTER_PK_ABS_ERR                   = (1E-8);
 constexpr double LSSEFT_DEFAULT_FILTER_PK_REL_ERR                   = (1E-6);
 
@@ -74,6 +94,28 @@ constexpr double LSSEFT_DEFAULT_FILTER_PK_INDEX                     = (0.04);
 constexpr Mpc_units::inverse_energy LSSEFT_DEFAULT_RESUM_QMIN       = 10 * Mpc_units::Mpc;
 constexpr Mpc_units::inverse_energy LSSEFT_DEFAULT_RESUM_QMAX       = 300 * Mpc_units::Mpc;
 
+// batched dispatch of work items: target fraction of each worker's wall time lost to communication,
+// and upper limit on the number of items carried by a single work message
+constexpr double LSSEFT_DEFAULT_BATCH_COMMUNICATION_FRACTION         = (0.05);
+constexpr unsigned int LSSEFT_DEFAULT_MAX_BATCH_SIZE                = 256;
+
+// number of batches each worker may hold (in progress + queued) before it must return a result
+constexpr unsigned int LSSEFT_DEFAULT_PREFETCH_DEPTH                = 2;
+
+// number of threads used by each worker process
+constexpr unsigned int LSSEFT_DEFAULT_WORKER_THREADS                = 1;
+
+// in shared-memory mode, number of items per thread processed between database writes
+constexpr unsigned int LSSEFT_DEFAULT_SHARED_MEMORY_ITEMS_PER_THREAD = 16;
+
+// number of returned batches which may wait for the database writer before the master stops accepting results
+constexpr unsigned int LSSEFT_DEFAULT_WRITE_QUEUE_DEPTH             = 32;
+
+// stored samples are committed in groups: a group is committed when it contains this many samples,
+// or after this interval (in nanoseconds), whichever comes first
+constexpr unsigned int LSSEFT_DEFAULT_GROUP_COMMIT_SAMPLES          = 256;
+constexpr long long int LSSEFT_DEFAULT_GROUP_COMMIT_INTERVAL        = 2000000000LL;
+
 // cross-over scale from series expansion of RSD mapping to exp + erf representation
 constexpr double LSSEFT_SERIES_CROSSOVER = 0.15;
 
@@ -50,6 +50,8 @@ void error_handler::error(std::string msg)
     boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
     std::string nowstr = boost::posix_time::to_simple_string(now);
 
+    std::lock_guard<std::mutex> guard(this->output_lock);
+
     if(colour) std::cout << ANSI_BOLD_RED;
     std::cout << "lsseft [" << nowstr << "]: " << msg << '\n';
     if(colour) std::cout << ANSI_NORMAL;
@@ -63,6 +65,8 @@ void error_handler::warn(std::string msg)
     boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
     std::string nowstr = boost::posix_time::to_simple_string(now);
 
+    std::lock_guard<std::mutex> guard(this->output_lock);
+
     if(colour) std::cout << ANSI_BOLD_MAGENTA;
     std::cout << WARNING_LABEL << " ";
     if(colour) std::cout << ANSI_NORMAL;
@@ -77,6 +81,8 @@ void error_handler::info(std::string msg)
     boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
     std::string nowstr = boost::posix_time::to_simple_string(now);
 
+    std::lock_guard<std::mutex> guard(this->output_lock);
+
     if(this->arg_cache.get_verbose())
       {
         std::cout << "lsseft [" << nowstr << "]: " << msg << '\n';
@@ -90,6 +96,8 @@ void error_handler::announce(std::string msg)
     
     boost::posix_time::ptime now = boost::posix_time::second_clock::universal_time();
     std::string nowstr = boost::posix_time::to_simple_string(now);
+
+    std::lock_guard<std::mutex> guard(this->output_lock);
     
     if(this->arg_cache.get_verbose())
       {
@@ -28,6 +28,7 @@
 
 
 #include <memory>
+#include <mutex>
 
 #include "controller/argument_cache.h"
 #include "controller/local_environment.h"
@@ -74,6 +75,9 @@ class error_handler
     //! local environment object
     local_environment& local_env;
 
+    //! serialize output from multiple threads, so that messages are not interleaved
+    std::mutex output_lock;
+
   };
 
 
@@ -58,5 +58,18 @@
 #define LSSEFT_SWITCH_EDS_MODE                "EdS-mode"
 #define LSSEFT_HELP_EDS_MODE                  "use Einstein-de Sitter approximations to growth functions"
 
+#define LSSEFT_SWITCH_K_TOLERANCE             "k-tolerance"
+#define LSSEFT_HELP_K_TOLERANCE               "relative tolerance on interpolation of loop integrals between sampled wavenumbers, used to refine the wavenumber grid (0 disables refinement)"
+
+#define LSSEFT_SWITCH_PREFETCH                "prefetch"
+#define LSSEFT_HELP_PREFETCH                  "number of batches of work queued on each worker"
+
+#define LSSEFT_SWITCH_THREADS                 "threads,t"
+#define LSSEFT_SWITCH_THREADS_LONG            "threads"
+#define LSSEFT_HELP_THREADS                   "number of threads per worker process (eg. run one process per node or socket), or of the master process in shared-memory mode"
+
+#define LSSEFT_SWITCH_SHARED_MEMORY           "shared-memory"
+#define LSSEFT_HELP_SHARED_MEMORY             "run all work in threads of the master process, without MPI workers (implied if there is only one process)"
+
 
 #endif //LSSEFT_COMMAND_LINE_EN_GB_H
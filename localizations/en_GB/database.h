@@ -41,4 +41,6 @@ constexpr auto DATABASE_ATTACHED                           = "attached to databa
 constexpr auto ERROR_DATABASE_WRONG_PIPELINE_ID_A          = "database pipline id";
 constexpr auto ERROR_DATABASE_WRONG_PIPELINE_ID_B          = "does not match toolchain pipeline id";
 
+constexpr auto WARNING_K_GRID_UNRESOLVED                   = "wavenumber grid cannot meet tolerance below the integration error; largest unresolved error is";
+
 #endif //LSSEFT_DATABASE_EN_GB_H
@@ -36,6 +36,7 @@
 #include "range.h"
 #include "format.h"
 #include "master_controller.h"
+#include "work_executor.h"
 #include "power_spectrum.h"
 #include "Pk_filter.h"
 #include "oneloop_Pk_calculator.h"
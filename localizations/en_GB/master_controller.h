@@ -29,5 +29,8 @@
 
 #define ERROR_TOO_FEW_WORKERS "too few worker processes available"
 
+#define ERROR_K_GRID_UNCONVERGED_A "refinement of wavenumber grid did not meet tolerance within"
+#define ERROR_K_GRID_UNCONVERGED_B "passes; relax the tolerance or increase the initial number of wavenumbers"
+
 
 #endif //LSSEFT_MASTER_CONTROLLER_EN_GB_H
@@ -36,5 +36,10 @@
 #define ERROR_POWERSPECTRUM_SPLINE_TOO_SMALL    "evaluation before or too close to start of spline"
 #define ERROR_POWERSPECTRUM_SPLINE_TOO_BIG      "evaluation after or too close to end of spline"
 
+#define ERROR_POWERSPECTRUM_SPLINE_TOO_FEW      "too few samples to construct spline"
+#define ERROR_POWERSPECTRUM_SPLINE_NOT_ORDERED  "spline samples must have strictly increasing positive wavenumbers"
+
+#define ERROR_FFT_LENGTH                        "length of Fourier transform must be a power of two"
+
 
 #endif //LSSEFT_POWER_SPECTRUM_EN_GB_H
@@ -46,6 +46,8 @@ constexpr auto ERROR_SQLITE3_INSERT_FILTER_PARAMS_FAIL               = "failed t
 
 constexpr auto ERROR_SQLITE3_MULTIPLE_ONELOOP_PARAMS                 = "multiple oneloop parameter sets with matching values";
 constexpr auto ERROR_SQLITE3_INSERT_ONELOOP_PARAMS_FAIL              = "failed to insert oneloop parameter record [backend code=";
+constexpr auto ERROR_SQLITE3_UPDATE_ONELOOP_PARAMS_FAIL              = "failed to update oneloop parameter record [backend code=";
+constexpr auto ERROR_SQLITE3_READ_TABLE_INFO_FAIL                    = "failed to read table schema";
 
 constexpr auto ERROR_SQLITE3_MULTIPLE_MATSUBARAXY_PARAMS             = "multiple Matsubara X&Y parameter sets with matching values";
 constexpr auto ERROR_SQLITE3_INSERT_MATSUBARAXY_PARAMS_FAIL          = "failed to insert Matsubara X&Y parameter record [backend code=";
@@ -67,6 +69,7 @@ constexpr auto ERROR_SQLITE3_INSERT_TRANSFER_FAIL                    = "failed t
 constexpr auto ERROR_SQLITE3_INSERT_GROWTH_D_FAIL                    = "failed to insert one-loop growth D-factor record";
 constexpr auto ERROR_SQLITE3_INSERT_GROWTH_F_FAIL                    = "failed to insert one-loop growth f-factor record";
 constexpr auto ERROR_SQLITE3_INSERT_LOOP_MOMENTUM_FAIL               = "failed to insert one-loop momentum integral record";
+constexpr auto ERROR_SQLITE3_REPLACE_LOOP_MOMENTUM_FAIL              = "failed to remove superseded one-loop momentum integral record";
 constexpr auto ERROR_SQLITE3_INSERT_ONELOOP_PK_FAIL                  = "failed to insert one-loop P(k) record";
 constexpr auto ERROR_SQLITE3_INSERT_ONELOOP_RSD_PK_FAIL              = "failed to insert one-loop RSD P(k) record";
 constexpr auto ERROR_SQLITE3_INSERT_RESUM_ONE_LOOP_PK_FAIL           = "failed to insert resummed one-loop P(k) record";
@@ -78,6 +81,8 @@ constexpr auto ERROR_SQLITE3_DF_GROWTH_TABLE_READ_FAIL               = "failed t
 constexpr auto ERROR_SQLITE3_DF_GROWTH_MISREAD                       = "read unexpected number of results from D- and f-factor growth table";
 constexpr auto ERROR_SQLITE3_READ_LOOP_MOMENTUM_FAIL                 = "failed to read from loop momentum table";
 constexpr auto ERROR_SQLITE3_LOOP_MOMENTUM_MISREAD                   = "read unexpected number of results from loop momentum table";
+constexpr auto ERROR_SQLITE3_READ_LOOP_TIMINGS_FAIL                  = "failed to read historical timings from loop momentum tables";
+constexpr auto ERROR_SQLITE3_READ_LOOP_SAMPLES_FAIL                  = "failed to read one-loop power spectra for k-grid refinement";
 constexpr auto ERROR_SQLITE3_READ_PK_FAIL                            = "failed to read from the delta-delta P(k) table";
 constexpr auto ERROR_SQLITE3_READ_PK_MISREAD                         = "read unexpected number of results from delta-delta P(k) table";
 constexpr auto ERROR_SQLITE3_READ_RSD_PK_FAIL                        = "failed to read from a delta-delta RSD P(k) table";
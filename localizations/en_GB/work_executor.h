@@ -0,0 +1,40 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_WORK_EXECUTOR_EN_GB_H
+#define LSSEFT_WORK_EXECUTOR_EN_GB_H
+
+
+#define ERROR_FILTERED_PK_NOT_RESIDENT "filtered power spectrum is not resident in this process; linear Pk token ="
+#define ERROR_P13_MATRIX_K_NOT_IN_GRID "wavenumber is not part of the grid for batched P13 evaluation; k ="
+#define ERROR_CUTOFF_SWEEP_NOT_IN_GRID "cutoff pair is not part of the sweep for single-pass evaluation; UV, IR ="
+#define ERROR_GAUSS_LEGENDRE_ORDER_NOT_IN_TABLE "Gauss-Legendre rule is not part of the shared node table; nodes ="
+
+#define WARNING_LOOP_TOLERANCE_BELOW_FLOOR_A "error budget needs a relative tolerance tighter than the parameter block allows; kernel ="
+#define WARNING_LOOP_TOLERANCE_BELOW_FLOOR_B "k ="
+#define WARNING_LOOP_TOLERANCE_BELOW_FLOOR_C "required ="
+#define WARNING_LOOP_TOLERANCE_BELOW_FLOOR_D "parameter block ="
+
+
+#endif //LSSEFT_WORK_EXECUTOR_EN_GB_H
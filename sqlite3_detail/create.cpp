@@ -30,6 +30,9 @@
 
 #include "defaults.h"
 
+#include "exceptions.h"
+#include "localizations/messages.h"
+
 namespace sqlite3_operations
   {
     
@@ -174,6 +177,12 @@ namespace sqlite3_operations
               << "nw_evals DOUBLE, "
               << "nw_err DOUBLE, "
               << "nw_time DOUBLE, "
+              << "raw_abstol DOUBLE DEFAULT 0, "
+              << "raw_reltol DOUBLE DEFAULT 0, "
+              << "nw_abstol DOUBLE DEFAULT 0, "
+              << "nw_reltol DOUBLE DEFAULT 0, "
+              << "tier INTEGER DEFAULT 0, "
+              << "type INTEGER DEFAULT 0, "
               << "FOREIGN KEY (mid) REFERENCES " << policy.FRW_model_table() << "(id), "
               << "FOREIGN KEY (params_id) REFERENCES " << policy.growth_config_table() << "(id), "
               << "FOREIGN KEY (kid) REFERENCES " << policy.wavenumber_config_table() << "(id), "
@@ -362,7 +371,11 @@ namespace sqlite3_operations
               << "abserr_13 DOUBLE, "
               << "relerr_13 DOUBLE, "
               << "abserr_22 DOUBLE, "
-              << "relerr_22 DOUBLE"
+              << "relerr_22 DOUBLE, "
+              << "backend INTEGER DEFAULT 0, "
+              << "gl_points INTEGER DEFAULT 0, "
+              << "target_err DOUBLE DEFAULT 0, "
+              << "tier INTEGER DEFAULT 0"
               << ");";
         
             exec(db, stmt.str());
@@ -464,6 +477,41 @@ namespace sqlite3_operations
             exec(db, stmt.str());
           }
         
+        
+        //! add a column to an existing table if it is not already present
+        void add_column_if_missing(sqlite3* db, const std::string& table, const std::string& column, const std::string& decl)
+          {
+            std::ostringstream info_stmt;
+            info_stmt << "PRAGMA table_info(" << table << ");";
+            
+            sqlite3_stmt* stmt;
+            check_stmt(db, sqlite3_prepare_v2(db, info_stmt.str().c_str(), info_stmt.str().length()+1, &stmt, nullptr));
+            
+            bool found = false;
+            int result = 0;
+            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+              {
+                if(result == SQLITE_ROW)
+                  {
+                    // column 1 of the table_info result is the column name
+                    if(column == reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1))) found = true;
+                  }
+                else
+                  {
+                    check_stmt(db, sqlite3_finalize(stmt));
+                    throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_TABLE_INFO_FAIL);
+                  }
+              }
+            
+            check_stmt(db, sqlite3_finalize(stmt));
+            
+            if(found) return;
+            
+            std::ostringstream alter_stmt;
+            alter_stmt << "ALTER TABLE " << table << " ADD COLUMN " << column << " " << decl << ";";
+            exec(db, alter_stmt.str());
+          }
+        
       }
     
     
@@ -503,4 +551,29 @@ namespace sqlite3_operations
 #include "autogenerated/create_stmts.cpp"
       }
     
+    
+    void upgrade_tables(sqlite3* db, const sqlite3_policy& policy)
+      {
+        // loop integral backend selection; containers which predate it used Cuhre throughout
+        create_impl::add_column_if_missing(db, policy.loop_integral_config_table(), "backend", "INTEGER DEFAULT 0");
+        create_impl::add_column_if_missing(db, policy.loop_integral_config_table(), "gl_points", "INTEGER DEFAULT 0");
+        create_impl::add_column_if_missing(db, policy.loop_integral_config_table(), "target_err", "DOUBLE DEFAULT 0");
+        
+        // precision tier, incremented whenever tighter tolerances are requested for a parameter set;
+        // containers which predate it hold a single tier
+        create_impl::add_column_if_missing(db, policy.loop_integral_config_table(), "tier", "INTEGER DEFAULT 0");
+        
+        // effective tolerance of each kernel, the precision tier at which it was computed, and its type (13 or 22);
+        // kernels stored before these were recorded read back as zero
+        for(const std::string& table : loop_kernel_tables(db))
+          {
+            create_impl::add_column_if_missing(db, table, "raw_abstol", "DOUBLE DEFAULT 0");
+            create_impl::add_column_if_missing(db, table, "raw_reltol", "DOUBLE DEFAULT 0");
+            create_impl::add_column_if_missing(db, table, "nw_abstol", "DOUBLE DEFAULT 0");
+            create_impl::add_column_if_missing(db, table, "nw_reltol", "DOUBLE DEFAULT 0");
+            create_impl::add_column_if_missing(db, table, "tier", "INTEGER DEFAULT 0");
+            create_impl::add_column_if_missing(db, table, "type", "INTEGER DEFAULT 0");
+          }
+      }
+    
   }   // namespace sqlite3_operations
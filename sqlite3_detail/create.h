@@ -38,6 +38,9 @@ namespace sqlite3_operations
   {
 
     void create_tables(sqlite3* db, const sqlite3_policy& policy);
+    
+    //! bring the tables of an existing container up to date, adding any columns introduced since it was created
+    void upgrade_tables(sqlite3* db, const sqlite3_policy& policy);
 
   }   // namespace sqlite3_operations
 
@@ -25,81 +25,115 @@
 
 #include "find.h"
 #include "utilities.h"
+#include "statement_cache.h"
 
 #include "exceptions.h"
 #include "localizations/messages.h"
 
 #include "temporary_tables.h"
 
+#include <list>
+#include <map>
+#include <tuple>
+
 namespace sqlite3_operations
   {
     
     namespace find_impl
       {
     
+        // parameter positions for the cached select statements
+
+        namespace loop_kernel_select
+          {
+            enum parameter { mid, params_id, kid, Pk_id, UV_id, IR_id };
+
+            const parameter_list names = { "@mid", "@params_id", "@kid", "@Pk_id", "@UV_id", "@IR_id" };
+          }
+
+
+        namespace dd_rsd_select
+          {
+            enum parameter { mid, growth_params, loop_params, zid, kid, init_Pk_id, final_Pk_id, IR_id, UV_id };
+
+            const parameter_list names = { "@mid", "@growth_params", "@loop_params", "@zid", "@kid", "@init_Pk_id",
+                                           "@final_Pk_id", "@IR_id", "@UV_id" };
+          }
+
+
+        namespace Matsubara_XY_select
+          {
+            enum parameter { mid, params_id, Pk_id, IR_resum_id };
+
+            const parameter_list names = { "@mid", "@params_id", "@Pk_id", "@IR_resum_id" };
+          }
+
+
         template <typename KernelType>
         void read_loop_kernel(sqlite3* db, const std::string& table, const FRW_model_token& model,
                                       const loop_integral_params_token& params, const k_token& k, const linear_Pk_token& Pk,
                                       const UV_cutoff_token& UV_cutoff, KernelType& kernel, const IR_cutoff_token& IR_cutoff)
           {
-            std::ostringstream read_stmt;
-            read_stmt
-              << "SELECT raw_value, raw_regions, raw_evals, raw_err, raw_time, nw_value, nw_regions, nw_evals, nw_err, nw_time FROM "
-              << table << " WHERE mid=@mid AND params_id=@params_id AND kid=@kid AND Pk_id=@Pk_id AND UV_id=@UV_id AND IR_id=@IR_id;";
-            
             // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
+            auto stmt = get_statement_cache(db).get(table, "select", [&]() -> std::string
+              {
+                std::ostringstream read_stmt;
+                read_stmt
+                  << "SELECT raw_value, raw_regions, raw_evals, raw_err, raw_time, nw_value, nw_regions, nw_evals, nw_err, nw_time, "
+                  << "raw_abstol, raw_reltol, nw_abstol, nw_reltol, type FROM "
+                  << table << " WHERE mid=@mid AND params_id=@params_id AND kid=@kid AND Pk_id=@Pk_id AND UV_id=@UV_id AND IR_id=@IR_id;";
+                return read_stmt.str();
+              }, loop_kernel_select::names);
             
             // bind parameter values
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), params.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), k.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), Pk.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_id"), UV_cutoff.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_id"), IR_cutoff.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::params_id), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::kid), k.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::Pk_id), Pk.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::UV_id), UV_cutoff.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_select::IR_id), IR_cutoff.get_id()));
             
             // perform read
             int result = 0;
             unsigned int count = 0;
-            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+            while((result = sqlite3_step(stmt.get())) != SQLITE_DONE)
               {
                 if(result == SQLITE_ROW)
                   {
                     auto& raw = kernel.get_raw();
                     auto& nw = kernel.get_nowiggle();
                     
-                    raw.value = sqlite3_column_double(stmt, 0) * dimensionful_unit<typename KernelType::value_type>();
-                    raw.regions = sqlite3_column_int(stmt, 1);
-                    raw.evaluations = sqlite3_column_int(stmt, 2);
-                    raw.error = sqlite3_column_double(stmt, 3) * dimensionful_unit<typename KernelType::value_type>();
-                    raw.time = sqlite3_column_int64(stmt, 4);
-    
-                    nw.value = sqlite3_column_double(stmt, 5) * dimensionful_unit<typename KernelType::value_type>();
-                    nw.regions = sqlite3_column_int(stmt, 6);
-                    nw.evaluations = sqlite3_column_int(stmt, 7);
-                    nw.error = sqlite3_column_double(stmt, 8) * dimensionful_unit<typename KernelType::value_type>();
-                    nw.time = sqlite3_column_int64(stmt, 9);
+                    raw.value = sqlite3_column_double(stmt.get(), 0) * dimensionful_unit<typename KernelType::value_type>();
+                    raw.regions = sqlite3_column_int(stmt.get(), 1);
+                    raw.evaluations = sqlite3_column_int(stmt.get(), 2);
+                    raw.error = sqlite3_column_double(stmt.get(), 3) * dimensionful_unit<typename KernelType::value_type>();
+                    raw.time = sqlite3_column_int64(stmt.get(), 4);
+    
+                    nw.value = sqlite3_column_double(stmt.get(), 5) * dimensionful_unit<typename KernelType::value_type>();
+                    nw.regions = sqlite3_column_int(stmt.get(), 6);
+                    nw.evaluations = sqlite3_column_int(stmt.get(), 7);
+                    nw.error = sqlite3_column_double(stmt.get(), 8) * dimensionful_unit<typename KernelType::value_type>();
+                    nw.time = sqlite3_column_int64(stmt.get(), 9);
+    
+                    raw.abs_tol = sqlite3_column_double(stmt.get(), 10);
+                    raw.rel_tol = sqlite3_column_double(stmt.get(), 11);
+                    nw.abs_tol = sqlite3_column_double(stmt.get(), 12);
+                    nw.rel_tol = sqlite3_column_double(stmt.get(), 13);
+                    
+                    raw.type = static_cast<unsigned int>(sqlite3_column_int(stmt.get(), 14));
+                    nw.type = raw.type;
     
                     ++count;
                   }
                 else
                   {
-                    check_stmt(db, sqlite3_clear_bindings(stmt));
-                    check_stmt(db, sqlite3_finalize(stmt));
-
                     throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_LOOP_MOMENTUM_FAIL);
                   }
               }
-            
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
-            
+
             if(count != 1) throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_LOOP_MOMENTUM_MISREAD);
           }
-        
-        
+
         template <typename DataType>
         void read_Pk_value(sqlite3_stmt* stmt, unsigned int value_raw, unsigned int err_raw, unsigned int value_nw,
                            unsigned int err_wiggle, DataType& data)
@@ -117,8 +151,7 @@ namespace sqlite3_operations
             data.set_raw(container(v_raw, e_raw));
             data.set_nowiggle(container(v_nw, e_nw));
           }
-    
-    
+
         template <typename DataType>
         void read_Pk_value(sqlite3_stmt* stmt, unsigned int value_raw, unsigned int value_nw, DataType& data)
           {
@@ -133,23 +166,27 @@ namespace sqlite3_operations
             data.set_nowiggle(container(v_nw, value_type(0.0)));
           }
 
-
         void read_dd_rsd_Pk(sqlite3* db, const std::string& table, const FRW_model_token& model,
                             const growth_params_token& growth_params, const loop_integral_params_token& loop_params,
                             const k_token& k, const z_token& z, const linear_Pk_token& init_Pk,
                             const boost::optional<linear_Pk_token>& final_Pk, const IR_cutoff_token& IR_cutoff,
                             const UV_cutoff_token& UV_cutoff, rsd_dd_Pk& Pk)
           {
-            std::ostringstream read_stmt;
-            read_stmt
-              << "SELECT "
-              << "Ptree_raw, err_tree_raw, P13_raw, err_13_raw, P22_raw, err_22_raw, P1loopSPT_raw, err_1loopSPT_raw, "
-              << "Ptree_nw, err_tree_nw, P13_nw, err_13_nw, P22_nw, err_22_nw, P1loopSPT_nw, err_1loopSPT_nw "
-              << "FROM " << table << " "
-              << "WHERE mid=@mid AND growth_params=@growth_params AND loop_params=@loop_params "
-              << "AND zid=@zid AND kid=@kid AND init_Pk_id=@init_Pk_id "
-              << "AND ((@final_Pk_id IS NULL AND final_Pk_id IS NULL) OR final_Pk_id=@final_Pk_id) AND IR_id=@IR_id AND UV_id=@UV_id;";
-    
+            // prepare statement
+            auto stmt = get_statement_cache(db).get(table, "select", [&]() -> std::string
+              {
+                std::ostringstream read_stmt;
+                read_stmt
+                  << "SELECT "
+                  << "Ptree_raw, err_tree_raw, P13_raw, err_13_raw, P22_raw, err_22_raw, P1loopSPT_raw, err_1loopSPT_raw, "
+                  << "Ptree_nw, err_tree_nw, P13_nw, err_13_nw, P22_nw, err_22_nw, P1loopSPT_nw, err_1loopSPT_nw "
+                  << "FROM " << table << " "
+                  << "WHERE mid=@mid AND growth_params=@growth_params AND loop_params=@loop_params "
+                  << "AND zid=@zid AND kid=@kid AND init_Pk_id=@init_Pk_id "
+                  << "AND ((@final_Pk_id IS NULL AND final_Pk_id IS NULL) OR final_Pk_id=@final_Pk_id) AND IR_id=@IR_id AND UV_id=@UV_id;";
+                return read_stmt.str();
+              }, dd_rsd_select::names);
+
             constexpr unsigned int Ptree_raw = 0;
             constexpr unsigned int err_tree_raw = 1;
             constexpr unsigned int P13_raw = 2;
@@ -166,52 +203,40 @@ namespace sqlite3_operations
             constexpr unsigned int err_22_nw = 13;
             constexpr unsigned int P1loopSPT_nw = 14;
             constexpr unsigned int err_1loopSPT_nw = 15;
-
-            // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
     
             // bind parameter values
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@growth_params"), growth_params.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@loop_params"), loop_params.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@zid"), z.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), k.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@init_Pk_id"), init_Pk.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::growth_params), growth_params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::loop_params), loop_params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::zid), z.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::kid), k.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::init_Pk_id), init_Pk.get_id()));
             if(final_Pk)
               {
-                check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@final_Pk_id"), final_Pk->get_id()));
+                check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::final_Pk_id), final_Pk->get_id()));
               }
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_id"), IR_cutoff.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_id"), UV_cutoff.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::IR_id), IR_cutoff.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(dd_rsd_select::UV_id), UV_cutoff.get_id()));
     
             // perform read
             int result = 0;
             unsigned int count = 0;
-            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+            while((result = sqlite3_step(stmt.get())) != SQLITE_DONE)
               {
                 if(result == SQLITE_ROW)
                   {
-                    read_Pk_value(stmt, Ptree_raw, err_tree_raw, Ptree_nw, err_tree_nw, Pk.get_tree());
-                    read_Pk_value(stmt, P13_raw, err_13_raw, P13_nw, err_13_nw, Pk.get_13());
-                    read_Pk_value(stmt, P22_raw, err_22_raw, P22_nw, err_22_nw, Pk.get_22());
-                    read_Pk_value(stmt, P1loopSPT_raw, err_1loopSPT_raw, P1loopSPT_nw, err_1loopSPT_nw, Pk.get_1loop_SPT());
+                    read_Pk_value(stmt.get(), Ptree_raw, err_tree_raw, Ptree_nw, err_tree_nw, Pk.get_tree());
+                    read_Pk_value(stmt.get(), P13_raw, err_13_raw, P13_nw, err_13_nw, Pk.get_13());
+                    read_Pk_value(stmt.get(), P22_raw, err_22_raw, P22_nw, err_22_nw, Pk.get_22());
+                    read_Pk_value(stmt.get(), P1loopSPT_raw, err_1loopSPT_raw, P1loopSPT_nw, err_1loopSPT_nw, Pk.get_1loop_SPT());
                     ++count;
                   }
                 else
                   {
-                    check_stmt(db, sqlite3_clear_bindings(stmt));
-                    check_stmt(db, sqlite3_finalize(stmt));
-            
                     throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_RSD_PK_FAIL);
                   }
               }
-    
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
-    
-    
+
             if(count != 1)
               {
                 std::ostringstream msg;
@@ -219,7 +244,7 @@ namespace sqlite3_operations
                 throw runtime_exception(exception_type::database_error, msg.str());
               }
           }
-          
+
       }   // namespace find_impl
     
     
@@ -349,8 +374,7 @@ namespace sqlite3_operations
         
         return std::move(payload);
       }
-    
-    
+
     std::unique_ptr<loop_integral>
     find(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
          const loop_integral_params_token& params, const k_token& k, const linear_Pk_token& Pk,
@@ -363,8 +387,148 @@ namespace sqlite3_operations
         
         return std::move(payload);
       }
+
+    loop_timing_list
+    find_loop_timings(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
+                      const loop_integral_params_token& params)
+      {
+        // total time for each (k, Pk, IR, UV) configuration, accumulated over kernels
+        typedef std::tuple<unsigned int, unsigned int, unsigned int, unsigned int> config_key;
+        std::map< config_key, loop_timing_sample > totals;
+        
+        for(const std::string& table : loop_kernel_tables(db))
+          {
+            std::ostringstream read_stmt;
+            read_stmt
+              << "SELECT " << table << ".kid, " << table << ".Pk_id, " << table << ".IR_id, " << table << ".UV_id, "
+              << "k_tab.k, UV_tab.k, IR_tab.k, " << table << ".raw_time + " << table << ".nw_time "
+              << "FROM " << table << " "
+              << "INNER JOIN " << policy.wavenumber_config_table() << " k_tab ON k_tab.id = " << table << ".kid "
+              << "INNER JOIN " << policy.UV_config_table() << " UV_tab ON UV_tab.id = " << table << ".UV_id "
+              << "INNER JOIN " << policy.IR_config_table() << " IR_tab ON IR_tab.id = " << table << ".IR_id "
+              << "WHERE " << table << ".mid=@mid AND " << table << ".params_id=@params_id;";
     
+            // prepare statement
+            sqlite3_stmt* stmt;
+            check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
     
+            // bind parameter values
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), params.get_id()));
+            
+            // perform read
+            int result = 0;
+            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+              {
+                if(result == SQLITE_ROW)
+                  {
+                    config_key key = std::make_tuple(static_cast<unsigned int>(sqlite3_column_int(stmt, 0)),
+                                                     static_cast<unsigned int>(sqlite3_column_int(stmt, 1)),
+                                                     static_cast<unsigned int>(sqlite3_column_int(stmt, 2)),
+                                                     static_cast<unsigned int>(sqlite3_column_int(stmt, 3)));
+                    
+                    Mpc_units::energy k  = sqlite3_column_double(stmt, 4) / Mpc_units::Mpc;
+                    Mpc_units::energy UV = sqlite3_column_double(stmt, 5) / Mpc_units::Mpc;
+                    Mpc_units::energy IR = sqlite3_column_double(stmt, 6) / Mpc_units::Mpc;
+                    boost::timer::nanosecond_type time = sqlite3_column_int64(stmt, 7);
+                    
+                    auto t = totals.find(key);
+                    if(t == totals.end()) totals.emplace(key, loop_timing_sample(k, UV, IR, time));
+                    else t->second.time += time;
+                  }
+                else
+                  {
+                    check_stmt(db, sqlite3_clear_bindings(stmt));
+                    check_stmt(db, sqlite3_finalize(stmt));
+                    
+                    throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_LOOP_TIMINGS_FAIL);
+                  }
+              }
+            
+            // clear bindings and release
+            check_stmt(db, sqlite3_clear_bindings(stmt));
+            check_stmt(db, sqlite3_finalize(stmt));
+          }
+        
+        loop_timing_list samples;
+        for(const auto& t : totals)
+          {
+            samples.push_back(t.second);
+          }
+        
+        return samples;
+      }
+
+    loop_Pk_samples
+    find_loop_Pk_samples(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy,
+                         const FRW_model_token& model, const growth_params_token& growth_params,
+                         const loop_integral_params_token& loop_params, const linear_Pk_token& init_Pk_lin,
+                         const boost::optional<linear_Pk_token>& final_Pk_lin, const IR_cutoff_token& IR_cutoff,
+                         const UV_cutoff_token& UV_cutoff, const std::string& z_table, const std::string& k_table)
+      {
+        loop_Pk_samples samples;
+        
+        for(const std::string& table : oneloop_Pk_tables(db))
+          {
+            std::ostringstream read_stmt;
+            read_stmt
+              << "SELECT " << table << ".zid, k_tab.k, "
+              << table << ".P1loopSPT_raw, " << table << ".err_1loopSPT_raw, " << table << ".Ptree_raw, "
+              << table << ".P1loopSPT_nw, " << table << ".err_1loopSPT_nw, " << table << ".Ptree_nw "
+              << "FROM " << table << " "
+              << "INNER JOIN temp." << z_table << " z_tab ON z_tab.id = " << table << ".zid "
+              << "INNER JOIN temp." << k_table << " k_tab ON k_tab.id = " << table << ".kid "
+              << "WHERE " << table << ".mid=@mid AND " << table << ".growth_params=@growth_params AND "
+              << table << ".loop_params=@loop_params AND " << table << ".init_Pk_id=@init_Pk_id AND "
+              << "((@final_Pk_id IS NULL AND " << table << ".final_Pk_id IS NULL) OR " << table << ".final_Pk_id=@final_Pk_id) AND "
+              << table << ".IR_id=@IR_id AND " << table << ".UV_id=@UV_id;";
+            
+            // prepare statement
+            sqlite3_stmt* stmt;
+            check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
+            
+            // bind parameter values
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@growth_params"), growth_params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@loop_params"), loop_params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@init_Pk_id"), init_Pk_lin.get_id()));
+            if(final_Pk_lin) check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@final_Pk_id"), final_Pk_lin->get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_id"), IR_cutoff.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_id"), UV_cutoff.get_id()));
+            
+            // perform read
+            int result = 0;
+            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+              {
+                if(result == SQLITE_ROW)
+                  {
+                    std::string series = table + ".z" + std::to_string(sqlite3_column_int(stmt, 0));
+                    double k = sqlite3_column_double(stmt, 1);
+                    
+                    samples[series + ".raw"].emplace(k, loop_Pk_sample(sqlite3_column_double(stmt, 2),
+                                                                       sqlite3_column_double(stmt, 3),
+                                                                       sqlite3_column_double(stmt, 4)));
+                    samples[series + ".nw"].emplace(k, loop_Pk_sample(sqlite3_column_double(stmt, 5),
+                                                                      sqlite3_column_double(stmt, 6),
+                                                                      sqlite3_column_double(stmt, 7)));
+                  }
+                else
+                  {
+                    check_stmt(db, sqlite3_clear_bindings(stmt));
+                    check_stmt(db, sqlite3_finalize(stmt));
+                    
+                    throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_LOOP_SAMPLES_FAIL);
+                  }
+              }
+            
+            // clear bindings and release
+            check_stmt(db, sqlite3_clear_bindings(stmt));
+            check_stmt(db, sqlite3_finalize(stmt));
+          }
+        
+        return samples;
+      }
+
     std::unique_ptr<oneloop_Pk_set>
     find(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
              const growth_params_token& growth_params, const loop_integral_params_token& loop_params, const k_token& k,
@@ -377,24 +541,24 @@ namespace sqlite3_operations
 
         return std::move(payload);
       }
-    
-    
+
     std::unique_ptr<Matsubara_XY>
     find(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
          const MatsubaraXY_params_token& params, const linear_Pk_token& Pk, const IR_resum_token& IR_resum)
       {
-        std::ostringstream read_stmt;
-        read_stmt << "SELECT X, Y FROM " << policy.Matsubara_XY_table() << " WHERE mid=@mid AND params_id=@params_id AND Pk_id=@Pk_id AND IR_resum_id=@IR_resum_id;";
-    
         // prepare statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
+        auto stmt = get_statement_cache(db).get(policy.Matsubara_XY_table(), "select", [&]() -> std::string
+          {
+            std::ostringstream read_stmt;
+            read_stmt << "SELECT X, Y FROM " << policy.Matsubara_XY_table() << " WHERE mid=@mid AND params_id=@params_id AND Pk_id=@Pk_id AND IR_resum_id=@IR_resum_id;";
+            return read_stmt.str();
+          }, find_impl::Matsubara_XY_select::names);
     
         // bind parameter values
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), params.get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), Pk.get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_resum_id"), IR_resum.get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(find_impl::Matsubara_XY_select::mid), model.get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(find_impl::Matsubara_XY_select::params_id), params.get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(find_impl::Matsubara_XY_select::Pk_id), Pk.get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(find_impl::Matsubara_XY_select::IR_resum_id), IR_resum.get_id()));
     
         // store value
         Mpc_units::inverse_energy2 X(0.0);
@@ -403,28 +567,21 @@ namespace sqlite3_operations
         // perform read
         int result = 0;
         unsigned int count = 0;
-        while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+        while((result = sqlite3_step(stmt.get())) != SQLITE_DONE)
           {
             if(result == SQLITE_ROW)
               {
-                X = sqlite3_column_double(stmt, 0) * dimensionful_unit<Mpc_units::inverse_energy2>();
-                Y = sqlite3_column_double(stmt, 1) * dimensionful_unit<Mpc_units::inverse_energy2>();
+                X = sqlite3_column_double(stmt.get(), 0) * dimensionful_unit<Mpc_units::inverse_energy2>();
+                Y = sqlite3_column_double(stmt.get(), 1) * dimensionful_unit<Mpc_units::inverse_energy2>();
             
                 ++count;
               }
             else
               {
-                check_stmt(db, sqlite3_clear_bindings(stmt));
-                check_stmt(db, sqlite3_finalize(stmt));
-            
                 throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_MATSUBARA_XY_FAIL);
               }
           }
-    
-        // clear bindings and release
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
-        
+
         if(count != 1)
           {
             std::ostringstream msg;
@@ -36,6 +36,8 @@
 #include "database/tokens.h"
 #include "database/z_database.h"
 #include "database/k_database.h"
+#include "database/loop_cost_model.h"
+#include "database/k_grid_planner.h"
 
 #include "cosmology/concepts/oneloop_growth.h"
 #include "cosmology/concepts/loop_integral.h"
@@ -67,6 +69,22 @@ namespace sqlite3_operations
              const z_token& z, const linear_Pk_token& init_Pk_lin, const boost::optional<linear_Pk_token>& final_Pk_lin,
              const IR_cutoff_token& IR_cutoff, const UV_cutoff_token& UV_cutoff);
     
+    //! extract historical timings for loop integrals computed with a given parameter set, summed over all kernels;
+    //! used to fit a cost model when scheduling new loop integrals
+    loop_timing_list
+    find_loop_timings(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
+                      const loop_integral_params_token& params);
+    
+    //! extract the stored one-loop power spectra, with their errors and the tree-level spectrum, for a given
+    //! linear power spectrum, IR cutoff and UV cutoff, restricted to the redshifts and wavenumbers in temporary
+    //! tables; used to plan refinement of the k-grid
+    loop_Pk_samples
+    find_loop_Pk_samples(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy,
+                         const FRW_model_token& model, const growth_params_token& growth_params,
+                         const loop_integral_params_token& loop_params, const linear_Pk_token& init_Pk_lin,
+                         const boost::optional<linear_Pk_token>& final_Pk_lin, const IR_cutoff_token& IR_cutoff,
+                         const UV_cutoff_token& UV_cutoff, const std::string& z_table, const std::string& k_table);
+    
     //! extract Matsubara X & Y coefficient sfor a given linear power spectrum and IR resummation scale
     std::unique_ptr<Matsubara_XY>
     find(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy, const FRW_model_token& model,
@@ -30,6 +30,8 @@
 #include <assert.h>
 #include <set>
 #include <unordered_set>
+#include <map>
+#include <tuple>
 #include <cosmology/types.h>
 
 #include "utilities.h"
@@ -794,6 +796,88 @@ namespace sqlite3_operations
 
         return total_missing;
       }
+
+    
+    loop_configs
+    stale_loop_integral_configurations(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy,
+                                       const FRW_model_token& model, const loop_integral_params_token& params,
+                                       const linear_Pk_token& Pk_lin, const loop_configs& required_configs)
+      {
+        assert(db != nullptr);
+        
+        // index required configurations by their (k, IR, UV) identifiers
+        std::map< std::tuple<unsigned int, unsigned int, unsigned int>, const loop_configs::value_type* > index;
+        for(const loop_configs::value_type& t : required_configs)
+          {
+            index.emplace(std::make_tuple(t.k->get_token().get_id(), t.IR_cutoff->get_token().get_id(),
+                                          t.UV_cutoff->get_token().get_id()), &t);
+          }
+        
+        loop_configs stale;
+        
+        // each kernel is held to the tolerances now set for its type, or to those it was stored with if they are
+        // tighter; kernels which predate recording of their type are held to their stored tolerances.
+        // As in the integrators, a kernel is accepted if it meets either its absolute or its relative tolerance
+        auto target = [](const std::string& part, const std::string& tol) -> std::string
+          {
+            std::ostringstream expr;
+            expr
+              << "(CASE kernels.type "
+              << "WHEN 13 THEN MIN(CASE WHEN kernels." << part << "_" << tol << "tol>0 THEN kernels." << part << "_" << tol << "tol ELSE params." << tol << "err_13 END, params." << tol << "err_13) "
+              << "WHEN 22 THEN MIN(CASE WHEN kernels." << part << "_" << tol << "tol>0 THEN kernels." << part << "_" << tol << "tol ELSE params." << tol << "err_22 END, params." << tol << "err_22) "
+              << "ELSE kernels." << part << "_" << tol << "tol END)";
+            return expr.str();
+          };
+        
+        auto unmet = [&](const std::string& part) -> std::string
+          {
+            std::ostringstream expr;
+            expr
+              << "(kernels." << part << "_err>" << target(part, "abs") << " AND "
+              << "kernels." << part << "_err>" << target(part, "rel") << "*ABS(kernels." << part << "_value))";
+            return expr.str();
+          };
+        
+        for(const std::string& table : loop_kernel_tables(db))
+          {
+            std::ostringstream select_stmt;
+            select_stmt
+              << "SELECT kernels.kid, kernels.IR_id, kernels.UV_id FROM " << table << " AS kernels "
+              << "INNER JOIN " << policy.loop_integral_config_table() << " AS params ON params.id = kernels.params_id "
+              << "WHERE kernels.mid=@mid AND kernels.params_id=@params_id AND kernels.Pk_id=@Pk_id "
+              << "AND kernels.tier<params.tier "
+              << "AND (" << unmet("raw") << " OR " << unmet("nw") << ");";
+            
+            // prepare statement
+            sqlite3_stmt* stmt;
+            check_stmt(db, sqlite3_prepare_v2(db, select_stmt.str().c_str(), select_stmt.str().length()+1, &stmt, nullptr));
+            
+            // bind parameter values
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), Pk_lin.get_id()));
+            
+            int status = 0;
+            while((status = sqlite3_step(stmt)) != SQLITE_DONE)
+              {
+                if(status == SQLITE_ROW)
+                  {
+                    auto t = index.find(std::make_tuple(static_cast<unsigned int>(sqlite3_column_int(stmt, 0)),
+                                                        static_cast<unsigned int>(sqlite3_column_int(stmt, 1)),
+                                                        static_cast<unsigned int>(sqlite3_column_int(stmt, 2))));
+                    
+                    // only refine configurations which are needed
+                    if(t != index.end()) stale.insert(*t->second);
+                  }
+              }
+            
+            // release bindings and finalize statement to release resources
+            check_stmt(db, sqlite3_clear_bindings(stmt));
+            check_stmt(db, sqlite3_finalize(stmt));
+          }
+        
+        return stale;
+      }
     
     
     std::unique_ptr<z_database>
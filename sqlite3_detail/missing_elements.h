@@ -74,6 +74,15 @@ namespace sqlite3_operations
                                          const linear_Pk_token& Pk_lin, const loop_configs& required_configs);
     
     
+    //! process a list of configurations for loop momentum integrals;
+    //! we detect those stored at an earlier precision tier of the parameter set, with a kernel whose error
+    //! estimate meets neither the absolute nor the relative tolerance now requested for its type
+    loop_configs
+    stale_loop_integral_configurations(sqlite3* db, transaction_manager& mgr, const sqlite3_policy& policy,
+                                       const FRW_model_token& model, const loop_integral_params_token& params,
+                                       const linear_Pk_token& Pk_lin, const loop_configs& required_configs);
+    
+    
     //! process a list of configurations for one-loop P(k) calculations;
     //! we detect which ones are already present in the database and avoid computing them
     std::unique_ptr<z_database>
@@ -36,30 +36,45 @@
 namespace sqlite3_operations
   {
     
+    namespace oneloop_params_impl
+      {
+        
+        //! node count recorded for a parameter set; it only affects results for the fixed-node backends,
+        //! so other parameter sets record zero and match regardless of the default node count
+        inline int recorded_gl_points(const loop_integral_params& data)
+          {
+            const loop_integral_backend b = data.get_backend();
+            const bool fixed_node = b == loop_integral_backend::gauss_legendre || b == loop_integral_backend::cutoff_sweep;
+            return fixed_node ? static_cast<int>(data.get_gl_points()) : 0;
+          }
+        
+      }   // namespace oneloop_params_impl
+    
+    
     boost::optional<unsigned int>
     lookup_oneloop_params(sqlite3* db, transaction_manager& mgr, const loop_integral_params& data,
                           const sqlite3_policy& policy, double tol)
       {
         assert(db != nullptr);
         
+        // tolerances do not identify a parameter set: they select a precision tier, and records computed at
+        // a looser tier are refined in place when a tighter one is requested.
+        // Containers which predate tiers may hold several matching sets; the tightest is used, so that no
+        // stored record is held to a looser tolerance than it was computed with. Sets with an error budget
+        // are looser than those without, and remaining ties go to the earliest
         std::ostringstream select_stmt;
         select_stmt
           << "SELECT id FROM " << tokenization_table<loop_integral_params_token>(policy) << " WHERE "
-          << "ABS((abserr_13-@abs13)/abserr_13)<@tol "
-          << "AND ABS((relerr_13-@rel13)/relerr_13)<@tol "
-          << "AND ABS((abserr_22-@abs22)/abserr_22)<@tol "
-          << "AND ABS((relerr_22-@rel22)/relerr_22)<@tol;";
+          << "backend=@backend AND gl_points=@gl_points "
+          << "ORDER BY MAX(relerr_13, relerr_22), MAX(abserr_13, abserr_22), target_err>0, target_err, id LIMIT 1;";
         
         // prepare SQL statement
         sqlite3_stmt* stmt;
         check_stmt(db, sqlite3_prepare_v2(db, select_stmt.str().c_str(), select_stmt.str().length()+1, &stmt, nullptr));
         
         // bind values to the parameters
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@tol"), tol));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@abs13"), data.get_abserr_13()));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel13"), data.get_relerr_13()));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@abs22"), data.get_abserr_22()));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel22"), data.get_relerr_22()));
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@backend"), static_cast<int>(data.get_backend())));
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@gl_points"), oneloop_params_impl::recorded_gl_points(data)));
         
         // execute statement and step through results
         int status = 0;
@@ -92,7 +107,7 @@ namespace sqlite3_operations
         
         std::ostringstream insert_stmt;
         insert_stmt
-          << "INSERT INTO " << tokenization_table<loop_integral_params_token>(policy) << " VALUES (@id, @abs13, @rel13, @abs22, @rel22);";
+          << "INSERT INTO " << tokenization_table<loop_integral_params_token>(policy) << " VALUES (@id, @abs13, @rel13, @abs22, @rel22, @backend, @gl_points, @target_err, 0);";
         
         // prepare SQL statement
         sqlite3_stmt* stmt;
@@ -104,6 +119,9 @@ namespace sqlite3_operations
         check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel13"), data.get_relerr_13()));
         check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@abs22"), data.get_abserr_22()));
         check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel22"), data.get_relerr_22()));
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@backend"), static_cast<int>(data.get_backend())));
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@gl_points"), oneloop_params_impl::recorded_gl_points(data)));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@target_err"), data.get_target_err()));
     
         // perform insertion
         check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_ONELOOP_PARAMS_FAIL, SQLITE_DONE);
@@ -116,4 +134,85 @@ namespace sqlite3_operations
       }
     
     
+    boost::optional<unsigned int>
+    tighten_oneloop_params(sqlite3* db, transaction_manager& mgr, unsigned int id, const loop_integral_params& data,
+                           const sqlite3_policy& policy, double tol)
+      {
+        assert(db != nullptr);
+        
+        // an error budget is looser than no budget, since without one every kernel uses the tolerances above
+        std::ostringstream update_stmt;
+        update_stmt
+          << "UPDATE " << tokenization_table<loop_integral_params_token>(policy) << " SET "
+          << "tier=tier+1, "
+          << "abserr_13=MIN(abserr_13, @abs13), "
+          << "relerr_13=MIN(relerr_13, @rel13), "
+          << "abserr_22=MIN(abserr_22, @abs22), "
+          << "relerr_22=MIN(relerr_22, @rel22), "
+          << "target_err=CASE WHEN target_err>0 AND (@target_err=0 OR @target_err<target_err) THEN @target_err ELSE target_err END "
+          << "WHERE id=@id AND ("
+          << "@abs13<abserr_13*(1.0-@tol) OR @rel13<relerr_13*(1.0-@tol) OR "
+          << "@abs22<abserr_22*(1.0-@tol) OR @rel22<relerr_22*(1.0-@tol) OR "
+          << "(target_err>0 AND (@target_err=0 OR @target_err<target_err*(1.0-@tol))));";
+        
+        // prepare SQL statement
+        sqlite3_stmt* stmt;
+        check_stmt(db, sqlite3_prepare_v2(db, update_stmt.str().c_str(), update_stmt.str().length()+1, &stmt, nullptr));
+        
+        // bind values to the parameters
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@id"), id));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@tol"), tol));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@abs13"), data.get_abserr_13()));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel13"), data.get_relerr_13()));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@abs22"), data.get_abserr_22()));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@rel22"), data.get_relerr_22()));
+        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@target_err"), data.get_target_err()));
+        
+        // perform update
+        check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_UPDATE_ONELOOP_PARAMS_FAIL, SQLITE_DONE);
+        bool tightened = sqlite3_changes(db) > 0;
+        
+        // finalize statement and release resources
+        check_stmt(db, sqlite3_clear_bindings(stmt));
+        check_stmt(db, sqlite3_finalize(stmt));
+        
+        if(!tightened) return boost::none;
+        
+        return oneloop_params_tier(db, mgr, id, policy);
+      }
+    
+    
+    unsigned int oneloop_params_tier(sqlite3* db, transaction_manager& mgr, unsigned int id, const sqlite3_policy& policy)
+      {
+        assert(db != nullptr);
+        
+        std::ostringstream select_stmt;
+        select_stmt
+          << "SELECT tier FROM " << tokenization_table<loop_integral_params_token>(policy) << " WHERE id=@id;";
+        
+        // prepare SQL statement
+        sqlite3_stmt* stmt;
+        check_stmt(db, sqlite3_prepare_v2(db, select_stmt.str().c_str(), select_stmt.str().length()+1, &stmt, nullptr));
+        
+        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@id"), id));
+        
+        // execute statement and step through results
+        int status = 0;
+        unsigned int tier = 0;
+        while((status = sqlite3_step(stmt)) != SQLITE_DONE)
+          {
+            if(status == SQLITE_ROW)
+              {
+                tier = static_cast<unsigned int>(sqlite3_column_int(stmt, 0));
+              }
+          }
+        
+        // finalize statement and release resources
+        check_stmt(db, sqlite3_clear_bindings(stmt));
+        check_stmt(db, sqlite3_finalize(stmt));
+        
+        return tier;
+      }
+    
+    
   }   // namespace sqlite3_operations
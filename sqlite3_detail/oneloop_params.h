@@ -50,6 +50,17 @@ namespace sqlite3_operations
     unsigned int insert_oneloop_params(sqlite3* db, transaction_manager& mgr, const loop_integral_params& data,
                                       const sqlite3_policy& policy);
     
+    //! if any tolerance in a set of loop integral parameters is tighter than those recorded for an existing
+    //! parameter set, record the tighter tolerances and move the set to a new precision tier.
+    //! Returns the new tier, or boost::none if no tolerance was tightened
+    boost::optional<unsigned int> tighten_oneloop_params(sqlite3* db, transaction_manager& mgr, unsigned int id,
+                                                         const loop_integral_params& data,
+                                                         const sqlite3_policy& policy, double tol);
+    
+    //! get current precision tier of a set of loop integral parameters
+    unsigned int oneloop_params_tier(sqlite3* db, transaction_manager& mgr, unsigned int id,
+                                     const sqlite3_policy& policy);
+    
   }   // namespace sqlite3_operations
 
 
@@ -37,6 +37,7 @@
 #include "sqlite3_policy.h"
 
 #include "utilities.h"
+#include "statement_cache.h"
 #include "exceptions.h"
 
 #include "localizations/messages.h"
@@ -49,6 +50,29 @@
 namespace sqlite3_operations
   {
     
+    namespace power_spectrum_impl
+      {
+
+        // parameter positions for the cached statements
+
+        namespace Pk_linear_lookup
+          {
+            enum parameter { p };
+
+            const parameter_list names = { "@p" };
+          }
+
+
+        namespace Pk_linear_insert
+          {
+            enum parameter { id, mid, path, md5_hash };
+
+            const parameter_list names = { "@id", "@mid", "@path", "@md5_hash" };
+          }
+
+      }   // namespace power_spectrum_impl
+
+
     //! lookup ID for linear power spectrum
     template <typename PkContainer>
     boost::optional<unsigned int> lookup_Pk_linear(sqlite3* db, transaction_manager& mgr, const FRW_model_token& model,
@@ -56,30 +80,31 @@ namespace sqlite3_operations
       {
         assert(db != nullptr);
         
-        std::ostringstream select_stmt;
-        select_stmt
-          << "SELECT id, mid, md5_hash FROM " << tokenization_table<linear_Pk_token>(policy) << " WHERE "
-          << "path = @p;";
-        
-        // prepare SQL statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, select_stmt.str().c_str(), select_stmt.str().length()+1, &stmt, nullptr));
+        // prepare statement
+        auto stmt = get_statement_cache(db).get(tokenization_table<linear_Pk_token>(policy), "lookup", [&]() -> std::string
+          {
+            std::ostringstream select_stmt;
+            select_stmt
+              << "SELECT id, mid, md5_hash FROM " << tokenization_table<linear_Pk_token>(policy) << " WHERE "
+              << "path = @p;";
+            return select_stmt.str();
+          }, power_spectrum_impl::Pk_linear_lookup::names);
         
         // bind values to the parameters
         const std::string path = Pk_lin.get_path().string();
-        check_stmt(db, sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@p"), path.c_str(), path.length(), SQLITE_STATIC));
+        check_stmt(db, sqlite3_bind_text(stmt.get(), stmt.param(power_spectrum_impl::Pk_linear_lookup::p), path.c_str(), path.length(), SQLITE_STATIC));
         
         // execute statement and step through results
         int status;
         boost::optional<unsigned int> id = boost::none;
-        while((status = sqlite3_step(stmt)) != SQLITE_DONE)
+        while((status = sqlite3_step(stmt.get())) != SQLITE_DONE)
           {
             if(status == SQLITE_ROW)
               {
                 if(id) throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_MULTIPLE_PK_LINEAR);
                 
-                unsigned int model_id = static_cast<unsigned int>(sqlite3_column_int(stmt, 1));
-                std::string md5(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
+                unsigned int model_id = static_cast<unsigned int>(sqlite3_column_int(stmt.get(), 1));
+                std::string md5(reinterpret_cast<const char*>(sqlite3_column_text(stmt.get(), 2)));
                 
                 if(model_id != model.get_id())
                   {
@@ -97,18 +122,13 @@ namespace sqlite3_operations
                     throw runtime_exception(exception_type::runtime_error, msg.str());
                   }
                 
-                id = static_cast<unsigned int>(sqlite3_column_int(stmt, 0));
+                id = static_cast<unsigned int>(sqlite3_column_int(stmt.get(), 0));
               }
           }
-        
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
-        
+
         return id;
       }
-    
-    
+
     //! insert a linear power spectrum configuration
     template <typename PkContainer>
     unsigned int insert_Pk_linear(sqlite3* db, transaction_manager& mgr, const FRW_model_token& model,
@@ -119,34 +139,30 @@ namespace sqlite3_operations
         // get number of rows in table; this will be the identifier for the new power spectrum record
         unsigned int new_id = count(db, tokenization_table<linear_Pk_token>(policy));
         
-        std::ostringstream insert_stmt;
-        insert_stmt
-          << "INSERT INTO " << tokenization_table<linear_Pk_token>(policy) << " VALUES (@id, @mid, @path, @md5_hash);";
-        
-        // prepare SQL statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+        // prepare statement
+        auto stmt = get_statement_cache(db).get(tokenization_table<linear_Pk_token>(policy), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_stmt;
+            insert_stmt
+              << "INSERT INTO " << tokenization_table<linear_Pk_token>(policy) << " VALUES (@id, @mid, @path, @md5_hash);";
+            return insert_stmt.str();
+          }, power_spectrum_impl::Pk_linear_insert::names);
         
         // bind values to the parameters
         const std::string path = Pk_lin.get_path().string();
         const std::string md5 = Pk_lin.get_MD5_hash();
         
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@id"), new_id));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-        check_stmt(db, sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@path"), path.c_str(), path.length(), SQLITE_STATIC));
-        check_stmt(db, sqlite3_bind_text(stmt, sqlite3_bind_parameter_index(stmt, "@md5_hash"), md5.c_str(), md5.length(), SQLITE_STATIC));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(power_spectrum_impl::Pk_linear_insert::id), new_id));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(power_spectrum_impl::Pk_linear_insert::mid), model.get_id()));
+        check_stmt(db, sqlite3_bind_text(stmt.get(), stmt.param(power_spectrum_impl::Pk_linear_insert::path), path.c_str(), path.length(), SQLITE_STATIC));
+        check_stmt(db, sqlite3_bind_text(stmt.get(), stmt.param(power_spectrum_impl::Pk_linear_insert::md5_hash), md5.c_str(), md5.length(), SQLITE_STATIC));
         
         // perform insertion
-        check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_PK_LINEAR_CONFIG_FAIL, SQLITE_DONE);
-        
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
-        
+        check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_PK_LINEAR_CONFIG_FAIL, SQLITE_DONE);
+
         return(new_id);
       }
-    
-    
+
   }   // namespace sqlite3_operations
 
 #endif //LSSEFT_SQLITE3_POWER_SPECTRUM_H
@@ -0,0 +1,109 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <mutex>
+#include <assert.h>
+
+#include "statement_cache.h"
+#include "utilities.h"
+
+
+namespace sqlite3_operations
+  {
+
+    namespace statement_cache_impl
+      {
+
+        //! lock protecting the registry of caches
+        std::mutex lock;
+
+        //! statement caches, one per database connection
+        std::map< sqlite3*, std::unique_ptr<statement_cache> > caches;
+
+      }   // namespace statement_cache_impl
+
+
+    cached_statement::cached_statement(sqlite3* d, const std::string& sql, const parameter_list& names)
+      : db(d),
+        stmt(nullptr)
+      {
+        assert(db != nullptr);
+
+        check_stmt(db, sqlite3_prepare_v2(db, sql.c_str(), sql.length()+1, &stmt, nullptr));
+
+        // every parameter of the statement should appear in the list, or it could never be bound
+        assert(static_cast<int>(names.size()) == sqlite3_bind_parameter_count(stmt));
+
+        // resolve all parameter indices now, so binding needs no lookup
+        this->indices.reserve(names.size());
+        for(const std::string& name : names)
+          {
+            this->indices.push_back(sqlite3_bind_parameter_index(stmt, name.c_str()));
+          }
+      }
+
+
+    cached_statement::~cached_statement()
+      {
+        sqlite3_finalize(this->stmt);
+      }
+
+
+    void cached_statement::reset()
+      {
+        // the return value of sqlite3_reset() reports the result of the most recent step, which has already
+        // been checked (or is being handled) by the caller, so it is not checked here
+        sqlite3_reset(this->stmt);
+        sqlite3_clear_bindings(this->stmt);
+      }
+
+
+    statement_cache::statement_cache(sqlite3* d)
+      : db(d)
+      {
+        assert(db != nullptr);
+      }
+
+
+    statement_cache& get_statement_cache(sqlite3* db)
+      {
+        std::lock_guard<std::mutex> guard(statement_cache_impl::lock);
+
+        auto t = statement_cache_impl::caches.find(db);
+        if(t == statement_cache_impl::caches.end())
+          {
+            t = statement_cache_impl::caches.emplace(db, std::make_unique<statement_cache>(db)).first;
+          }
+
+        return *t->second;
+      }
+
+
+    void release_statement_cache(sqlite3* db)
+      {
+        std::lock_guard<std::mutex> guard(statement_cache_impl::lock);
+        statement_cache_impl::caches.erase(db);
+      }
+
+  }   // namespace sqlite3_operations
@@ -0,0 +1,215 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_SQLITE3_STATEMENT_CACHE_H
+#define LSSEFT_SQLITE3_STATEMENT_CACHE_H
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "sqlite3.h"
+
+
+namespace sqlite3_operations
+  {
+
+    //! names of the parameters of a statement; callers refer to each parameter by its position in this list
+    typedef std::vector<std::string> parameter_list;
+
+
+    //! a prepared statement owned by a statement_cache. Parameter indices are resolved once, when the
+    //! statement is prepared, so binding is a plain array access
+    class cached_statement
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor prepares the statement and resolves the index of each named parameter
+        cached_statement(sqlite3* d, const std::string& sql, const parameter_list& names);
+
+        //! destructor finalizes the statement
+        ~cached_statement();
+
+        // disable copying; we own the underlying sqlite3_stmt
+        cached_statement(const cached_statement& obj) = delete;
+
+        cached_statement& operator=(const cached_statement& obj) = delete;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get underlying statement
+        sqlite3_stmt* get() const { return this->stmt; }
+
+        //! get index of the i'th parameter in the list supplied when the statement was prepared, or 0 if the
+        //! statement has no such parameter; as for sqlite3_bind_parameter_index(), binding to index 0 fails with SQLITE_RANGE
+        int param(unsigned int i) const { return this->indices[i]; }
+
+        //! reset statement and clear its bindings, ready for reuse
+        void reset();
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! database connection
+        sqlite3* db;
+
+        //! prepared statement
+        sqlite3_stmt* stmt;
+
+        //! parameter indices, in the order of the list supplied when the statement was prepared
+        std::vector<int> indices;
+
+      };
+
+
+    //! provides access to a cached statement, and resets it once the caller has finished. A SELECT statement
+    //! which is not reset keeps its read transaction open, so this also happens if an exception is thrown
+    class statement_guard
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor
+        statement_guard(cached_statement& s)
+          : stmt(&s)
+          {
+          }
+
+        //! move constructor; only the destination resets the statement
+        statement_guard(statement_guard&& obj)
+          : stmt(obj.stmt)
+          {
+            obj.stmt = nullptr;
+          }
+
+        //! destructor resets the statement
+        ~statement_guard() { if(this->stmt != nullptr) this->stmt->reset(); }
+
+        // disable copying
+        statement_guard(const statement_guard& obj) = delete;
+
+        statement_guard& operator=(const statement_guard& obj) = delete;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get underlying statement
+        sqlite3_stmt* get() const { return this->stmt->get(); }
+
+        //! get index of the i'th parameter
+        int param(unsigned int i) const { return this->stmt->param(i); }
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! cached statement
+        cached_statement* stmt;
+
+      };
+
+
+    //! cache of prepared statements for a single database connection, keyed by table and operation.
+    //! Statements should only be cached if they refer to permanent tables; SQLite re-prepares them
+    //! automatically if the schema changes, eg. when indices are dropped or rebuilt
+    class statement_cache
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor
+        statement_cache(sqlite3* d);
+
+        //! destructor is default; finalizes all cached statements
+        ~statement_cache() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get the statement for a given table and operation; if it is not already cached, build()
+        //! is called to generate its SQL, the statement is prepared, and the indices of the parameters
+        //! named in 'names' are resolved. The same list should be supplied each time
+        template <typename Builder>
+        statement_guard get(const std::string& table, const std::string& op, Builder build, const parameter_list& names);
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! database connection
+        sqlite3* db;
+
+        //! cached statements, keyed by (table, operation)
+        std::map< std::pair<std::string, std::string>, std::unique_ptr<cached_statement> > statements;
+
+      };
+
+
+    template <typename Builder>
+    statement_guard statement_cache::get(const std::string& table, const std::string& op, Builder build,
+                                         const parameter_list& names)
+      {
+        auto key = std::make_pair(table, op);
+        auto t = this->statements.find(key);
+
+        if(t == this->statements.end())
+          {
+            t = this->statements.emplace(std::move(key), std::make_unique<cached_statement>(this->db, build(), names)).first;
+          }
+
+        return statement_guard(*t->second);
+      }
+
+
+    //! get statement cache for a database connection, constructing it if necessary
+    statement_cache& get_statement_cache(sqlite3* db);
+
+    //! release statement cache for a database connection; must be called before the connection is closed
+    void release_statement_cache(sqlite3* db);
+
+  }   // namespace sqlite3_operations
+
+
+#endif //LSSEFT_SQLITE3_STATEMENT_CACHE_H
@@ -29,6 +29,7 @@
 
 #include "store.h"
 #include "utilities.h"
+#include "statement_cache.h"
 
 #include "localizations/messages.h"
 
@@ -81,122 +82,359 @@ namespace sqlite3_operations
           }
     
     
+        // parameter positions for the cached insert statements
+
+        namespace loop_kernel_insert
+          {
+            enum parameter { mid, params_id, kid, Pk_id, IR_id, UV_id, raw_value, raw_regions, raw_evals, raw_err,
+                             raw_time, nw_value, nw_regions, nw_evals, nw_err, nw_time, raw_abstol, raw_reltol,
+                             nw_abstol, nw_reltol, type };
+
+            const parameter_list names = { "@mid", "@params_id", "@kid", "@Pk_id", "@IR_id", "@UV_id", "@raw_value",
+                                           "@raw_regions", "@raw_evals", "@raw_err", "@raw_time", "@nw_value",
+                                           "@nw_regions", "@nw_evals", "@nw_err", "@nw_time", "@raw_abstol",
+                                           "@raw_reltol", "@nw_abstol", "@nw_reltol", "@type" };
+          }
+
+
+        // identifies the rows for one loop integral configuration; shared by the statements which remove
+        // a kernel being replaced by a refined value, and the power spectra built from it
+        namespace loop_config_delete
+          {
+            enum parameter { mid, params_id, kid, Pk_id, IR_id, UV_id };
+            
+            const parameter_list names = { "@mid", "@params_id", "@kid", "@Pk_id", "@IR_id", "@UV_id" };
+          }
+
+
+        namespace oneloop_rsd_insert
+          {
+            enum parameter { mid, growth_params, loop_params, zid, kid, init_Pk_id, final_Pk_id, IR_id, UV_id,
+                             Ptree_raw, err_tree_raw, P13_raw, err_13_raw, P22_raw, err_22_raw, P1loopSPT_raw,
+                             err_1loopSPT_raw, Ptree_nw, err_tree_nw, P13_nw, err_13_nw, P22_nw, err_22_nw,
+                             P1loopSPT_nw, err_1loopSPT_nw };
+
+            const parameter_list names = { "@mid", "@growth_params", "@loop_params", "@zid", "@kid", "@init_Pk_id",
+                                           "@final_Pk_id", "@IR_id", "@UV_id", "@Ptree_raw", "@err_tree_raw",
+                                           "@P13_raw", "@err_13_raw", "@P22_raw", "@err_22_raw", "@P1loopSPT_raw",
+                                           "@err_1loopSPT_raw", "@Ptree_nw", "@err_tree_nw", "@P13_nw", "@err_13_nw",
+                                           "@P22_nw", "@err_22_nw", "@P1loopSPT_nw", "@err_1loopSPT_nw" };
+          }
+
+
+        namespace multipole_insert
+          {
+            enum parameter { mid, growth_params, loop_params, XY_params, zid, kid, init_Pk_id, final_Pk_id,
+                             IR_cutoff_id, UV_cutoff_id, IR_resum_id, Ptree, Ptree_err, Ptree_resum, Ptree_resum_err,
+                             P13, P13_err, P13_resum, P13_resum_err, P22, P22_err, P22_resum, P22_resum_err, P1loopSPT,
+                             P1loopSPT_err, P1loopSPT_resum, P1loopSPT_resum_err };
+
+            const parameter_list names = { "@mid", "@growth_params", "@loop_params", "@XY_params", "@zid", "@kid",
+                                           "@init_Pk_id", "@final_Pk_id", "@IR_cutoff_id", "@UV_cutoff_id",
+                                           "@IR_resum_id", "@Ptree", "@Ptree_err", "@Ptree_resum", "@Ptree_resum_err",
+                                           "@P13", "@P13_err", "@P13_resum", "@P13_resum_err", "@P22", "@P22_err",
+                                           "@P22_resum", "@P22_resum_err", "@P1loopSPT", "@P1loopSPT_err",
+                                           "@P1loopSPT_resum", "@P1loopSPT_resum_err" };
+          }
+
+
+        namespace counterterm_insert
+          {
+            enum parameter { mid, growth_params, XY_params, zid, kid, init_Pk_id, final_Pk_id, IR_cutoff_id,
+                             UV_cutoff_id, IR_resum_id, P0_k0_raw, P0_k0_raw_err, P0_k0_resum, P0_k0_resum_err,
+                             P2_k0_raw, P2_k0_raw_err, P2_k0_resum, P2_k0_resum_err, P4_k0_raw, P4_k0_raw_err,
+                             P4_k0_resum, P4_k0_resum_err, P0_k2_raw, P0_k2_raw_err, P0_k2_resum, P0_k2_resum_err,
+                             P2_k2_raw, P2_k2_raw_err, P2_k2_resum, P2_k2_resum_err, P4_k2_raw, P4_k2_raw_err,
+                             P4_k2_resum, P4_k2_resum_err };
+
+            const parameter_list names = { "@mid", "@growth_params", "@XY_params", "@zid", "@kid", "@init_Pk_id",
+                                           "@final_Pk_id", "@IR_cutoff_id", "@UV_cutoff_id", "@IR_resum_id",
+                                           "@P0_k0_raw", "@P0_k0_raw_err", "@P0_k0_resum", "@P0_k0_resum_err",
+                                           "@P2_k0_raw", "@P2_k0_raw_err", "@P2_k0_resum", "@P2_k0_resum_err",
+                                           "@P4_k0_raw", "@P4_k0_raw_err", "@P4_k0_resum", "@P4_k0_resum_err",
+                                           "@P0_k2_raw", "@P0_k2_raw_err", "@P0_k2_resum", "@P0_k2_resum_err",
+                                           "@P2_k2_raw", "@P2_k2_raw_err", "@P2_k2_resum", "@P2_k2_resum_err",
+                                           "@P4_k2_raw", "@P4_k2_raw_err", "@P4_k2_resum", "@P4_k2_resum_err" };
+          }
+
+
+        namespace transfer_insert
+          {
+            enum parameter { mid, kid, zid, delta_m, delta_r, theta_m, theta_r, Phi };
+
+            const parameter_list names = { "@mid", "@kid", "@zid", "@delta_m", "@delta_r", "@theta_m", "@theta_r",
+                                           "@Phi" };
+          }
+
+
+        namespace D_factor_insert
+          {
+            enum parameter { mid, params_id, zid, D_linear, A, B, D, E, F, G, J };
+
+            const parameter_list names = { "@mid", "@params_id", "@zid", "@D_linear", "@A", "@B", "@D", "@E", "@F",
+                                           "@G", "@J" };
+          }
+
+
+        namespace f_factor_insert
+          {
+            enum parameter { mid, params_id, zid, f_linear, fA, fB, fD, fE, fF, fG, fJ };
+
+            const parameter_list names = { "@mid", "@params_id", "@zid", "@f_linear", "@fA", "@fB", "@fD", "@fE", "@fF",
+                                           "@fG", "@fJ" };
+          }
+
+
+        namespace Matsubara_XY_insert
+          {
+            enum parameter { mid, params_id, Pk_id, IR_resum_id, X, Y };
+
+            const parameter_list names = { "@mid", "@params_id", "@Pk_id", "@IR_resum_id", "@X", "@Y" };
+          }
+
+
+        namespace Pk_linear_insert
+          {
+            enum parameter { Pk_id, params_id, kid, Pk_raw, Pk_nw, Pk_ref, Pk_nw_err, regions, evaluations, time };
+
+            const parameter_list names = { "@Pk_id", "@params_id", "@kid", "@Pk_raw", "@Pk_nw", "@Pk_ref", "@Pk_nw_err",
+                                           "@regions", "@evaluations", "@time" };
+          }
+
+
+        //! state shared by every kernel of a loop integral sample. store() builds it once, and the
+        //! autogenerated store statements pass it through to store_loop_kernel() with each kernel
+        class loop_kernel_context
+          {
+            
+            // CONSTRUCTOR, DESTRUCTOR
+            
+          public:
+            
+            //! constructor
+            loop_kernel_context(const sqlite3_policy& p, const loop_integral_params_token& t)
+              : policy(p),
+                params(t),
+                replaced(false)
+              {
+              }
+            
+            //! destructor is default
+            ~loop_kernel_context() = default;
+            
+            
+            // INTERFACE
+            
+          public:
+            
+            //! get policy supplied by the caller
+            const sqlite3_policy& get_policy() const { return this->policy; }
+            
+            //! get id of the loop integral parameter set
+            unsigned int get_id() const { return this->params.get_id(); }
+            
+            //! record that a stored kernel was replaced
+            void mark_replaced() const { this->replaced = true; }
+            
+            //! determine whether any stored kernel was replaced
+            bool is_replaced() const { return this->replaced; }
+            
+            
+            // INTERNAL DATA
+            
+          private:
+            
+            //! policy supplied by the caller
+            const sqlite3_policy& policy;
+            
+            //! token for the loop integral parameter set
+            const loop_integral_params_token& params;
+            
+            //! flag set when a kernel replaces one stored at an earlier precision tier; the autogenerated
+            //! statements see the context only as a const reference
+            mutable bool replaced;
+            
+          };
+        
+        
+        //! bind the identifiers of a loop integral configuration to a cached delete statement
+        void bind_loop_config(sqlite3* db, statement_guard& stmt, const FRW_model_token& model,
+                              const loop_integral_params_token& params, const loop_integral& sample)
+          {
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::params_id), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::kid), sample.get_k_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::Pk_id), sample.get_Pk_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::IR_id), sample.get_IR_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_config_delete::UV_id), sample.get_UV_token().get_id()));
+          }
+        
+        
+        //! remove the one-loop and multipole power spectra built from a loop integral configuration whose
+        //! kernels have been replaced, so that they are rebuilt from the refined values
+        void invalidate_loop_Pk(sqlite3* db, const FRW_model_token& model, const loop_integral_params_token& params,
+                                const loop_integral& sample)
+          {
+            auto drop = [&](const std::string& table, const std::string& IR_col, const std::string& UV_col) -> void
+              {
+                auto stmt = get_statement_cache(db).get(table, "invalidate", [&]() -> std::string
+                  {
+                    std::ostringstream drop_stmt;
+                    drop_stmt
+                      << "DELETE FROM " << table << " WHERE mid=@mid AND loop_params=@params_id AND kid=@kid AND "
+                      << "init_Pk_id=@Pk_id AND " << IR_col << "=@IR_id AND " << UV_col << "=@UV_id;";
+                    return drop_stmt.str();
+                  }, loop_config_delete::names);
+                
+                bind_loop_config(db, stmt, model, params, sample);
+                check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_REPLACE_LOOP_MOMENTUM_FAIL, SQLITE_DONE);
+              };
+            
+            for(const std::string& table : oneloop_Pk_tables(db))   drop(table, "IR_id", "UV_id");
+            for(const std::string& table : multipole_Pk_tables(db)) drop(table, "IR_cutoff_id", "UV_cutoff_id");
+          }
+        
+        
         template <typename KernelType>
         void store_loop_kernel(sqlite3* db, const std::string& table_name, const KernelType& kernel, const FRW_model_token& model,
-                                       const loop_integral_params_token& params, const loop_integral& sample)
+                                       const loop_kernel_context& params, const loop_integral& sample)
           {
-            std::ostringstream insert_stmt;
-            insert_stmt
-              << "INSERT INTO " << table_name << " VALUES (@mid, @params_id, @kid, @Pk_id, @IR_id, @UV_id, "
-              << "@raw_value, @raw_regions, @raw_evals, @raw_err, @raw_time, "
-              << "@nw_value, @nw_regions, @nw_evals, @nw_err, @nw_time);";
+            // a refined value replaces the row stored at an earlier precision tier; that row is kept until now,
+            // so an interrupted refinement leaves the earlier value in place
+            {
+              auto drop = get_statement_cache(db).get(table_name, "replace", [&]() -> std::string
+                {
+                  std::ostringstream drop_stmt;
+                  drop_stmt
+                    << "DELETE FROM " << table_name << " WHERE mid=@mid AND params_id=@params_id AND kid=@kid AND "
+                    << "Pk_id=@Pk_id AND IR_id=@IR_id AND UV_id=@UV_id;";
+                  return drop_stmt.str();
+                }, loop_config_delete::names);
+              
+              bind_loop_config(db, drop, model, sample.get_params_token(), sample);
+              check_stmt(db, sqlite3_step(drop.get()), ERROR_SQLITE3_REPLACE_LOOP_MOMENTUM_FAIL, SQLITE_DONE);
+              if(sqlite3_changes(db) > 0) params.mark_replaced();
+            }
             
-            // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+            // prepare statement; each kernel records the current precision tier of its parameter set
+            auto stmt = get_statement_cache(db).get(table_name, "insert", [&]() -> std::string
+              {
+                std::ostringstream insert_stmt;
+                insert_stmt
+                  << "INSERT INTO " << table_name << " VALUES (@mid, @params_id, @kid, @Pk_id, @IR_id, @UV_id, "
+                  << "@raw_value, @raw_regions, @raw_evals, @raw_err, @raw_time, "
+                  << "@nw_value, @nw_regions, @nw_evals, @nw_err, @nw_time, "
+                  << "@raw_abstol, @raw_reltol, @nw_abstol, @nw_reltol, "
+                  << "(SELECT tier FROM " << params.get_policy().loop_integral_config_table() << " WHERE id=@params_id), "
+                  << "@type);";
+                return insert_stmt.str();
+              }, loop_kernel_insert::names);
             
             // bind parameter values
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), params.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), sample.get_k_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), sample.get_Pk_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_id"), sample.get_IR_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_id"), sample.get_UV_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::params_id), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::kid), sample.get_k_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::Pk_id), sample.get_Pk_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::IR_id), sample.get_IR_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::UV_id), sample.get_UV_token().get_id()));
 
             auto raw = kernel.get_raw();
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@raw_value"), dimensionless_value(raw)));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@raw_regions"),raw.regions));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@raw_evals"), raw.evaluations));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@raw_err"), dimensionless_error(raw)));
-            check_stmt(db, sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@raw_time"), raw.time));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::raw_value), dimensionless_value(raw)));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::raw_regions),raw.regions));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::raw_evals), raw.evaluations));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::raw_err), dimensionless_error(raw)));
+            check_stmt(db, sqlite3_bind_int64(stmt.get(), stmt.param(loop_kernel_insert::raw_time), raw.time));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::raw_abstol), raw.abs_tol));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::raw_reltol), raw.rel_tol));
     
             auto nw = kernel.get_nowiggle();
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@nw_value"), dimensionless_value(nw)));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@nw_regions"),nw.regions));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@nw_evals"), nw.evaluations));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@nw_err"), dimensionless_error(nw)));
-            check_stmt(db, sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@nw_time"), nw.time));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::nw_value), dimensionless_value(nw)));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::nw_regions),nw.regions));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::nw_evals), nw.evaluations));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::nw_err), dimensionless_error(nw)));
+            check_stmt(db, sqlite3_bind_int64(stmt.get(), stmt.param(loop_kernel_insert::nw_time), nw.time));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::nw_abstol), nw.abs_tol));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(loop_kernel_insert::nw_reltol), nw.rel_tol));
+            
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(loop_kernel_insert::type), raw.type));
     
             // perform insertion
-            check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_LOOP_MOMENTUM_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_LOOP_MOMENTUM_FAIL, SQLITE_DONE);
     
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
           }
         
         
         // store Pk-value, including raw & nowiggle parts, with error information
         template <typename ValueType>
-        void store_Pk_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value_raw, const std::string& error_raw,
-                            const std::string& value_nw, const std::string& error_nw, const ValueType& item)
+        void store_Pk_value(sqlite3* db, statement_guard& stmt, unsigned int value_raw, unsigned int error_raw,
+                            unsigned int value_nw, unsigned int error_nw, const ValueType& item)
           {
             const auto& raw = item.get_raw();
             const auto& nw = item.get_nowiggle();
             
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_raw.c_str()), dimensionless_value(raw)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, error_raw.c_str()), dimensionless_error(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_raw), dimensionless_value(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(error_raw), dimensionless_error(raw)));
     
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_nw.c_str()), dimensionless_value(nw)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, error_nw.c_str()), dimensionless_error(nw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_nw), dimensionless_value(nw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(error_nw), dimensionless_error(nw)));
           }
     
     
         // store Pk-value, including raw & nowiggle parts, with no error information
         template <typename ValueType, typename ValueType::container_type* = nullptr>
-        void store_Pk_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value_raw, const std::string& value_nw, const ValueType& item)
+        void store_Pk_value(sqlite3* db, statement_guard& stmt, unsigned int value_raw, unsigned int value_nw, const ValueType& item)
           {
             const auto& raw = item.get_raw();
             const auto& nw = item.get_nowiggle();
 
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_raw.c_str()), dimensionless_value(raw)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_nw.c_str()), dimensionless_value(nw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_raw), dimensionless_value(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_nw), dimensionless_value(nw)));
           }
         
         
         // store Pk-value, including error information, but no raw/nowiggle parts
         template <typename ValueType, typename ValueType::error_type* = nullptr>
-        void store_Pk_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value, const std::string& error, const ValueType& item)
+        void store_Pk_value(sqlite3* db, statement_guard& stmt, unsigned int value, unsigned int error, const ValueType& item)
           {
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value.c_str()), dimensionless_value(item)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, error.c_str()), dimensionless_error(item)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value), dimensionless_value(item)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(error), dimensionless_error(item)));
           };
         
         
         // store Pk-value, no raw/nowiggle or error information
         template <typename ValueType>
-        void store_Pk_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value, const ValueType& item)
+        void store_Pk_value(sqlite3* db, statement_guard& stmt, unsigned int value, const ValueType& item)
           {
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value.c_str()), dimensionless_value(item)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value), dimensionless_value(item)));
           }
         
         
         // store multipole P_ell value, including raw and resummed parts, with error information
         template <typename ValueType>
-        void store_Pell_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value_raw, const std::string& error_raw,
-                              const std::string& value_resum, const std::string& error_resum, const ValueType& item)
+        void store_Pell_value(sqlite3* db, statement_guard& stmt, unsigned int value_raw, unsigned int error_raw,
+                              unsigned int value_resum, unsigned int error_resum, const ValueType& item)
           {
             const auto& raw = item.get_raw();
             const auto& resum = item.get_resum();
             
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_raw.c_str()), dimensionless_value(raw)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, error_raw.c_str()), dimensionless_error(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_raw), dimensionless_value(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(error_raw), dimensionless_error(raw)));
             
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_resum.c_str()), dimensionless_value(resum)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, error_resum.c_str()), dimensionless_error(resum)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_resum), dimensionless_value(resum)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(error_resum), dimensionless_error(resum)));
           }
     
     
         // store multipole P_ell value, including raw and resummed parts, but with noerror information
         template <typename ValueType>
-        void store_Pell_value(sqlite3* db, sqlite3_stmt* stmt, const std::string& value_raw,
-                              const std::string& value_resum, const ValueType& item)
+        void store_Pell_value(sqlite3* db, statement_guard& stmt, unsigned int value_raw,
+                              unsigned int value_resum, const ValueType& item)
           {
             const auto& raw = item.get_raw();
             const auto& resum = item.get_resum();
         
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_raw.c_str()), dimensionless_value(raw)));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, value_resum.c_str()), dimensionless_value(resum)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_raw), dimensionless_value(raw)));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(value_resum), dimensionless_value(resum)));
           }
 
 
@@ -204,68 +442,71 @@ namespace sqlite3_operations
         void store_one_loop_rsd_Pk(sqlite3* db, const std::string& table_name, const PkType& value,
                                    const FRW_model_token& model, const oneloop_Pk& sample)
           {
-            std::ostringstream insert_stmt;
-            insert_stmt
-              << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @loop_params, @zid, @kid, @init_Pk_id, @final_Pk_id, @IR_id, @UV_id, "
-                                              << "@Ptree_raw, @err_tree_raw, "
-                                              << "@P13_raw, @err_13_raw, "
-                                              << "@P22_raw, @err_22_raw, "
-                                              << "@P1loopSPT_raw, @err_1loopSPT_raw, "
-                                              << "@Ptree_nw, @err_tree_nw, "
-                                              << "@P13_nw, @err_13_nw, "
-                                              << "@P22_nw, @err_22_nw, "
-                                              << "@P1loopSPT_nw, @err_1loopSPT_nw"
-                                              << ");";
-        
             // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+            auto stmt = get_statement_cache(db).get(table_name, "insert", [&]() -> std::string
+              {
+                std::ostringstream insert_stmt;
+                insert_stmt
+                  << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @loop_params, @zid, @kid, @init_Pk_id, @final_Pk_id, @IR_id, @UV_id, "
+                                                  << "@Ptree_raw, @err_tree_raw, "
+                                                  << "@P13_raw, @err_13_raw, "
+                                                  << "@P22_raw, @err_22_raw, "
+                                                  << "@P1loopSPT_raw, @err_1loopSPT_raw, "
+                                                  << "@Ptree_nw, @err_tree_nw, "
+                                                  << "@P13_nw, @err_13_nw, "
+                                                  << "@P22_nw, @err_22_nw, "
+                                                  << "@P1loopSPT_nw, @err_1loopSPT_nw"
+                                                  << ");";
+                return insert_stmt.str();
+              }, oneloop_rsd_insert::names);
         
             // bind parameter values
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@growth_params"), sample.get_growth_params().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@loop_params"), sample.get_loop_params().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@zid"), sample.get_z_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), sample.get_k_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@init_Pk_id"), sample.get_init_Pk_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::growth_params), sample.get_growth_params().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::loop_params), sample.get_loop_params().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::zid), sample.get_z_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::kid), sample.get_k_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::init_Pk_id), sample.get_init_Pk_token().get_id()));
             const boost::optional<linear_Pk_token>& final_tok = sample.get_final_Pk_token();
             if(final_tok)
               {
-                check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@final_Pk_id"), final_tok->get_id()));
+                check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::final_Pk_id), final_tok->get_id()));
               }
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_id"), sample.get_IR_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_id"), sample.get_UV_token().get_id()));
-
-            store_Pk_value(db, stmt, "@Ptree_raw", "@err_tree_raw", "@Ptree_nw", "@err_tree_nw", value.get_tree());
-            store_Pk_value(db, stmt, "@P13_raw", "@err_13_raw", "@P13_nw", "@err_13_nw", value.get_13());
-            store_Pk_value(db, stmt, "@P22_raw", "@err_22_raw", "@P22_nw", "@err_22_nw", value.get_22());
-            store_Pk_value(db, stmt, "@P1loopSPT_raw", "@err_1loopSPT_raw", "@P1loopSPT_nw", "@err_1loopSPT_nw", value.get_1loop_SPT());
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::IR_id), sample.get_IR_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(oneloop_rsd_insert::UV_id), sample.get_UV_token().get_id()));
+
+            store_Pk_value(db, stmt, oneloop_rsd_insert::Ptree_raw, oneloop_rsd_insert::err_tree_raw,
+                           oneloop_rsd_insert::Ptree_nw, oneloop_rsd_insert::err_tree_nw, value.get_tree());
+            store_Pk_value(db, stmt, oneloop_rsd_insert::P13_raw, oneloop_rsd_insert::err_13_raw,
+                           oneloop_rsd_insert::P13_nw, oneloop_rsd_insert::err_13_nw, value.get_13());
+            store_Pk_value(db, stmt, oneloop_rsd_insert::P22_raw, oneloop_rsd_insert::err_22_raw,
+                           oneloop_rsd_insert::P22_nw, oneloop_rsd_insert::err_22_nw, value.get_22());
+            store_Pk_value(db, stmt, oneloop_rsd_insert::P1loopSPT_raw, oneloop_rsd_insert::err_1loopSPT_raw,
+                           oneloop_rsd_insert::P1loopSPT_nw, oneloop_rsd_insert::err_1loopSPT_nw, value.get_1loop_SPT());
 
             // perform insertion
-            check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_ONELOOP_RSD_PK_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_ONELOOP_RSD_PK_FAIL, SQLITE_DONE);
         
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
           }
     
     
         void store_multipole_Pk(sqlite3* db, const std::string& table_name, const Pk_ell& value,
                                 const FRW_model_token& model, const multipole_Pk& sample)
           {
-            std::ostringstream insert_stmt;
-            insert_stmt
-              << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @loop_params, @XY_params, "
-                                              << "@zid, @kid, @init_Pk_id, @final_Pk_id, @IR_cutoff_id, @UV_cutoff_id, @IR_resum_id, "
-                                              << "@Ptree, @Ptree_err, @Ptree_resum, @Ptree_resum_err, "
-                                              << "@P13, @P13_err, @P13_resum, @P13_resum_err, "
-                                              << "@P22, @P22_err, @P22_resum, @P22_resum_err, "
-                                              << "@P1loopSPT, @P1loopSPT_err, @P1loopSPT_resum, @P1loopSPT_resum_err"
-                                              << ");";
-    
             // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+            auto stmt = get_statement_cache(db).get(table_name, "insert", [&]() -> std::string
+              {
+                std::ostringstream insert_stmt;
+                insert_stmt
+                  << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @loop_params, @XY_params, "
+                                                  << "@zid, @kid, @init_Pk_id, @final_Pk_id, @IR_cutoff_id, @UV_cutoff_id, @IR_resum_id, "
+                                                  << "@Ptree, @Ptree_err, @Ptree_resum, @Ptree_resum_err, "
+                                                  << "@P13, @P13_err, @P13_resum, @P13_resum_err, "
+                                                  << "@P22, @P22_err, @P22_resum, @P22_resum_err, "
+                                                  << "@P1loopSPT, @P1loopSPT_err, @P1loopSPT_resum, @P1loopSPT_resum_err"
+                                                  << ");";
+                return insert_stmt.str();
+              }, multipole_insert::names);
     
             // bind parameter values
             const auto& tree = value.get_tree();
@@ -273,83 +514,87 @@ namespace sqlite3_operations
             const auto& P22 = value.get_22();
             const auto& P1loopSPT = value.get_1loop_SPT();
 
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@growth_params"), sample.get_growth_params_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@loop_params"), sample.get_loop_params_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@XY_params"), sample.get_XY_params_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@zid"), sample.get_z_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), sample.get_k_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@init_Pk_id"), sample.get_init_Pk_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::growth_params), sample.get_growth_params_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::loop_params), sample.get_loop_params_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::XY_params), sample.get_XY_params_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::zid), sample.get_z_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::kid), sample.get_k_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::init_Pk_id), sample.get_init_Pk_token().get_id()));
             const boost::optional<linear_Pk_token>& final_tok = sample.get_final_Pk_token();
             if(final_tok)
               {
-                check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@final_Pk_id"), final_tok->get_id()));
+                check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::final_Pk_id), final_tok->get_id()));
               }
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_cutoff_id"), sample.get_IR_cutoff_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_cutoff_id"), sample.get_UV_cutoff_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_resum_id"), sample.get_IR_resum_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::IR_cutoff_id), sample.get_IR_cutoff_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::UV_cutoff_id), sample.get_UV_cutoff_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(multipole_insert::IR_resum_id), sample.get_IR_resum_token().get_id()));
             
-            store_Pell_value(db, stmt, "@Ptree", "@Ptree_err", "@Ptree_resum", "@Ptree_resum_err", tree);
-            store_Pell_value(db, stmt, "@P13", "@P13_err", "@P13_resum", "@P13_resum_err", P13);
-            store_Pell_value(db, stmt, "@P22", "@P22_err", "@P22_resum", "@P22_resum_err", P22);
-            store_Pell_value(db, stmt, "@P1loopSPT", "@P1loopSPT_err", "@P1loopSPT_resum", "@P1loopSPT_resum_err", P1loopSPT);
+            store_Pell_value(db, stmt, multipole_insert::Ptree, multipole_insert::Ptree_err,
+                             multipole_insert::Ptree_resum, multipole_insert::Ptree_resum_err, tree);
+            store_Pell_value(db, stmt, multipole_insert::P13, multipole_insert::P13_err,
+                             multipole_insert::P13_resum, multipole_insert::P13_resum_err, P13);
+            store_Pell_value(db, stmt, multipole_insert::P22, multipole_insert::P22_err,
+                             multipole_insert::P22_resum, multipole_insert::P22_resum_err, P22);
+            store_Pell_value(db, stmt, multipole_insert::P1loopSPT, multipole_insert::P1loopSPT_err,
+                             multipole_insert::P1loopSPT_resum, multipole_insert::P1loopSPT_resum_err, P1loopSPT);
 
             // perform insertion
-            check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_MULTIPOLE_PK_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_MULTIPOLE_PK_FAIL, SQLITE_DONE);
     
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
           }
 
 
         void store_counterterm(sqlite3* db, const std::string& table_name, const FRW_model_token& model, const multipole_counterterm& sample)
           {
-            std::ostringstream insert_stmt;
-            insert_stmt
-              << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @XY_params, "
-              << "@zid, @kid, @init_Pk_id, @final_Pk_id, @IR_cutoff_id, @UV_cutoff_id, @IR_resum_id, "
-              << "@P0_k0_raw, @P0_k0_raw_err, @P0_k0_resum, @P0_k0_resum_err, "
-              << "@P2_k0_raw, @P2_k0_raw_err, @P2_k0_resum, @P2_k0_resum_err, "
-              << "@P4_k0_raw, @P4_k0_raw_err, @P4_k0_resum, @P4_k0_resum_err, "
-              << "@P0_k2_raw, @P0_k2_raw_err, @P0_k2_resum, @P0_k2_resum_err, "
-              << "@P2_k2_raw, @P2_k2_raw_err, @P2_k2_resum, @P2_k2_resum_err, "
-              << "@P4_k2_raw, @P4_k2_raw_err, @P4_k2_resum, @P4_k2_resum_err"
-              << ");";
-
             // prepare statement
-            sqlite3_stmt* stmt;
-            check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+            auto stmt = get_statement_cache(db).get(table_name, "insert", [&]() -> std::string
+              {
+                std::ostringstream insert_stmt;
+                insert_stmt
+                  << "INSERT INTO " << table_name << " VALUES (@mid, @growth_params, @XY_params, "
+                  << "@zid, @kid, @init_Pk_id, @final_Pk_id, @IR_cutoff_id, @UV_cutoff_id, @IR_resum_id, "
+                  << "@P0_k0_raw, @P0_k0_raw_err, @P0_k0_resum, @P0_k0_resum_err, "
+                  << "@P2_k0_raw, @P2_k0_raw_err, @P2_k0_resum, @P2_k0_resum_err, "
+                  << "@P4_k0_raw, @P4_k0_raw_err, @P4_k0_resum, @P4_k0_resum_err, "
+                  << "@P0_k2_raw, @P0_k2_raw_err, @P0_k2_resum, @P0_k2_resum_err, "
+                  << "@P2_k2_raw, @P2_k2_raw_err, @P2_k2_resum, @P2_k2_resum_err, "
+                  << "@P4_k2_raw, @P4_k2_raw_err, @P4_k2_resum, @P4_k2_resum_err"
+                  << ");";
+                return insert_stmt.str();
+              }, counterterm_insert::names);
 
             // bind parameter values
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@growth_params"), sample.get_growth_params_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@XY_params"), sample.get_XY_params_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@zid"), sample.get_z_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), sample.get_k_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@init_Pk_id"), sample.get_init_Pk_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::growth_params), sample.get_growth_params_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::XY_params), sample.get_XY_params_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::zid), sample.get_z_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::kid), sample.get_k_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::init_Pk_id), sample.get_init_Pk_token().get_id()));
             const boost::optional<linear_Pk_token>& final_tok = sample.get_final_Pk_token();
             if(final_tok)
               {
-                check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@final_Pk_id"), final_tok->get_id()));
+                check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::final_Pk_id), final_tok->get_id()));
               }
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_cutoff_id"), sample.get_IR_cutoff_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@UV_cutoff_id"), sample.get_UV_cutoff_token().get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_resum_id"), sample.get_IR_resum_token().get_id()));
-
-            store_Pell_value(db, stmt, "@P0_k0_raw", "@P0_k0_raw_err", "@P0_k0_resum", "@P0_k0_resum_err", sample.get_P0_k0());
-            store_Pell_value(db, stmt, "@P2_k0_raw", "@P2_k0_raw_err", "@P2_k0_resum", "@P2_k0_resum_err", sample.get_P2_k0());
-            store_Pell_value(db, stmt, "@P4_k0_raw", "@P4_k0_raw_err", "@P4_k0_resum", "@P4_k0_resum_err", sample.get_P4_k0());
-            store_Pell_value(db, stmt, "@P0_k2_raw", "@P0_k2_raw_err", "@P0_k2_resum", "@P0_k2_resum_err", sample.get_P0_k2());
-            store_Pell_value(db, stmt, "@P2_k2_raw", "@P2_k2_raw_err", "@P2_k2_resum", "@P2_k2_resum_err", sample.get_P2_k2());
-            store_Pell_value(db, stmt, "@P4_k2_raw", "@P4_k2_raw_err", "@P4_k2_resum", "@P4_k2_resum_err", sample.get_P4_k2());
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::IR_cutoff_id), sample.get_IR_cutoff_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::UV_cutoff_id), sample.get_UV_cutoff_token().get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(counterterm_insert::IR_resum_id), sample.get_IR_resum_token().get_id()));
+
+            store_Pell_value(db, stmt, counterterm_insert::P0_k0_raw, counterterm_insert::P0_k0_raw_err,
+                             counterterm_insert::P0_k0_resum, counterterm_insert::P0_k0_resum_err, sample.get_P0_k0());
+            store_Pell_value(db, stmt, counterterm_insert::P2_k0_raw, counterterm_insert::P2_k0_raw_err,
+                             counterterm_insert::P2_k0_resum, counterterm_insert::P2_k0_resum_err, sample.get_P2_k0());
+            store_Pell_value(db, stmt, counterterm_insert::P4_k0_raw, counterterm_insert::P4_k0_raw_err,
+                             counterterm_insert::P4_k0_resum, counterterm_insert::P4_k0_resum_err, sample.get_P4_k0());
+            store_Pell_value(db, stmt, counterterm_insert::P0_k2_raw, counterterm_insert::P0_k2_raw_err,
+                             counterterm_insert::P0_k2_resum, counterterm_insert::P0_k2_resum_err, sample.get_P0_k2());
+            store_Pell_value(db, stmt, counterterm_insert::P2_k2_raw, counterterm_insert::P2_k2_raw_err,
+                             counterterm_insert::P2_k2_resum, counterterm_insert::P2_k2_resum_err, sample.get_P2_k2());
+            store_Pell_value(db, stmt, counterterm_insert::P4_k2_raw, counterterm_insert::P4_k2_raw_err,
+                             counterterm_insert::P4_k2_resum, counterterm_insert::P4_k2_resum_err, sample.get_P4_k2());
 
             // perform insertion
-            check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_COUNTERTERM_FAIL, SQLITE_DONE);
-
-            // clear bindings and release
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_finalize(stmt));
+            check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_COUNTERTERM_FAIL, SQLITE_DONE);
           }
     
       }   // namespace store_impl
@@ -359,14 +604,14 @@ namespace sqlite3_operations
       {
         assert(db != nullptr);
         
-        // construct SQL insert statement
-        std::ostringstream insert_stmt;
-        insert_stmt
-          << "INSERT INTO " << policy.transfer_table() << " VALUES (@mid, @kid, @zid, @delta_m, @delta_r, @theta_m, @theta_r, @Phi);";
-
         // prepare statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+        auto stmt = get_statement_cache(db).get(policy.transfer_table(), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_stmt;
+            insert_stmt
+              << "INSERT INTO " << policy.transfer_table() << " VALUES (@mid, @kid, @zid, @delta_m, @delta_r, @theta_m, @theta_r, @Phi);";
+            return insert_stmt.str();
+          }, store_impl::transfer_insert::names);
 
         // get wavenumber token
         const k_token& k_token = sample.get_k_token();
@@ -375,25 +620,22 @@ namespace sqlite3_operations
         for(const transfer_value& val : sample)
           {
             // bind values to the statement
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), k_token.get_id()));
-            check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@zid"), val.first.get_id()));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@delta_m"), val.second.delta_m));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@delta_r"), val.second.delta_r));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@theta_m"), val.second.theta_m));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@theta_r"), val.second.theta_r));
-            check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Phi"), val.second.Phi));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::transfer_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::transfer_insert::kid), k_token.get_id()));
+            check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::transfer_insert::zid), val.first.get_id()));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::transfer_insert::delta_m), val.second.delta_m));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::transfer_insert::delta_r), val.second.delta_r));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::transfer_insert::theta_m), val.second.theta_m));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::transfer_insert::theta_r), val.second.theta_r));
+            check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::transfer_insert::Phi), val.second.Phi));
 
             // perform insertion
-            check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_TRANSFER_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_TRANSFER_FAIL, SQLITE_DONE);
 
             // clear bindings and reset statement
-            check_stmt(db, sqlite3_clear_bindings(stmt));
-            check_stmt(db, sqlite3_reset(stmt));
+            check_stmt(db, sqlite3_clear_bindings(stmt.get()));
+            check_stmt(db, sqlite3_reset(stmt.get()));
           }
-
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_finalize(stmt));
       }
 
 
@@ -401,68 +643,65 @@ namespace sqlite3_operations
       {
         assert(db != nullptr);
 
-        // construct SQL insert statements
-        std::ostringstream insert_D_stmt;
-        insert_D_stmt
-          << "INSERT INTO " << policy.D_factor_table() << " VALUES (@mid, @params_id, @zid, @D_linear, @A, @B, @D, @E, @F, @G, @J);";
-        
-        std::ostringstream insert_f_stmt;
-        insert_f_stmt
-          << "INSERT INTO " << policy.f_factor_table() << " VALUES (@mid, @params_id, @zid, @f_linear, @fA, @fB, @fD, @fE, @fF, @fG, @fJ);";
-
         // prepare statements
-        sqlite3_stmt* D_stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_D_stmt.str().c_str(), insert_D_stmt.str().length()+1, &D_stmt, nullptr));
-    
-        sqlite3_stmt* f_stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_f_stmt.str().c_str(), insert_f_stmt.str().length()+1, &f_stmt, nullptr));
+        auto D_stmt = get_statement_cache(db).get(policy.D_factor_table(), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_D_stmt;
+            insert_D_stmt
+              << "INSERT INTO " << policy.D_factor_table() << " VALUES (@mid, @params_id, @zid, @D_linear, @A, @B, @D, @E, @F, @G, @J);";
+            return insert_D_stmt.str();
+          }, store_impl::D_factor_insert::names);
+        
+        auto f_stmt = get_statement_cache(db).get(policy.f_factor_table(), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_f_stmt;
+            insert_f_stmt
+              << "INSERT INTO " << policy.f_factor_table() << " VALUES (@mid, @params_id, @zid, @f_linear, @fA, @fB, @fD, @fE, @fF, @fG, @fJ);";
+            return insert_f_stmt.str();
+          }, store_impl::f_factor_insert::names);
     
         // loop through sample, writing its values into the database
         const growth_params_token& params = sample.get_params_token();
         for(const oneloop_value& val : sample)
           {
             // bind values to the D statement
-            check_stmt(db, sqlite3_bind_int(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@params_id"), params.get_id()));
-            check_stmt(db, sqlite3_bind_int(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@zid"), val.first.get_id()));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@D_linear"), val.second.D_lin));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@A"), val.second.A));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@B"), val.second.B));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@D"), val.second.D));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@E"), val.second.E));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@F"), val.second.F));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@G"), val.second.G));
-            check_stmt(db, sqlite3_bind_double(D_stmt, sqlite3_bind_parameter_index(D_stmt, "@J"), val.second.J));
+            check_stmt(db, sqlite3_bind_int(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::params_id), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::zid), val.first.get_id()));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::D_linear), val.second.D_lin));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::A), val.second.A));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::B), val.second.B));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::D), val.second.D));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::E), val.second.E));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::F), val.second.F));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::G), val.second.G));
+            check_stmt(db, sqlite3_bind_double(D_stmt.get(), D_stmt.param(store_impl::D_factor_insert::J), val.second.J));
 
             // perform D insertion
-            check_stmt(db, sqlite3_step(D_stmt), ERROR_SQLITE3_INSERT_GROWTH_D_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(D_stmt.get()), ERROR_SQLITE3_INSERT_GROWTH_D_FAIL, SQLITE_DONE);
     
             // bind values to the f statement
-            check_stmt(db, sqlite3_bind_int(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@mid"), model.get_id()));
-            check_stmt(db, sqlite3_bind_int(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@params_id"), params.get_id()));
-            check_stmt(db, sqlite3_bind_int(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@zid"), val.first.get_id()));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@f_linear"), val.second.f_lin));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fA"), val.second.fA));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fB"), val.second.fB));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fD"), val.second.fD));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fE"), val.second.fE));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fF"), val.second.fF));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fG"), val.second.fG));
-            check_stmt(db, sqlite3_bind_double(f_stmt, sqlite3_bind_parameter_index(f_stmt, "@fJ"), val.second.fJ));
+            check_stmt(db, sqlite3_bind_int(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::mid), model.get_id()));
+            check_stmt(db, sqlite3_bind_int(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::params_id), params.get_id()));
+            check_stmt(db, sqlite3_bind_int(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::zid), val.first.get_id()));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::f_linear), val.second.f_lin));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fA), val.second.fA));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fB), val.second.fB));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fD), val.second.fD));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fE), val.second.fE));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fF), val.second.fF));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fG), val.second.fG));
+            check_stmt(db, sqlite3_bind_double(f_stmt.get(), f_stmt.param(store_impl::f_factor_insert::fJ), val.second.fJ));
     
             // perform f insertion
-            check_stmt(db, sqlite3_step(f_stmt), ERROR_SQLITE3_INSERT_GROWTH_F_FAIL, SQLITE_DONE);
+            check_stmt(db, sqlite3_step(f_stmt.get()), ERROR_SQLITE3_INSERT_GROWTH_F_FAIL, SQLITE_DONE);
 
             // clear bindings and reset statement
-            check_stmt(db, sqlite3_clear_bindings(D_stmt));
-            check_stmt(db, sqlite3_reset(D_stmt));
-            check_stmt(db, sqlite3_clear_bindings(f_stmt));
-            check_stmt(db, sqlite3_reset(f_stmt));
+            check_stmt(db, sqlite3_clear_bindings(D_stmt.get()));
+            check_stmt(db, sqlite3_reset(D_stmt.get()));
+            check_stmt(db, sqlite3_clear_bindings(f_stmt.get()));
+            check_stmt(db, sqlite3_reset(f_stmt.get()));
           }
-
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_finalize(D_stmt));
-        check_stmt(db, sqlite3_finalize(f_stmt));
       }
 
 
@@ -484,9 +723,13 @@ namespace sqlite3_operations
             throw runtime_exception(exception_type::store_error, msg.str());
           }
     
-        const loop_integral_params_token& params = sample.get_params_token();
+        // the autogenerated statements pass this to store_loop_kernel() with each kernel
+        const store_impl::loop_kernel_context params(policy, sample.get_params_token());
 
 #include "autogenerated/store_kernel_stmts.cpp"
+        
+        // power spectra built from the values just replaced are stale
+        if(params.is_replaced()) store_impl::invalidate_loop_Pk(db, model, sample.get_params_token(), sample);
       }
     
     
@@ -532,28 +775,26 @@ namespace sqlite3_operations
       {
         assert(db != nullptr);
         
-        std::ostringstream insert_stmt;
-        insert_stmt
-          << "INSERT INTO " << policy.Matsubara_XY_table() << " VALUES (@mid, @params_id, @Pk_id, @IR_resum_id, @X, @Y);";
-    
         // prepare statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+        auto stmt = get_statement_cache(db).get(policy.Matsubara_XY_table(), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_stmt;
+            insert_stmt
+              << "INSERT INTO " << policy.Matsubara_XY_table() << " VALUES (@mid, @params_id, @Pk_id, @IR_resum_id, @X, @Y);";
+            return insert_stmt.str();
+          }, store_impl::Matsubara_XY_insert::names);
     
         // bind parameter values
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@mid"), model.get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), sample.get_params_token().get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), sample.get_Pk_token().get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@IR_resum_id"), sample.get_IR_resum_token().get_id()));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@X"), make_dimensionless(sample.get_X())));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Y"), make_dimensionless(sample.get_Y())));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::mid), model.get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::params_id), sample.get_params_token().get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::Pk_id), sample.get_Pk_token().get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::IR_resum_id), sample.get_IR_resum_token().get_id()));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::X), make_dimensionless(sample.get_X())));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Matsubara_XY_insert::Y), make_dimensionless(sample.get_Y())));
     
         // perform insertion
-        check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_MATSUBARA_XY_FAIL, SQLITE_DONE);
+        check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_MATSUBARA_XY_FAIL, SQLITE_DONE);
     
-        // clear bindings and release
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
       }
     
     
@@ -571,34 +812,32 @@ namespace sqlite3_operations
             throw runtime_exception(exception_type::store_error, msg.str());
           }
 
-        std::ostringstream insert_stmt;
-        insert_stmt
-          << "INSERT INTO " << policy.Pk_linear_table() << " VALUES (@Pk_id, @params_id, @kid, @Pk_raw, @Pk_nw, @Pk_ref, @Pk_nw_err, @regions, @evaluations, @time);";
-    
         // prepare statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+        auto stmt = get_statement_cache(db).get(policy.Pk_linear_table(), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_stmt;
+            insert_stmt
+              << "INSERT INTO " << policy.Pk_linear_table() << " VALUES (@Pk_id, @params_id, @kid, @Pk_raw, @Pk_nw, @Pk_ref, @Pk_nw_err, @regions, @evaluations, @time);";
+            return insert_stmt.str();
+          }, store_impl::Pk_linear_insert::names);
     
         // bind parameter values
         const Pk_filter_result& Pk_nw = sample.get_Pk_nowiggle();
         
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_id"), sample.get_Pk_token().get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@params_id"), sample.get_params_token().get_id()));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@kid"), sample.get_k_token().get_id()));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_raw"), make_dimensionless(sample.get_Pk_raw())));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_nw"), make_dimensionless(Pk_nw.value)));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_ref"), make_dimensionless(sample.get_Pk_ref())));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@Pk_nw_err"), make_dimensionless(Pk_nw.error)));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@regions"), Pk_nw.regions));
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@evaluations"), Pk_nw.evaluations));
-        check_stmt(db, sqlite3_bind_int64(stmt, sqlite3_bind_parameter_index(stmt, "@time"), Pk_nw.time));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Pk_linear_insert::Pk_id), sample.get_Pk_token().get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Pk_linear_insert::params_id), sample.get_params_token().get_id()));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Pk_linear_insert::kid), sample.get_k_token().get_id()));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Pk_linear_insert::Pk_raw), make_dimensionless(sample.get_Pk_raw())));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Pk_linear_insert::Pk_nw), make_dimensionless(Pk_nw.value)));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Pk_linear_insert::Pk_ref), make_dimensionless(sample.get_Pk_ref())));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(store_impl::Pk_linear_insert::Pk_nw_err), make_dimensionless(Pk_nw.error)));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Pk_linear_insert::regions), Pk_nw.regions));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(store_impl::Pk_linear_insert::evaluations), Pk_nw.evaluations));
+        check_stmt(db, sqlite3_bind_int64(stmt.get(), stmt.param(store_impl::Pk_linear_insert::time), Pk_nw.time));
     
         // perform insertion
-        check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_PK_LINEAR_DATA_FAIL, SQLITE_DONE);
+        check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_PK_LINEAR_DATA_FAIL, SQLITE_DONE);
     
-        // clear bindings and release
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
       }
 
 
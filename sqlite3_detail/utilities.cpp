@@ -257,4 +257,60 @@ namespace sqlite3_operations
       }
     
     
+    namespace utilities_impl
+      {
+        
+        //! get names of all tables whose schema matches a LIKE condition
+        std::list<std::string> tables_matching(sqlite3* db, const std::string& condition)
+          {
+            std::ostringstream read_stmt;
+            read_stmt << "SELECT name FROM sqlite_master WHERE type='table' AND " << condition << ";";
+
+            // prepare statement
+            sqlite3_stmt* stmt;
+            check_stmt(db, sqlite3_prepare_v2(db, read_stmt.str().c_str(), read_stmt.str().length()+1, &stmt, nullptr));
+        
+            std::list<std::string> tables;
+        
+            // perform read
+            int result = 0;
+            while((result = sqlite3_step(stmt)) != SQLITE_DONE)
+              {
+                if(result == SQLITE_ROW)
+                  {
+                    tables.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)));
+                  }
+                else
+                  {
+                    check_stmt(db, sqlite3_finalize(stmt));
+                    throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_READ_TABLE_INFO_FAIL);
+                  }
+              }
+        
+            check_stmt(db, sqlite3_finalize(stmt));
+        
+            return tables;
+          }
+        
+      }   // namespace utilities_impl
+    
+    
+    std::list<std::string> loop_kernel_tables(sqlite3* db)
+      {
+        return utilities_impl::tables_matching(db, "sql LIKE '%raw_time%' AND sql LIKE '%nw_time%' AND sql LIKE '%UV_id%' AND sql LIKE '%IR_id%'");
+      }
+    
+    
+    std::list<std::string> oneloop_Pk_tables(sqlite3* db)
+      {
+        return utilities_impl::tables_matching(db, "sql LIKE '%loop_params%' AND sql LIKE '%init_Pk_id%' AND sql LIKE '%UV_id%' AND sql LIKE '%IR_id%'");
+      }
+    
+    
+    std::list<std::string> multipole_Pk_tables(sqlite3* db)
+      {
+        return utilities_impl::tables_matching(db, "sql LIKE '%loop_params%' AND sql LIKE '%init_Pk_id%' AND sql LIKE '%UV_cutoff_id%' AND sql LIKE '%IR_resum_id%'");
+      }
+    
+    
   }   // namespace sqlite3_operations
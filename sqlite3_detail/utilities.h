@@ -28,6 +28,7 @@
 
 
 #include <string>
+#include <list>
 
 #include "sqlite3.h"
 
@@ -84,6 +85,19 @@ namespace sqlite3_operations
     
     //! update SQLite's internal statistics
     void analyze(sqlite3* db);
+    
+    
+    // TABLE DISCOVERY
+    
+    //! get names of all loop kernel tables; these are created by create_impl::oneloop_momentum_integral_table(),
+    //! so can be recognized from their schema without reference to the autogenerated kernel list
+    std::list<std::string> loop_kernel_tables(sqlite3* db);
+    
+    //! get names of all one-loop P(k) tables, created by create_impl::oneloop_rsd_Pk_table()
+    std::list<std::string> oneloop_Pk_tables(sqlite3* db);
+    
+    //! get names of all multipole P(k) tables, created by create_impl::multipole_Pk_table()
+    std::list<std::string> multipole_Pk_tables(sqlite3* db);
 
   }
 
@@ -37,6 +37,7 @@
 #include "sqlite3_policy.h"
 
 #include "utilities.h"
+#include "statement_cache.h"
 #include "exceptions.h"
 
 #include "localizations/messages.h"
@@ -49,6 +50,29 @@
 namespace sqlite3_operations
   {
 
+    namespace wavenumber_impl
+      {
+
+        // parameter positions for the cached statements
+
+        namespace wavenumber_lookup
+          {
+            enum parameter { tol, k };
+
+            const parameter_list names = { "@tol", "@k" };
+          }
+
+
+        namespace wavenumber_insert
+          {
+            enum parameter { id, k };
+
+            const parameter_list names = { "@id", "@k" };
+          }
+
+      }   // namespace wavenumber_impl
+
+
     template <typename Token>
     boost::optional<unsigned int> lookup_wavenumber(sqlite3* db, transaction_manager& mgr,
                                                     const Mpc_units::energy& k, const sqlite3_policy& policy, double tol)
@@ -57,39 +81,35 @@ namespace sqlite3_operations
 
         double k_in_h_inv_Mpc = k * Mpc_units::Mpc;
 
-        std::ostringstream select_stmt;
-        select_stmt
-        << "SELECT id FROM " << tokenization_table<Token>(policy) << " WHERE "
-        << "ABS((k-@k)/k)<@tol;";
-
-        // prepare SQL statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, select_stmt.str().c_str(), select_stmt.str().length()+1, &stmt, nullptr));
+        // prepare statement
+        auto stmt = get_statement_cache(db).get(tokenization_table<Token>(policy), "lookup", [&]() -> std::string
+          {
+            std::ostringstream select_stmt;
+            select_stmt
+            << "SELECT id FROM " << tokenization_table<Token>(policy) << " WHERE "
+            << "ABS((k-@k)/k)<@tol;";
+            return select_stmt.str();
+          }, wavenumber_impl::wavenumber_lookup::names);
 
         // bind values to the parameters
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@tol"), tol));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@k"), k_in_h_inv_Mpc));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(wavenumber_impl::wavenumber_lookup::tol), tol));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(wavenumber_impl::wavenumber_lookup::k), k_in_h_inv_Mpc));
 
         // execute statement and step through results
         int status = 0;
         boost::optional<unsigned int> id = boost::none;
-        while((status = sqlite3_step(stmt)) != SQLITE_DONE)
+        while((status = sqlite3_step(stmt.get())) != SQLITE_DONE)
           {
             if(status == SQLITE_ROW)
               {
                 if(id) throw runtime_exception(exception_type::database_error, ERROR_SQLITE3_MULTIPLE_WAVENUMBERS);
-                id = static_cast<unsigned int>(sqlite3_column_int(stmt, 0));
+                id = static_cast<unsigned int>(sqlite3_column_int(stmt.get(), 0));
               }
           }
 
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
-
         return(id);
       }
 
-
     template <typename Token>
     unsigned int insert_wavenumber(sqlite3* db, transaction_manager& mgr,
                                    const Mpc_units::energy& k, const sqlite3_policy& policy)
@@ -101,24 +121,21 @@ namespace sqlite3_operations
 
         double k_in_h_inv_Mpc = k * Mpc_units::Mpc;
 
-        std::ostringstream insert_stmt;
-        insert_stmt
-        << "INSERT INTO " << tokenization_table<Token>(policy) << " VALUES (@id, @k);";
-
-        // prepare SQL statement
-        sqlite3_stmt* stmt;
-        check_stmt(db, sqlite3_prepare_v2(db, insert_stmt.str().c_str(), insert_stmt.str().length()+1, &stmt, nullptr));
+        // prepare statement
+        auto stmt = get_statement_cache(db).get(tokenization_table<Token>(policy), "insert", [&]() -> std::string
+          {
+            std::ostringstream insert_stmt;
+            insert_stmt
+            << "INSERT INTO " << tokenization_table<Token>(policy) << " VALUES (@id, @k);";
+            return insert_stmt.str();
+          }, wavenumber_impl::wavenumber_insert::names);
 
         // bind values to the parameters
-        check_stmt(db, sqlite3_bind_int(stmt, sqlite3_bind_parameter_index(stmt, "@id"), new_id));
-        check_stmt(db, sqlite3_bind_double(stmt, sqlite3_bind_parameter_index(stmt, "@k"), k_in_h_inv_Mpc));
+        check_stmt(db, sqlite3_bind_int(stmt.get(), stmt.param(wavenumber_impl::wavenumber_insert::id), new_id));
+        check_stmt(db, sqlite3_bind_double(stmt.get(), stmt.param(wavenumber_impl::wavenumber_insert::k), k_in_h_inv_Mpc));
 
         // perform insertion
-        check_stmt(db, sqlite3_step(stmt), ERROR_SQLITE3_INSERT_WAVENUMBER_FAIL, SQLITE_DONE);
-
-        // finalize statement and release resources
-        check_stmt(db, sqlite3_clear_bindings(stmt));
-        check_stmt(db, sqlite3_finalize(stmt));
+        check_stmt(db, sqlite3_step(stmt.get()), ERROR_SQLITE3_INSERT_WAVENUMBER_FAIL, SQLITE_DONE);
 
         return(new_id);
       }
@@ -0,0 +1,72 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <cmath>
+#include <utility>
+
+#include "fft.h"
+
+#include "exceptions.h"
+#include "localizations/messages.h"
+
+
+void fft(std::vector< std::complex<double> >& data)
+  {
+    const size_t n = data.size();
+    if(!is_power_of_two(static_cast<unsigned int>(n))) throw runtime_exception(exception_type::runtime_error, ERROR_FFT_LENGTH);
+
+    // reorder into bit-reversed sequence
+    for(size_t i = 1, j = 0; i < n; ++i)
+      {
+        size_t bit = n >> 1;
+        for(; j & bit; bit >>= 1)
+          {
+            j ^= bit;
+          }
+        j ^= bit;
+
+        if(i < j) std::swap(data[i], data[j]);
+      }
+
+    // combine transforms of increasing length
+    for(size_t len = 2; len <= n; len <<= 1)
+      {
+        const double angle = -2.0 * M_PI / len;
+        const std::complex<double> w_len(std::cos(angle), std::sin(angle));
+
+        for(size_t i = 0; i < n; i += len)
+          {
+            std::complex<double> w(1.0, 0.0);
+            for(size_t j = 0; j < len/2; ++j)
+              {
+                const std::complex<double> u = data[i+j];
+                const std::complex<double> v = data[i+j+len/2] * w;
+
+                data[i+j] = u + v;
+                data[i+j+len/2] = u - v;
+                w *= w_len;
+              }
+          }
+      }
+  }
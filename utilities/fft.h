@@ -0,0 +1,41 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_FFT_H
+#define LSSEFT_FFT_H
+
+
+#include <complex>
+#include <vector>
+
+
+//! in-place forward discrete Fourier transform, X_m = sum_j x_j exp(-2 pi i m j / N), computed by
+//! radix-2 Cooley-Tukey; the length must be a power of two
+void fft(std::vector< std::complex<double> >& data);
+
+//! is n a power of two?
+constexpr bool is_power_of_two(unsigned int n) { return n != 0 && (n & (n-1)) == 0; }
+
+
+#endif //LSSEFT_FFT_H
@@ -0,0 +1,101 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "gauss_legendre.h"
+
+
+namespace gauss_legendre_impl
+  {
+
+    //! convergence tolerance for Newton iteration on the node positions
+    constexpr double node_tolerance = 1E-15;
+
+    //! maximum number of Newton iterations per node
+    constexpr unsigned int max_iterations = 100;
+
+    //! cache of computed rules
+    std::map< unsigned int, std::unique_ptr<gauss_legendre_rule> > cache;
+
+    //! lock for cache
+    std::mutex cache_lock;
+
+  }   // namespace gauss_legendre_impl
+
+
+gauss_legendre_rule::gauss_legendre_rule(unsigned int n)
+  : nodes(n),
+    weights(n)
+  {
+    // nodes are symmetric about zero, so only half need to be located
+    const unsigned int half = (n+1)/2;
+
+    for(unsigned int i = 0; i < half; ++i)
+      {
+        // Tricomi's approximation to the i-th root gives a starting point for Newton iteration
+        double z = std::cos(M_PI * (i + 0.75) / (n + 0.5));
+        double dP = 0.0;
+
+        for(unsigned int iter = 0; iter < gauss_legendre_impl::max_iterations; ++iter)
+          {
+            // evaluate P_n(z) by upward recurrence, and its derivative
+            double P0 = 1.0;
+            double P1 = 0.0;
+            for(unsigned int j = 1; j <= n; ++j)
+              {
+                double P2 = P1;
+                P1 = P0;
+                P0 = ((2.0*j - 1.0)*z*P1 - (j - 1.0)*P2) / j;
+              }
+            dP = n*(z*P0 - P1) / (z*z - 1.0);
+
+            const double dz = P0 / dP;
+            z -= dz;
+            if(std::abs(dz) < gauss_legendre_impl::node_tolerance) break;
+          }
+
+        const double w = 2.0 / ((1.0 - z*z)*dP*dP);
+
+        this->nodes[i] = -z;
+        this->nodes[n-1-i] = z;
+        this->weights[i] = w;
+        this->weights[n-1-i] = w;
+      }
+  }
+
+
+const gauss_legendre_rule& gauss_legendre(unsigned int n)
+  {
+    std::lock_guard<std::mutex> lock(gauss_legendre_impl::cache_lock);
+
+    auto t = gauss_legendre_impl::cache.find(n);
+    if(t != gauss_legendre_impl::cache.end()) return *t->second;
+
+    auto res = gauss_legendre_impl::cache.emplace(n, std::make_unique<gauss_legendre_rule>(n));
+    return *res.first->second;
+  }
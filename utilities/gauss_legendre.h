@@ -0,0 +1,78 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_GAUSS_LEGENDRE_H
+#define LSSEFT_GAUSS_LEGENDRE_H
+
+
+#include <vector>
+
+
+//! Gauss-Legendre quadrature rule with n nodes on the interval [-1, 1]
+class gauss_legendre_rule
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor computes nodes and weights
+    gauss_legendre_rule(unsigned int n);
+
+    //! destructor is default
+    ~gauss_legendre_rule() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! get number of nodes
+    unsigned int size() const { return static_cast<unsigned int>(this->nodes.size()); }
+
+    //! get nodes
+    const std::vector<double>& get_nodes() const { return this->nodes; }
+
+    //! get weights
+    const std::vector<double>& get_weights() const { return this->weights; }
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! nodes, in increasing order
+    std::vector<double> nodes;
+
+    //! weights
+    std::vector<double> weights;
+
+  };
+
+
+//! get a shared n-point rule; rules are computed on first use and cached for the lifetime of the process
+const gauss_legendre_rule& gauss_legendre(unsigned int n);
+
+
+#endif //LSSEFT_GAUSS_LEGENDRE_H
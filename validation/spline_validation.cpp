@@ -0,0 +1,218 @@
+//
+// --@@ // Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure platform (LSSEFT).
+//
+// LSSEFT is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+
+#include "cosmology/concepts/power_spectrum_detail/log_cubic_spline.h"
+
+#include "SPLINTER/datatable.h"
+#include "SPLINTER/bspline.h"
+#include "SPLINTER/bsplinebuilder.h"
+
+#include "boost/timer/timer.hpp"
+
+
+// compare the natural cubic spline in log k used by splined_Pk with the cubic B-spline in k
+// which it replaced, using an analytic spectrum with baryon oscillations as the reference;
+// exits with failure if the log-cubic spline is less accurate than the B-spline in any band
+namespace spline_validation_impl
+  {
+    
+    //! sampled range, in h/Mpc, matching a typical CAMB linear power spectrum
+    constexpr double k_min = 1E-4;
+    constexpr double k_max = 10.0;
+    
+    //! default number of samples
+    constexpr unsigned int default_samples = 500;
+    
+    //! number of evaluations used for timing
+    constexpr unsigned int timing_evaluations = 1000000;
+    
+    //! the log-cubic spline passes if its error is no worse than this multiple of the B-spline error,
+    //! or below the absolute floor, in every band
+    constexpr double error_ratio = 1.0;
+    constexpr double error_floor = 1E-6;
+    
+    //! power spectrum with a BBKS transfer function and damped baryon oscillations
+    double reference_Pk(double k)
+      {
+        constexpr double Gamma = 0.21;
+        constexpr double n_s = 0.965;
+        constexpr double r_s = 105.0;
+        constexpr double k_silk = 0.2;
+        
+        const double q = k / Gamma;
+        const double T = std::log(1.0 + 2.34*q) / (2.34*q)
+                         * std::pow(1.0 + 3.89*q + std::pow(16.1*q, 2) + std::pow(5.46*q, 3) + std::pow(6.71*q, 4), -0.25);
+        const double wiggle = 1.0 + 0.05 * std::sin(k*r_s) * std::exp(-(k/k_silk)*(k/k_silk));
+        
+        return 2E7 * std::pow(k, n_s) * T*T * wiggle;
+      }
+    
+    
+    //! band of wavenumbers in which errors are reported
+    struct band
+      {
+        std::string name;
+        double lo;
+        double hi;
+      };
+    
+    
+    //! accumulated errors within a band
+    struct band_errors
+      {
+        double B_spline = 0.0;
+        double log_cubic = 0.0;
+        double difference = 0.0;
+      };
+    
+    
+    //! build sample points uniformly spaced in log k, or perturbed away from uniform spacing
+    std::vector<double> sample_points(unsigned int N, bool perturb)
+      {
+        std::vector<double> k(N);
+        
+        const double log_lo = std::log(k_min);
+        const double h = (std::log(k_max) - log_lo) / (N-1);
+        
+        for(unsigned int i = 0; i < N; ++i)
+          {
+            // deterministic perturbation of the interior points, by up to a third of the spacing
+            const double shift = (perturb && i > 0 && i < N-1) ? h * std::sin(7.0*i) / 3.0 : 0.0;
+            k[i] = std::exp(log_lo + i*h + shift);
+          }
+        
+        return k;
+      }
+    
+    
+    //! compare the evaluators on a single grid; returns false if the log-cubic spline fails
+    bool validate(const std::string& label, const std::vector<double>& k)
+      {
+        std::vector<double> P(k.size());
+        std::transform(k.cbegin(), k.cend(), P.begin(), reference_Pk);
+        
+        SPLINTER::DataTable table;
+        for(unsigned int i = 0; i < k.size(); ++i)
+          {
+            table.addSample(k[i], P[i]);
+          }
+        SPLINTER::BSpline B_spline = SPLINTER::BSpline::Builder(table).degree(3).build();
+        
+        log_cubic_spline log_cubic(k, P);
+        
+        const std::vector<band> bands = { { "k < 0.01", k_min, 0.01 }, { "BAO", 0.01, 0.5 }, { "k > 0.5", 0.5, k_max } };
+        std::vector<band_errors> errors(bands.size());
+        
+        // interval midpoints in log k are furthest from the knots
+        std::vector<double> k_test;
+        for(unsigned int i = 0; i+1 < k.size(); ++i)
+          {
+            k_test.push_back(std::sqrt(k[i]*k[i+1]));
+          }
+        
+        SPLINTER::DenseVector x(1);
+        for(double kt : k_test)
+          {
+            x(0) = kt;
+            const double P_true = reference_Pk(kt);
+            const double P_B = B_spline.eval(x);
+            const double P_L = log_cubic(kt);
+            
+            for(unsigned int b = 0; b < bands.size(); ++b)
+              {
+                if(kt < bands[b].lo || kt >= bands[b].hi) continue;
+                
+                errors[b].B_spline = std::max(errors[b].B_spline, std::abs(P_B/P_true - 1.0));
+                errors[b].log_cubic = std::max(errors[b].log_cubic, std::abs(P_L/P_true - 1.0));
+                errors[b].difference = std::max(errors[b].difference, std::abs(P_L/P_B - 1.0));
+              }
+          }
+        
+        // time both evaluators over the same points
+        std::vector<double> k_timing(timing_evaluations);
+        for(unsigned int i = 0; i < timing_evaluations; ++i)
+          {
+            k_timing[i] = k_test[i % k_test.size()];
+          }
+        
+        double sink = 0.0;
+        
+        boost::timer::cpu_timer B_timer;
+        for(double kt : k_timing)
+          {
+            x(0) = kt;
+            sink += B_spline.eval(x);
+          }
+        B_timer.stop();
+        
+        boost::timer::cpu_timer L_timer;
+        std::vector<double> P_timing(timing_evaluations);
+        log_cubic.evaluate(k_timing.data(), P_timing.data(), timing_evaluations);
+        L_timer.stop();
+        sink += P_timing.back();
+        
+        std::cout << label << ": " << k.size() << " samples" << '\n';
+        std::cout << std::setw(10) << "band" << std::setw(16) << "B-spline" << std::setw(16) << "log-cubic"
+                  << std::setw(16) << "difference" << '\n';
+        
+        bool pass = true;
+        for(unsigned int b = 0; b < bands.size(); ++b)
+          {
+            std::cout << std::setw(10) << bands[b].name << std::scientific << std::setprecision(3)
+                      << std::setw(16) << errors[b].B_spline << std::setw(16) << errors[b].log_cubic
+                      << std::setw(16) << errors[b].difference << '\n';
+            
+            if(errors[b].log_cubic > std::max(error_ratio * errors[b].B_spline, error_floor)) pass = false;
+          }
+        
+        std::cout << std::fixed << std::setprecision(1)
+                  << "time per evaluation: B-spline = " << static_cast<double>(B_timer.elapsed().wall) / timing_evaluations
+                  << " ns, log-cubic = " << static_cast<double>(L_timer.elapsed().wall) / timing_evaluations << " ns"
+                  << " (checksum " << std::scientific << sink << ")" << '\n';
+        std::cout << (pass ? "PASS" : "FAIL") << '\n' << '\n';
+        
+        return pass;
+      }
+    
+  }   // namespace spline_validation_impl
+
+
+int main(int argc, char* argv[])
+  {
+    const unsigned int N = argc > 1 ? static_cast<unsigned int>(std::atoi(argv[1])) : spline_validation_impl::default_samples;
+    
+    bool pass = spline_validation_impl::validate("uniform in log k", spline_validation_impl::sample_points(N, false));
+    pass = spline_validation_impl::validate("non-uniform in log k", spline_validation_impl::sample_points(N, true)) && pass;
+    
+    return(pass ? EXIT_SUCCESS : EXIT_FAILURE);
+  }